@@ -0,0 +1,443 @@
+/**
+ * @brief Microbenchmarks for the firmware hot paths, on the host and on the Teensy
+ *
+ * One source, two targets:
+ *
+ *   host     - built against the sim/ stand-ins (make bench-host), times with
+ *              std::chrono and reports ns/op. The virtual clock only moves
+ *              when a benchmark advances it.
+ *   teensy41 - the teensy41-bench environment (make benchmark) builds this
+ *              file instead of main.cpp, times with the DWT cycle counter and
+ *              reports cycles/op over USB serial. Real time passes.
+ *
+ * Every result is one JSON object per line, so runs can be stored and
+ * compared by machine:
+ *
+ *   {"suite":"hot_paths","target":"host","unit":"ns","cpu_hz":0}
+ *   {"bench":"debouncer_update","target":"host","unit":"ns","iterations":200000,"per_op":2.41,"min":2.38,"max":2.57}
+ *   {"suite":"hot_paths","done":true,"benches":24}
+ *
+ * Two kinds of benchmark:
+ *   loop  - the step runs back to back; per_op is the mean over all repeats,
+ *           min/max are the best and worst repeat averages
+ *   paced - one step per scan tick against a scripted input sequence, with
+ *           untimed preparation between steps; min/max are single calls
+ *
+ * Debug prints are compiled out (DEBUG=0) in both builds.
+ */
+
+#include <Arduino.h>
+#include "config.h"
+#include "pins.h"
+#include "debouncer.h"
+#include "analog_smoother.h"
+#include "robust_input_processor.h"
+#include "robust_midi_mapper.h"
+#include "midi_out.h"
+#include "portal_controller.h"
+#include "portal_cue_handler.h"
+#include "oled_display.h"
+#include "perf_monitor.h"
+#include "event_log.h"
+#include "rule_engine.h"
+#include "led_power.h"
+
+#if STATIC_INPUT_PIPELINE > 0
+#error "bench_hot_paths drives RobustInputProcessor with frames; build with STATIC_INPUT_PIPELINE=0"
+#endif
+
+// ===== TARGET CLOCK AND OUTPUT =====
+
+#ifdef ARM_DWT_CYCCNT
+static const char* const BENCH_TARGET = "teensy41";
+static const char* const BENCH_UNIT = "cycles";
+
+static inline uint32_t benchNow() { return ARM_DWT_CYCCNT; }
+
+// Real time passes on its own
+static inline void benchElapse(uint32_t) {}
+static void benchWaitUntilUs(uint32_t us) { while ((int32_t)(micros() - us) < 0) {} }
+
+static void benchPrint(const char* line) { Serial.println(line); }
+#else
+#include <chrono>
+
+static const char* const BENCH_TARGET = "host";
+static const char* const BENCH_UNIT = "ns";
+
+static inline uint32_t benchNow() {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static inline void benchElapse(uint32_t us) { sim::advanceMicros(us); }
+static void benchWaitUntilUs(uint32_t us) {
+    if ((int32_t)(us - micros()) > 0) sim::advanceMicros(us - micros());
+}
+
+static void benchPrint(const char* line) { printf("%s\n", line); }
+#endif
+
+static constexpr uint8_t BENCH_REPEATS = 5;
+static constexpr uint32_t BENCH_PACED_TICKS = 2000;  // 2 s of scan ticks
+
+// Results written here cannot be optimized away
+static volatile uint32_t benchSink;
+static uint16_t benchCount;
+
+static void printResult(const char* name, uint32_t iterations, double perOp, double minOp, double maxOp) {
+    char line[192];
+    snprintf(line, sizeof(line),
+             "{\"bench\":\"%s\",\"target\":\"%s\",\"unit\":\"%s\",\"iterations\":%lu,"
+             "\"per_op\":%.2f,\"min\":%.2f,\"max\":%.2f}",
+             name, BENCH_TARGET, BENCH_UNIT, (unsigned long)iterations, perOp, minOp, maxOp);
+    benchPrint(line);
+    benchCount++;
+}
+
+/**
+ * @brief Time step(i) back to back, BENCH_REPEATS times, after a warm-up pass
+ */
+template <typename Step>
+static void runLoop(const char* name, uint32_t iterations, Step step) {
+    for (uint32_t i = 0; i < iterations / 8; i++) step(i);
+
+    double total = 0;
+    double minOp = 1e30;
+    double maxOp = 0;
+    for (uint8_t r = 0; r < BENCH_REPEATS; r++) {
+        const uint32_t start = benchNow();
+        for (uint32_t i = 0; i < iterations; i++) step(i);
+        const uint32_t elapsed = benchNow() - start;
+
+        const double perOp = (double)elapsed / iterations;
+        total += elapsed;
+        if (perOp < minOp) minOp = perOp;
+        if (perOp > maxOp) maxOp = perOp;
+    }
+    printResult(name, iterations, total / ((double)iterations * BENCH_REPEATS), minOp, maxOp);
+}
+
+/**
+ * @brief One prepare(tick) + timed measure(tick) per scan period
+ */
+template <typename Prepare, typename Measure>
+static void runPaced(const char* name, uint32_t ticks, Prepare prepare, Measure measure) {
+    double total = 0;
+    uint32_t minOp = UINT32_MAX;
+    uint32_t maxOp = 0;
+    uint32_t nextUs = micros();
+    for (uint32_t tick = 0; tick < ticks; tick++) {
+        nextUs += SCAN_PERIOD_US;
+        benchWaitUntilUs(nextUs);
+        prepare(tick);
+
+        const uint32_t start = benchNow();
+        measure(tick);
+        const uint32_t elapsed = benchNow() - start;
+
+        total += elapsed;
+        if (elapsed < minOp) minOp = elapsed;
+        if (elapsed > maxOp) maxOp = elapsed;
+    }
+    printResult(name, ticks, total / ticks, minOp, maxOp);
+}
+
+// ===== INPUT PIPELINE =====
+
+/**
+ * @brief Scripted play at scan rate: a button every 100 ticks (held 40, with
+ * contact bounce), pot 0 sweeping with ADC jitter, pot 2 jittering only, a
+ * switch every 250 ticks, a joystick push every 500 ticks
+ */
+static RawInputFrame scriptedFrame(uint32_t tick) {
+    RawInputFrame frame = {};
+
+    const uint32_t phase = tick % 100;
+    const bool bounce = phase == 1 || phase == 3 || phase == 41;
+    if ((phase < 40) != bounce) frame.buttons = 1 << ((tick / 100) % BUTTON_COUNT);
+
+    frame.switches = (tick / 250) & 0x0FFF;
+    if (tick % 500 < 30) frame.joystick = 1 << ((tick / 500) % 4);
+
+    const uint32_t sweep = tick % 1024;
+    frame.pots[0] = (tick / 1024) & 1 ? 1023 - sweep : sweep;
+    for (uint8_t i = 0; i < POT_COUNT; i++) {
+        if (i != 0) frame.pots[i] = 512;
+        frame.pots[i] += (tick * 7 + i * 3) % 5 - 2;  // ±2 counts
+    }
+    return frame;
+}
+
+static void benchInputs() {
+    Debouncer debouncer;
+    runLoop("debouncer_update", 200000, [&](uint32_t i) {
+        // Toggles every 32 ticks, one bounce after each edge; 1 ms per update
+        const bool raw = ((i >> 5) & 1) ^ ((i & 31) == 1);
+        benchSink = debouncer.update(raw, i);
+    });
+
+    AnalogSmoother smoother(POT_SMOOTHING_ALPHA);
+    runLoop("analog_smoother_update", 200000, [&](uint32_t i) {
+        const uint16_t raw = (i & 1023) + (i * 7) % 5;
+        benchSink = smoother.update(raw > 1023 ? 1023 : raw, i);
+    });
+
+    RobustInputProcessor processor;
+    MidiOut midiOut;
+    RobustMidiMapper mapper(processor, midiOut);
+    processor.begin();
+    processor.restart(scriptedFrame(0));
+
+    runPaced("input_processor_update", BENCH_PACED_TICKS,
+             [](uint32_t) {},
+             [&](uint32_t tick) { processor.update(scriptedFrame(tick)); });
+
+    // MIDI sends (usbMIDI on the Teensy) are part of processInputs()
+    mapper.reset();
+    runPaced("midi_mapper_process_inputs", BENCH_PACED_TICKS,
+             [&](uint32_t tick) {
+                 processor.update(scriptedFrame(tick));
+                 #ifndef ARM_DWT_CYCCNT
+                 sim::midiOutput().clear();
+                 #endif
+             },
+             [&](uint32_t) { mapper.processInputs(); });
+
+    runLoop("midi_mapper_idle", 100000, [&](uint32_t) { mapper.processInputs(); });
+}
+
+// ===== PORTAL =====
+
+struct PortalBenchAccess {
+    typedef void (PortalController::*Program)();
+
+    static constexpr Program PROGRAMS[PORTAL_PROGRAM_COUNT] = {
+        &PortalController::updateSpiral, &PortalController::updatePulse,
+        &PortalController::updateWave, &PortalController::updateChaos,
+        &PortalController::updateAmbient, &PortalController::updateIdle,
+        &PortalController::updateRipple, &PortalController::updateRainbow,
+        &PortalController::updatePlasma, &PortalController::updateBreathe
+    };
+
+    static void run(PortalController& portal, uint8_t program) { (portal.*PROGRAMS[program])(); }
+
+    // Flash plus every ripple slot; triggerRipple() skips slots already running
+    static void triggerAllEffects(PortalController& portal) {
+        portal.triggerFlash();
+        for (uint8_t r = 0; r < PortalController::MAX_RIPPLES; r++) {
+            portal.triggerRipple(r * LED_COUNT / PortalController::MAX_RIPPLES);
+        }
+    }
+
+    static void applyInteractionEffects(PortalController& portal) { portal.applyInteractionEffects(); }
+};
+
+constexpr PortalBenchAccess::Program PortalBenchAccess::PROGRAMS[];
+
+static void benchPortal() {
+    static CRGB leds[LED_COUNT];
+    static const char* const NAMES[PORTAL_PROGRAM_COUNT] = {
+        "portal_update_spiral", "portal_update_pulse", "portal_update_wave",
+        "portal_update_chaos", "portal_update_ambient", "portal_update_idle",
+        "portal_update_ripple", "portal_update_rainbow", "portal_update_plasma",
+        "portal_update_breathe"
+    };
+
+    PortalController portal;
+    portal.begin(leds);
+
+    for (uint8_t program = 0; program < PORTAL_PROGRAM_COUNT; program++) {
+        portal.setProgram(program);
+        runLoop(NAMES[program], 2000, [&](uint32_t) {
+            PortalBenchAccess::run(portal, program);
+            benchElapse(PORTAL_FRAME_INTERVAL_US);
+        });
+    }
+
+    // Worst case: flash and all ripples active on every frame
+    runLoop("portal_apply_effects", 2000, [&](uint32_t i) {
+        if ((i & 63) == 0) PortalBenchAccess::triggerAllEffects(portal);
+        PortalBenchAccess::applyInteractionEffects(portal);
+    });
+
+    // Whole frame: clear, phase update, program, effects
+    portal.setProgram(PORTAL_PLASMA);
+    runLoop("portal_update_frame", 2000, [&](uint32_t) {
+        portal.update();
+        benchElapse(PORTAL_FRAME_INTERVAL_US);
+    });
+
+    // Current estimate and limit of that frame (flash on, so it limits)
+    LedPowerLimiter power;
+    power.configure(255, LED_POWER_BUDGET_MA);
+    PortalBenchAccess::triggerAllEffects(portal);
+    PortalBenchAccess::applyInteractionEffects(portal);
+    runLoop("led_power_update", 20000, [&](uint32_t) {
+        benchSink = power.update(leds, LED_COUNT);
+    });
+}
+
+// ===== SERIAL PROTOCOL =====
+
+static void benchProtocol() {
+    // A Pi cue burst: program, BPM, intensity, hue, brightness, ripple frames
+    static const PortalSerialCommand COMMANDS[] = {
+        PortalSerialCommand::SET_PROGRAM, PortalSerialCommand::SET_BPM,
+        PortalSerialCommand::SET_INTENSITY, PortalSerialCommand::SET_HUE,
+        PortalSerialCommand::SET_BRIGHTNESS, PortalSerialCommand::TRIGGER_RIPPLE
+    };
+    constexpr uint8_t FRAME_COUNT = sizeof(COMMANDS) / sizeof(COMMANDS[0]);
+    static uint8_t stream[FRAME_COUNT * PORTAL_MSG_MIN_SIZE];
+    for (uint8_t f = 0; f < FRAME_COUNT; f++) {
+        PortalMessage(COMMANDS[f], f * 37).toBytes(stream + f * PORTAL_MSG_MIN_SIZE);
+    }
+
+    PortalCueHandler handler;
+    PortalMessage message;
+    runLoop("protocol_receive_byte", 60000, [&](uint32_t i) {
+        benchSink = handler.receiveByte(stream[i % sizeof(stream)], message);
+    });
+}
+
+// ===== EVENT LOG =====
+
+static void benchEventLog() {
+    // What a hot-path LOG_EVENT costs, stored and filtered out by level
+    static EventLog log;
+    log.setLevel(LOG_INFO);
+    runLoop("event_log_write", 200000, [&](uint32_t i) {
+        log.write(LOG_MIDI_POT_CC, i & 7, 20 + (i & 7), i & 127);
+    });
+    runLoop("event_log_filtered", 200000, [&](uint32_t i) {
+        log.write(LOG_INPUT_POT, i & 7, i & 1023, i & 127);
+    });
+}
+
+// ===== RULE ENGINE =====
+
+static void benchRules() {
+    // RULES_MAX rules spread over every input, none firing (a program that
+    // is never current), so only matching is timed
+    static Rule table[RULES_MAX];
+    static RuleEngine engine;
+    const uint8_t sizes[RULE_SOURCE_COUNT] = {BUTTON_COUNT, POT_COUNT, 4, SWITCH_COUNT};
+    uint16_t count = 0;
+    while (count < RULES_MAX) {
+        const uint8_t source = count % RULE_SOURCE_COUNT;
+        const uint8_t index = (count / RULE_SOURCE_COUNT) % (sizes[source] + 1);
+        table[count++] = {source, index < sizes[source] ? index : RULE_ANY_INDEX, RULE_ON_CHANGE,
+                          RULE_OPERAND_CONST, RULE_IF_PROGRAM, 0x7F, RULE_DO_FLASH, 0, 0};
+    }
+    engine.load(table, count);
+    runLoop("rules_match_256", 100000, [&](uint32_t i) {
+        const uint8_t source = i % RULE_SOURCE_COUNT;
+        benchSink = engine.handleEvent({source, (uint8_t)((i / RULE_SOURCE_COUNT) % sizes[source]), 127, true});
+    });
+
+    // Worst case: the input's group and its "any index" group both full
+    count = 0;
+    for (uint8_t i = 0; i < 2 * RULES_MAX_PER_INPUT; i++) {
+        table[count++] = {RULE_SRC_BUTTON, i < RULES_MAX_PER_INPUT ? (uint8_t)0 : RULE_ANY_INDEX, RULE_ON_CHANGE,
+                          RULE_OPERAND_CONST, RULE_IF_PROGRAM, 0x7F, RULE_DO_FLASH, 0, 0};
+    }
+    engine.load(table, count);
+    runLoop("rules_match_worst", 100000, [&](uint32_t i) {
+        benchSink = engine.handleEvent({RULE_SRC_BUTTON, 0, 127, (i & 1) != 0});
+    });
+}
+
+// ===== OLED =====
+
+static void benchOled() {
+    static const char* const NAMES[OledDisplay::MODE_COUNT] = {
+        "oled_render_midi_log", "oled_render_status", "oled_render_activity",
+        "oled_render_info", "oled_render_perf"
+    };
+
+    static OledDisplay oled;
+    static PerfMonitor perf;
+    if (!oled.begin()) {
+        char line[96];
+        snprintf(line, sizeof(line), "{\"bench\":\"oled_render\",\"target\":\"%s\",\"error\":\"no display\"}",
+                 BENCH_TARGET);
+        benchPrint(line);
+        return;
+    }
+
+    // Let the splash expire, then fill every screen with typical content
+    #ifdef ARM_DWT_CYCCNT
+    delay(OLED_SPLASH_MS);
+    #else
+    sim::advanceMicros(OLED_SPLASH_MS * 1000UL);
+    #endif
+    oled.setPerfMonitor(&perf);
+    for (uint8_t i = 0; i < 6; i++) {
+        oled.logMidiNoteOn(60 + i, 100, 1);
+        oled.logMidiCC(POT_CCS[i % POT_COUNT], i * 20, 1);
+    }
+    const bool buttons[BUTTON_COUNT] = {true, false, true, false, false, true, true, false, false, true};
+    const uint8_t pots[POT_COUNT] = {12, 64, 127, 0};
+    const bool switches[SWITCH_COUNT] = {true, false, true, true, false, false, true, false, true, false, false, true};
+    const bool joystick[4] = {true, false, false, true};
+    oled.updateInputStatus(buttons, pots, switches, joystick);
+    oled.setActivity(0x0155, 0x05, 0x0A5A);
+    oled.updateSystemInfo(245, false, 3723000);
+
+    for (uint8_t mode = 0; mode < OledDisplay::MODE_COUNT; mode++) {
+        oled.setMode(static_cast<OledDisplay::DisplayMode>(mode));
+        runLoop(NAMES[mode], 2000, [&](uint32_t) { benchSink = oled.beginFrame(); });
+    }
+}
+
+// ===== SUITE =====
+
+static void runSuite() {
+    char line[128];
+    snprintf(line, sizeof(line), "{\"suite\":\"hot_paths\",\"target\":\"%s\",\"unit\":\"%s\",\"cpu_hz\":%lu}",
+             BENCH_TARGET, BENCH_UNIT,
+             #ifdef ARM_DWT_CYCCNT
+             (unsigned long)F_CPU_ACTUAL
+             #else
+             0UL
+             #endif
+             );
+    benchPrint(line);
+
+    benchCount = 0;
+    benchInputs();
+    benchPortal();
+    benchProtocol();
+    benchEventLog();
+    benchRules();
+    benchOled();
+
+    snprintf(line, sizeof(line), "{\"suite\":\"hot_paths\",\"done\":true,\"benches\":%u}", benchCount);
+    benchPrint(line);
+}
+
+#ifdef ARM_DWT_CYCCNT
+void setup() {
+    // Cycle counter on (StageProfiler::begin() does the same)
+    ARM_DEMCR |= ARM_DEMCR_TRCENA;
+    ARM_DWT_CTRL |= ARM_DWT_CTRL_CYCCNTENA;
+
+    while (!Serial && millis() < 4000) {}
+    runSuite();
+}
+
+void loop() {
+    // Any byte from the host runs the suite again
+    if (Serial.available()) {
+        while (Serial.available()) Serial.read();
+        runSuite();
+    }
+}
+#else
+int main() {
+    sim::reset();
+    sim::setMicros(1000000);
+    runSuite();
+    return 0;
+}
+#endif
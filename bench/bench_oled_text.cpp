@@ -0,0 +1,307 @@
+/**
+ * @brief Host benchmark: Adafruit GFX text path vs OledTextRenderer
+ *
+ * Renders the MIDI_LOG, STATUS and INFO screens into a 128x64 SSD1306-style
+ * page buffer two ways and reports the time per screen:
+ *
+ *   gfx  - stand-in for Adafruit_GFX/Adafruit_SSD1306 text output:
+ *          printf -> vsnprintf -> write() per char -> drawChar() ->
+ *          virtual writePixel()/drawPixel() per set pixel
+ *   blit - OledTextRenderer OR-ing glyph columns into the page buffer
+ *
+ * Both paths share the same font table and must produce identical buffers.
+ *
+ * Build & run: make bench-host
+ */
+
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <stdint.h>
+#include "oled_text.h"
+
+static constexpr int WIDTH = 128;
+static constexpr int HEIGHT = 64;
+static constexpr int BUFFER_SIZE = WIDTH * HEIGHT / 8;
+
+// ===== FRAMEBUFFER STAND-IN FOR THE ADAFRUIT GFX TEXT PATH =====
+
+class GfxFramebuffer {
+public:
+    explicit GfxFramebuffer(uint8_t* buffer) : buffer(buffer), cursorX(0), cursorY(0) {}
+    virtual ~GfxFramebuffer() {}
+
+    // Adafruit_SSD1306::drawPixel: bounds check, rotation switch, bit set
+    virtual void drawPixel(int16_t x, int16_t y, uint16_t color) {
+        if ((x >= 0) && (x < WIDTH) && (y >= 0) && (y < HEIGHT)) {
+            switch (rotation) {
+                case 1: { int16_t t = x; x = WIDTH - y - 1; y = t; } break;
+                case 2: x = WIDTH - x - 1; y = HEIGHT - y - 1; break;
+                case 3: { int16_t t = x; x = y; y = HEIGHT - t - 1; } break;
+            }
+            if (color) buffer[x + (y / 8) * WIDTH] |= (1 << (y & 7));
+            else       buffer[x + (y / 8) * WIDTH] &= ~(1 << (y & 7));
+        }
+    }
+    virtual void startWrite() {}
+    virtual void endWrite() {}
+    virtual void writePixel(int16_t x, int16_t y, uint16_t color) { drawPixel(x, y, color); }
+
+    // Adafruit_GFX::drawChar (classic font, size 1, transparent background)
+    void drawChar(int16_t x, int16_t y, unsigned char c) {
+        if ((x >= WIDTH) || (y >= HEIGHT) || ((x + 6 - 1) < 0) || ((y + 8 - 1) < 0)) return;
+        if (c < 0x20 || c > 0x7E) c = '?';
+        startWrite();
+        for (int8_t i = 0; i < 5; i++) {
+            uint8_t line = OLED_FONT_5X7[(c - 0x20) * 5 + i];
+            for (int8_t j = 0; j < 8; j++, line >>= 1) {
+                if (line & 1) writePixel(x + i, y + j, 1);
+            }
+        }
+        endWrite();
+    }
+
+    // Adafruit_GFX::write (Print interface), with text wrap enabled
+    virtual size_t write(uint8_t c) {
+        if (c == '\n') {
+            cursorX = 0;
+            cursorY += 8;
+        } else if (c != '\r') {
+            if ((cursorX + 6) > WIDTH) {
+                cursorX = 0;
+                cursorY += 8;
+            }
+            drawChar(cursorX, cursorY, c);
+            cursorX += 6;
+        }
+        return 1;
+    }
+
+    // Print::write(buffer) / print / printf
+    size_t write(const char* str, size_t size) {
+        size_t n = 0;
+        while (size--) n += write((uint8_t)*str++);
+        return n;
+    }
+    size_t print(const char* str) { return write(str, strlen(str)); }
+    size_t printf(const char* format, ...) {
+        char buf[64];
+        va_list args;
+        va_start(args, format);
+        int len = vsnprintf(buf, sizeof(buf), format, args);
+        va_end(args);
+        return write(buf, len < (int)sizeof(buf) ? len : sizeof(buf) - 1);
+    }
+    void setCursor(int16_t x, int16_t y) { cursorX = x; cursorY = y; }
+
+    uint8_t rotation = 0;
+
+private:
+    uint8_t* buffer;
+    int16_t cursorX;
+    int16_t cursorY;
+};
+
+// ===== SCREEN CONTENT =====
+
+struct ScreenData {
+    const char* midiLog[6];
+    uint32_t midiAge[6];
+    bool buttons[10];
+    uint8_t pots[4];
+    bool switches[12];
+    bool joystick[4];
+    uint32_t loopTimeUs;
+    uint32_t uptime;
+};
+
+static const ScreenData DATA = {
+    {"NoteOn C4 V100 Ch1", "CC1=64 Ch1", "NoteOff D#4 V0 Ch1", "CC20=127 Ch1", "CC50=5 Ch1", "CC2=3 Ch1"},
+    {400, 1200, 2500, 3100, 8000, 12000},
+    {true, false, true, false, false, true, true, false, false, true},
+    {12, 64, 127, 0},
+    {true, false, true, true, false, false, true, false, true, false, false, true},
+    {true, false, false, true},
+    245,
+    3723000
+};
+
+// ===== LEGACY RENDERING (mirrors the pre-blitter OledDisplay code) =====
+
+static void gfxHeader(GfxFramebuffer& gfx, const char* name) {
+    gfx.setCursor(0, 0);
+    gfx.print(name);
+    gfx.setCursor(80, 0);
+    gfx.printf("(%d/%d)", 1, 4);
+}
+
+static void gfxMidiLog(GfxFramebuffer& gfx) {
+    gfxHeader(gfx, "MIDI LOG");
+    int y = 16;
+    for (int i = 0; i < 6; i++) {
+        gfx.setCursor(0, y);
+        if (DATA.midiAge[i] < 10000) {
+            gfx.printf("%ds %s", (int)(DATA.midiAge[i] / 1000), DATA.midiLog[i]);
+        } else {
+            gfx.print(DATA.midiLog[i]);
+        }
+        y += 8;
+    }
+}
+
+static void gfxStatus(GfxFramebuffer& gfx) {
+    gfxHeader(gfx, "STATUS");
+    gfx.setCursor(0, 16);
+    gfx.print("Btns:");
+    for (int i = 0; i < 10; i++) {
+        if (i == 5) {
+            gfx.setCursor(0, 24);
+            gfx.print("     ");
+        }
+        gfx.print(DATA.buttons[i] ? "1" : "0");
+    }
+    gfx.setCursor(0, 32);
+    gfx.printf("Pots: %d %d %d %d", DATA.pots[0], DATA.pots[1], DATA.pots[2], DATA.pots[3]);
+    gfx.setCursor(0, 40);
+    gfx.print("Switches:");
+    gfx.setCursor(0, 48);
+    for (int i = 0; i < 12; i++) {
+        gfx.print(DATA.switches[i] ? "1" : "0");
+        if (i == 7) gfx.setCursor(0, 56);
+    }
+    gfx.setCursor(80, 48);
+    gfx.printf("Joy:%s%s%s%s",
+               DATA.joystick[0] ? "U" : "", DATA.joystick[1] ? "D" : "",
+               DATA.joystick[2] ? "L" : "", DATA.joystick[3] ? "R" : "");
+}
+
+static void gfxInfo(GfxFramebuffer& gfx) {
+    gfxHeader(gfx, "INFO");
+    gfx.setCursor(0, 16);
+    gfx.printf("Loop: %luus", (unsigned long)DATA.loopTimeUs);
+    gfx.setCursor(0, 24);
+    gfx.printf("State: %s", "ACTIVE");
+    gfx.setCursor(0, 32);
+    uint32_t s = DATA.uptime / 1000;
+    gfx.printf("Uptime: %lum%lus", (unsigned long)(s / 60), (unsigned long)(s % 60));
+    gfx.setCursor(0, 40);
+    gfx.printf("Mode: %d/%d", 4, 4);
+    gfx.setCursor(0, 48);
+    gfx.print("MIDI Log Mode");
+    gfx.setCursor(0, 56);
+    gfx.print("USB: MIDI");
+}
+
+// ===== BLITTER RENDERING (mirrors the current OledDisplay code) =====
+
+static void blitHeader(OledTextRenderer& text, const char* name) {
+    text.drawString(0, 0, name);
+    int16_t x = text.drawChar(80, 0, '(');
+    x = text.drawUInt(x, 0, 1);
+    x = text.drawChar(x, 0, '/');
+    x = text.drawUInt(x, 0, 4);
+    text.drawChar(x, 0, ')');
+}
+
+static void blitMidiLog(OledTextRenderer& text) {
+    blitHeader(text, "MIDI LOG");
+    int y = 16;
+    for (int i = 0; i < 6; i++) {
+        int16_t x = 0;
+        if (DATA.midiAge[i] < 10000) {
+            x = text.drawUInt(x, y, DATA.midiAge[i] / 1000);
+            x = text.drawString(x, y, "s ");
+        }
+        text.drawString(x, y, DATA.midiLog[i]);
+        y += 8;
+    }
+}
+
+static void blitStatus(OledTextRenderer& text) {
+    blitHeader(text, "STATUS");
+    int16_t x = text.drawString(0, 16, "Btns:");
+    for (int i = 0; i < 10; i++) {
+        text.drawChar(x + (i % 5) * 6, (i < 5) ? 16 : 24, DATA.buttons[i] ? '1' : '0');
+    }
+    x = text.drawString(0, 32, "Pots:");
+    for (int i = 0; i < 4; i++) {
+        x = text.drawChar(x, 32, ' ');
+        x = text.drawUInt(x, 32, DATA.pots[i]);
+    }
+    text.drawString(0, 40, "Switches:");
+    for (int i = 0; i < 12; i++) {
+        text.drawChar((i % 8) * 6, (i < 8) ? 48 : 56, DATA.switches[i] ? '1' : '0');
+    }
+    x = text.drawString(80, 48, "Joy:");
+    if (DATA.joystick[0]) x = text.drawChar(x, 48, 'U');
+    if (DATA.joystick[1]) x = text.drawChar(x, 48, 'D');
+    if (DATA.joystick[2]) x = text.drawChar(x, 48, 'L');
+    if (DATA.joystick[3]) x = text.drawChar(x, 48, 'R');
+}
+
+static void blitInfo(OledTextRenderer& text) {
+    blitHeader(text, "INFO");
+    int16_t x = text.drawString(0, 16, "Loop: ");
+    x = text.drawUInt(x, 16, DATA.loopTimeUs);
+    text.drawString(x, 16, "us");
+    x = text.drawString(0, 24, "State: ");
+    text.drawString(x, 24, "ACTIVE");
+    uint32_t s = DATA.uptime / 1000;
+    x = text.drawString(0, 32, "Uptime: ");
+    x = text.drawUInt(x, 32, s / 60);
+    x = text.drawChar(x, 32, 'm');
+    x = text.drawUInt(x, 32, s % 60);
+    text.drawChar(x, 32, 's');
+    x = text.drawString(0, 40, "Mode: ");
+    x = text.drawUInt(x, 40, 4);
+    x = text.drawChar(x, 40, '/');
+    text.drawUInt(x, 40, 4);
+    text.drawString(0, 48, "MIDI Log Mode");
+    text.drawString(0, 56, "USB: MIDI");
+}
+
+// ===== BENCH HARNESS =====
+
+static constexpr int ITERATIONS = 20000;
+
+template <typename Render>
+static double timeScreen(uint8_t* buffer, Render render) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        memset(buffer, 0, BUFFER_SIZE);  // display.clearDisplay()
+        render();
+        asm volatile("" : : "r"(buffer) : "memory");
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / ITERATIONS;
+}
+
+int main() {
+    static uint8_t gfxBuffer[BUFFER_SIZE];
+    static uint8_t blitBuffer[BUFFER_SIZE];
+    GfxFramebuffer gfx(gfxBuffer);
+    OledTextRenderer text(blitBuffer, WIDTH, HEIGHT);
+
+    struct Screen {
+        const char* name;
+        void (*gfxRender)(GfxFramebuffer&);
+        void (*blitRender)(OledTextRenderer&);
+    } screens[] = {
+        {"MIDI_LOG", gfxMidiLog, blitMidiLog},
+        {"STATUS", gfxStatus, blitStatus},
+        {"INFO", gfxInfo, blitInfo},
+    };
+
+    int failures = 0;
+    printf("%-10s %12s %12s %8s  %s\n", "screen", "gfx ns", "blit ns", "speedup", "pixels");
+    for (const Screen& screen : screens) {
+        double gfxNs = timeScreen(gfxBuffer, [&] { screen.gfxRender(gfx); });
+        double blitNs = timeScreen(blitBuffer, [&] { screen.blitRender(text); });
+        bool identical = memcmp(gfxBuffer, blitBuffer, BUFFER_SIZE) == 0;
+        if (!identical) failures++;
+        printf("%-10s %12.0f %12.0f %7.1fx  %s\n", screen.name, gfxNs, blitNs,
+               gfxNs / blitNs, identical ? "identical" : "MISMATCH");
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,680 @@
+/**
+ * @brief Input-to-MIDI latency and traffic sweep over the input tuning
+ *
+ * Injects synthetic gestures with known timing into RobustInputProcessor ->
+ * RobustMidiMapper and times the MIDI they produce, for every combination of
+ * scan rate, debounce window and pot rate limit:
+ *
+ *   presses - a button goes down at a random point of the scan period with
+ *             --bounce ms of contact chatter, holds, and is released the same
+ *             way. Latency is contact edge -> Note On / Note Off. "lost"
+ *             presses sent no Note On; "extra" Note Ons are chatter that got
+ *             through the debouncer.
+ *   sweeps  - a pot travels end to end in --sweep-ms with reading noise, then
+ *             rests there. first = movement start -> first CC, tail =
+ *             movement end -> last CC, err = MIDI steps between the last CC
+ *             and the end stop, cc/sw = messages per sweep.
+ *   jitter  - all pots rest mid-travel with reading noise; cc/s is the
+ *             traffic the noise alone produces.
+ *
+ * The scan rate is swept by running the pipeline once per period, as the
+ * scheduler does for SCAN_HZ (a row applies to a build with that SCAN_HZ);
+ * debounce and rate limit go through applyConfig(), as runtime tuning does.
+ *
+ * One source, two targets (like bench_hot_paths.cpp):
+ *
+ *   host     - make latency-sweep. Virtual clock, all three gesture kinds,
+ *              a table (or --json lines). Latency is the algorithmic part:
+ *              scan quantization, debounce, rate limit, filter lag.
+ *   teensy41 - the teensy41-latency environment (make latency-device). Jumper
+ *              LATENCY_LOOPBACK_PIN to button 0: the harness drives the chatter
+ *              on that pin in real time and the real scanner reads it, so pin
+ *              reads and pipeline cost are included. Presses only (there is no
+ *              DAC to drive a pot), JSON lines over USB serial.
+ *
+ * Host options:
+ *   --scan-hz LIST --debounce LIST --rate-limit LIST   comma separated
+ *   --pot-deadband N --presses N --bounce MS --hold MS
+ *   --sweeps N --sweep-ms MS --noise N --seed N --json
+ *
+ * Stimulus timing comes from a fixed-seed generator, so runs are repeatable.
+ */
+
+#include <Arduino.h>
+#include <algorithm>
+#include "config.h"
+#include "pins.h"
+#include "input_trace.h"
+#include "robust_input_processor.h"
+#include "robust_midi_mapper.h"
+#include "midi_out.h"
+#include "config_store.h"
+
+#if STATIC_INPUT_PIPELINE > 0
+#error "latency_sweep drives RobustInputProcessor with frames; build with STATIC_INPUT_PIPELINE=0"
+#endif
+
+namespace {
+
+enum : uint8_t {
+    LATENCY_NOTE_OFF = 0x80,
+    LATENCY_NOTE_ON = 0x90,
+    LATENCY_CONTROL_CHANGE = 0xB0
+};
+
+constexpr uint16_t MAX_SAMPLES = 1000;
+constexpr uint8_t MAX_VALUES = 8;           // Per swept parameter
+constexpr uint32_t TRIAL_GAP_MIN_US = 50000;
+constexpr uint32_t SWEEP_REST_US = 600000;
+constexpr uint32_t JITTER_SETTLE_US = 500000;
+constexpr uint32_t CHATTER_SLOT_US = 250;   // Chatter changes level at most this often
+constexpr uint16_t POT_REST = 512;
+
+struct SweepPoint {
+    uint16_t scanHz;
+    uint8_t debounceMs;
+    uint8_t rateLimitMs;
+};
+
+struct Stimulus {
+    uint16_t presses = 200;
+    uint8_t bounceMs = 3;
+    uint16_t holdMs = 80;
+    uint16_t sweeps = 16;
+    uint16_t sweepMs = 250;
+    uint8_t noise = 3;
+    uint16_t jitterMs = 2000;
+    uint8_t deadband = POT_DEADBAND;
+    uint32_t seed = 1;
+};
+
+struct SweepGrid {
+    uint16_t scanHz[MAX_VALUES];
+    uint8_t scanHzCount;
+    uint8_t debounceMs[MAX_VALUES];
+    uint8_t debounceCount;
+    uint8_t rateLimitMs[MAX_VALUES];
+    uint8_t rateLimitCount;
+};
+
+class LatencySamples {
+public:
+    void clear() { count = 0; sorted = true; }
+    void add(uint32_t us) {
+        if (count < MAX_SAMPLES) values[count++] = us;
+        sorted = false;
+    }
+
+    // Nearest-rank percentile; 0 when empty
+    uint32_t percentile(uint8_t pct) {
+        if (count == 0) return 0;
+        if (!sorted) {
+            std::sort(values, values + count);
+            sorted = true;
+        }
+        uint32_t rank = ((uint32_t)pct * count + 99) / 100;
+        return values[rank ? rank - 1 : 0];
+    }
+
+private:
+    uint32_t values[MAX_SAMPLES];
+    uint16_t count = 0;
+    bool sorted = true;
+};
+
+struct PointResult {
+    SweepPoint point;
+    uint16_t presses;
+    uint16_t lost;
+    uint16_t extra;
+    uint32_t pressP50, pressP99, pressMax;
+    uint32_t releaseP50, releaseP99;
+    uint16_t sweeps;
+    uint32_t firstP50;
+    uint32_t tailP50, tailMax;
+    uint8_t maxErr;
+    float ccPerSweep;
+    float jitterCcPerSec;
+};
+
+uint32_t rngState = 1;
+
+uint32_t nextRandom() {
+    rngState = rngState * 1664525 + 1013904223;
+    return rngState >> 8;
+}
+
+// Stateless hash, so a level or reading at time t is the same however
+// often it is looked at (the device samples the stimulus in a spin loop)
+uint32_t mix(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7FEB352D;
+    x ^= x >> 15;
+    x *= 0x846CA68B;
+    x ^= x >> 16;
+    return x;
+}
+
+bool chatter(uint32_t seed, uint32_t tUs) {
+    return mix(seed ^ (tUs / CHATTER_SLOT_US)) & 1;
+}
+
+uint16_t noisyReading(int32_t value, uint8_t noise, uint32_t seed, uint32_t tUs) {
+    if (noise) value += (int32_t)(mix(seed ^ (tUs * 2654435761u)) % (2 * noise + 1)) - noise;
+    return constrain(value, 0L, 1023L);
+}
+
+// ===== SCENES =====
+// A scene is the stimulus for one trial: the raw inputs at any time, and
+// what the MIDI it produced says about it
+
+struct PressScene {
+    uint8_t button;
+    uint32_t pressUs;
+    uint32_t releaseUs;
+    uint32_t bounceUs;
+    uint32_t seed;
+    uint16_t pots[POT_COUNT];
+
+    uint16_t noteOns = 0;
+    bool haveRelease = false;
+    uint32_t onUs = 0;
+    uint32_t offUs = 0;
+
+    RawInputFrame frameAt(uint32_t tUs) const {
+        bool level = false;
+        if (tUs >= pressUs && tUs < releaseUs) {
+            level = tUs - pressUs < bounceUs ? chatter(seed, tUs) : true;
+        } else if (tUs >= releaseUs && tUs - releaseUs < bounceUs) {
+            level = chatter(~seed, tUs);
+        }
+        RawInputFrame frame = {};
+        frame.buttons = level ? 1 << button : 0;
+        for (uint8_t i = 0; i < POT_COUNT; i++) frame.pots[i] = pots[i];
+        return frame;
+    }
+
+    void onMidi(uint8_t type, uint8_t data1, uint8_t, uint32_t tUs) {
+        if (data1 != BUTTON_NOTES[button]) return;
+        if (type == LATENCY_NOTE_ON) {
+            if (noteOns++ == 0) onUs = tUs;
+        } else if (type == LATENCY_NOTE_OFF && tUs >= releaseUs && !haveRelease) {
+            haveRelease = true;
+            offUs = tUs;
+        }
+    }
+};
+
+struct SweepScene {
+    uint8_t pot;
+    uint16_t from;
+    uint16_t to;
+    uint32_t startUs;
+    uint32_t sweepUs;
+    uint8_t noise;
+    uint32_t seed;
+    uint16_t pots[POT_COUNT];
+
+    uint16_t ccs = 0;
+    uint32_t firstUs = 0;
+    uint32_t lastUs = 0;
+    uint8_t lastValue = 0;
+
+    RawInputFrame frameAt(uint32_t tUs) const {
+        int32_t value = to;
+        if (tUs < startUs) {
+            value = from;
+        } else if (tUs - startUs < sweepUs) {
+            value = from + ((int32_t)to - from) * (int32_t)(tUs - startUs) / (int32_t)sweepUs;
+        }
+        RawInputFrame frame = {};
+        for (uint8_t i = 0; i < POT_COUNT; i++) frame.pots[i] = pots[i];
+        frame.pots[pot] = noisyReading(value, noise, seed, tUs);
+        return frame;
+    }
+
+    void onMidi(uint8_t type, uint8_t data1, uint8_t data2, uint32_t tUs) {
+        if (type != LATENCY_CONTROL_CHANGE || data1 != POT_CCS[pot] || tUs < startUs) return;
+        if (ccs++ == 0) firstUs = tUs;
+        lastUs = tUs;
+        lastValue = data2;
+    }
+};
+
+struct JitterScene {
+    uint32_t countFromUs;
+    uint8_t noise;
+    uint32_t seed;
+
+    uint32_t ccs = 0;
+
+    RawInputFrame frameAt(uint32_t tUs) const {
+        RawInputFrame frame = {};
+        for (uint8_t i = 0; i < POT_COUNT; i++) {
+            frame.pots[i] = noisyReading(POT_REST, noise, seed + i, tUs);
+        }
+        return frame;
+    }
+
+    void onMidi(uint8_t type, uint8_t data1, uint8_t, uint32_t tUs) {
+        if (type != LATENCY_CONTROL_CHANGE || tUs < countFromUs) return;
+        for (uint8_t i = 0; i < POT_COUNT; i++) {
+            if (data1 == POT_CCS[i]) ccs++;
+        }
+    }
+};
+
+// ===== PIPELINE UNDER TEST =====
+
+RobustInputProcessor processor;
+MidiOut midiOut;
+RobustMidiMapper mapper(processor, midiOut);
+
+void applyPoint(const SweepPoint& point, const Stimulus& stimulus) {
+    RuntimeConfig config = ConfigStore::defaults();
+    config.debounceMs = point.debounceMs;
+    config.potRateLimitMs = point.rateLimitMs;
+    config.potDeadband = stimulus.deadband;
+    processor.applyConfig(config);
+}
+
+// ===== TARGET CLOCK AND OUTPUT =====
+// Times are microseconds since the start of a sweep point. Scan passes run
+// on a fixed grid of the point's scan period.
+
+#ifdef ARM_DWT_CYCCNT
+const char* const LATENCY_TARGET = "teensy41";
+constexpr uint8_t PRESS_BUTTONS = 1;        // Only button 0 has the loopback
+
+uint32_t pointStartUs;
+bool loopbackPressed;
+
+void startPoint(const RawInputFrame&) {
+    pinMode(LATENCY_LOOPBACK_PIN, OUTPUT);
+    digitalWriteFast(LATENCY_LOOPBACK_PIN, HIGH);  // Released (active low)
+    delay(50);
+
+    // Pots are whatever the hardware reads
+    RawInputFrame frame;
+    processor.update();
+    processor.getRawFrame(frame);
+    processor.restart(frame);
+    mapper.reset();
+    loopbackPressed = false;
+    pointStartUs = micros();
+}
+
+// Drive the loopback pin until the tick, then scan the real pins
+template <typename Scene>
+void scanPass(Scene& scene, uint32_t tickUs) {
+    uint32_t nowUs;
+    while ((int32_t)((nowUs = micros() - pointStartUs) - tickUs) < 0) {
+        const bool pressed = scene.frameAt(nowUs).buttons & 1;
+        digitalWriteFast(LATENCY_LOOPBACK_PIN, pressed ? LOW : HIGH);
+    }
+    processor.update();
+    mapper.processInputs();
+
+    // The mapper sends a note exactly when the debounced state changes
+    const bool pressed = processor.getButtonState(0);
+    if (pressed != loopbackPressed) {
+        loopbackPressed = pressed;
+        scene.onMidi(pressed ? LATENCY_NOTE_ON : LATENCY_NOTE_OFF, BUTTON_NOTES[0], 0,
+                     micros() - pointStartUs);
+    }
+}
+
+void latencyPrint(const char* line) { Serial.println(line); }
+#else
+const char* const LATENCY_TARGET = "host";
+constexpr uint8_t PRESS_BUTTONS = BUTTON_COUNT;
+
+// Start away from zero so rate-limit windows measured from zero are open
+constexpr uint64_t LATENCY_START_US = 1000000;
+
+void startPoint(const RawInputFrame& rest) {
+    sim::reset();
+    sim::setMicros(LATENCY_START_US);
+    processor.restart(rest);
+    mapper.reset();
+}
+
+template <typename Scene>
+void scanPass(Scene& scene, uint32_t tickUs) {
+    sim::setMicros(LATENCY_START_US + tickUs);
+    processor.update(scene.frameAt(tickUs));
+    mapper.processInputs();
+
+    // The clock stands still during the pass: MIDI goes out at the tick
+    std::vector<sim::MidiEvent>& sent = sim::midiOutput();
+    for (const sim::MidiEvent& event : sent) {
+        scene.onMidi(event.type, event.data1, event.data2, tickUs);
+    }
+    sent.clear();
+}
+
+bool jsonOutput = false;
+
+void latencyPrint(const char* line) { printf("%s\n", line); }
+#endif
+
+template <typename Scene>
+void runScene(Scene& scene, uint32_t periodUs, uint32_t fromUs, uint32_t toUs) {
+    for (uint32_t tick = (fromUs + periodUs - 1) / periodUs * periodUs; tick < toUs; tick += periodUs) {
+        scanPass(scene, tick);
+    }
+}
+
+// ===== MEASUREMENT =====
+
+LatencySamples pressSamples;
+LatencySamples releaseSamples;
+LatencySamples firstSamples;
+LatencySamples tailSamples;
+
+void measurePoint(const SweepPoint& point, const Stimulus& stimulus, PointResult& result) {
+    const uint32_t periodUs = 1000000UL / point.scanHz;
+    const uint32_t bounceUs = stimulus.bounceMs * 1000UL;
+    const uint32_t gapUs = std::max<uint32_t>(TRIAL_GAP_MIN_US, point.debounceMs * 4000UL);
+
+    memset(&result, 0, sizeof(result));
+    result.point = point;
+    rngState = stimulus.seed;
+
+    RawInputFrame rest = {};
+    startPoint(rest);
+    applyPoint(point, stimulus);
+
+    pressSamples.clear();
+    releaseSamples.clear();
+    firstSamples.clear();
+    tailSamples.clear();
+
+    // Presses: edges land anywhere in the scan period
+    uint32_t cursor = 0;
+    for (uint16_t i = 0; i < stimulus.presses; i++) {
+        PressScene scene;
+        scene.button = i % PRESS_BUTTONS;
+        scene.pressUs = cursor + gapUs + nextRandom() % periodUs;
+        scene.releaseUs = scene.pressUs + stimulus.holdMs * 1000UL + nextRandom() % periodUs;
+        scene.bounceUs = bounceUs;
+        scene.seed = nextRandom();
+        for (uint8_t p = 0; p < POT_COUNT; p++) scene.pots[p] = rest.pots[p];
+
+        const uint32_t endUs = scene.releaseUs + bounceUs + gapUs;
+        runScene(scene, periodUs, cursor, endUs);
+        cursor = endUs;
+
+        result.presses++;
+        if (scene.noteOns == 0) {
+            result.lost++;
+            continue;
+        }
+        result.extra += scene.noteOns - 1;
+        pressSamples.add(scene.onUs - scene.pressUs);
+        if (scene.haveRelease) releaseSamples.add(scene.offUs - scene.releaseUs);
+    }
+
+    // Sweeps: each pot end to end and back, resting between movements
+    uint16_t position[POT_COUNT] = {};
+    uint32_t sweepCcs = 0;
+    for (uint16_t i = 0; i < stimulus.sweeps; i++) {
+        SweepScene scene;
+        scene.pot = i % POT_COUNT;
+        scene.from = position[scene.pot];
+        scene.to = scene.from ? 0 : 1023;
+        scene.startUs = cursor + gapUs + nextRandom() % periodUs;
+        scene.sweepUs = stimulus.sweepMs * 1000UL;
+        scene.noise = stimulus.noise;
+        scene.seed = nextRandom();
+        for (uint8_t p = 0; p < POT_COUNT; p++) scene.pots[p] = position[p];
+
+        const uint32_t sweepEndUs = scene.startUs + scene.sweepUs;
+        const uint32_t endUs = sweepEndUs + SWEEP_REST_US;
+        runScene(scene, periodUs, cursor, endUs);
+        cursor = endUs;
+        position[scene.pot] = scene.to;
+
+        result.sweeps++;
+        sweepCcs += scene.ccs;
+        if (scene.ccs == 0) continue;
+        firstSamples.add(scene.firstUs - scene.startUs);
+        tailSamples.add(scene.lastUs > sweepEndUs ? scene.lastUs - sweepEndUs : 0);
+        const uint8_t endStop = scene.to ? 127 : 0;
+        const uint8_t err = scene.lastValue > endStop ? scene.lastValue - endStop : endStop - scene.lastValue;
+        if (err > result.maxErr) result.maxErr = err;
+    }
+
+    // Jitter: everything at rest, noise only
+    if (stimulus.jitterMs > 0 && stimulus.noise > 0 && stimulus.sweeps > 0) {
+        JitterScene scene;
+        scene.countFromUs = cursor + JITTER_SETTLE_US;
+        scene.noise = stimulus.noise;
+        scene.seed = nextRandom();
+        const uint32_t endUs = scene.countFromUs + stimulus.jitterMs * 1000UL;
+        runScene(scene, periodUs, cursor, endUs);
+        result.jitterCcPerSec = scene.ccs * 1000.0f / stimulus.jitterMs;
+    }
+
+    result.pressP50 = pressSamples.percentile(50);
+    result.pressP99 = pressSamples.percentile(99);
+    result.pressMax = pressSamples.percentile(100);
+    result.releaseP50 = releaseSamples.percentile(50);
+    result.releaseP99 = releaseSamples.percentile(99);
+    result.firstP50 = firstSamples.percentile(50);
+    result.tailP50 = tailSamples.percentile(50);
+    result.tailMax = tailSamples.percentile(100);
+    result.ccPerSweep = result.sweeps ? (float)sweepCcs / result.sweeps : 0;
+}
+
+// ===== REPORTING =====
+
+bool isDefaultPoint(const SweepPoint& point) {
+    return point.scanHz == SCAN_HZ && point.debounceMs == DEBOUNCE_MS &&
+           point.rateLimitMs == POT_RATE_LIMIT_MS;
+}
+
+void printJsonHeader(const Stimulus& stimulus) {
+    char line[200];
+    snprintf(line, sizeof(line),
+             "{\"suite\":\"latency_sweep\",\"target\":\"%s\",\"bounce_ms\":%u,\"hold_ms\":%u,"
+             "\"sweep_ms\":%u,\"noise\":%u,\"pot_deadband\":%u,\"seed\":%lu}",
+             LATENCY_TARGET, stimulus.bounceMs, stimulus.holdMs, stimulus.sweepMs,
+             stimulus.noise, stimulus.deadband, (unsigned long)stimulus.seed);
+    latencyPrint(line);
+}
+
+void printJson(const PointResult& r) {
+    char line[480];
+    int n = snprintf(line, sizeof(line),
+             "{\"point\":\"latency\",\"target\":\"%s\",\"scan_hz\":%u,\"debounce_ms\":%u,"
+             "\"rate_limit_ms\":%u,\"presses\":%u,\"lost\":%u,\"extra\":%u,"
+             "\"press_p50_us\":%lu,\"press_p99_us\":%lu,\"press_max_us\":%lu,"
+             "\"release_p50_us\":%lu,\"release_p99_us\":%lu",
+             LATENCY_TARGET, r.point.scanHz, r.point.debounceMs, r.point.rateLimitMs,
+             r.presses, r.lost, r.extra,
+             (unsigned long)r.pressP50, (unsigned long)r.pressP99, (unsigned long)r.pressMax,
+             (unsigned long)r.releaseP50, (unsigned long)r.releaseP99);
+    if (r.sweeps > 0) {
+        n += snprintf(line + n, sizeof(line) - n,
+             ",\"sweeps\":%u,\"first_p50_us\":%lu,\"tail_p50_us\":%lu,\"tail_max_us\":%lu,"
+             "\"max_err\":%u,\"cc_per_sweep\":%.1f,\"jitter_cc_per_s\":%.2f",
+             r.sweeps, (unsigned long)r.firstP50, (unsigned long)r.tailP50,
+             (unsigned long)r.tailMax, r.maxErr, r.ccPerSweep, r.jitterCcPerSec);
+    }
+    snprintf(line + n, sizeof(line) - n, "}");
+    latencyPrint(line);
+}
+
+void printJsonDone(uint16_t points) {
+    char line[80];
+    snprintf(line, sizeof(line), "{\"suite\":\"latency_sweep\",\"done\":true,\"points\":%u}", points);
+    latencyPrint(line);
+}
+
+uint16_t runSweep(const SweepGrid& grid, const Stimulus& stimulus, void (*report)(const PointResult&)) {
+    PointResult result;
+    uint16_t points = 0;
+    for (uint8_t s = 0; s < grid.scanHzCount; s++) {
+        for (uint8_t d = 0; d < grid.debounceCount; d++) {
+            for (uint8_t r = 0; r < grid.rateLimitCount; r++) {
+                const SweepPoint point = {grid.scanHz[s], grid.debounceMs[d], grid.rateLimitMs[r]};
+                measurePoint(point, stimulus, result);
+                report(result);
+                points++;
+            }
+        }
+    }
+    return points;
+}
+
+} // namespace
+
+#ifdef ARM_DWT_CYCCNT
+// Presses through the loopback at each scan rate and debounce window; the
+// rate limit only affects pots, which the device run cannot drive
+static const SweepGrid DEVICE_GRID = {
+    {500, 1000, 2000}, 3,
+    {2, 5, 8, 12}, 4,
+    {POT_RATE_LIMIT_MS}, 1
+};
+
+static void runDeviceSweep() {
+    Stimulus stimulus;
+    stimulus.presses = 50;
+    stimulus.sweeps = 0;
+    printJsonHeader(stimulus);
+    printJsonDone(runSweep(DEVICE_GRID, stimulus, printJson));
+}
+
+void setup() {
+    while (!Serial && millis() < 4000) {}
+    processor.begin();
+    midiOut.begin();
+    runDeviceSweep();
+}
+
+void loop() {
+    // Any byte from the host runs the sweep again
+    if (Serial.available()) {
+        while (Serial.available()) Serial.read();
+        runDeviceSweep();
+    }
+}
+#else
+#include <string>
+
+namespace {
+
+template <typename T>
+bool parseList(const char* text, T* values, uint8_t& count) {
+    count = 0;
+    const char* p = text;
+    while (*p) {
+        char* end;
+        unsigned long value = strtoul(p, &end, 0);
+        if (end == p || value == 0 || count >= MAX_VALUES) return false;
+        values[count++] = (T)value;
+        p = *end == ',' ? end + 1 : end;
+        if (*end && *end != ',') return false;
+    }
+    return count > 0;
+}
+
+void printTableHeader(const Stimulus& stimulus) {
+    printf("Latency sweep: %u presses (bounce %u ms, hold %u ms), %u sweeps of %u ms, "
+           "noise +-%u, deadband %u, seed %lu\n\n",
+           stimulus.presses, stimulus.bounceMs, stimulus.holdMs, stimulus.sweeps,
+           stimulus.sweepMs, stimulus.noise, stimulus.deadband, (unsigned long)stimulus.seed);
+    printf("                 ------------ press ------------  -- release --  ------- pot sweep -------  jitter\n");
+    printf("  scan  deb rate    p50    p99    max  lost extra    p50    p99  first   tail    max err cc/sw    cc/s\n");
+    printf("    Hz   ms   ms     ms     ms     ms                 ms     ms     ms     ms     ms\n");
+}
+
+void printTableRow(const PointResult& r) {
+    auto ms = [](uint32_t us) { return us / 1000.0; };
+    printf("%c%5u %4u %4u %6.2f %6.2f %6.2f %5u %5u %6.2f %6.2f %6.2f %6.2f %6.2f %3u %5.1f %7.2f\n",
+           isDefaultPoint(r.point) ? '*' : ' ', r.point.scanHz, r.point.debounceMs, r.point.rateLimitMs,
+           ms(r.pressP50), ms(r.pressP99), ms(r.pressMax), r.lost, r.extra,
+           ms(r.releaseP50), ms(r.releaseP99),
+           ms(r.firstP50), ms(r.tailP50), ms(r.tailMax), r.maxErr, r.ccPerSweep, r.jitterCcPerSec);
+}
+
+void report(const PointResult& result) {
+    if (jsonOutput) {
+        printJson(result);
+    } else {
+        printTableRow(result);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    SweepGrid grid = {
+        {500, 1000, 2000}, 3,
+        {2, 5, 8, 12}, 4,
+        {5, 10, 15, 30}, 4
+    };
+    Stimulus stimulus;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        bool ok = true;
+        if (arg == "--json") {
+            jsonOutput = true;
+            continue;
+        } else if (!value) {
+            ok = false;
+        } else if (arg == "--scan-hz") {
+            ok = parseList(value, grid.scanHz, grid.scanHzCount);
+        } else if (arg == "--debounce") {
+            ok = parseList(value, grid.debounceMs, grid.debounceCount);
+        } else if (arg == "--rate-limit") {
+            ok = parseList(value, grid.rateLimitMs, grid.rateLimitCount);
+        } else if (arg == "--pot-deadband") {
+            stimulus.deadband = strtoul(value, nullptr, 0);
+        } else if (arg == "--presses") {
+            stimulus.presses = std::min<unsigned long>(strtoul(value, nullptr, 0), MAX_SAMPLES);
+        } else if (arg == "--bounce") {
+            stimulus.bounceMs = strtoul(value, nullptr, 0);
+        } else if (arg == "--hold") {
+            stimulus.holdMs = strtoul(value, nullptr, 0);
+        } else if (arg == "--sweeps") {
+            stimulus.sweeps = std::min<unsigned long>(strtoul(value, nullptr, 0), MAX_SAMPLES);
+        } else if (arg == "--sweep-ms") {
+            stimulus.sweepMs = std::max<unsigned long>(strtoul(value, nullptr, 0), 1);
+        } else if (arg == "--noise") {
+            stimulus.noise = strtoul(value, nullptr, 0);
+        } else if (arg == "--seed") {
+            stimulus.seed = strtoul(value, nullptr, 0);
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            fprintf(stderr, "latency_sweep: bad option %s\n"
+                            "usage: latency_sweep [--scan-hz LIST] [--debounce LIST] [--rate-limit LIST]\n"
+                            "       [--pot-deadband N] [--presses N] [--bounce MS] [--hold MS]\n"
+                            "       [--sweeps N] [--sweep-ms MS] [--noise N] [--seed N] [--json]\n",
+                    arg.c_str());
+            return 2;
+        }
+        i++;
+    }
+
+    processor.begin();
+    midiOut.begin();
+
+    if (jsonOutput) {
+        printJsonHeader(stimulus);
+        printJsonDone(runSweep(grid, stimulus, report));
+    } else {
+        printTableHeader(stimulus);
+        runSweep(grid, stimulus, report);
+        printf("\n* = config.h defaults (SCAN_HZ %u, DEBOUNCE_MS %u, POT_RATE_LIMIT_MS %u)\n",
+               SCAN_HZ, DEBOUNCE_MS, POT_RATE_LIMIT_MS);
+    }
+    return 0;
+}
+#endif
@@ -54,6 +54,14 @@ public:
      */
     void forceNextSend() { forceSend = true; }
     
+    /**
+     * @brief Change deadband and rate limit; filter state is kept
+     */
+    void setLimits(uint8_t newDeadband, uint8_t newRateLimitMs) {
+        deadband = newDeadband;
+        rateLimitMs = newRateLimitMs;
+    }
+    
     /**
      * @brief Reset filter state
      * @param initialValue Starting value (default: 0)
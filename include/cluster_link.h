@@ -0,0 +1,309 @@
+#pragma once
+
+#include <Arduino.h>
+#include "config.h"
+#include "pins.h"
+#include "flight_recorder.h"
+#include "robust_midi_mapper.h"
+#include "portal_cue_handler.h"
+#include "static_input_pipeline.h"
+
+/**
+ * @brief Several control panels playing as one instrument over a UART chain
+ *
+ *   [primary] A <-> A [secondary 1] B <-> A [secondary 2] B <-> ...
+ *
+ * Every board scans and debounces its own inputs as usual. A secondary
+ * turns each debounced edge (button, joystick pulse, switch, pot MIDI
+ * value) into an event and sends it toward the primary, frame by frame,
+ * through any boards in between. The primary merges its own events and
+ * every secondary's into one stream in timestamp order and plays it as one
+ * MIDI output through RobustMidiMapper's send*() calls: the same notes,
+ * CCs and switch snapshots as a single board, on channel
+ * MIDI_CHANNEL + node. Portal cues the primary receives (serial or OSC)
+ * are passed down the chain and applied on every board.
+ *
+ * Frame (both directions, CLUSTER_BAUD):
+ *   0xC7, type, node, length, payload, CRC-8 over type..payload
+ *   EVENTS    (up)   node = sender; u16 transit us, then per event
+ *                    u16 age us, type, index, value
+ *   ENUMERATE (down) node = the receiving board's number; each secondary
+ *                    takes it and passes node + 1 on
+ *   CUE       (down) a 5-byte portal protocol frame
+ *
+ * Boards keep their own clocks. Timestamps travel as ages: an event's age
+ * when its frame was written, plus the frame's transit time, which the
+ * sender and each forwarding board add to (bytes queued ahead and the
+ * frame itself at the wire rate, and the time the frame sat in the board).
+ * The primary subtracts both from the frame's arrival. Arrival is bounded
+ * by the poll that parses the frame (less the bytes that came in after it)
+ * and the poll before (plus the bytes read up to the frame's end); the
+ * midpoint is used, so the error is at most half a task period per hop.
+ *
+ * Merging: a secondary sends a frame at least every CLUSTER_KEEPALIVE_US,
+ * so the primary knows up to when each board's stream is complete. An
+ * event is played once every active board has reported past it, or after
+ * CLUSTER_MERGE_WINDOW_US at the latest. A board silent for
+ * CLUSTER_NODE_TIMEOUT_MS is dropped and its held notes are released.
+ *
+ * The chain pins are also inputs on a full panel (see pins.h); a cluster
+ * board ignores the inputs on the pins its chain uses.
+ */
+
+enum ClusterEventType : uint8_t {
+    CLUSTER_BUTTON = 0,     // value = pressed
+    CLUSTER_JOYSTICK = 1,   // value = 1 (pulse per press)
+    CLUSTER_SWITCH = 2,     // value = on
+    CLUSTER_POT = 3         // value = MIDI value
+};
+
+struct ClusterEvent {
+    uint32_t time;          // micros() on the merging board's clock
+    uint8_t node;           // 0 = primary
+    uint8_t type;           // ClusterEventType
+    uint8_t index;
+    uint8_t value;
+};
+
+/**
+ * @brief Byte-wise chain frame decoder
+ */
+class ClusterFrameParser {
+public:
+    static constexpr uint8_t START_BYTE = 0xC7;
+    static constexpr uint8_t OVERHEAD = 5;
+
+    struct Frame {
+        uint8_t type;
+        uint8_t node;
+        uint8_t length;
+        uint8_t payload[255];
+    };
+
+    ClusterFrameParser() : state(0), received(0), crcErrors(0) {}
+
+    /**
+     * @return true when frame() holds a complete frame with a valid CRC
+     */
+    bool receive(uint8_t byte);
+
+    const Frame& frame() const { return current; }
+    uint32_t getCrcErrors() const { return crcErrors; }
+
+    /**
+     * @brief Encode a frame into out (length + OVERHEAD bytes)
+     * @return Encoded size
+     */
+    static size_t encode(uint8_t type, uint8_t node, const uint8_t* payload, uint8_t length, uint8_t* out);
+
+private:
+    Frame current;
+    uint8_t state;          // 0 = start, 1 = type, 2 = node, 3 = length, 4 = payload, 5 = CRC
+    uint8_t received;
+    uint32_t crcErrors;
+};
+
+/**
+ * @brief Timestamp-ordered merge of per-board event streams
+ *
+ * Each board's events arrive in time order, so each has a FIFO; release()
+ * repeatedly takes the earliest head. A board's watermark is the time up
+ * to which its stream is known complete; the head is released once every
+ * other active board's queue or watermark is past it, or when it is older
+ * than the merge window.
+ */
+class ClusterMerger {
+public:
+    typedef void (*Sink)(const ClusterEvent& event, void* context);
+
+    ClusterMerger();
+
+    void reset();
+
+    /**
+     * @return false if the board's queue is full (the event is dropped)
+     */
+    bool push(const ClusterEvent& event);
+
+    // Board's stream is complete up to time
+    void advance(uint8_t node, uint32_t watermark);
+
+    // Inactive boards are not waited for; their queued events still play
+    void setActive(uint8_t node, bool active);
+    bool isActive(uint8_t node) const { return node < CLUSTER_MAX_NODES && queues[node].active; }
+
+    /**
+     * @brief Pass every event that can no longer be preceded to sink, in
+     * time order
+     * @return Events released
+     */
+    uint16_t release(uint32_t now, uint32_t windowUs, Sink sink, void* context);
+
+    uint32_t getDropped() const { return dropped; }
+    uint32_t getLate() const { return late; }
+    uint32_t getOutOfOrder() const { return outOfOrder; }
+    uint32_t getMaxDelayUs() const { return maxDelayUs; }
+    uint8_t getMaxDepth() const { return maxDepth; }
+
+private:
+    struct Queue {
+        ClusterEvent events[CLUSTER_NODE_EVENTS];
+        uint8_t head;           // Free-running
+        uint8_t tail;
+        uint32_t watermark;
+        bool active;
+    };
+
+    Queue queues[CLUSTER_MAX_NODES];
+    uint32_t lastReleased;
+    bool released;
+
+    // Statistics
+    uint32_t dropped;
+    uint32_t late;              // Released by the window, not the watermarks
+    uint32_t outOfOrder;        // Released before an event already played
+    uint32_t maxDelayUs;        // Worst event time -> release
+    uint8_t maxDepth;
+};
+
+class ClusterLink {
+public:
+    // Chain side of a board: a UART and the pins it takes
+    struct Port {
+        HardwareSerial* serial;
+        uint8_t rxPin;
+        uint8_t txPin;
+    };
+
+    // Receive and transmit memory for both ports
+    struct Buffers {
+        uint8_t rxA[CLUSTER_UART_BUFFER];
+        uint8_t txA[CLUSTER_UART_BUFFER];
+        uint8_t rxB[CLUSTER_UART_BUFFER];
+        uint8_t txB[CLUSTER_UART_BUFFER];
+    };
+
+    /**
+     * @param role CLUSTER_PRIMARY or CLUSTER_SECONDARY
+     * @param portA Toward the primary (secondary), or the chain (primary)
+     * @param portB Toward the next secondary; unused on the primary
+     * @param events Flight recorder for merged remote events, or nullptr
+     */
+    ClusterLink(uint8_t role, const Port& portA, const Port& portB, RobustMidiMapper& mapper,
+                PortalCueHandler& cues, FlightRecorder* events, Buffers* buffers);
+
+    /**
+     * @brief Open the chain UARTs; on the primary, start listening for cues
+     * to pass down
+     */
+    void begin();
+
+    /**
+     * @brief Turn this scan tick's debounced edges into events: merged
+     * (primary) or queued and sent up (secondary). Replaces the MIDI
+     * mapper on cluster boards.
+     */
+    void captureInputs(const InputProcessor& inputs, uint32_t tickStart);
+
+    /**
+     * @brief Background task: forward frames, merge and play events,
+     * enumerate the chain, drop silent boards
+     * @return true while more events are waiting to be sent (secondary)
+     */
+    bool poll();
+
+    /**
+     * @brief Pass a portal cue down the chain (primary)
+     */
+    void forwardCue(const PortalMessage& message);
+
+    // This board's number: 0 on the primary, 1.. on secondaries once enumerated
+    uint8_t getNodeId() const { return nodeId; }
+    // Bit n set while secondary n is reporting (primary)
+    uint8_t getActiveNodes() const { return activeNodes; }
+    uint32_t getEventsMerged() const { return eventsMerged; }
+    uint32_t getEventsSent() const { return eventsSent; }
+    uint32_t getForwardDrops() const { return forwardDrops; }
+    uint32_t getCuesForwarded() const { return cuesForwarded; }
+    uint32_t getCrcErrors() const { return parserA.getCrcErrors() + parserB.getCrcErrors(); }
+    const ClusterMerger& getMerger() const { return merger; }
+
+    void printStats(Print& out) const;
+
+private:
+    enum FrameType : uint8_t {
+        FRAME_EVENTS = 1,
+        FRAME_ENUMERATE = 2,
+        FRAME_CUE = 3
+    };
+
+    static constexpr uint8_t FRAME_EVENTS_MAX = 48;
+    static constexpr uint8_t EVENT_BYTES = 5;
+
+    void queueEvent(uint8_t type, uint8_t index, uint8_t value, uint32_t time);
+    bool sendEvents(uint32_t now);
+    void receive(HardwareSerial& serial, ClusterFrameParser& parser, bool fromA);
+    void handleFrame(const ClusterFrameParser::Frame& frame, uint32_t arrival, bool fromA);
+    void mergeFrame(const ClusterFrameParser::Frame& frame, uint32_t arrival);
+    bool writeFrame(HardwareSerial& serial, uint16_t capacity, uint8_t type, uint8_t node,
+                    uint8_t* payload, uint8_t length, uint32_t transitUs, bool wait);
+    void checkNodes(uint32_t nowMs);
+    void play(const ClusterEvent& event);
+    static void onRelease(const ClusterEvent& event, void* context);
+    static void onCue(const PortalMessage& message, void* context);
+
+    uint8_t role;
+    Port portA;
+    Port portB;
+    RobustMidiMapper& mapper;
+    PortalCueHandler& cues;
+    FlightRecorder* events;
+    Buffers* buffers;
+
+    ClusterFrameParser parserA;
+    ClusterFrameParser parserB;
+    uint16_t capacityA;         // Empty transmit buffer, for bytes queued ahead
+    uint16_t capacityB;
+    bool started;
+    uint8_t nodeId;
+
+    // Inputs on chain pins, never captured
+    uint16_t ignoredButtons;
+    uint16_t ignoredSwitches;
+    uint8_t ignoredJoystick;
+
+    // Edge tracking, as in RobustMidiMapper
+    uint16_t lastButtons;
+    uint16_t lastSwitches;
+    uint8_t lastPots[POT_COUNT];
+
+    // Secondary: events not sent yet (times on this board's clock)
+    ClusterEvent pending[CLUSTER_NODE_EVENTS];
+    uint8_t pendingHead;        // Free-running
+    uint8_t pendingTail;
+    uint32_t lastSendUs;
+    uint32_t lastPollA;         // Receive buffer drained up to here
+    uint32_t lastPollB;
+
+    // Primary
+    ClusterMerger merger;
+    uint32_t lastFrameMs[CLUSTER_MAX_NODES];
+    uint8_t activeNodes;
+    uint32_t lastEnumerateMs;
+
+    // Statistics
+    uint32_t framesSent;
+    uint32_t framesReceived;
+    uint32_t eventsSent;
+    uint32_t eventsMerged;
+    uint32_t eventsDropped;     // Secondary: pending queue full
+    uint32_t framesForwarded;
+    uint32_t forwardDrops;      // Frames dropped: next hop's transmit buffer full
+    uint32_t cuesForwarded;     // Primary: cues passed down the chain
+    uint32_t maxTransitUs;      // Primary: worst event time -> arrival
+    uint8_t pendingPeak;
+};
+
+#if CLUSTER_ROLE != CLUSTER_STANDALONE
+extern ClusterLink clusterLink;
+#endif
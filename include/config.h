@@ -27,6 +27,9 @@
 #define JOYSTICK_REARM_MS 120
 #endif
 
+// Input scan tick period derived from SCAN_HZ
+constexpr uint32_t SCAN_PERIOD_US = 1000000 / SCAN_HZ;
+
 // ===== LED CONFIGURATION =====
 #ifndef LED_BRIGHTNESS_MAX
 #define LED_BRIGHTNESS_MAX 160
@@ -36,11 +39,103 @@
 #define IDLE_BRIGHTNESS_CAP_PCT 15
 #endif
 
+// Estimated strip current the limiter holds frames under (mA, 0 = off);
+// boot default of the led_power_budget tuning parameter
+#ifndef LED_POWER_BUDGET_MA
+#define LED_POWER_BUDGET_MA 1500
+#endif
+
 // ===== DEBUG CONFIGURATION =====
 #ifndef DEBUG
 #define DEBUG 1  // Phase 2: Enable debug output by default
 #endif
 
+// Cycle-counter stage profiler: 0 = compiled out, 1 = enabled
+#ifndef PROFILE
+#define PROFILE 1
+#endif
+
+// Hardware watchdog with stall report: 0 = disabled, 1 = enabled
+#ifndef WATCHDOG
+#define WATCHDOG 1
+#endif
+
+// Persistent flight recorder of recent events: 0 = compiled out, 1 = enabled
+#ifndef FLIGHT_RECORDER
+#define FLIGHT_RECORDER 1
+#endif
+
+// Flight recorder stream to the built-in SD card when one is present at boot:
+// 0 = compiled out, 1 = enabled (needs FLIGHT_RECORDER)
+#ifndef SESSION_RECORDER
+#define SESSION_RECORDER 1
+#endif
+
+// OSC over UDP to the Pi on the Teensy 4.1 Ethernet port (QNEthernet),
+// alongside USB serial: 0 = compiled out, 1 = enabled
+#ifndef ETHERNET_OSC
+#define ETHERNET_OSC 0
+#endif
+
+// Multi-board cluster over a UART daisy chain (cluster_link.h):
+// 0 = standalone, 1 = primary (merges every board into one MIDI stream),
+// 2 = secondary (sends its input events up the chain)
+#define CLUSTER_STANDALONE 0
+#define CLUSTER_PRIMARY 1
+#define CLUSTER_SECONDARY 2
+#ifndef CLUSTER_ROLE
+#define CLUSTER_ROLE CLUSTER_STANDALONE
+#endif
+
+// Button looper on the device, locked to the portal BPM (midi_looper.h):
+// 0 = compiled out, 1 = enabled (armed with switch LOOPER_SWITCH)
+#ifndef MIDI_LOOPER
+#define MIDI_LOOPER 1
+#endif
+
+// Switch bank output (robust_midi_mapper.h): 0 = a CC per switch plus
+// SWITCH_BINARY_CC, 1 = one NRPN snapshot of all 12, 2 = one SysEx snapshot.
+// Boot default only; the Pi can change it at runtime (CONFIG_SWITCH_SNAPSHOT)
+#ifndef SWITCH_SNAPSHOT
+#define SWITCH_SNAPSHOT 0
+#endif
+
+// Chattering, stuck and noisy inputs quarantined until they settle
+// (input_health.h): 0 = compiled out, 1 = enabled
+#ifndef INPUT_HEALTH
+#define INPUT_HEALTH 1
+#endif
+
+// Raw input trace capture and replay: 0 = compiled out, 1 = enabled
+#ifndef INPUT_TRACE
+#define INPUT_TRACE 1
+#endif
+
+// Deferred binary event log in place of hot-path debug prints: 0 = compiled out, 1 = enabled
+#ifndef EVENT_LOG
+#define EVENT_LOG 1
+#endif
+
+// Event log startup level (0 = off ... 4 = debug) and text output on Serial;
+// production keeps records for LOG_DUMP, the debug build prints them
+#ifndef EVENT_LOG_LEVEL
+#define EVENT_LOG_LEVEL (DEBUG >= 2 ? 4 : 3)
+#endif
+#ifndef EVENT_LOG_TEXT
+#define EVENT_LOG_TEXT (DEBUG >= 2 ? 1 : 0)
+#endif
+
+// Teensy -> Pi output in prioritized logical channels (see serial_mux.h):
+// 0 = raw Serial as before, 1 = tagged frames (the Pi must demultiplex)
+#ifndef SERIAL_MUX
+#define SERIAL_MUX 0
+#endif
+
+// Input pipeline: 0 = RobustInputProcessor, 1 = compile-time specialized templates
+#ifndef STATIC_INPUT_PIPELINE
+#define STATIC_INPUT_PIPELINE 0
+#endif
+
 // ===== PHASE 2 ROBUST INPUT CONFIGURATION =====
 // EMA smoothing alpha (0-255, where 64 ≈ 0.25)
 #ifndef POT_SMOOTHING_ALPHA
@@ -90,6 +185,14 @@ constexpr uint8_t SWITCH_CCS[] = {
 // MIDI CC for binary representation of first 8 switches
 constexpr uint8_t SWITCH_BINARY_CC = 50;
 
+// Switch bank snapshots: sent once the bank has been still this long, and at
+// most this long after the first change of a burst (a slow sweep)
+constexpr uint8_t SWITCH_SNAPSHOT_SETTLE_MS = 8;
+constexpr uint8_t SWITCH_SNAPSHOT_MAX_HOLD_MS = 50;
+
+// NRPN parameter number of the snapshot (CC 99/98), value on CC 6/38
+constexpr uint16_t SWITCH_SNAPSHOT_NRPN_PARAM = 50;
+
 // ===== PORTAL ANIMATION CONFIGURATION =====
 constexpr uint8_t PORTAL_PROGRAM_COUNT = 10;
 enum PortalProgram {
@@ -109,6 +212,13 @@ enum PortalProgram {
 constexpr uint8_t  PORTAL_FPS = 60;
 constexpr uint32_t PORTAL_FRAME_INTERVAL_US = 1000000 / PORTAL_FPS;
 
+// Animation phases wrap so float precision holds over weeks of uptime.
+// 2560 s is a whole number of periods of every hue term that runs at a fixed
+// rate, so only the sine terms jump (once per ~43 min, like a program change).
+// bpmPhase wraps every two beats: breathe uses sin(pi * phase).
+constexpr float PORTAL_ANIMATION_PHASE_WRAP = 2560.0f;
+constexpr float PORTAL_BPM_PHASE_WRAP = 2.0f;
+
 // ===== SERIAL PORTAL COMMUNICATION =====
 // Serial communication parameters for Pi <-> Teensy portal control
 constexpr uint32_t PORTAL_SERIAL_BAUD = 115200;
@@ -128,5 +238,225 @@ constexpr uint8_t OLED_UPDATE_HZ = 20;
 // Default display mode on startup
 constexpr uint8_t OLED_DEFAULT_MODE = 0;  // MIDI_LOG mode
 
+// How long the startup message stays up after OLED init
+constexpr uint16_t OLED_SPLASH_MS = 1500;
+
+// I2C clock used during and between OLED transfers
+constexpr uint32_t OLED_I2C_CLOCK_HZ = 400000;
+
+// Bytes sent per cooperative transfer slice (<= 31 for the 32-byte Wire buffer).
+// 16 bytes at 400 kHz is ~0.4 ms, well inside one scan tick.
+constexpr uint8_t OLED_TRANSFER_SLICE_BYTES = 16;
+
 // MIDI log settings
 constexpr uint8_t OLED_MIDI_LOG_SIZE = 8;  // Number of MIDI messages to keep in log
+
+// ===== PERFORMANCE MONITOR CONFIGURATION =====
+// Rolling window for stage budgets and the loop-time histogram
+constexpr uint16_t PERF_WINDOW_MS = 1000;
+
+// ===== WATCHDOG CONFIGURATION =====
+// Reset if the watched tasks have not all checked in for this long
+// (WDOG1 counts in 500 ms steps)
+constexpr uint16_t WATCHDOG_TIMEOUT_MS = 1000;
+
+// Early-warning interrupt fires this long before the reset to save the stall record
+constexpr uint16_t WATCHDOG_WARNING_MS = 500;
+
+// ===== FLIGHT RECORDER CONFIGURATION =====
+// Ring size in 8-byte entries (power of two); 8192 = 64 KB of DMAMEM, ~8 s
+constexpr uint16_t FLIGHT_RECORDER_ENTRIES = 8192;
+
+// Entries written per background dump slice (512 bytes)
+constexpr uint8_t FLIGHT_DUMP_SLICE_ENTRIES = 64;
+
+// Background task period: cache flush of new entries and dump streaming
+constexpr uint32_t FLIGHT_TASK_PERIOD_US = 2000;
+
+// ===== SESSION RECORDER CONFIGURATION =====
+// Each half of the RAM double buffer (DMAMEM, multiple of 512); ~2 s of scan ticks
+constexpr uint32_t SESSION_BUFFER_BYTES = 16384;
+
+// Session file size before rotating to the next one, preallocated at open;
+// 32 MB is about an hour of play
+constexpr uint32_t SESSION_FILE_BYTES = 32UL * 1024 * 1024;
+
+// Session files kept on the card; the oldest is deleted to make room
+constexpr uint16_t SESSION_MAX_FILES = 32;
+
+// 512-byte sectors written per background slice, each only while the card is idle
+constexpr uint8_t SESSION_SECTORS_PER_SLICE = 4;
+
+// A partly filled buffer is written and the file synced at least this often
+constexpr uint16_t SESSION_SYNC_MS = 1000;
+
+// Background task period: collect new flight entries and write sectors
+constexpr uint32_t SESSION_TASK_PERIOD_US = 5000;
+
+// ===== ETHERNET OSC CONFIGURATION =====
+// Static address; all zero = DHCP (started without waiting)
+constexpr uint8_t ETHERNET_IP[4] = {192, 168, 7, 2};
+constexpr uint8_t ETHERNET_NETMASK[4] = {255, 255, 255, 0};
+constexpr uint8_t ETHERNET_GATEWAY[4] = {192, 168, 7, 1};
+
+// UDP port the Teensy listens on; replies, events and telemetry go back to
+// the address and port the Pi last sent from
+constexpr uint16_t ETHERNET_OSC_PORT = 9000;
+
+// Outgoing packet buffers (power of two) and their size (Ethernet MTU minus
+// IP and UDP headers)
+constexpr uint8_t ETHERNET_TX_PACKETS = 8;
+constexpr uint16_t ETHERNET_PACKET_BYTES = 1472;
+
+// Received packets queued by the network stack between polls, and handled per poll
+constexpr uint8_t ETHERNET_RX_QUEUE = 8;
+
+// Telemetry interval; the Pi is dropped as a peer after this long without a packet
+constexpr uint16_t ETHERNET_TELEMETRY_MS = 1000;
+constexpr uint16_t ETHERNET_PEER_TIMEOUT_MS = 5000;
+
+// Background task period: network poll, received cues, outgoing events
+constexpr uint32_t ETHERNET_TASK_PERIOD_US = 1000;
+
+// ===== CLUSTER CONFIGURATION =====
+// Chain UART rate; 5 us per byte
+constexpr uint32_t CLUSTER_BAUD = 2000000;
+
+// Primary plus up to 7 secondaries; secondary n sends on MIDI channel MIDI_CHANNEL + n
+constexpr uint8_t CLUSTER_MAX_NODES = 8;
+
+// Receive and transmit memory added to each chain UART (OCRAM)
+constexpr uint16_t CLUSTER_UART_BUFFER = 1024;
+
+// Events queued per node, on a secondary before sending and on the primary
+// before merging (power of two)
+constexpr uint8_t CLUSTER_NODE_EVENTS = 64;
+
+// A secondary sends a frame at least this often, events or not, so the
+// primary knows how far each board's stream is complete
+constexpr uint32_t CLUSTER_KEEPALIVE_US = 1000;
+
+// Longest an event waits on the primary for a board that has gone quiet
+constexpr uint32_t CLUSTER_MERGE_WINDOW_US = 5000;
+
+// A board is dropped (and its held notes released) after this long without a frame
+constexpr uint16_t CLUSTER_NODE_TIMEOUT_MS = 50;
+
+// The primary numbers the chain this often, so boards can join at any time
+constexpr uint16_t CLUSTER_ENUMERATE_MS = 250;
+
+// Background task period: forward frames, merge, enumerate
+constexpr uint32_t CLUSTER_TASK_PERIOD_US = 250;
+
+// ===== LOOPER CONFIGURATION =====
+// Note on/off events held by the loop, 4 bytes each
+constexpr uint16_t LOOPER_MAX_EVENTS = 512;
+
+// Loop clock resolution and the longest loop
+constexpr uint16_t LOOPER_TICKS_PER_BEAT = 96;
+constexpr uint8_t LOOPER_MAX_BEATS = 64;
+
+// Recorded notes snap to this many steps per beat (4 = sixteenths); 0 = as played
+constexpr uint8_t LOOPER_QUANTIZE_STEPS = 4;
+
+// Playback channel, apart from the live buttons so the two never cut each other off
+constexpr uint8_t LOOPER_MIDI_CHANNEL = 16;
+
+// Gestures: the switch arms the looper (off mutes it); while armed the
+// joystick records / overdubs and clears
+constexpr uint8_t LOOPER_SWITCH = 9;
+constexpr uint8_t LOOPER_RECORD_DIRECTION = 3;  // Right
+constexpr uint8_t LOOPER_CLEAR_DIRECTION = 2;   // Left
+
+// ===== RULE ENGINE CONFIGURATION =====
+// Reaction rules held on the device, 10 bytes each (plus an upload copy in OCRAM)
+constexpr uint16_t RULES_MAX = 256;
+
+// Rules for any one input (and again for its "any index" rules): an input
+// event examines at most twice this many, whatever the table size
+constexpr uint8_t RULES_MAX_PER_INPUT = 32;
+
+// Actions one input event can fire; later matches are counted and skipped
+constexpr uint8_t RULES_MAX_ACTIONS_PER_EVENT = 8;
+
+// Channel for rule MIDI actions
+constexpr uint8_t RULES_MIDI_CHANNEL = 1;
+
+// ===== INPUT HEALTH CONFIGURATION =====
+// Edge and reversal counts are per fixed window of this length
+constexpr uint16_t INPUT_HEALTH_WINDOW_MS = 1000;
+
+// Debounced edges per window that are chatter, not playing: buttons and
+// joystick (fast playing stays near 20), toggle switches
+constexpr uint8_t INPUT_HEALTH_MAX_EDGES = 40;
+constexpr uint8_t INPUT_HEALTH_MAX_SWITCH_EDGES = 16;
+
+// Pot sends per window that turn back the way they came: a floating input
+constexpr uint8_t INPUT_HEALTH_MAX_POT_REVERSALS = 12;
+
+// A button or joystick direction held this long is stuck
+constexpr uint32_t INPUT_HEALTH_STUCK_MS = 60000;
+
+// A quarantined input is let back in after this long without its fault
+constexpr uint32_t INPUT_HEALTH_RECOVERY_MS = 10000;
+
+// ===== LED POWER CONFIGURATION =====
+// WS2812B draw per LED at 5 V: each channel at full scale, and the
+// controller with the LED dark
+constexpr uint8_t LED_POWER_MA_RED = 16;
+constexpr uint8_t LED_POWER_MA_GREEN = 11;
+constexpr uint8_t LED_POWER_MA_BLUE = 15;
+constexpr uint8_t LED_POWER_MA_DARK = 1;
+
+// Once a frame fits the budget again, brightness returns this much per frame
+// (a limit is applied at once, in the frame that needs it)
+constexpr uint8_t LED_POWER_RELEASE_STEP = 2;
+
+// ===== INPUT TRACE CONFIGURATION =====
+// Capture buffer in OCRAM; 3 bytes per changed input, ~10 s of a jittery pot
+constexpr uint32_t INPUT_TRACE_BYTES = 32768;
+
+// Bytes written per background dump slice
+constexpr uint16_t INPUT_TRACE_DUMP_SLICE_BYTES = 512;
+
+// Background task period: dump streaming
+constexpr uint32_t INPUT_TRACE_TASK_PERIOD_US = 2000;
+
+// ===== EVENT LOG CONFIGURATION =====
+// Ring size in 12-byte records (power of two); 512 = 6 KB
+constexpr uint16_t EVENT_LOG_ENTRIES = 512;
+
+// Records formatted per background text drain slice
+constexpr uint8_t EVENT_LOG_DRAIN_SLICE = 4;
+
+// Records written per background dump slice (384 bytes)
+constexpr uint8_t EVENT_LOG_DUMP_SLICE_RECORDS = 32;
+
+// Background task period: text drain and dump streaming
+constexpr uint32_t EVENT_LOG_TASK_PERIOD_US = 2000;
+
+// ===== SERIAL MUX CONFIGURATION =====
+// Queue per logical channel in bytes (powers of two), highest priority first
+constexpr uint16_t SERIAL_MUX_CONTROL_QUEUE = 64;
+constexpr uint16_t SERIAL_MUX_TELEMETRY_QUEUE = 1024;
+constexpr uint16_t SERIAL_MUX_LOG_QUEUE = 1024;
+constexpr uint16_t SERIAL_MUX_BULK_QUEUE = 2048;
+
+// Largest frame payload; a frame adds 4 bytes (start, channel, length, CRC-8)
+constexpr uint8_t SERIAL_MUX_MAX_PAYLOAD = 64;
+
+// Bytes the background pump may hand to USB per slice
+constexpr uint16_t SERIAL_MUX_PUMP_BYTES = 1024;
+
+// Background task period: frame queued output onto Serial
+constexpr uint32_t SERIAL_MUX_TASK_PERIOD_US = 1000;
+
+// ===== RUNTIME CONFIG STORE =====
+// EEPROM offset of the versioned tuning block (Teensy 4.1 has 4284 bytes)
+constexpr uint16_t CONFIG_EEPROM_ADDRESS = 0;
+
+// Largest tuning payload a block may carry (room for later firmware fields)
+constexpr uint8_t CONFIG_MAX_PAYLOAD = 64;
+
+// Background task period: deferred EEPROM writes
+constexpr uint32_t CONFIG_TASK_PERIOD_US = 100000;
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <Arduino.h>
+#include "config.h"
+
+/**
+ * @brief Runtime-tunable configuration block in EEPROM
+ *
+ * Holds the on-site tuning knobs (debounce, pot deadband and rate limit,
+ * idle timeout, joystick rearm, LED brightness cap and power budget,
+ * switch bank output). The -D build flags
+ * in config.h are the compile-time defaults; a valid EEPROM block
+ * overrides them at boot.
+ *
+ * Edits arrive over the serial protocol (CONFIG_* commands) or SysEx and
+ * are staged. applyPending() is called at the start of a scan tick, so a
+ * tick always runs with one consistent set. Nothing is persisted until
+ * CONFIG_SAVE; the EEPROM write happens later from a background task.
+ *
+ * Block layout (little-endian) at CONFIG_EEPROM_ADDRESS:
+ *   header   "MMCF", u8 version, u8 payload size, u16 reserved
+ *   payload  RuntimeConfig (fields are only ever appended)
+ *   checksum u32 FNV-1a over header and payload
+ *
+ * A block written by older firmware keeps the fields it has; fields it
+ * lacks, and stored values outside their valid range, fall back to the
+ * defaults. A bad magic or checksum means all defaults.
+ *
+ * SysEx (non-commercial ID 0x7D, device 'M'), values as three 7-bit
+ * groups, most significant first:
+ *   F0 7D 4D 01 pp v2 v1 v0 F7   set   -> VALUE or ERROR
+ *   F0 7D 4D 02 pp F7            get   -> VALUE
+ *   F0 7D 4D 03 pp v2 v1 v0 F7   VALUE (reply; staged value)
+ *   F0 7D 4D 04 F7               save  -> OK
+ *   F0 7D 4D 05 F7               defaults (staged, not saved) -> OK
+ *   F0 7D 4D 7E F7               OK (reply)
+ *   F0 7D 4D 7F F7               ERROR (reply)
+ */
+
+enum ConfigParam : uint8_t {
+    CONFIG_DEBOUNCE_MS = 0,
+    CONFIG_POT_DEADBAND = 1,
+    CONFIG_POT_RATE_LIMIT_MS = 2,
+    CONFIG_IDLE_TIMEOUT_MS = 3,
+    CONFIG_JOYSTICK_REARM_MS = 4,
+    CONFIG_LED_BRIGHTNESS_MAX = 5,
+    CONFIG_SWITCH_SNAPSHOT = 6,     // 0 = CC per switch, 1 = NRPN, 2 = SysEx snapshot
+    CONFIG_LED_POWER_BUDGET_MA = 7, // 0 = no limit
+    CONFIG_PARAM_COUNT
+};
+
+// Live tuning values; new fields go at the end (block version bump)
+struct RuntimeConfig {
+    uint32_t idleTimeoutMs;
+    uint16_t joystickRearmMs;
+    uint8_t debounceMs;
+    uint8_t potDeadband;
+    uint8_t potRateLimitMs;
+    uint8_t ledBrightnessMax;
+    uint8_t reserved[2];
+    uint8_t switchSnapshot;         // Version 2
+    uint8_t reserved2[3];
+    uint16_t ledPowerBudgetMa;      // Version 3
+    uint8_t reserved3[2];
+};
+
+// The payload is written to EEPROM and checksummed as raw bytes: no padding
+static_assert(offsetof(RuntimeConfig, ledPowerBudgetMa) == 16 && sizeof(RuntimeConfig) == 20,
+              "RuntimeConfig layout changed");
+
+class ConfigStore {
+public:
+    static constexpr uint32_t MAGIC = 0x46434D4D;  // "MMCF"
+    static constexpr uint8_t VERSION = 3;
+    static constexpr uint8_t HEADER_SIZE = 8;
+    static constexpr uint8_t BLOCK_SIZE = HEADER_SIZE + sizeof(RuntimeConfig) + 4;
+    static constexpr uint8_t SYSEX_MAX_SIZE = 10;
+
+    // SysEx message types
+    static constexpr uint8_t SYSEX_MANUFACTURER = 0x7D;
+    static constexpr uint8_t SYSEX_DEVICE = 0x4D;
+    static constexpr uint8_t SYSEX_SET = 0x01;
+    static constexpr uint8_t SYSEX_GET = 0x02;
+    static constexpr uint8_t SYSEX_VALUE = 0x03;
+    static constexpr uint8_t SYSEX_SAVE = 0x04;
+    static constexpr uint8_t SYSEX_DEFAULTS = 0x05;
+    static constexpr uint8_t SYSEX_OK = 0x7E;
+    static constexpr uint8_t SYSEX_ERROR = 0x7F;
+
+    struct ParamInfo {
+        const char* name;
+        uint32_t minValue;
+        uint32_t maxValue;
+        uint16_t wireUnit;      // Serial protocol 8-bit value step
+    };
+
+    ConfigStore();
+
+    /**
+     * @brief Load the EEPROM block (or the defaults); call early in setup()
+     * @return true if a valid block was found
+     */
+    bool begin();
+
+    static RuntimeConfig defaults();
+    static const ParamInfo& getParamInfo(ConfigParam param);
+
+    // Live values, changed only by applyPending()
+    const RuntimeConfig& get() const { return active; }
+
+    /**
+     * @brief Stage a new value; applied at the next tick boundary
+     * @return false for an unknown parameter or out-of-range value
+     */
+    bool setValue(ConfigParam param, uint32_t value);
+
+    // Staged value (equals the live one once applied)
+    uint32_t getValue(ConfigParam param) const;
+
+    // Stage the compile-time defaults
+    void restoreDefaults();
+
+    /**
+     * @brief Make staged edits live; call at the start of a scan tick
+     * @return true if the live values changed
+     */
+    bool applyPending();
+
+    // Persist the live values from the background task
+    void requestSave() { saveRequested = true; }
+    bool saveIfRequested();
+
+    bool isLoadedFromEeprom() const { return loaded; }
+    uint32_t getSaveCount() const { return saveCount; }
+
+    // Serial protocol values: 8 bits in units of ParamInfo::wireUnit
+    static uint32_t fromWire(ConfigParam param, uint8_t value);
+    static uint8_t toWire(ConfigParam param, uint32_t value);
+
+    /**
+     * @brief Serialize the live values as an EEPROM block
+     * @param out At least BLOCK_SIZE bytes
+     */
+    void encode(uint8_t* out) const;
+
+    /**
+     * @brief Load a block into the live and staged values
+     * @return false (values reset to defaults) if the block is not valid
+     */
+    bool decode(const uint8_t* block, size_t length);
+
+    /**
+     * @brief Handle a complete SysEx message (F0 ... F7)
+     * @param reply At least SYSEX_MAX_SIZE bytes
+     * @return Reply length, 0 if the message is not for us
+     */
+    size_t handleSysEx(const uint8_t* data, size_t length, uint8_t* reply);
+
+    void print(Print& out) const;
+
+private:
+    RuntimeConfig active;
+    RuntimeConfig pending;
+    bool pendingChanged;
+    bool saveRequested;
+    bool loaded;
+    uint32_t saveCount;
+
+    static uint32_t readField(const RuntimeConfig& config, ConfigParam param);
+    static void writeField(RuntimeConfig& config, ConfigParam param, uint32_t value);
+    static uint32_t checksum(const uint8_t* data, size_t length);
+    static size_t sysExReply(uint8_t* reply, uint8_t type, const uint8_t* payload, size_t length);
+};
+
+extern ConfigStore configStore;
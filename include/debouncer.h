@@ -45,6 +45,11 @@ public:
      */
     bool justReleased() const { return !stableState && stateChanged; }
     
+    /**
+     * @brief Change the debounce window; the current state is kept
+     */
+    void setDebounceMs(uint8_t ms) { debounceMs = ms; }
+    
     /**
      * @brief Reset debouncer state
      */
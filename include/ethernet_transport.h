@@ -0,0 +1,147 @@
+#pragma once
+
+#include <Arduino.h>
+#include <QNEthernet.h>
+#include "config.h"
+#include "flight_recorder.h"
+#include "osc_codec.h"
+#include "portal_controller.h"
+#include "portal_cue_handler.h"
+
+/**
+ * @brief OSC over UDP to the Pi on the Teensy 4.1 Ethernet port
+ *
+ * A second Pi link next to USB serial. Cues arrive as OSC messages, any
+ * number per packet (or bundled), and run through the same
+ * PortalCueHandler dispatch as serial frames; there is no stop-and-wait,
+ * the Pi may pipeline as many cues as it likes. Their ACK/NAK/PONG replies
+ * come back over UDP. Input events, MIDI sends and telemetry stream to the
+ * Pi as OSC bundles.
+ *
+ * Pi -> Teensy (to ETHERNET_OSC_PORT):
+ *   /portal/cmd ii       any protocol command and value (serial_portal_protocol.h)
+ *   /portal/frame b      raw 5-byte protocol frames, back to back
+ *   /portal/program i, /portal/bpm i, /portal/intensity i, /portal/hue i,
+ *   /portal/brightness i, /portal/flash, /portal/ripple i, /ping
+ *                        the cue commands by name; values are protocol bytes
+ *
+ * Teensy -> Pi (to the address and port the Pi last sent from, until
+ * ETHERNET_PEER_TIMEOUT_MS passes without a packet):
+ *   /portal/reply ii     response command and value
+ *   /input/button iii    micros() timestamp, index, pressed (also
+ *   /input/joystick, /input/switch; /input/pot has the raw value)
+ *   /midi/note_on iiii   timestamp, channel, note, velocity (also
+ *   /midi/note_off, /midi/cc with controller and value)
+ *   /input/health iii    timestamp, input health channel, fault (0 =
+ *                        back from quarantine, see input_health.h)
+ *   /telemetry iiiii     uptime ms, program, worst scan tick us since the
+ *                        last telemetry, events dropped, packets received
+ *
+ * Events come from the flight recorder ring, so the scan path is
+ * unchanged; without FLIGHT_RECORDER only replies and telemetry are sent.
+ * Dumps and text reports still stream on USB serial.
+ *
+ * Packets are encoded in place in a ring of ETHERNET_TX_PACKETS buffers
+ * and handed to the stack from there; received packets are parsed where
+ * the stack keeps them. The poll task never waits: a packet the stack
+ * cannot take yet stays queued for the next poll, and events that find
+ * the ring full are dropped and counted.
+ */
+class EthernetTransport {
+public:
+    struct Packet {
+        uint16_t length;
+        uint8_t data[ETHERNET_PACKET_BYTES];
+    };
+
+    /**
+     * @param events Flight recorder to stream events from, or nullptr
+     * @param packets ETHERNET_TX_PACKETS outgoing packet buffers
+     */
+    EthernetTransport(PortalCueHandler& cues, PortalController& portal, FlightRecorder* events, Packet* packets);
+
+    /**
+     * @brief Bring up the interface (static address, or start DHCP) and
+     * open the UDP port; returns at once, the link comes up on its own
+     * @return false if there is no Ethernet hardware
+     */
+    bool begin();
+
+    /**
+     * @brief Background task: run the stack, handle received packets,
+     * queue events and telemetry, hand queued packets to the stack
+     * @return true while packets remain queued
+     */
+    bool poll();
+
+    bool hasPeer() const { return peerActive; }
+    uint32_t getPacketsReceived() const { return rxPackets; }
+    uint32_t getPacketsSent() const { return txPackets; }
+    uint32_t getEventsDropped() const { return eventsDropped; }
+
+    void printStats(Print& out) const;
+
+private:
+    // Replies from PortalCueHandler, as 5-byte frames -> /portal/reply
+    class ReplyOutput : public Print {
+    public:
+        explicit ReplyOutput(EthernetTransport& transport) : transport(transport) {}
+        size_t write(uint8_t b) override;
+        using Print::write;
+        int availableForWrite() override { return PORTAL_MSG_MAX_SIZE; }
+
+    private:
+        EthernetTransport& transport;
+        uint8_t frame[5];
+        uint8_t length = 0;
+    };
+
+    static void onMessage(const OscMessage& message, void* context);
+    void handleMessage(const OscMessage& message);
+    void dispatch(uint8_t command, int32_t value);
+    void collectEvents();
+
+    // Append one all-int message to the open packet, opening a new one as needed
+    bool queueMessage(const char* address, const int32_t* args, uint8_t count);
+    bool openPacket();
+    void closePacket();
+    bool sendQueued();
+
+    PortalCueHandler& cues;
+    PortalController& portal;
+    FlightRecorder* events;
+    Packet* packets;
+    ReplyOutput replies;
+
+    qindesign::network::EthernetUDP udp;
+    bool started;
+
+    IPAddress peerIP;
+    uint16_t peerPort;
+    bool peerActive;
+    uint32_t lastReceiveMs;
+    uint32_t lastTelemetryMs;
+
+    OscWriter writer;           // Encodes into packets[txHead] while open
+    bool packetOpen;
+    uint32_t txHead;            // Free-running: packet being written / next free
+    uint32_t txTail;            // Free-running: next packet to send
+
+    uint32_t readSequence;      // Next flight recorder entry to forward
+    uint16_t maxTickUs;
+
+    // Statistics
+    uint32_t rxPackets;
+    uint32_t rxMessages;
+    uint32_t rxMalformed;
+    uint32_t rxUnknown;
+    uint32_t txPackets;
+    uint32_t txBytes;
+    uint32_t txRetries;         // Polls that found the stack not ready
+    uint32_t eventsDropped;
+    uint16_t maxQueued;
+};
+
+#if ETHERNET_OSC > 0
+extern EthernetTransport ethernetTransport;
+#endif
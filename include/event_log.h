@@ -0,0 +1,250 @@
+#pragma once
+
+#include <Arduino.h>
+#include "config.h"
+
+/**
+ * @brief Leveled, deferred binary event log
+ *
+ * Hot paths (MIDI mapping, protocol dispatch, program changes, input
+ * edges) log a message id and up to three 16-bit arguments instead of
+ * calling Serial.printf. A record is a level/category check against
+ * compile-time metadata, one 12-byte store into a RAM ring and an index
+ * increment; nothing is formatted and nothing touches Serial.
+ *
+ * The background log task drains the ring: with text output on it formats
+ * a few records per slice with the message's printf format. The LOG_DUMP
+ * serial command instead streams the ring as binary (like FLIGHT_DUMP),
+ * so a production build can keep its diagnostics without any text
+ * interleaving with protocol frames on the serial stream.
+ *
+ * Level and categories are runtime settings (LOG_LEVEL, LOG_CATEGORIES);
+ * records above the level or outside the categories are not stored.
+ * When the ring wraps before the text drain catches up, the oldest
+ * records are dropped and counted.
+ *
+ * Dump format (little-endian):
+ *   header  "ELOG", u8 version, u8 record size, u16 dropped (saturating),
+ *           u32 record count, u32 micros() at dump start
+ *   records u32 timestamp, u16 id (LogId), u16 a, u16 b, u16 c
+ */
+
+enum LogLevel : uint8_t {
+    LOG_OFF = 0,
+    LOG_ERROR = 1,
+    LOG_WARN = 2,
+    LOG_INFO = 3,
+    LOG_DEBUG = 4
+};
+
+enum LogCategory : uint8_t {
+    LOG_CAT_SYSTEM = 0x01,
+    LOG_CAT_INPUT = 0x02,
+    LOG_CAT_MIDI = 0x04,
+    LOG_CAT_PORTAL = 0x08,
+    LOG_CAT_PROTOCOL = 0x10,
+    LOG_CAT_CONFIG = 0x20,
+    LOG_CAT_ALL = 0xFF
+};
+
+// How the text drain passes the arguments to the format
+enum LogArgs : uint8_t {
+    LOG_ARGS_NUMBERS,       // a, b, c
+    LOG_ARGS_NAME_A,        // name(a), b, c
+    LOG_ARGS_NAME_B,        // a, name(b), c
+    LOG_ARGS_NAME_A_WIDE    // name(a), (unsigned long)(b | c << 16)
+};
+
+// Name table for the named argument
+enum LogNames : uint8_t {
+    LOG_NAMES_NONE,
+    LOG_NAMES_PROGRAM,      // PORTAL_PROGRAM_NAMES
+    LOG_NAMES_COMMAND,      // PortalSerialCommand
+    LOG_NAMES_CONFIG,       // ConfigParam
+    LOG_NAMES_DIRECTION,    // Joystick Up, Down, Left, Right
+    LOG_NAMES_PRESSED,      // 0 = RELEASED, 1 = PRESSED
+    LOG_NAMES_ON_OFF,       // 0 = OFF, 1 = ON
+    LOG_NAMES_LOOPER,       // MidiLooper::State
+    LOG_NAMES_HEALTH        // InputHealthMonitor::Fault
+};
+
+// Message catalogue: id, level, category, argument layout, names, format.
+// Ids are the record's id field; append new messages to keep dumps decodable.
+#define EVENT_LOG_MESSAGES(X) \
+    X(LOG_LOG_DROPPED,        LOG_WARN,  LOG_CAT_SYSTEM,   LOG_ARGS_NUMBERS,     LOG_NAMES_NONE,      "Log: %u records dropped") \
+    X(LOG_MIDI_NOTE_ON,       LOG_INFO,  LOG_CAT_MIDI,     LOG_ARGS_NUMBERS,     LOG_NAMES_NONE,      "MIDI: Button %u pressed -> Note %u ON") \
+    X(LOG_MIDI_NOTE_OFF,      LOG_INFO,  LOG_CAT_MIDI,     LOG_ARGS_NUMBERS,     LOG_NAMES_NONE,      "MIDI: Button %u released -> Note %u OFF") \
+    X(LOG_MIDI_POT_CC,        LOG_INFO,  LOG_CAT_MIDI,     LOG_ARGS_NUMBERS,     LOG_NAMES_NONE,      "MIDI: Pot %u changed -> CC %u = %u") \
+    X(LOG_MIDI_JOYSTICK_CC,   LOG_INFO,  LOG_CAT_MIDI,     LOG_ARGS_NAME_A,      LOG_NAMES_DIRECTION, "MIDI: Joystick %s -> CC %u = 127") \
+    X(LOG_MIDI_SWITCH_CC,     LOG_INFO,  LOG_CAT_MIDI,     LOG_ARGS_NUMBERS,     LOG_NAMES_NONE,      "MIDI: Switch %u -> CC %u = %u") \
+    X(LOG_MIDI_SWITCH_BINARY, LOG_INFO,  LOG_CAT_MIDI,     LOG_ARGS_NUMBERS,     LOG_NAMES_NONE,      "MIDI: Switch binary representation -> CC %u = %u") \
+    X(LOG_MIDI_PANIC,         LOG_INFO,  LOG_CAT_MIDI,     LOG_ARGS_NUMBERS,     LOG_NAMES_NONE,      "MIDI: All notes OFF (panic)") \
+    X(LOG_MIDI_OUT_NOTE_ON,   LOG_INFO,  LOG_CAT_MIDI,     LOG_ARGS_NUMBERS,     LOG_NAMES_NONE,      "MIDI NoteOn Ch:%u P1:%u P2:%u") \
+    X(LOG_MIDI_OUT_NOTE_OFF,  LOG_INFO,  LOG_CAT_MIDI,     LOG_ARGS_NUMBERS,     LOG_NAMES_NONE,      "MIDI NoteOff Ch:%u P1:%u P2:%u") \
+    X(LOG_MIDI_OUT_CC,        LOG_INFO,  LOG_CAT_MIDI,     LOG_ARGS_NUMBERS,     LOG_NAMES_NONE,      "MIDI CC Ch:%u P1:%u P2:%u") \
+    X(LOG_INPUT_BUTTON,       LOG_DEBUG, LOG_CAT_INPUT,    LOG_ARGS_NAME_B,      LOG_NAMES_PRESSED,   "Button %u: %s") \
+    X(LOG_INPUT_JOYSTICK,     LOG_DEBUG, LOG_CAT_INPUT,    LOG_ARGS_NAME_A,      LOG_NAMES_DIRECTION, "Joystick %s pressed (rearm: %ums)") \
+    X(LOG_INPUT_SWITCH,       LOG_DEBUG, LOG_CAT_INPUT,    LOG_ARGS_NAME_B,      LOG_NAMES_ON_OFF,    "Switch %u: %s") \
+    X(LOG_INPUT_POT,          LOG_DEBUG, LOG_CAT_INPUT,    LOG_ARGS_NUMBERS,     LOG_NAMES_NONE,      "Pot %u: %u -> MIDI %u") \
+    X(LOG_PORTAL_PROGRAM,     LOG_INFO,  LOG_CAT_PORTAL,   LOG_ARGS_NAME_A,      LOG_NAMES_PROGRAM,   "Portal program changed to: %s (%u)") \
+    X(LOG_PORTAL_BPM,         LOG_INFO,  LOG_CAT_PORTAL,   LOG_ARGS_NUMBERS,     LOG_NAMES_NONE,      "Portal BPM set to: %u.%u") \
+    X(LOG_PORTAL_INTENSITY,   LOG_INFO,  LOG_CAT_PORTAL,   LOG_ARGS_NUMBERS,     LOG_NAMES_NONE,      "Portal intensity set to: %u%%") \
+    X(LOG_PORTAL_HUE,         LOG_INFO,  LOG_CAT_PORTAL,   LOG_ARGS_NUMBERS,     LOG_NAMES_NONE,      "Portal base hue set to: %u%%") \
+    X(LOG_PORTAL_BRIGHTNESS,  LOG_INFO,  LOG_CAT_PORTAL,   LOG_ARGS_NUMBERS,     LOG_NAMES_NONE,      "Portal brightness set to: %u") \
+    X(LOG_PORTAL_FLASH,       LOG_INFO,  LOG_CAT_PORTAL,   LOG_ARGS_NUMBERS,     LOG_NAMES_NONE,      "Portal flash triggered") \
+    X(LOG_PORTAL_RIPPLE,      LOG_INFO,  LOG_CAT_PORTAL,   LOG_ARGS_NUMBERS,     LOG_NAMES_NONE,      "Portal ripple triggered at position: %u") \
+    X(LOG_PORTAL_RESET,       LOG_INFO,  LOG_CAT_PORTAL,   LOG_ARGS_NUMBERS,     LOG_NAMES_NONE,      "Portal reset to default state") \
+    X(LOG_PORTAL_MIDI_CC,     LOG_INFO,  LOG_CAT_PORTAL,   LOG_ARGS_NUMBERS,     LOG_NAMES_NONE,      "Portal MIDI CC: %u = %u") \
+    X(LOG_PORTAL_IDLE_ENTER,  LOG_INFO,  LOG_CAT_PORTAL,   LOG_ARGS_NAME_B,      LOG_NAMES_PROGRAM,   "No activity for %us - switching to IDLE mode (was %s)") \
+    X(LOG_PORTAL_IDLE_EXIT,   LOG_INFO,  LOG_CAT_PORTAL,   LOG_ARGS_NAME_A,      LOG_NAMES_PROGRAM,   "Activity detected - switching from IDLE to %s") \
+    X(LOG_PORTAL_AUTO_SWITCH, LOG_INFO,  LOG_CAT_PORTAL,   LOG_ARGS_NAME_A,      LOG_NAMES_PROGRAM,   "Auto-switching to %s for ambient display") \
+    X(LOG_PROTOCOL_FRAME,     LOG_INFO,  LOG_CAT_PROTOCOL, LOG_ARGS_NAME_A,      LOG_NAMES_COMMAND,   "Portal Serial: %s (0x%02X) = %u") \
+    X(LOG_PROTOCOL_UNKNOWN,   LOG_WARN,  LOG_CAT_PROTOCOL, LOG_ARGS_NUMBERS,     LOG_NAMES_NONE,      "Unknown serial command: 0x%02X") \
+    X(LOG_PROTOCOL_CHECKSUM,  LOG_DEBUG, LOG_CAT_PROTOCOL, LOG_ARGS_NUMBERS,     LOG_NAMES_NONE,      "Invalid message checksum: got 0x%02X, expected 0x%02X") \
+    X(LOG_PROTOCOL_TIMEOUT,   LOG_DEBUG, LOG_CAT_PROTOCOL, LOG_ARGS_NUMBERS,     LOG_NAMES_NONE,      "Serial message timeout - resetting buffer") \
+    X(LOG_PROTOCOL_OVERFLOW,  LOG_DEBUG, LOG_CAT_PROTOCOL, LOG_ARGS_NUMBERS,     LOG_NAMES_NONE,      "Serial buffer overflow - resetting") \
+    X(LOG_CONFIG_SET,         LOG_INFO,  LOG_CAT_CONFIG,   LOG_ARGS_NAME_A_WIDE, LOG_NAMES_CONFIG,    "Config %s set to %lu") \
+    X(LOG_TRACE_STOPPED,      LOG_INFO,  LOG_CAT_SYSTEM,   LOG_ARGS_NUMBERS,     LOG_NAMES_NONE,      "Input trace: %u records") \
+    X(LOG_LOOPER_STATE,       LOG_INFO,  LOG_CAT_MIDI,     LOG_ARGS_NAME_A,      LOG_NAMES_LOOPER,    "Looper: %s, %u beats, %u events") \
+    X(LOG_LOOPER_FULL,        LOG_WARN,  LOG_CAT_MIDI,     LOG_ARGS_NUMBERS,     LOG_NAMES_NONE,      "Looper: event buffer full, button %u not recorded") \
+    X(LOG_RULES_LOADED,       LOG_INFO,  LOG_CAT_CONFIG,   LOG_ARGS_NUMBERS,     LOG_NAMES_NONE,      "Rules: %u loaded, largest input group %u") \
+    X(LOG_RULES_REJECTED,     LOG_WARN,  LOG_CAT_CONFIG,   LOG_ARGS_NUMBERS,     LOG_NAMES_NONE,      "Rules: table rejected at rule %u") \
+    X(LOG_RULE_FIRED,         LOG_DEBUG, LOG_CAT_PORTAL,   LOG_ARGS_NUMBERS,     LOG_NAMES_NONE,      "Rule: source %u input %u -> action 0x%02X") \
+    X(LOG_MIDI_SWITCH_SNAPSHOT, LOG_INFO, LOG_CAT_MIDI,     LOG_ARGS_NUMBERS,     LOG_NAMES_NONE,      "MIDI: Switch bank snapshot (mode %u) = 0x%03X, %u changed") \
+    X(LOG_MIDI_OUT_SYSEX,     LOG_INFO,  LOG_CAT_MIDI,     LOG_ARGS_NUMBERS,     LOG_NAMES_NONE,      "MIDI SysEx %u bytes, type 0x%02X") \
+    X(LOG_INPUT_QUARANTINED,  LOG_WARN,  LOG_CAT_INPUT,    LOG_ARGS_NAME_B,      LOG_NAMES_HEALTH,    "Input channel %u quarantined: %s") \
+    X(LOG_INPUT_RECOVERED,    LOG_INFO,  LOG_CAT_INPUT,    LOG_ARGS_NUMBERS,     LOG_NAMES_NONE,      "Input channel %u back from quarantine") \
+    X(LOG_LED_POWER_LIMITED,  LOG_INFO,  LOG_CAT_PORTAL,   LOG_ARGS_NUMBERS,     LOG_NAMES_NONE,      "LEDs: %u mA frame over the %u mA budget, brightness %u") \
+    X(LOG_CLUSTER_NODE_JOINED, LOG_INFO, LOG_CAT_SYSTEM,   LOG_ARGS_NUMBERS,     LOG_NAMES_NONE,      "Cluster: board %u reporting") \
+    X(LOG_CLUSTER_NODE_LOST,  LOG_WARN,  LOG_CAT_SYSTEM,   LOG_ARGS_NUMBERS,     LOG_NAMES_NONE,      "Cluster: board %u stopped reporting (silent %u ms)") \
+    X(LOG_CLUSTER_ENUMERATED, LOG_INFO,  LOG_CAT_SYSTEM,   LOG_ARGS_NUMBERS,     LOG_NAMES_NONE,      "Cluster: this board is node %u (was %u)")
+
+enum LogId : uint16_t {
+    #define EVENT_LOG_ID(id, level, category, args, names, format) id,
+    EVENT_LOG_MESSAGES(EVENT_LOG_ID)
+    #undef EVENT_LOG_ID
+    LOG_ID_COUNT
+};
+
+struct LogMeta {
+    uint8_t level;
+    uint8_t category;
+    uint8_t args;
+    uint8_t names;
+};
+
+// Compile-time metadata, so a constant id's level check folds to one compare
+constexpr LogMeta LOG_META[] = {
+    #define EVENT_LOG_META(id, level, category, args, names, format) {level, category, args, names},
+    EVENT_LOG_MESSAGES(EVENT_LOG_META)
+    #undef EVENT_LOG_META
+};
+
+class EventLog {
+public:
+    static constexpr uint32_t MAGIC = 0x474F4C45;  // "ELOG"
+    static constexpr uint8_t FORMAT_VERSION = 1;
+    static constexpr uint8_t HEADER_SIZE = 16;
+
+    struct Record {
+        uint32_t timestamp;
+        uint16_t id;
+        uint16_t a;
+        uint16_t b;
+        uint16_t c;
+    };
+
+    EventLog();
+
+    void write(LogId id, uint16_t a = 0, uint16_t b = 0, uint16_t c = 0) {
+        const LogMeta& meta = LOG_META[id];
+        if (meta.level > level || !(meta.category & categories)) return;
+        if (dumping) {
+            dropped++;
+            return;
+        }
+        Record& record = records[head & INDEX_MASK];
+        record.timestamp = micros();
+        record.id = id;
+        record.a = a;
+        record.b = b;
+        record.c = c;
+        head++;
+    }
+
+    void setLevel(LogLevel newLevel) { level = newLevel; }
+    void setCategories(uint8_t mask) { categories = mask; }
+    LogLevel getLevel() const { return (LogLevel)level; }
+    uint8_t getCategories() const { return categories; }
+
+    /**
+     * @brief Format drained records onto Serial from the log task; turning
+     * it on prints what the ring still holds first
+     */
+    void setTextOutput(bool enabled);
+    bool isTextOutput() const { return textOutput; }
+
+    /**
+     * @brief Format up to EVENT_LOG_DRAIN_SLICE records, oldest first
+     * @return true while more are waiting
+     */
+    bool drainText(Print& out);
+
+    /**
+     * @brief Format one record as a line without the newline
+     * @return Characters written (truncated to size - 1)
+     */
+    static size_t format(const Record& record, char* buffer, size_t size);
+
+    /**
+     * @brief Start streaming the ring; records are dropped until it completes
+     * @return false if a dump is already running
+     */
+    bool beginDump();
+
+    /**
+     * @brief Write the header or the next EVENT_LOG_DUMP_SLICE_RECORDS records
+     * @return true while more remains
+     */
+    bool dumpSlice(Print& out);
+
+    bool isDumping() const { return dumping; }
+
+    // Records held (up to EVENT_LOG_ENTRIES) and lost to overrun or a dump
+    uint32_t getCount() const { return head < EVENT_LOG_ENTRIES ? head : EVENT_LOG_ENTRIES; }
+    uint32_t getDropped() const { return dropped; }
+
+    // Record by age: 0 = oldest kept record
+    const Record& getRecord(uint32_t index) const {
+        return records[(head - getCount() + index) & INDEX_MASK];
+    }
+
+    /**
+     * @brief Forget all records and counters (level and categories are kept)
+     */
+    void clear();
+
+private:
+    static constexpr uint32_t INDEX_MASK = EVENT_LOG_ENTRIES - 1;
+
+    Record records[EVENT_LOG_ENTRIES];
+    uint32_t head;            // Free-running write index
+    uint32_t tail;            // Next record for the text drain
+    uint32_t dropped;
+    uint32_t droppedReported;
+    uint8_t level;
+    uint8_t categories;
+    bool textOutput;
+
+    bool dumping;
+    bool dumpHeaderSent;
+    uint32_t dumpNext;
+    uint32_t dumpRemaining;
+};
+
+#if EVENT_LOG > 0
+extern EventLog eventLog;
+#define LOG_EVENT(id, ...) eventLog.write(id, ##__VA_ARGS__)
+#else
+#define LOG_EVENT(id, ...) do {} while (0)
+#endif
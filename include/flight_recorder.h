@@ -0,0 +1,146 @@
+#pragma once
+
+#include <Arduino.h>
+#include "config.h"
+
+/**
+ * @brief Persistent flight recorder of recent events and timings
+ *
+ * A fixed ring of 8-byte binary entries (micros() timestamp, type, two
+ * arguments) covering input events, MIDI sends, protocol frames and the
+ * duration of every 1 kHz scan tick. With FLIGHT_RECORDER_ENTRIES = 8192
+ * that is the last ~8 s of activity in 64 KB.
+ *
+ * The ring lives in DMAMEM, which the startup code does not clear, so it
+ * survives soft and watchdog resets: begin() keeps a valid ring and appends
+ * a FLIGHT_BOOT marker. flushToMemory() writes newly recorded entries out
+ * of the data cache so they are not lost with it on reset.
+ *
+ * Recording is an index mask and one 8-byte store. The FLIGHT_DUMP serial
+ * command streams the ring (header + raw entries, oldest first) in small
+ * slices from a background task; recording pauses while a dump runs so the
+ * dump is consistent.
+ *
+ * Dump format (little-endian):
+ *   header  "FLTR", u8 version, u8 entry size, u16 boot count,
+ *           u32 entry count, u32 micros() at dump start
+ *   entries u32 timestamp, u8 type, u8 a, u16 b
+ */
+
+// Entry types and their arguments
+enum FlightEventType : uint8_t {
+    FLIGHT_BOOT = 1,        // a = reset cause (SRC_SRSR low byte), b = boot count
+    FLIGHT_BUTTON = 2,      // a = button, b = pressed
+    FLIGHT_JOYSTICK = 3,    // a = direction, b = pressed
+    FLIGHT_SWITCH = 4,      // a = switch, b = on
+    FLIGHT_POT = 5,         // a = pot, b = smoothed raw value
+    FLIGHT_NOTE_ON = 6,     // a = note, b = velocity | channel << 8
+    FLIGHT_NOTE_OFF = 7,    // a = note, b = velocity | channel << 8
+    FLIGHT_CC = 8,          // a = controller, b = value | channel << 8
+    FLIGHT_FRAME_RX = 9,    // a = command, b = value (valid frame)
+    FLIGHT_FRAME_BAD = 10,  // a = command, b = value (checksum failed)
+    FLIGHT_FRAME_TX = 11,   // a = command, b = value
+    FLIGHT_TICK = 12,       // a = 0, b = scan tick duration in us (timestamp = tick start)
+    FLIGHT_GAP = 13,        // Session files only: a = 0 ring overrun (b = entries lost), 1 = dump pause
+    FLIGHT_REMOTE = 14,     // Cluster primary: a = node << 4 | ClusterEventType, b = index | value << 8
+                            // (timestamp = event time on this board's clock, recorded when merged)
+    FLIGHT_HEALTH = 15      // a = input health channel, b = InputHealthMonitor::Fault (0 = recovered)
+};
+
+class FlightRecorder {
+public:
+    static constexpr uint32_t MAGIC = 0x464C5452;  // "FLTR"
+    static constexpr uint8_t FORMAT_VERSION = 1;
+    static constexpr uint8_t HEADER_SIZE = 16;
+
+    struct Entry {
+        uint32_t timestamp;
+        uint8_t type;
+        uint8_t a;
+        uint16_t b;
+    };
+
+    // Backing store; place in no-init memory to survive resets
+    struct Storage {
+        uint32_t magic;
+        uint32_t head;        // Free-running write index
+        uint32_t count;       // Valid entries (saturates at FLIGHT_RECORDER_ENTRIES)
+        uint32_t bootCount;
+        Entry entries[FLIGHT_RECORDER_ENTRIES];
+    };
+
+    explicit FlightRecorder(Storage* storage);
+
+    /**
+     * @brief Keep a valid ring from before the reset (or start a new one)
+     * and record a FLIGHT_BOOT marker; call early in setup()
+     */
+    void begin();
+
+    void record(FlightEventType type, uint8_t a, uint16_t b) {
+        recordAt(micros(), type, a, b);
+    }
+
+    void recordAt(uint32_t timestamp, FlightEventType type, uint8_t a, uint16_t b) {
+        if (dumping) return;
+        Entry& entry = storage->entries[storage->head & INDEX_MASK];
+        entry.timestamp = timestamp;
+        entry.type = type;
+        entry.a = a;
+        entry.b = b;
+        storage->head++;
+        if (storage->count < FLIGHT_RECORDER_ENTRIES) storage->count++;
+    }
+
+    /**
+     * @brief Write entries recorded since the last call out of the data cache
+     */
+    void flushToMemory();
+
+    /**
+     * @brief Start streaming the ring; recording pauses until it completes
+     * @return false if a dump is already running
+     */
+    bool beginDump();
+
+    /**
+     * @brief Write the next FLIGHT_DUMP_SLICE_ENTRIES of a running dump
+     * @return true while more remains
+     */
+    bool dumpSlice(Print& out);
+
+    bool isDumping() const { return dumping; }
+    uint32_t getCount() const { return storage->count; }
+    uint32_t getBootCount() const { return storage->bootCount; }
+
+    // Entry by age: 0 = oldest kept entry
+    const Entry& getEntry(uint32_t index) const {
+        return storage->entries[(storage->head - storage->count + index) & INDEX_MASK];
+    }
+
+    // Free-running write index, for readers that follow the ring as it fills
+    uint32_t getHead() const { return storage->head; }
+
+    // Entry by write index; valid while head - sequence <= FLIGHT_RECORDER_ENTRIES
+    const Entry& getEntryAt(uint32_t sequence) const {
+        return storage->entries[sequence & INDEX_MASK];
+    }
+
+private:
+    static constexpr uint32_t INDEX_MASK = FLIGHT_RECORDER_ENTRIES - 1;
+
+    Storage* storage;
+    uint32_t flushedHead;
+
+    bool dumping;
+    bool dumpHeaderSent;
+    uint32_t dumpNext;        // Ring index of the next entry to send
+    uint32_t dumpRemaining;
+};
+
+#if FLIGHT_RECORDER > 0
+extern FlightRecorder flightRecorder;
+#define FLIGHT_RECORD(type, a, b) flightRecorder.record(type, a, b)
+#else
+#define FLIGHT_RECORD(type, a, b) do {} while (0)
+#endif
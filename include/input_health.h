@@ -0,0 +1,101 @@
+#pragma once
+
+#include <Arduino.h>
+#include "config.h"
+#include "pins.h"
+
+/**
+ * @brief Spots misbehaving inputs and quarantines them until they settle
+ *
+ * A worn switch that chatters, a button wedged down or a floating pot
+ * floods MIDI and keeps resetting the idle timer, so the portal never
+ * dims. The input processor reports what it sees each scan tick; the
+ * monitor looks for three faults:
+ *   CHATTER  more debounced edges in one INPUT_HEALTH_WINDOW_MS window
+ *            than a hand makes (INPUT_HEALTH_MAX_EDGES, or
+ *            INPUT_HEALTH_MAX_SWITCH_EDGES for the toggle switches)
+ *   STUCK    a button or joystick direction read active without a break
+ *            for INPUT_HEALTH_STUCK_MS (switches stay on by design)
+ *   NOISE    a pot whose sent value turns back more than
+ *            INPUT_HEALTH_MAX_POT_REVERSALS times in one window
+ *
+ * A quarantined input reads as released (a pot stops reporting changes)
+ * and its edges no longer count as activity. The input keeps being
+ * watched, and it is let back in once INPUT_HEALTH_RECOVERY_MS pass
+ * without the fault. Each change is logged and recorded in the flight
+ * recorder (FLIGHT_HEALTH), which the Ethernet transport forwards.
+ *
+ * Inputs are numbered as channels in one 32-bit mask: buttons, then
+ * joystick directions, switches and pots (the *_CHANNEL bases below).
+ */
+class InputHealthMonitor {
+public:
+    enum Fault : uint8_t {
+        HEALTH_OK = 0,
+        HEALTH_CHATTER = 1,
+        HEALTH_STUCK = 2,
+        HEALTH_NOISE = 3
+    };
+
+    static constexpr uint8_t BUTTON_CHANNEL = 0;
+    static constexpr uint8_t JOYSTICK_CHANNEL = BUTTON_CHANNEL + BUTTON_COUNT;
+    static constexpr uint8_t SWITCH_CHANNEL = JOYSTICK_CHANNEL + 4;
+    static constexpr uint8_t POT_CHANNEL = SWITCH_CHANNEL + SWITCH_COUNT;
+    static constexpr uint8_t CHANNEL_COUNT = POT_CHANNEL + POT_COUNT;
+    static_assert(CHANNEL_COUNT <= 32, "input health channels are one 32-bit mask");
+
+    InputHealthMonitor();
+
+    static const char* faultName(uint8_t fault);
+
+    /**
+     * @brief Forget all history and lift every quarantine
+     */
+    void reset(uint32_t nowMs);
+
+    /**
+     * @brief Debounced edges of this tick, as a channel mask
+     * @return Mask of the edges from inputs not in quarantine (activity)
+     */
+    uint32_t recordEdges(uint32_t channels, uint32_t nowMs);
+
+    /**
+     * @brief A pot sent a new MIDI value
+     * @return false if the pot is in quarantine
+     */
+    bool recordPot(uint8_t pot, uint8_t value, uint32_t nowMs);
+
+    /**
+     * @brief Once per scan tick, after the edges
+     * @param rawActive Channels read active before debouncing (buttons and
+     * joystick; others are ignored)
+     */
+    void update(uint32_t rawActive, uint32_t nowMs);
+
+    uint32_t getQuarantined() const { return quarantined; }
+    bool isQuarantined(uint8_t channel) const { return (quarantined >> (channel & 31)) & 1; }
+    uint8_t getFault(uint8_t channel) const { return channel < CHANNEL_COUNT ? fault[channel] : HEALTH_OK; }
+
+    uint32_t getQuarantineCount() const { return quarantineCount; }
+    uint32_t getSuppressed() const { return suppressed; }
+
+    void printStats(Print& out) const;
+
+private:
+    uint32_t quarantined;
+    uint32_t rawActive;
+    uint32_t windowStart;
+    uint32_t activeSince[CHANNEL_COUNT];
+    uint32_t releaseAt[CHANNEL_COUNT];    // Quarantine lifts at this time if the fault stays away
+    uint8_t edges[CHANNEL_COUNT];         // This window, saturating
+    uint8_t fault[CHANNEL_COUNT];
+    uint8_t lastPotValue[POT_COUNT];
+    int8_t lastPotDirection[POT_COUNT];
+
+    // Statistics
+    uint32_t quarantineCount;
+    uint32_t suppressed;                  // Edges and pot sends held back
+
+    void flag(uint8_t channel, uint8_t newFault, uint32_t nowMs);
+    void closeWindow(uint32_t nowMs);
+};
@@ -3,6 +3,7 @@
 #include <Arduino.h>
 #include "pins.h"
 #include "config.h"
+#include "input_trace.h"
 
 /**
  * @brief Raw input scanner for all hardware inputs
@@ -25,13 +26,25 @@ public:
      */
     void scan();
     
+    /**
+     * @brief Take one scan's readings from a frame instead of the pins
+     * (trace replay); same edge tracking as scan()
+     */
+    void scanFrame(const RawInputFrame& frame);
+    
+    /**
+     * @brief Readings of the last scan, for trace capture
+     */
+    void getRawFrame(RawInputFrame& frame) const;
+    
     // Button state access
     bool getButtonState(uint8_t buttonIndex) const;
     bool getButtonPressed(uint8_t buttonIndex) const;
     bool getButtonReleased(uint8_t buttonIndex) const;
     
     // Joystick state access
-    bool getJoystickPressed(uint8_t direction) const;  // 0=Up, 1=Down, 2=Left, 3=Right
+    bool getJoystickState(uint8_t direction) const;    // 0=Up, 1=Down, 2=Left, 3=Right
+    bool getJoystickPressed(uint8_t direction) const;
     
     // Switch state access
     bool getSwitchState(uint8_t switchIndex) const;
@@ -62,4 +75,5 @@ private:
     void scanJoystick();
     void scanSwitches();
     void scanPots();
+    void saveLastStates();
 };
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <Arduino.h>
+#include "pins.h"
+#include "config.h"
+
+/**
+ * @brief Raw input levels seen by one scan tick (before debouncing/smoothing)
+ */
+struct RawInputFrame {
+    uint16_t buttons;           // Bit i = button i pressed
+    uint8_t joystick;           // Bits 0-3 = Up, Down, Left, Right pressed
+    uint16_t switches;          // Bit i = switch i on
+    uint16_t pots[POT_COUNT];   // Raw 10-bit ADC readings
+};
+
+/**
+ * @brief Deterministic input trace: capture raw scan input, replay it later
+ *
+ * A trace holds the raw frames the scanner read, change-only: each record
+ * is 3 bytes (tag, u16 value) and the tag carries the ticks elapsed since
+ * the previous record, so an idle panel costs nothing and a jittery pot
+ * about 3 bytes per noisy tick. Replaying the frames through
+ * RobustInputProcessor::update(frame) and RobustMidiMapper gives the same
+ * MIDI stream on the device and on the host (make trace-replay), which is
+ * what lets golden-output diffs judge a debounce or filter change.
+ *
+ * Format (little-endian):
+ *   header  "ITRC", u8 version, u8 button count, u8 switch count,
+ *           u8 pot count, u16 tick period in us, u16 reserved,
+ *           u32 record bytes, u32 duration in ticks
+ *   records u8 tag = source | ticks since previous record << 3, u16 value
+ *
+ * Sources: buttons mask, joystick mask, switches mask, one per pot (raw
+ * value) and TRACE_WAIT, whose value adds ticks for gaps longer than the
+ * tag can hold. A trace starts with every source at tick 0.
+ */
+
+enum InputTraceSource : uint8_t {
+    TRACE_BUTTONS = 0,
+    TRACE_JOYSTICK = 1,
+    TRACE_SWITCHES = 2,
+    TRACE_POT = 3,          // TRACE_POT + i = pot i
+    TRACE_WAIT = 7          // Value = extra ticks before the next record
+};
+
+static_assert(TRACE_POT + POT_COUNT <= TRACE_WAIT, "Trace tags hold at most 4 pots");
+static_assert(BUTTON_COUNT <= 16 && SWITCH_COUNT <= 16, "Trace masks are 16 bits");
+
+class InputTraceRecorder {
+public:
+    static constexpr uint32_t MAGIC = 0x43525449;  // "ITRC"
+    static constexpr uint8_t FORMAT_VERSION = 1;
+    static constexpr uint8_t HEADER_SIZE = 20;
+    static constexpr uint8_t RECORD_SIZE = 3;
+    static constexpr uint8_t MAX_TAG_TICKS = 31;
+
+    /**
+     * @param buffer Header and records; the trace is complete at any time
+     */
+    InputTraceRecorder(uint8_t* buffer, size_t capacity);
+
+    /**
+     * @brief Start a new trace at timeUs with tick period tickUs
+     */
+    void begin(uint32_t timeUs, uint16_t tickUs = SCAN_PERIOD_US);
+
+    /**
+     * @brief Add the frame scanned at timeUs; only changed sources are stored
+     * @return false once the buffer is full (capture stops)
+     */
+    bool capture(const RawInputFrame& frame, uint32_t timeUs);
+
+    /**
+     * @brief Close the trace: the duration then covers the last idle ticks too
+     */
+    void end(uint32_t timeUs);
+
+    bool isCapturing() const { return capturing; }
+    const uint8_t* data() const { return buffer; }
+    size_t size() const { return HEADER_SIZE + recordBytes; }
+    uint32_t getRecordCount() const { return recordBytes / RECORD_SIZE; }
+
+private:
+    uint8_t* buffer;
+    size_t capacity;
+    bool capturing;
+    uint32_t startUs;
+    uint16_t tickUs;
+    uint32_t recordBytes;
+    uint32_t lastTick;          // Tick of the last record
+    uint32_t durationTicks;
+    RawInputFrame last;
+
+    bool put(uint8_t source, uint32_t tick, uint16_t value);
+    void writeHeader();
+};
+
+class InputTracePlayer {
+public:
+    InputTracePlayer();
+
+    /**
+     * @brief Open a trace (header + records, as dumped or built by a recorder)
+     * @return false if the header is invalid or the input counts differ
+     */
+    bool begin(const uint8_t* trace, size_t length);
+
+    /**
+     * @brief Frame at elapsedUs since the start of replay (all records up to
+     * that tick applied). Call with increasing times.
+     * @return false once elapsedUs is past the end of the trace
+     */
+    bool advance(uint32_t elapsedUs, RawInputFrame& frame);
+
+    // First frame of the trace, for RobustInputProcessor::restart()
+    const RawInputFrame& getInitialFrame() const { return initial; }
+
+    uint16_t getTickUs() const { return tickUs; }
+    uint32_t getDurationTicks() const { return durationTicks; }
+    uint32_t getDurationUs() const { return durationTicks * tickUs; }
+    bool isPlaying() const { return records != nullptr; }
+
+private:
+    const uint8_t* records;
+    const uint8_t* recordsEnd;
+    const uint8_t* next;
+    uint16_t tickUs;
+    uint32_t durationTicks;
+    uint32_t nextTick;          // Tick of *next
+    RawInputFrame current;
+    RawInputFrame initial;
+
+    // Decode the record at *next into current and move past it
+    void apply();
+    void loadNextTick(uint32_t fromTick);
+};
+
+#if INPUT_TRACE > 0
+/**
+ * @brief Firmware trace: a capture buffer in OCRAM, TRACE_DUMP streaming and
+ * on-device replay of the captured trace
+ */
+class InputTrace {
+public:
+    InputTrace(uint8_t* buffer, size_t capacity);
+
+    /**
+     * @brief Start a new capture (replaces the previous trace)
+     * @return false while the trace is being replayed or dumped
+     */
+    bool startCapture();
+    void stopCapture() { if (recorder.isCapturing()) recorder.end(micros()); }
+
+    // Call after every scan with the frame the processor just used
+    void capture(const RawInputFrame& frame) {
+        if (recorder.isCapturing()) recorder.capture(frame, micros());
+    }
+
+    /**
+     * @brief Replay the captured trace; the caller restarts the input
+     * pipeline with getInitialFrame() and feeds nextFrame() to it per tick
+     * @return false if there is no complete trace or a replay is running
+     */
+    bool startReplay();
+    bool nextFrame(RawInputFrame& frame);
+    bool isReplaying() const { return replaying; }
+    const RawInputFrame& getInitialFrame() const { return player.getInitialFrame(); }
+
+    /**
+     * @brief Stream the captured trace (header + records) in slices
+     * @return false while capturing or if a dump is running
+     */
+    bool beginDump();
+    bool dumpSlice(Print& out);
+    bool isDumping() const { return dumping; }
+
+    bool isCapturing() const { return recorder.isCapturing(); }
+    uint32_t getRecordCount() const { return recorder.getRecordCount(); }
+
+private:
+    InputTraceRecorder recorder;
+    InputTracePlayer player;
+    bool replaying;
+    uint32_t replayStartUs;
+    bool dumping;
+    size_t dumpOffset;
+};
+
+extern InputTrace inputTrace;
+#endif
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <Arduino.h>
+#include <FastLED.h>
+#include "config.h"
+
+/**
+ * @brief Per-frame LED current estimate and brightness limiter
+ *
+ * LED_BRIGHTNESS_MAX caps every frame the same way, so it has to be set
+ * for the worst one: a white flash on top of a bright program. The
+ * limiter instead estimates what each rendered frame will draw and only
+ * pulls brightness down for the frames that would exceed the budget.
+ *
+ * The estimate is the per-channel sum over the framebuffer times the
+ * LED_POWER_MA_* coefficients, scaled by the brightness FastLED applies,
+ * plus LED_POWER_MA_DARK per LED. The sum reads the frame a word at a
+ * time into 16-bit lanes (UXTAB16 on the Cortex-M7, a mask and add
+ * elsewhere), a few hundred cycles for the whole strip.
+ *
+ * A frame over budget gets the highest brightness that fits, in that same
+ * frame. Once frames fit again the brightness climbs back by
+ * LED_POWER_RELEASE_STEP per frame, so a burst of flashes dims the portal
+ * smoothly instead of pumping.
+ */
+class LedPowerLimiter {
+public:
+    LedPowerLimiter();
+
+    /**
+     * @brief Brightness the portal asks for and the budget (0 = no limit)
+     */
+    void configure(uint8_t brightness, uint16_t budgetMa);
+
+    /**
+     * @brief Estimate a rendered frame and limit it
+     * @return Brightness to show the frame at (FastLED.setBrightness)
+     */
+    uint8_t update(const CRGB* leds, uint16_t count);
+
+    /**
+     * @brief Estimated draw of a frame at a brightness, in mA
+     */
+    static uint32_t estimateMa(const CRGB* leds, uint16_t count, uint8_t brightness);
+
+    /**
+     * @brief Sum of each channel over the frame
+     * @param sums Red, green, blue
+     */
+    static void sumChannels(const CRGB* leds, uint16_t count, uint32_t sums[3]);
+
+    uint8_t getBrightness() const { return brightness; }
+    uint8_t getLimit() const { return limit; }
+    uint16_t getBudgetMa() const { return budgetMa; }
+    uint32_t getLastMa() const { return lastMa; }
+    uint32_t getPeakMa() const { return peakMa; }
+    uint32_t getLimitedFrames() const { return limitedFrames; }
+
+    void printStats(Print& out) const;
+
+private:
+    uint8_t brightness;
+    uint16_t budgetMa;
+    uint8_t limit;              // Ceiling on brightness, 255 when not limiting
+
+    // Statistics
+    uint32_t lastMa;            // Last frame as shown
+    uint32_t peakMa;            // Largest frame as rendered, before limiting
+    uint32_t limitedFrames;
+};
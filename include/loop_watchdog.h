@@ -0,0 +1,142 @@
+#pragma once
+
+#include <Arduino.h>
+#include "config.h"
+
+class PerfMonitor;
+class TaskScheduler;
+
+/**
+ * @brief Hardware watchdog (i.MX RT WDOG1) fed by scheduler check-ins
+ *
+ * The watchdog is only fed once every watched task has completed at least
+ * one job since the previous feed, so a stalled or starved stage (I2C hang
+ * in the OLED transfer, USB blocking in Serial.flush(), a runaway loop)
+ * leads to a reset instead of a silent freeze.
+ *
+ * WATCHDOG_WARNING_MS before the reset the early-warning interrupt stores
+ * a StallRecord in no-init RAM: the task and PerfStage that were running,
+ * the cycle count, which tasks had checked in, and the last
+ * STALL_EVENT_COUNT scheduler events. The record survives the reset; the
+ * next boot picks it up with checkBootReport() and reports it on serial;
+ * the Pi can fetch it any time with the STALL_REPORT protocol command.
+ *
+ * Compiled to a no-op with WATCHDOG == 0 or on non-i.MX RT targets.
+ */
+
+class LoopWatchdog {
+public:
+    static constexpr uint8_t STALL_EVENT_COUNT = 16;
+    static constexpr uint8_t NO_TASK = 0xFF;
+
+    enum EventType : uint8_t {
+        EVENT_TASK_ENTER = 1,   // Scheduler started a slice
+        EVENT_TASK_DONE = 2,    // Task completed a job (check-in)
+        EVENT_FEED = 3          // Hardware watchdog fed
+    };
+
+    struct Event {
+        uint32_t cycles;
+        uint8_t type;
+        uint8_t id;
+    };
+
+    // Written by the early-warning ISR, read back on the next boot
+    struct StallRecord {
+        uint32_t magic;
+        uint32_t cycles;          // ARM_DWT_CYCCNT when the warning fired
+        uint32_t uptimeMs;
+        uint32_t checkedIn;       // Task bits that had checked in
+        uint32_t required;        // Task bits that had to check in
+        uint8_t task;             // Task running at the warning (NO_TASK = none)
+        uint8_t stage;            // PerfStage running (PERF_STAGE_COUNT = none)
+        uint8_t eventHead;        // Next write index in events
+        uint8_t eventCount;
+        Event events[STALL_EVENT_COUNT];
+        uint32_t checksum;
+    };
+
+    LoopWatchdog();
+
+    /**
+     * @brief Read (and clear) the stall record left by a previous watchdog
+     * reset; call first thing in setup()
+     * @return true if the last reset was a detected stall
+     */
+    bool checkBootReport();
+
+    /**
+     * @brief Add a scheduler task to the set that must check in before a feed
+     */
+    void watchTask(uint8_t id);
+
+    /**
+     * @brief Optional source for the stage running at the warning
+     */
+    void setPerfMonitor(const PerfMonitor* monitor) { perfMonitor = monitor; }
+
+    /**
+     * @brief Start the hardware watchdog; call after the tasks are registered
+     * @param taskScheduler Scheduler whose task names are used in reports
+     */
+    void begin(const TaskScheduler* taskScheduler);
+
+    // Scheduler hooks
+    void enterTask(uint8_t id) {
+        currentTask = id;
+        recordEvent(EVENT_TASK_ENTER, id);
+    }
+    void checkIn(uint8_t id);
+    void leaveTask() { currentTask = NO_TASK; }
+
+    // Boot report
+    bool hasStallReport() const { return stallReported; }
+    const StallRecord& getStallReport() const { return lastStall; }
+    void printStallReport(Print& out) const;
+
+    // Called from the early-warning interrupt
+    void onWarning();
+
+    uint32_t getFeedCount() const { return feedCount; }
+
+private:
+    const PerfMonitor* perfMonitor;
+    const TaskScheduler* scheduler;
+    bool running;
+    uint32_t requiredMask;
+    volatile uint32_t checkedInMask;
+    volatile uint8_t currentTask;
+    uint32_t feedCount;
+
+    Event events[STALL_EVENT_COUNT];
+    uint8_t eventHead;
+    uint8_t eventCount;
+
+    bool stallReported;
+    StallRecord lastStall;
+
+    void recordEvent(uint8_t type, uint8_t id) {
+        Event& event = events[eventHead];
+        event.cycles = cycles();
+        event.type = type;
+        event.id = id;
+        eventHead = (eventHead + 1) % STALL_EVENT_COUNT;
+        if (eventCount < STALL_EVENT_COUNT) eventCount++;
+    }
+
+    void feed();
+
+    static uint32_t cycles() {
+        #ifdef ARM_DWT_CYCCNT
+        return ARM_DWT_CYCCNT;
+        #else
+        return micros();
+        #endif
+    }
+
+    static uint32_t checksum(const StallRecord& record);
+};
+
+#if WATCHDOG > 0
+extern LoopWatchdog loopWatchdog;
+#endif
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * @brief Memory placement scheme for the Teensy 4.1 (i.MX RT1062)
+ *
+ *   ITCM  (RAM1, FASTRUN)   Code on the 1 kHz scan path, the portal render
+ *                           kernels, the scheduler and the watchdog ISR.
+ *                           Zero-wait fetch, never evicted by other code.
+ *   Flash (FLASHMEM)        setup(), begin() and on-request diagnostics.
+ *                           Runs once or rarely through the 32 KB I-cache.
+ *   DTCM  (RAM1, default)   Globals and const tables: input state, leds[],
+ *                           the protocol receive buffer, profiler bins.
+ *                           Uncached and zero-wait, so hot state never misses.
+ *   OCRAM (RAM2, DMAMEM)    Large and no-init buffers (flight recorder ring,
+ *                           watchdog stall record). Write-back cached: flush
+ *                           with flushDataCache() before DMA reads them or a
+ *                           reset would lose them.
+ *
+ * The stock linker script also puts unmarked code in ITCM; FASTRUN states
+ * the intent for the hot paths, and FLASHMEM on cold code is what frees
+ * RAM1 (ITCM and DTCM share it in 32 KB banks). Heap allocations (the
+ * SSD1306 frame buffer, String) come from OCRAM, so nothing on the scan
+ * path allocates.
+ *
+ * On host builds the section macros are empty and the cache helpers no-ops.
+ */
+
+#ifndef FASTRUN
+#define FASTRUN
+#endif
+
+#ifndef FLASHMEM
+#define FLASHMEM
+#endif
+
+#ifndef DMAMEM
+#define DMAMEM
+#endif
+
+// OCRAM buffers start on a cache line so maintenance never touches neighbours
+constexpr size_t CACHE_LINE_SIZE = 32;
+#define CACHE_ALIGNED alignas(CACHE_LINE_SIZE)
+
+/**
+ * @brief Write a cached OCRAM range back to memory (DMA source, no-init data)
+ */
+inline void flushDataCache(const void* start, size_t bytes) {
+    #ifdef __IMXRT1062__
+    if (bytes) arm_dcache_flush(const_cast<void*>(start), bytes);
+    #else
+    (void)start;
+    (void)bytes;
+    #endif
+}
+
+// Address range checks for the placement self-test
+inline bool isInItcm(const void* address) {
+    return reinterpret_cast<uintptr_t>(address) < 0x00080000UL;
+}
+
+inline bool isInDtcm(const void* address) {
+    uintptr_t a = reinterpret_cast<uintptr_t>(address);
+    return a >= 0x20000000UL && a < 0x20080000UL;
+}
+
+inline bool isInOcram(const void* address) {
+    uintptr_t a = reinterpret_cast<uintptr_t>(address);
+    return a >= 0x20200000UL && a < 0x20280000UL;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <Arduino.h>
+#include "config.h"
+#include "pins.h"
+#include "midi_out.h"
+#include "static_input_pipeline.h"
+
+/**
+ * @brief Button loop recorded and played back on the Teensy
+ *
+ * A looper on the Pi hears the buttons a USB round trip late and plays
+ * back with the Pi's scheduling jitter. This one records button note
+ * on/off edges as they are debounced and plays them through MidiOut from
+ * the 1 kHz scan tick, so loop timing never crosses USB.
+ *
+ * The loop clock counts LOOPER_TICKS_PER_BEAT ticks per beat at the portal
+ * BPM, exactly (integer remainder, no drift); a BPM change stretches the
+ * loop with it. Recorded note-ons snap to the nearest of
+ * LOOPER_QUANTIZE_STEPS steps per beat and their note-offs move with them.
+ * A note that snaps ahead of the clock is not replayed until the next
+ * pass. The first recording's length is rounded to whole beats when it is
+ * closed.
+ *
+ * Gestures, while switch LOOPER_SWITCH is on:
+ *   joystick right   empty -> record -> play <-> overdub
+ *   joystick left    clear
+ * Turning the switch off mutes playback (the loop keeps time) and drops a
+ * recording in progress. The joystick still sends its CC as usual.
+ */
+class MidiLooper {
+public:
+    enum State : uint8_t {
+        LOOPER_EMPTY = 0,
+        LOOPER_RECORDING = 1,       // First pass; length set when it closes
+        LOOPER_PLAYING = 2,
+        LOOPER_OVERDUBBING = 3      // Playing and recording into the loop
+    };
+
+    explicit MidiLooper(MidiOut& midi);
+
+    /**
+     * @brief Gestures and button edges of this scan tick, at the loop
+     * clock's current position (call update() first)
+     */
+    void captureInputs(const InputProcessor& inputs);
+
+    /**
+     * @brief Advance the loop clock to now at bpm; plays whatever falls due
+     */
+    void update(uint32_t now, float bpm);
+
+    // The operations behind the gestures
+    void setEnabled(bool enabled);
+    void pressRecord();
+    void clear();
+    void noteEdge(uint8_t button, bool on);
+
+    // Steps per beat recorded notes snap to; 0 = as played
+    void setQuantize(uint8_t stepsPerBeat) { quantizeSteps = stepsPerBeat; }
+
+    State getState() const { return (State)state; }
+    bool isEnabled() const { return enabled; }
+    uint16_t getEventCount() const { return count; }
+    uint16_t getLengthTicks() const { return length; }
+    uint16_t getPosition() const { return position; }
+    uint32_t getPlayed() const { return played; }
+    uint32_t getDropped() const { return dropped; }
+    uint32_t getMaxLateUs() const { return maxLateUs; }
+
+    void printStats(Print& out) const;
+
+    static const char* stateName(uint8_t state);
+
+private:
+    struct Event {
+        uint16_t tick;
+        uint8_t button;
+        uint8_t flags;              // EVENT_ON, EVENT_FRESH
+    };
+
+    static constexpr uint8_t EVENT_ON = 0x01;
+    static constexpr uint8_t EVENT_FRESH = 0x02;   // Snapped ahead of the clock: skip once
+
+    static constexpr uint32_t MAX_TICKS = (uint32_t)LOOPER_MAX_BEATS * LOOPER_TICKS_PER_BEAT;
+    // Loop clock remainder units per tick: us x milli-BPM x ticks per beat
+    static constexpr uint64_t TICK_UNITS = 60000000000ULL;
+
+    void closeLoop();
+    void insert(uint16_t tick, uint8_t button, uint8_t flags);
+    void play(const Event& event);
+    void silence();
+    void setState(uint8_t newState);
+    uint16_t snap(uint32_t tick) const;
+
+    MidiOut& midi;
+
+    Event events[LOOPER_MAX_EVENTS];  // Sorted by tick
+    uint16_t count;
+    uint16_t cursor;                // First event with tick > position
+
+    uint8_t state;
+    bool enabled;
+    uint8_t quantizeSteps;
+
+    // Loop clock
+    uint32_t lastUpdate;
+    uint32_t bpmMilli;
+    uint64_t remainder;             // Fraction of a tick, TICK_UNITS per tick
+    uint32_t position;              // Ticks from the loop start
+    uint16_t length;                // Loop length in ticks, 0 while recording
+
+    // Button edge tracking and notes being recorded
+    uint16_t lastButtons;
+    uint16_t recording;             // Note-on recorded, note-off still to come
+    int16_t shift[BUTTON_COUNT];    // Quantize offset of the recorded note-on
+    uint16_t onTick[BUTTON_COUNT];
+    uint16_t sounding;              // Looped notes currently on
+
+    // Statistics
+    uint32_t played;
+    uint32_t dropped;               // Note-ons not recorded: buffer full
+    uint32_t maxLateUs;             // Worst due time -> send
+};
+
+#if MIDI_LOOPER > 0
+extern MidiLooper midiLooper;      // Defined in main.cpp, next to midiOut
+#endif
@@ -55,8 +55,13 @@ public:
      */
     void sendControlChange(uint8_t controller, uint8_t value, uint8_t channel = 1);
     
+    /**
+     * @brief Send a complete SysEx message
+     * @param data Message including the F0 and F7 bytes
+     * @param length Bytes in data
+     */
+    void sendSysEx(const uint8_t* data, uint8_t length);
+    
 private:
     OledDisplay* oledDisplay;
-    
-    void debugMidi(const char* type, uint8_t param1, uint8_t param2, uint8_t channel);
 };
@@ -6,6 +6,10 @@
 #include <Adafruit_SSD1306.h>
 #include "pins.h"
 #include "config.h"
+#include "oled_text.h"
+
+// Forward declaration to avoid circular dependency
+class PerfMonitor;
 
 /**
  * @brief OLED Display Controller for Mystery Melody Machine
@@ -18,6 +22,7 @@
  * - STATUS: Shows system status and input values
  * - ACTIVITY: Shows input activity visualization
  * - INFO: Shows device information and settings
+ * - PERF: Shows per-stage time budgets and the loop-time histogram
  */
 class OledDisplay {
 public:
@@ -26,6 +31,7 @@ public:
         STATUS = 1,      // System status and input values
         ACTIVITY = 2,    // Input activity visualization
         INFO = 3,        // Device info and settings
+        PERF = 4,        // Performance dashboard
         MODE_COUNT       // Total number of modes
     };
     
@@ -36,15 +42,32 @@ public:
     
     /**
      * @brief Initialize the OLED display
+     * Sends the controller init sequence (~2 ms) and renders the startup
+     * message into the buffer; it is sent by the next update() or sliced
+     * transfer and kept on screen for OLED_SPLASH_MS.
      * @return true if initialization successful, false otherwise
      */
     bool begin();
     
     /**
      * @brief Update the display content (call regularly)
+     * Renders and transfers the whole frame in one blocking call.
      */
     void update();
     
+    /**
+     * @brief Render the current mode into the frame buffer (no I2C traffic)
+     * First step of a cooperatively sliced update; follow with transferSlice().
+     * @return false if the display is not initialized
+     */
+    bool beginFrame();
+    
+    /**
+     * @brief Send the next OLED_TRANSFER_SLICE_BYTES of the frame over I2C
+     * @return true while more of the frame remains to be sent
+     */
+    bool transferSlice();
+    
     /**
      * @brief Switch to next display mode
      */
@@ -111,21 +134,36 @@ public:
     
     /**
      * @brief Update system information
-     * @param loopTimeUs Current main loop time in microseconds
+     * @param loopTimeUs Worst main loop pass time in the last window (microseconds)
      * @param isIdle Whether system is in idle state
      * @param uptime System uptime in milliseconds
      */
     void updateSystemInfo(uint32_t loopTimeUs, bool isIdle, uint32_t uptime);
+    
+    /**
+     * @brief Set boot time shown on the INFO page
+     * @param firstScanUs Time from reset to the first input scan (microseconds)
+     */
+    void setBootTime(uint32_t firstScanUs) { bootTimeUs = firstScanUs; }
+    
+    /**
+     * @brief Set performance monitor for the PERF dashboard (optional)
+     * @param monitor Pointer to PerfMonitor instance, or nullptr to disable
+     */
+    void setPerfMonitor(const PerfMonitor* monitor) { perfMonitor = monitor; }
 
 private:
     // Display hardware
     Adafruit_SSD1306 display;
+    OledTextRenderer text;     // Fast glyph blitter into display's page buffer
     bool initialized;
     
     // Display state
     DisplayMode currentMode;
+    uint16_t transferOffset;   // Next frame buffer byte for transferSlice()
     uint32_t lastUpdate;
     uint32_t modeDisplayTime;  // Time when current mode was set
+    uint32_t initTime;         // millis() at begin(), for the startup message
     
     // MIDI log state
     static constexpr uint8_t MIDI_LOG_SIZE = 8;
@@ -152,17 +190,23 @@ private:
     uint32_t loopTimeUs;
     bool isIdle;
     uint32_t uptime;
+    uint32_t bootTimeUs;
+    const PerfMonitor* perfMonitor;
     
     // Private methods
+    void renderCurrentMode();
     void drawMidiLog();
     void drawStatus();
     void drawActivity();
     void drawInfo();
+    void drawPerf();
     void addMidiLogEntry(const char* message);
     void drawHeader();
     void drawScrollIndicator();
     
     // Note name conversion
     const char* getNoteNameFromMidi(uint8_t note);
+    void formatNoteMessage(char* out, size_t size, const char* type,
+                           uint8_t note, uint8_t velocity, uint8_t channel);
     static const char* NOTE_NAMES[12];
 };
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief Fixed-font text renderer for the SSD1306 page buffer
+ *
+ * The SSD1306 stores its 128x64 framebuffer as 8 horizontal pages of
+ * 8 pixel rows, one byte per column with bit 0 at the top. The 5x7 font
+ * below uses the same column-major layout, so a glyph on a page-aligned
+ * row is drawn by OR-ing five bytes into the buffer instead of issuing
+ * up to 40 virtual drawPixel calls through Adafruit GFX.
+ *
+ * Text is drawn in 6x8 cells (5 glyph columns + 1 spacing column),
+ * matching the Adafruit GFX default font at text size 1. Rows that are
+ * not page aligned are split across two pages. Text is clipped at the
+ * right edge instead of wrapping.
+ *
+ * The renderer has no Arduino dependency so it can be benchmarked and
+ * tested on the host against a plain byte array.
+ */
+
+// 5x7 glyphs for printable ASCII (0x20-0x7E), 5 column bytes per glyph
+extern const uint8_t OLED_FONT_5X7[];
+
+class OledTextRenderer {
+public:
+    static constexpr uint8_t GLYPH_WIDTH = 5;
+    static constexpr uint8_t CELL_WIDTH = 6;
+    static constexpr uint8_t CELL_HEIGHT = 8;
+    static constexpr char FIRST_CHAR = 0x20;
+    static constexpr char LAST_CHAR = 0x7E;
+
+    /**
+     * @brief Constructor
+     * @param buffer SSD1306 page buffer (width * height / 8 bytes), may be nullptr until set
+     * @param width Display width in pixels
+     * @param height Display height in pixels (multiple of 8)
+     */
+    OledTextRenderer(uint8_t* buffer = nullptr, uint8_t width = 128, uint8_t height = 64);
+
+    /**
+     * @brief Attach the page buffer (e.g. after Adafruit_SSD1306::begin allocates it)
+     * @param buffer SSD1306 page buffer
+     */
+    void setBuffer(uint8_t* buffer) { this->buffer = buffer; }
+
+    /**
+     * @brief Draw one character with its top-left corner at (x, y)
+     * @param x Left pixel column
+     * @param y Top pixel row (fast path when a multiple of 8)
+     * @param c Character; values outside 0x20-0x7E draw as '?'
+     * @return x position of the next character cell
+     */
+    int16_t drawChar(int16_t x, int16_t y, char c);
+
+    /**
+     * @brief Draw a null-terminated string
+     * @return x position after the last character
+     */
+    int16_t drawString(int16_t x, int16_t y, const char* text);
+
+    /**
+     * @brief Draw an unsigned decimal number without printf
+     * @return x position after the last digit
+     */
+    int16_t drawUInt(int16_t x, int16_t y, uint32_t value);
+
+    /**
+     * @brief Draw a signed decimal number without printf
+     * @return x position after the last character
+     */
+    int16_t drawInt(int16_t x, int16_t y, int32_t value);
+
+private:
+    uint8_t* buffer;
+    uint8_t width;
+    uint8_t pages;
+};
+
+/**
+ * @brief printf-free integer formatting helpers
+ *
+ * Each function writes at `out`, null-terminates, and returns a pointer to
+ * the terminator so calls can be chained to build a line in place.
+ */
+namespace OledText {
+
+    // Unsigned decimal (up to 10 digits)
+    char* formatUInt(char* out, uint32_t value);
+
+    // Signed decimal with leading '-' for negatives
+    char* formatInt(char* out, int32_t value);
+
+    // Two upper-case hex digits
+    char* formatHex2(char* out, uint8_t value);
+
+    // Copy a string, bounded by `end` (the last usable byte of the same buffer)
+    char* appendString(char* out, const char* text, char* end);
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Minimal OSC 1.0 encoder and in-place decoder
+ *
+ * Covers what the Ethernet transport needs: messages with int32 ('i'),
+ * float32 ('f') and blob ('b') arguments, and bundles of messages. All
+ * values are big-endian and every field is padded to 4 bytes.
+ *
+ * OscWriter encodes straight into a caller-owned packet buffer (no
+ * staging copy). A message that does not fit is rolled back, so the
+ * buffer always holds complete messages.
+ *
+ * OscReader walks a received packet where it lies: addresses, type tags
+ * and blobs are pointers into the packet. Bundles are flattened; their
+ * time tags are ignored (everything runs on arrival).
+ */
+
+class OscWriter {
+public:
+    OscWriter(uint8_t* buffer, size_t capacity);
+
+    // Restart at an empty packet
+    void reset();
+
+    // "#bundle" header with time tag 1 (immediately); messages written
+    // after this become bundle elements
+    bool beginBundle();
+
+    /**
+     * @brief Start a message; follow with one add*() per type tag
+     * @param types Type tags without the leading ','
+     * @return false if the packet is full
+     */
+    bool beginMessage(const char* address, const char* types);
+    bool addInt(int32_t value);
+    bool addFloat(float value);
+    bool addBlob(const uint8_t* data, uint32_t length);
+
+    /**
+     * @brief Finish the message
+     * @return false (and the message is rolled back) if anything overflowed
+     */
+    bool endMessage();
+
+    bool isBundle() const { return bundle; }
+    uint16_t getMessageCount() const { return messages; }
+    size_t getLength() const { return length; }
+    const uint8_t* getData() const { return buffer; }
+
+private:
+    bool put(const void* data, size_t size);
+    bool putPadded(const void* data, size_t size);
+    bool putWord(uint32_t word);
+
+    uint8_t* buffer;
+    size_t capacity;
+    size_t length;
+    size_t messageStart;    // Rollback point; the element size word in a bundle
+    bool bundle;
+    bool overflow;
+    uint16_t messages;
+};
+
+struct OscMessage {
+    const char* address;
+    const char* types;          // Type tags without the leading ','
+    const uint8_t* args;
+    const uint8_t* end;
+
+    bool is(const char* pattern) const;
+    uint8_t getArgCount() const;
+
+    // Argument by index; ints and floats convert into each other
+    bool getInt(uint8_t index, int32_t& value) const;
+    bool getFloat(uint8_t index, float& value) const;
+    bool getBlob(uint8_t index, const uint8_t*& data, uint32_t& length) const;
+
+private:
+    const uint8_t* argAt(uint8_t index, char& type) const;
+};
+
+class OscReader {
+public:
+    typedef void (*Handler)(const OscMessage& message, void* context);
+
+    /**
+     * @brief Call handler for each message in a packet (bundles flattened)
+     * @return false if the packet is malformed; messages before the fault
+     * have been handled
+     */
+    static bool parse(const uint8_t* data, size_t length, Handler handler, void* context);
+
+    static uint32_t readWord(const uint8_t* p) {
+        return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+    }
+
+private:
+    static bool parseElement(const uint8_t* data, size_t length, Handler handler, void* context, uint8_t depth);
+    static bool parseMessage(const uint8_t* data, size_t length, OscMessage& message);
+};
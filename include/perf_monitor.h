@@ -0,0 +1,161 @@
+#pragma once
+
+#include <Arduino.h>
+#include "config.h"
+
+/**
+ * @brief Per-subsystem timing and loop-time statistics
+ *
+ * Collects how long each main-loop stage takes, a log2 histogram of the
+ * time between consecutive loop() passes, and the scheduler's counts of
+ * scan ticks and portal frames that had to be skipped because the loop ran
+ * late.
+ *
+ * Statistics are gathered over a rolling window (PERF_WINDOW_MS). When a
+ * window closes its results are published for readers (OLED dashboard,
+ * serial) and accumulation starts again, so readers always see one
+ * consistent, complete window.
+ */
+
+// Main-loop stages that are individually timed
+enum PerfStage : uint8_t {
+    PERF_STAGE_SCAN = 0,      // inputProcessor.update()
+    PERF_STAGE_MAPPER = 1,    // inputMapper.processInputs()
+    PERF_STAGE_PORTAL = 2,    // portalController.update()
+    PERF_STAGE_LED_SHOW = 3,  // FastLED.show()
+    PERF_STAGE_OLED = 4,      // OLED frame render / transfer slice
+    PERF_STAGE_SERIAL = 5,    // Serial/MIDI cue input processing
+    PERF_STAGE_COUNT
+};
+
+// Short labels for the OLED dashboard (3 chars)
+constexpr const char* PERF_STAGE_LABELS[PERF_STAGE_COUNT] = {
+    "SCN", "MAP", "POR", "LED", "OLD", "SER"
+};
+
+// Per-call time budget for each stage in microseconds
+constexpr uint32_t PERF_STAGE_BUDGET_US[PERF_STAGE_COUNT] = {
+    250,    // SCAN: well inside one 1 kHz tick
+    100,    // MAPPER
+    1000,   // PORTAL: render one frame
+    2000,   // LED_SHOW: 45 WS2812 LEDs @ 800 kHz ~1.4 ms
+    1000,   // OLED: render, or one 16-byte I2C slice ~0.4 ms
+    250     // SERIAL
+};
+
+/**
+ * @brief Histogram with power-of-two bins
+ *
+ * Bin 0 counts zero values, bin b (b >= 1) counts values in [2^(b-1), 2^b).
+ * Adding a sample is a count-leading-zeros and an increment.
+ */
+struct LogHistogram {
+    static constexpr uint8_t BIN_COUNT = 32;
+
+    uint32_t bins[BIN_COUNT];
+    uint32_t count;
+    uint32_t maxValue;
+
+    LogHistogram() { reset(); }
+
+    void reset() {
+        memset(bins, 0, sizeof(bins));
+        count = 0;
+        maxValue = 0;
+    }
+
+    static uint8_t binFor(uint32_t value) {
+        uint8_t bin = value ? 32 - __builtin_clz(value) : 0;
+        return bin < BIN_COUNT ? bin : BIN_COUNT - 1;
+    }
+
+    // Largest value that falls in a bin
+    static uint32_t binUpperBound(uint8_t bin) {
+        return bin == 0 ? 0 : (bin >= 32 ? 0xFFFFFFFF : (1UL << bin) - 1);
+    }
+
+    void add(uint32_t value) {
+        bins[binFor(value)]++;
+        count++;
+        if (value > maxValue) maxValue = value;
+    }
+
+    /**
+     * @brief Estimate a percentile as the upper bound of the bin that reaches it
+     * @param pct Percentile (1-100)
+     * @return Value estimate (never above the recorded maximum)
+     */
+    uint32_t percentile(uint8_t pct) const {
+        if (count == 0) return 0;
+        uint32_t target = ((uint64_t)count * pct + 99) / 100;
+        uint32_t seen = 0;
+        for (uint8_t bin = 0; bin < BIN_COUNT; bin++) {
+            seen += bins[bin];
+            if (seen >= target) {
+                uint32_t bound = binUpperBound(bin);
+                return bound < maxValue ? bound : maxValue;
+            }
+        }
+        return maxValue;
+    }
+};
+
+class PerfMonitor {
+public:
+    struct StageStats {
+        uint32_t calls;      // Calls in the window
+        uint32_t totalUs;    // Time spent in the window
+        uint32_t maxUs;      // Longest single call
+        uint32_t avgUs() const { return calls ? totalUs / calls : 0; }
+    };
+
+    PerfMonitor();
+
+    /**
+     * @brief Mark the start of a loop() pass
+     * Records the time since the previous pass and rolls the window over.
+     */
+    void markLoop();
+
+    // Stage timing; StageScope (stage_profiler.h) calls begin/end around the
+    // stage's work and passes the time it measured
+    void beginStage(PerfStage stage) { currentStage = stage; }
+    void endStage(PerfStage stage, uint32_t elapsedUs);
+
+    // Stage between beginStage() and endStage(), PERF_STAGE_COUNT if none
+    uint8_t getCurrentStage() const { return currentStage; }
+
+    // Deadline misses reported by the task scheduler (totals since boot)
+    void setDeadlineMisses(uint32_t scanTicks, uint32_t frames) {
+        missedScanTicks = scanTicks;
+        droppedFrames = frames;
+    }
+
+    // Published results (last completed window)
+    const StageStats& getStageStats(uint8_t stage) const { return publishedStages[stage]; }
+    const LogHistogram& getLoopHistogram() const { return publishedLoop; }
+    uint32_t getLoopP99Us() const { return publishedLoop.percentile(99); }
+    uint32_t getLoopMaxUs() const { return publishedLoop.maxValue; }
+
+    // Totals since boot
+    uint32_t getMissedScanTicks() const { return missedScanTicks; }
+    uint32_t getDroppedFrames() const { return droppedFrames; }
+
+private:
+    // Accumulating window
+    StageStats stages[PERF_STAGE_COUNT];
+    LogHistogram loopHistogram;
+    uint32_t windowStart;
+    uint32_t lastLoopStart;
+    volatile uint8_t currentStage;
+
+    // Last completed window
+    StageStats publishedStages[PERF_STAGE_COUNT];
+    LogHistogram publishedLoop;
+
+    // Cumulative counters
+    uint32_t missedScanTicks;
+    uint32_t droppedFrames;
+
+    void publishWindow(uint32_t now);
+};
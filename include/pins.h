@@ -46,5 +46,19 @@ constexpr uint8_t OLED_I2C_ADDRESS = 0x3C;  // Common I2C address for SSD1306
 constexpr uint8_t LED_DATA_PIN = 1;  // Pin 1 for LED data
 constexpr uint8_t LED_COUNT = 45;    // Circular infinity portal LED count
 
+// ===== CLUSTER UART PINS =====
+// Daisy chain between boards (CLUSTER_ROLE, see cluster_link.h). A
+// secondary talks to the board before it on port A and to the next one on
+// port B; the primary only uses port A. These pins are also switch 11 and
+// joystick down/left, which cluster boards ignore where the chain uses them.
+constexpr uint8_t CLUSTER_PORT_A_RX_PIN = 21;  // Serial5
+constexpr uint8_t CLUSTER_PORT_A_TX_PIN = 20;
+constexpr uint8_t CLUSTER_PORT_B_RX_PIN = 34;  // Serial8
+constexpr uint8_t CLUSTER_PORT_B_TX_PIN = 35;
+
 // ===== BUILT-IN PINS =====
 constexpr uint8_t BUILTIN_LED_PIN = 13;  // Teensy 4.1 built-in LED
+
+// ===== TEST PINS =====
+// Latency harness only (bench/latency_sweep.cpp): jumper to BUTTON_PINS[0]
+constexpr uint8_t LATENCY_LOOPBACK_PIN = 32;
@@ -22,7 +22,9 @@ public:
     void setBpm(float bpm);
     void setIntensity(float intensity);    // 0.0-1.0
     void setBaseHue(float hue);           // 0.0-1.0 hue shift
-    void setBrightness(uint8_t brightness); // 0-255
+    void setBrightness(uint8_t brightness); // 0-255, capped at the max
+    void setMaxBrightness(uint8_t brightness); // Runtime LED_BRIGHTNESS_MAX
+    uint8_t getMaxBrightness() const { return maxBrightness; }
     
     // Interaction feedback
     void triggerFlash();                  // Button press feedback
@@ -32,11 +34,17 @@ public:
     // State queries
     bool isIdle() const { return currentProgram == PORTAL_IDLE; }
     uint32_t getFrameCount() const { return frameCount; }
+    float getBpm() const { return bpm; }
+    float getAnimationPhase() const { return animationPhase; }  // Seconds
+    float getBpmPhase() const { return bpmPhase; }              // Beats
     
     // Portal cue handling (hooks for MIDI CC)
     void handlePortalCue(uint8_t cueType, uint8_t value);
     
 private:
+    // bench/bench_hot_paths.cpp times each program and the effects alone
+    friend struct PortalBenchAccess;
+    
     // LED array reference
     CRGB* leds;
     
@@ -46,6 +54,7 @@ private:
     float intensity;
     float baseHue;
     uint8_t globalBrightness;
+    uint8_t maxBrightness;
     float activityLevel;
     
     // Timing
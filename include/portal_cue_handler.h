@@ -4,26 +4,54 @@
 #include "portal_controller.h"
 #include "serial_portal_protocol.h"
 
+class ConfigStore;
+
 class PortalCueHandler {
 public:
+    // Called with each cue that changes the portal (SET_*, TRIGGER_*, RESET)
+    // once it is applied and ACKed, from whichever transport it came
+    typedef void (*CueListener)(const PortalMessage& message, void* context);
+    
     PortalCueHandler();
     
     void begin(PortalController* controller);
     
+    // Target of the CONFIG_* serial commands
+    void setConfigStore(ConfigStore* store) { configStore = store; }
+    
+    // One listener, e.g. the cluster link fanning cues out to other boards
+    void setCueListener(CueListener listener, void* context) {
+        cueListener = listener;
+        cueListenerContext = context;
+    }
+    
     // Legacy MIDI CC support (can be removed after transition)
     void handleMidiCC(uint8_t cc, uint8_t value);
     void handleSerialCommand(const String& command);
     
-    // New serial protocol handling
-    void handleSerialMessage(const PortalMessage& message);
+    // New serial protocol handling; true when the frame was ACKed
+    bool handleSerialMessage(const PortalMessage& message);
     void processSerialInput();
     
+    /**
+     * @brief Frame one received byte (no dispatch)
+     * @return true when message holds a complete frame; check isValid()
+     */
+    bool receiveByte(uint8_t byte, PortalMessage& message);
+    
+    /**
+     * @brief Count, record and dispatch one received frame from any
+     * transport; ACK/NAK/PONG/STATUS/CONFIG_VALUE go to reply
+     */
+    void receiveMessage(const PortalMessage& message, Print& reply);
+    
     // Automatic activity detection and idle switching
     void update();
     void setInputActivity(bool hasActivity);
     
     // Auto-program switching based on idle state
     void checkIdleState();
+    void setIdleTimeoutMs(uint32_t timeoutMs) { idleTimeoutMs = timeoutMs; }
     
     // Response methods for Pi communication
     void sendAck();
@@ -33,11 +61,13 @@ public:
     
 private:
     PortalController* portalController;
+    ConfigStore* configStore;
     
     // Activity tracking for auto idle mode
     elapsedMillis timeSinceLastActivity;
     bool wasIdle;
     uint8_t lastActiveProgram;  // Remember last program before going idle
+    uint32_t idleTimeoutMs;
     
     // Auto-switching parameters
     static constexpr uint32_t AUTO_SWITCH_INTERVAL = 60000;  // Switch programs every minute when idle
@@ -48,6 +78,11 @@ private:
     uint8_t serialBuffer[PORTAL_SERIAL_BUFFER_SIZE];
     uint8_t bufferIndex;
     elapsedMillis lastMessageTime;
+    uint8_t selectedConfigParam;  // CONFIG_SELECT target for CONFIG_SET
+    Print* replyOut;              // Transport of the frame being handled
+    bool frameAcked;              // Frame being handled got an ACK
+    CueListener cueListener;
+    void* cueListenerContext;
     
     // Statistics
     uint32_t messagesReceived;
@@ -56,7 +91,7 @@ private:
     
     void printStatus();
     void resetSerialBuffer();
-    bool parseSerialMessage();
+    bool parseSerialMessage(PortalMessage& message);
     void sendMessage(const PortalMessage& message);
 };
 
@@ -4,14 +4,20 @@
 #include "input_scanner.h"
 #include "debouncer.h"
 #include "analog_smoother.h"
+#include "input_health.h"
 #include "config.h"
 
+struct RuntimeConfig;
+
 /**
  * @brief Robust input processing layer with debouncing and smoothing
  * 
  * Phase 2: Wraps raw InputScanner with debouncing for digital inputs
  * and EMA smoothing for analog inputs. Provides clean interfaces for
  * MIDI mapping layer.
+ *
+ * Inputs quarantined by the health monitor (input_health.h) read as
+ * released, report no edges or pot changes, and do not count as activity.
  */
 class RobustInputProcessor {
 public:
@@ -28,6 +34,29 @@ public:
      */
     void update();
     
+    /**
+     * @brief Same as update(), with the raw readings taken from a trace
+     * frame instead of the pins (see input_trace.h)
+     */
+    void update(const RawInputFrame& frame);
+    
+    /**
+     * @brief Start over from a frame as begin() does from the pins:
+     * everything released, pot filters at the frame's readings. Tuning is kept.
+     */
+    void restart(const RawInputFrame& frame);
+    
+    /**
+     * @brief Raw readings used by the last update, for trace capture
+     */
+    void getRawFrame(RawInputFrame& frame) const { scanner.getRawFrame(frame); }
+    
+    /**
+     * @brief Apply runtime tuning (debounce, pot limits, joystick rearm,
+     * idle timeout); call between updates. Input state is kept.
+     */
+    void applyConfig(const RuntimeConfig& config);
+    
     // Debounced button access
     bool getButtonPressed(uint8_t buttonIndex) const;
     bool getButtonReleased(uint8_t buttonIndex) const;
@@ -48,9 +77,12 @@ public:
     uint32_t getTimeSinceLastActivity() const;
     bool isIdle() const;
     
+    // Chattering, stuck and noisy inputs
+    const InputHealthMonitor& getHealth() const { return health; }
+    
     // Test mode support
     void enableTestMode(bool enable) { testModeEnabled = enable; }
-    void dumpTestValues() const;
+    void dumpTestValues(Print& out) const;
     
 private:
     // Raw input scanner
@@ -62,6 +94,7 @@ private:
     // Joystick with rearm timing
     Debouncer joystickDebouncers[4];
     uint32_t joystickRearmTime[4];
+    uint16_t joystickRearmMs;
     
     // Debounced switch states
     Debouncer switchDebouncers[SWITCH_COUNT];
@@ -71,6 +104,9 @@ private:
     
     // Activity tracking
     uint32_t lastActivityTime;
+    uint32_t idleTimeoutMs;
+    
+    InputHealthMonitor health;
     
     // Test mode
     bool testModeEnabled;
@@ -80,6 +116,11 @@ private:
      */
     void updateActivity();
     
+    /**
+     * @brief Debounce and smooth the scanner's current readings
+     */
+    void processAll();
+    
     /**
      * @brief Process button inputs with debouncing
      */
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "robust_input_processor.h"
+#include "static_input_pipeline.h"
 #include "midi_out.h"
 
 /**
@@ -8,34 +8,143 @@
  * 
  * Phase 2 implementation - works with debounced and filtered inputs.
  * Handles all input types with proper timing and change detection.
+ *
+ * Switches go out one of two ways (setSwitchSnapshotMode()):
+ *   SWITCH_SNAPSHOT_OFF  a CC per switch that changed, plus SWITCH_BINARY_CC
+ *                        for the first 8
+ *   NRPN / SYSEX         the whole 12-switch bank as one 12-bit snapshot,
+ *                        bit i = switch i. Changes are gathered until the
+ *                        bank has been still for SWITCH_SNAPSHOT_SETTLE_MS
+ *                        (SWITCH_SNAPSHOT_MAX_HOLD_MS at most), so a preset
+ *                        flip or a hand sweep sends one consistent state:
+ *     NRPN   CC 99/98 = SWITCH_SNAPSHOT_NRPN_PARAM, CC 6 = bits 11-7, CC 38 = bits 6-0
+ *     SysEx  F0 7D 4D 20 <bits 11-7> <bits 6-0> F7 (device 4D + node on a cluster)
+ *   Switching a snapshot mode on sends the current bank once it settles;
+ *   switching it off sends a burst still being gathered right away.
+ *
+ * The send*() calls below are the mapping itself: one input edge in, its
+ * notes and CCs out on a channel. processInputs() feeds them this board's
+ * edges on MIDI_CHANNEL; a cluster primary feeds them every board's merged
+ * events on MIDI_CHANNEL + node (see cluster_link.h). Each channel keeps
+ * its own held notes and switch bank, so snapshots work per board.
  */
 class RobustMidiMapper {
 public:
-    RobustMidiMapper(RobustInputProcessor& processor, MidiOut& midiOut);
+    enum SwitchSnapshotMode : uint8_t {
+        SWITCH_SNAPSHOT_OFF = 0,
+        SWITCH_SNAPSHOT_NRPN = 1,
+        SWITCH_SNAPSHOT_SYSEX = 2
+    };
+    
+    // SysEx message type of the snapshot, next to ConfigStore's and RuleEngine's
+    static constexpr uint8_t SYSEX_SWITCH_SNAPSHOT = 0x20;
+    static constexpr uint8_t SYSEX_SNAPSHOT_SIZE = 7;
+    
+    RobustMidiMapper(InputProcessor& processor, MidiOut& midiOut);
     
     /**
      * @brief Process all input changes and send MIDI
-     * Call this after RobustInputProcessor::update()
+     * Call this after InputProcessor::update()
      */
     void processInputs();
     
+    /**
+     * @brief Note On/Off for a button
+     */
+    void sendButton(uint8_t index, bool pressed, uint8_t channel);
+    
+    /**
+     * @brief Pot CC with its MIDI value
+     */
+    void sendPot(uint8_t index, uint8_t value, uint8_t channel);
+    
+    /**
+     * @brief Joystick pulse CC (127 on press, no release)
+     */
+    void sendJoystick(uint8_t direction, uint8_t channel);
+    
+    /**
+     * @brief New state of a channel's whole switch bank, bit i = switch i:
+     * per-switch CCs and SWITCH_BINARY_CC for what changed, or gathered
+     * into a snapshot
+     */
+    void sendSwitches(uint16_t bits, uint8_t channel);
+    
+    /**
+     * @brief One switch changed; see sendSwitches()
+     */
+    void sendSwitch(uint8_t index, bool on, uint8_t channel);
+    
+    /**
+     * @brief Send the snapshots whose burst has settled. processInputs()
+     * does this itself; call it regularly when feeding send*() directly.
+     */
+    void flushSwitchBanks(uint32_t nowMs);
+    
+    /**
+     * @brief Note Off for every note held on a channel
+     */
+    void releaseChannel(uint8_t channel);
+    
     /**
      * @brief Send all notes off (panic function)
      */
     void sendAllNotesOff();
     
+    /**
+     * @brief Forget what was sent, as after construction (no messages);
+     * used before a trace replay so its MIDI stream starts from scratch
+     */
+    void reset();
+    
+    /**
+     * @brief Choose how switch changes are sent (SwitchSnapshotMode)
+     */
+    void setSwitchSnapshotMode(uint8_t mode);
+    uint8_t getSwitchSnapshotMode() const { return snapshotMode; }
+    
+    // Snapshots sent, and switch changes they carried
+    uint32_t getSnapshotsSent() const { return snapshotsSent; }
+    uint32_t getSnapshotChanges() const { return snapshotChanges; }
+    
 private:
-    RobustInputProcessor& processor_;
+    // A cluster primary plays every board's inputs, one channel per board
+    #if CLUSTER_ROLE == CLUSTER_PRIMARY
+    static constexpr uint8_t CHANNEL_COUNT = CLUSTER_MAX_NODES;
+    #else
+    static constexpr uint8_t CHANNEL_COUNT = 1;
+    #endif
+    
+    // What the receiver has been sent on one channel
+    struct ChannelState {
+        uint16_t heldButtons;
+        uint16_t switchBits;
+        uint8_t binaryValue;      // Last SWITCH_BINARY_CC (first 8 switches)
+        bool used;                // Has had inputs; primed when a snapshot mode goes on
+        
+        // Switch bank snapshot
+        bool bankPending;         // Changes not yet sent
+        bool bankSent;            // sentBits holds what the receiver has
+        uint16_t sentBits;
+        uint16_t bankChanges;     // Switch changes in the pending burst
+        uint32_t burstStartMs;
+        uint32_t lastChangeMs;
+    };
+    
+    InputProcessor& processor_;
     MidiOut& midiOut_;
     
-    // State tracking for edge detection
-    bool lastButtonStates[BUTTON_COUNT];
-    bool lastSwitchStates[SWITCH_COUNT];
+    ChannelState channels[CHANNEL_COUNT];
     uint8_t lastPotValues[POT_COUNT];
-    uint8_t lastBinaryValue;  // Track binary representation of first 8 switches
     
+    uint8_t snapshotMode;
+    uint32_t snapshotsSent;
+    uint32_t snapshotChanges;
+    
+    ChannelState* channelState(uint8_t channel);
     void processButtons();
     void processPots();
     void processJoystick();
     void processSwitches();
+    void sendSwitchSnapshot(ChannelState& state, uint8_t channel);
 };
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <Arduino.h>
+#include "config.h"
+#include "config_store.h"
+#include "midi_out.h"
+#include "portal_controller.h"
+#include "static_input_pipeline.h"
+
+/**
+ * @brief Input reactions as a table of rules, evaluated on the Teensy
+ *
+ * Reactions that must land within the scan tick (portal flash on a button,
+ * ripples, program cycling) used to be hard-coded. They are now rules:
+ *
+ *   input event  ->  condition  ->  action
+ *
+ * One rule per reaction, checked in order for each debounced input event
+ * of the scan tick. The firmware boots with DEFAULT_RULES (the original
+ * reactions); the Pi can replace the table over SysEx and restore it.
+ *
+ * Cost per event is bounded by the table layout, not its size: rules are
+ * grouped by input when loaded, an event walks only its input's group and
+ * its source's "any index" group, and a group holds at most
+ * RULES_MAX_PER_INPUT rules (a table that breaks this is rejected). At most
+ * RULES_MAX_ACTIONS_PER_EVENT actions fire per event.
+ *
+ * SysEx upload (ID 0x7D, device 'M', as ConfigStore), replies are
+ * F0 7D 4D 7E <count hi> <count lo> F7, or F0 7D 4D 7F F7 on error:
+ *   F0 7D 4D 10 F7                  begin an upload (table unchanged)
+ *   F0 7D 4D 11 <rule x 1-8> F7     append rules, 10 bytes each (Rule wire
+ *                                   format: fields in order, value as two
+ *                                   7-bit bytes, high first)
+ *   F0 7D 4D 12 F7                  commit: check and swap in the new table
+ *   F0 7D 4D 13 F7                  back to DEFAULT_RULES
+ * The table is not saved; it is back to the defaults after a reset.
+ */
+
+// What an input event came from
+enum RuleSource : uint8_t {
+    RULE_SRC_BUTTON = 0,
+    RULE_SRC_POT = 1,
+    RULE_SRC_JOYSTICK = 2,          // Index = direction (up, down, left, right)
+    RULE_SRC_SWITCH = 3,
+    RULE_SOURCE_COUNT
+};
+
+// Rule::index matching every input of its source
+constexpr uint8_t RULE_ANY_INDEX = 0x7F;
+
+enum RuleTrigger : uint8_t {
+    RULE_ON_PRESS = 0,              // Button/joystick press, switch on, any pot change
+    RULE_ON_RELEASE = 1,            // Button release, switch off
+    RULE_ON_CHANGE = 2,             // Either
+    RULE_TRIGGER_COUNT
+};
+
+enum RuleCondition : uint8_t {
+    RULE_IF_ALWAYS = 0,
+    RULE_IF_PROGRAM = 1,            // Portal program == arg
+    RULE_IF_SWITCH_ON = 2,          // Switch arg is on
+    RULE_IF_SWITCH_OFF = 3,
+    RULE_IF_BUTTON_HELD = 4,        // Button arg is down
+    RULE_IF_VALUE_ABOVE = 5,        // Event value (0-127) >= arg
+    RULE_IF_VALUE_BELOW = 6,        // Event value < arg
+    RULE_CONDITION_COUNT
+};
+
+enum RuleAction : uint8_t {
+    // Portal cues, operand in serial protocol units (same codes as PortalSerialCommand)
+    RULE_DO_PROGRAM = 0x01,
+    RULE_DO_BPM = 0x02,
+    RULE_DO_INTENSITY = 0x03,
+    RULE_DO_HUE = 0x04,
+    RULE_DO_BRIGHTNESS = 0x05,
+    RULE_DO_FLASH = 0x06,
+    RULE_DO_RIPPLE = 0x07,
+    RULE_DO_NEXT_PROGRAM = 0x08,
+    RULE_DO_HUE_DRIFT = 0x09,       // Hue = slow clock drift + operand
+    RULE_DO_ACTIVITY = 0x0A,        // Animation activity level
+
+    // MIDI on RULES_MIDI_CHANNEL: target = note or CC, operand = velocity (0 = off) or value
+    RULE_DO_NOTE = 0x10,
+    RULE_DO_CC = 0x11,
+
+    // Tuning: target = ConfigParam, operand in its serial wire units (staged)
+    RULE_DO_CONFIG = 0x20
+};
+
+// Rule::flags
+constexpr uint8_t RULE_OPERAND_MASK = 0x03;
+constexpr uint8_t RULE_OPERAND_CONST = 0x00;    // Operand = value
+constexpr uint8_t RULE_OPERAND_EVENT = 0x01;    // Event value (0-255 scale) x value / 256
+constexpr uint8_t RULE_OPERAND_INDEX = 0x02;    // Input index x value
+constexpr uint8_t RULE_STOP = 0x04;             // No further rules for this event
+
+struct Rule {
+    uint8_t source;                 // RuleSource
+    uint8_t index;                  // Input index or RULE_ANY_INDEX
+    uint8_t trigger;                // RuleTrigger
+    uint8_t flags;
+    uint8_t condition;              // RuleCondition
+    uint8_t conditionArg;
+    uint8_t action;                 // RuleAction
+    uint8_t target;                 // Note, CC or ConfigParam
+    uint16_t value;                 // Constant or gain for the operand (14 bits on the wire)
+};
+
+static_assert(sizeof(Rule) == 10, "Rule is 10 bytes, as on the wire");
+
+struct RuleEvent {
+    uint8_t source;
+    uint8_t index;
+    uint8_t value;                  // 0-127: MIDI value of a pot, 127 / 0 otherwise
+    bool on;                        // Press or switch on; always true for pots
+};
+
+class RuleEngine {
+public:
+    static constexpr uint8_t RULE_WIRE_SIZE = 10;
+    static constexpr uint8_t SYSEX_RULES_PER_MESSAGE = 8;
+    static constexpr uint8_t SYSEX_REPLY_SIZE = 7;
+
+    // SysEx message types, next to ConfigStore's 0x01-0x05
+    static constexpr uint8_t SYSEX_RULES_BEGIN = 0x10;
+    static constexpr uint8_t SYSEX_RULES_ADD = 0x11;
+    static constexpr uint8_t SYSEX_RULES_COMMIT = 0x12;
+    static constexpr uint8_t SYSEX_RULES_DEFAULTS = 0x13;
+
+    static const Rule DEFAULT_RULES[];
+    static const uint16_t DEFAULT_RULE_COUNT;
+
+    RuleEngine();
+
+    /**
+     * @brief Set the action targets (any may be nullptr) and load DEFAULT_RULES
+     */
+    void begin(PortalController* portal, MidiOut* midi, ConfigStore* config);
+
+    /**
+     * @brief Run the rules for every input event of this scan tick
+     * @return true if there was player activity (anything but a release)
+     */
+    bool processInputs(const InputProcessor& inputs);
+
+    /**
+     * @brief Run the rules for one event
+     * @return Actions fired
+     */
+    uint8_t handleEvent(const RuleEvent& event);
+
+    /**
+     * @brief Check and load a table; the old one stays if it is invalid
+     * @return false if a rule is malformed or an input has too many rules
+     */
+    bool load(const Rule* table, uint16_t count);
+    void loadDefaults() { load(DEFAULT_RULES, DEFAULT_RULE_COUNT); }
+
+    static void encodeRule(const Rule& rule, uint8_t* out);
+    static bool decodeRule(const uint8_t* in, Rule& rule);
+
+    /**
+     * @brief Handle a complete SysEx message (F0 ... F7)
+     * @param reply At least SYSEX_REPLY_SIZE bytes
+     * @return Reply length, 0 if the message is not for us
+     */
+    size_t handleSysEx(const uint8_t* data, size_t length, uint8_t* reply);
+
+    uint16_t getRuleCount() const { return count; }
+    uint8_t getLargestGroup() const { return largestGroup; }
+    uint32_t getEvents() const { return events; }
+    uint32_t getFired() const { return fired; }
+    uint32_t getCapped() const { return capped; }
+    uint8_t getMaxExamined() const { return maxExamined; }
+
+    void printStats(Print& out) const;
+
+private:
+    // One group per input of each source, plus its "any index" group
+    static constexpr uint8_t INDEX_SLOTS = 16;
+    static constexpr uint8_t GROUPS_PER_SOURCE = INDEX_SLOTS + 1;
+    static constexpr uint8_t GROUP_COUNT = RULE_SOURCE_COUNT * GROUPS_PER_SOURCE;
+
+    static uint8_t groupOf(uint8_t source, uint8_t index);
+    static bool isValid(const Rule& rule);
+
+    uint8_t runGroup(uint8_t group, const RuleEvent& event, uint8_t firedSoFar, uint8_t& examined, bool& stop);
+    bool conditionHolds(const Rule& rule, const RuleEvent& event) const;
+    uint16_t operand(const Rule& rule, const RuleEvent& event) const;
+    void run(const Rule& rule, uint16_t value);
+
+    PortalController* portal;
+    MidiOut* midi;
+    ConfigStore* config;
+    const InputProcessor* inputs;   // For conditions; set by processInputs()
+
+    Rule rules[RULES_MAX];          // Grouped by input, load order within a group
+    uint16_t groupStart[GROUP_COUNT + 1];
+    uint16_t count;
+    uint8_t largestGroup;
+
+    // SysEx upload in progress
+    uint16_t stagingCount;
+    bool uploading;
+
+    // Statistics
+    uint32_t events;
+    uint32_t fired;
+    uint32_t capped;                // Matches skipped: RULES_MAX_ACTIONS_PER_EVENT reached
+    uint8_t maxExamined;
+};
+
+extern RuleEngine ruleEngine;
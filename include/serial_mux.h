@@ -0,0 +1,129 @@
+#pragma once
+
+#include <Arduino.h>
+#include "config.h"
+
+/**
+ * @brief Prioritized logical channels over the single USB serial link
+ *
+ * Protocol responses, heartbeat text, event log text and binary dumps all
+ * leave the Teensy on one Serial stream. With SERIAL_MUX=1 each kind of
+ * output writes to its own channel instead: a Print with a bounded byte
+ * queue. The mux task frames queued bytes onto Serial, always taking the
+ * highest-priority channel that has data, and only as much as the USB
+ * buffer accepts without blocking.
+ *
+ *   control   protocol response frames (ACK, NAK, PONG, CONFIG_VALUE);
+ *             flush() sends them at once, ahead of anything queued
+ *   telemetry heartbeat, test dump and scheduler statistics
+ *   log       event log text and other debug prints
+ *   bulk      FLIGHT_DUMP, TRACE_DUMP, LOG_DUMP, profile and stall reports
+ *
+ * Control and bulk never lose bytes: a write that does not fit sends
+ * frames synchronously until it does (what a raw Serial.write would do).
+ * Telemetry and log drop the whole write under pressure, count it, and
+ * flag the channel's next frame so the Pi knows text is missing.
+ *
+ * Frame (Teensy -> Pi only; Pi commands are unchanged):
+ *   0xA5, channel | 0x80 if bytes were dropped before this frame,
+ *   length (1-SERIAL_MUX_MAX_PAYLOAD), payload, CRC-8 over channel..payload
+ *
+ * A channel's payloads concatenate into that channel's byte stream, so
+ * text lines and dump records may span frames. Unframed bytes (boot
+ * banners, the interactive console) fail the CRC and are skipped.
+ */
+
+enum MuxChannelId : uint8_t {
+    MUX_CONTROL = 0,    // Highest priority
+    MUX_TELEMETRY = 1,
+    MUX_LOG = 2,
+    MUX_BULK = 3,
+    MUX_CHANNEL_COUNT
+};
+
+enum MuxOverflow : uint8_t {
+    MUX_BLOCK,          // Send frames until the write fits
+    MUX_DROP            // Drop the write and flag the next frame
+};
+
+class SerialMux {
+public:
+    static constexpr uint8_t START_BYTE = 0xA5;
+    static constexpr uint8_t FLAG_DROPPED = 0x80;
+    static constexpr uint8_t FRAME_OVERHEAD = 4;
+
+    class Channel : public Print {
+    public:
+        size_t write(uint8_t b) override { return write(&b, 1); }
+        size_t write(const uint8_t* data, size_t size) override;
+        using Print::write;
+
+        // Free queue space
+        int availableForWrite() override { return capacity - (head - tail); }
+
+        // Send everything queued here (and on higher-priority channels) now
+        void flush() override;
+
+        uint32_t getQueued() const { return head - tail; }
+        uint32_t getPeak() const { return peak; }
+        uint32_t getDropped() const { return dropped; }
+
+    private:
+        friend class SerialMux;
+
+        SerialMux* mux = nullptr;
+        uint8_t* buffer = nullptr;
+        uint32_t capacity = 0;
+        uint8_t id = 0;
+        MuxOverflow overflow = MUX_BLOCK;
+        bool dropPending = false;
+        uint32_t head = 0;          // Free-running write index
+        uint32_t tail = 0;          // Free-running send index
+        uint32_t peak = 0;          // Queue high-water mark
+        uint32_t dropped = 0;       // Bytes dropped (MUX_DROP only)
+    };
+
+    explicit SerialMux(Print& link);
+
+    Channel& channel(MuxChannelId id) { return channels[id]; }
+
+    /**
+     * @brief Frame queued output, highest priority first, while the link
+     * has room; never blocks
+     * @param budget Maximum payload bytes to send
+     * @return true while anything is still queued
+     */
+    bool pump(uint16_t budget = SERIAL_MUX_PUMP_BYTES);
+
+    uint32_t getFramesSent() const { return framesSent; }
+
+    /**
+     * @brief Print per-channel queue, peak and dropped counts
+     */
+    void printStats(Print& out) const;
+
+    static uint8_t crc8(const uint8_t* data, size_t length);
+
+private:
+    void sendFrame(Channel& channel);
+    // Send higher-priority frames, then one of this channel's frames
+    void makeRoom(Channel& channel);
+
+    Print& link;
+    Channel channels[MUX_CHANNEL_COUNT];
+    uint32_t framesSent;
+
+    uint8_t controlQueue[SERIAL_MUX_CONTROL_QUEUE];
+    uint8_t telemetryQueue[SERIAL_MUX_TELEMETRY_QUEUE];
+    uint8_t logQueue[SERIAL_MUX_LOG_QUEUE];
+    uint8_t bulkQueue[SERIAL_MUX_BULK_QUEUE];
+};
+
+#if SERIAL_MUX > 0
+extern SerialMux serialMux;
+
+inline Print& serialChannel(MuxChannelId id) { return serialMux.channel(id); }
+#else
+// Every channel is the raw Serial stream
+inline Print& serialChannel(MuxChannelId) { return Serial; }
+#endif
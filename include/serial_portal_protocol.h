@@ -34,12 +34,30 @@ enum class PortalSerialCommand : uint8_t {
     // System commands
     PING = 0x10,             // Ping/keepalive (responds with PONG)
     RESET = 0x11,            // Reset to default state
+    PROFILE_DUMP = 0x12,     // Print stage profile as text (value ignored)
+    PROFILE_RESET = 0x13,    // Clear stage profile (value ignored)
+    STALL_REPORT = 0x14,     // Print watchdog stall report as text (value ignored)
+    FLIGHT_DUMP = 0x15,      // Stream flight recorder ring as binary (value ignored)
+    CONFIG_SELECT = 0x16,    // Select tuning parameter for CONFIG_SET (ConfigParam)
+    CONFIG_SET = 0x17,       // Stage selected parameter (wire units, see ConfigStore)
+    CONFIG_GET = 0x18,       // Read parameter (ConfigParam); answers CONFIG_VALUE
+    CONFIG_SAVE = 0x19,      // Persist live tuning to EEPROM (value ignored)
+    CONFIG_DEFAULTS = 0x1A,  // Stage compile-time defaults (value ignored)
+    TRACE_CAPTURE = 0x1B,    // Input trace capture: 1 = start (new trace), 0 = stop
+    TRACE_DUMP = 0x1C,       // Stream captured input trace as binary (value ignored)
+    TRACE_REPLAY = 0x1D,     // Replay captured trace through the input pipeline (value ignored)
+    LOG_LEVEL = 0x1E,        // Event log level 0-4 (bits 0-2); bit 7 = text output on Serial
+    LOG_CATEGORIES = 0x1F,   // Event log category mask (LogCategory bits)
     
     // Response commands (Teensy -> Pi)
     PONG = 0x20,             // Response to PING
     ACK = 0x21,              // Command acknowledged
     NAK = 0x22,              // Command rejected/invalid
-    STATUS = 0x23            // Status report
+    STATUS = 0x23,           // Status report
+    CONFIG_VALUE = 0x24,     // Response to CONFIG_GET (wire units)
+    
+    // System commands (continued past the response range)
+    LOG_DUMP = 0x30          // Stream event log ring as binary (value ignored)
 };
 
 // Portal message structure
@@ -132,10 +150,26 @@ namespace SerialPortalProtocol {
             case PortalSerialCommand::TRIGGER_RIPPLE: return "TRIGGER_RIPPLE";
             case PortalSerialCommand::PING: return "PING";
             case PortalSerialCommand::RESET: return "RESET";
+            case PortalSerialCommand::PROFILE_DUMP: return "PROFILE_DUMP";
+            case PortalSerialCommand::PROFILE_RESET: return "PROFILE_RESET";
+            case PortalSerialCommand::STALL_REPORT: return "STALL_REPORT";
+            case PortalSerialCommand::FLIGHT_DUMP: return "FLIGHT_DUMP";
+            case PortalSerialCommand::CONFIG_SELECT: return "CONFIG_SELECT";
+            case PortalSerialCommand::CONFIG_SET: return "CONFIG_SET";
+            case PortalSerialCommand::CONFIG_GET: return "CONFIG_GET";
+            case PortalSerialCommand::CONFIG_SAVE: return "CONFIG_SAVE";
+            case PortalSerialCommand::CONFIG_DEFAULTS: return "CONFIG_DEFAULTS";
+            case PortalSerialCommand::TRACE_CAPTURE: return "TRACE_CAPTURE";
+            case PortalSerialCommand::TRACE_DUMP: return "TRACE_DUMP";
+            case PortalSerialCommand::TRACE_REPLAY: return "TRACE_REPLAY";
+            case PortalSerialCommand::LOG_LEVEL: return "LOG_LEVEL";
+            case PortalSerialCommand::LOG_CATEGORIES: return "LOG_CATEGORIES";
+            case PortalSerialCommand::LOG_DUMP: return "LOG_DUMP";
             case PortalSerialCommand::PONG: return "PONG";
             case PortalSerialCommand::ACK: return "ACK";
             case PortalSerialCommand::NAK: return "NAK";
             case PortalSerialCommand::STATUS: return "STATUS";
+            case PortalSerialCommand::CONFIG_VALUE: return "CONFIG_VALUE";
             default: return "UNKNOWN";
         }
     }
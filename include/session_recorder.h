@@ -0,0 +1,142 @@
+#pragma once
+
+#include <Arduino.h>
+#include <SdFat.h>
+#include "config.h"
+#include "flight_recorder.h"
+
+#if SESSION_RECORDER > 0 && FLIGHT_RECORDER == 0
+#error "SESSION_RECORDER streams the flight recorder: build with FLIGHT_RECORDER=1 or SESSION_RECORDER=0"
+#endif
+
+/**
+ * @brief Whole-session recording of the flight recorder to the SD card
+ *
+ * The flight recorder already sees every input event, MIDI send, protocol
+ * frame and scan tick, but keeps only the last ~8 s. The session recorder
+ * is a second reader of that ring: its background task copies new entries
+ * into one half of a RAM double buffer while the other half goes to the
+ * card. Nothing on the scan path changes.
+ *
+ * Writes are whole 512-byte sectors, at most SESSION_SECTORS_PER_SLICE per
+ * slice and each only while the card reports it is not busy, so an SD
+ * write-latency spike (tens of ms on a consumer card) stalls the buffer,
+ * not the loop. The halves swap when the fill half is full, or every
+ * SESSION_SYNC_MS with whatever whole sectors it holds. The file is synced
+ * on the same interval, so a power cut loses about a second.
+ *
+ * Files are SESSnnnn.BIN in the card root, preallocated to
+ * SESSION_FILE_BYTES and truncated to their length when closed. A full
+ * file closes and the next one opens (the one blocking step, once per
+ * file); the oldest files are deleted to keep SESSION_MAX_FILES.
+ *
+ * The card is mounted once in begin(). Without a card, or after a write
+ * error, the recorder stays off until the next boot.
+ *
+ * File format (little-endian):
+ *   sector 0  "SESS", u8 version, u8 entry size, u16 boot count,
+ *             u32 file sequence, u32 micros() at open, zero padding
+ *   entries   u32 timestamp, u8 type, u8 a, u16 b (as FLIGHT_DUMP);
+ *             FLIGHT_GAP marks entries lost to a full buffer or a dump,
+ *             type 0 pads the last sector. Timestamps wrap every ~71 min.
+ */
+class SessionRecorder {
+public:
+    static constexpr uint32_t MAGIC = 0x53534553;  // "SESS"
+    static constexpr uint8_t FORMAT_VERSION = 1;
+    static constexpr uint16_t SECTOR_SIZE = 512;
+
+    enum State : uint8_t {
+        SESSION_OFF,            // Not mounted yet, or no card at boot
+        SESSION_RECORDING,
+        SESSION_FAILED          // Write, open or sync error; off until reboot
+    };
+
+    /**
+     * @param source Flight recorder to follow
+     * @param buffers 2 * SESSION_BUFFER_BYTES of RAM
+     */
+    SessionRecorder(FlightRecorder& source, uint8_t* buffers);
+
+    /**
+     * @brief Mount the card and open the next session file; call in setup()
+     * after the flight recorder's begin()
+     * @return false if there is no usable card
+     */
+    bool begin();
+
+    /**
+     * @brief Background task: collect new entries and write ready sectors
+     * while the card is idle; never waits on the card
+     * @return true while a full buffer is still being written
+     */
+    bool update();
+
+    /**
+     * @brief Write everything collected, truncate and close the file
+     */
+    void close();
+
+    State getState() const { return state; }
+    uint32_t getFileSequence() const { return fileSequence; }
+    uint64_t getBytesWritten() const { return bytesWritten; }
+    uint32_t getEntriesLost() const { return entriesLost; }
+    uint32_t getMaxWriteUs() const { return maxWriteUs; }
+
+    // Card throughput while writing, and average rate since mount, in bytes/s
+    uint32_t getWriteRate() const;
+    uint32_t getSustainedRate() const;
+
+    /**
+     * @brief Print state, rates and write latency
+     */
+    void printStats(Print& out) const;
+
+private:
+    void collect();
+    bool openNext();
+    void prune();
+    void fail();
+    bool writeSector(const uint8_t* data);
+    static void fileName(uint32_t sequence, char* name);
+
+    FlightRecorder& source;
+    uint8_t* buffers[2];
+
+    SdFs sd;
+    FsFile file;
+    State state;
+
+    uint32_t readSequence;      // Next flight recorder entry to copy
+    uint32_t pendingLost;       // Entries lost since the last FLIGHT_GAP
+    bool dumpPaused;            // A flight dump paused recording since the last FLIGHT_GAP
+
+    uint8_t fillIndex;          // Buffer being filled
+    uint32_t fillLength;
+    const uint8_t* writeData;   // Buffer being written (whole sectors)
+    uint32_t writeLength;
+    uint32_t writeOffset;
+    uint32_t lastSwapMs;
+    uint32_t lastSyncMs;
+    bool syncPending;
+
+    uint32_t fileSequence;
+    uint32_t oldestSequence;
+    uint16_t fileCount;
+    uint32_t fileBytes;
+
+    // Statistics
+    uint32_t mountMs;
+    uint64_t bytesWritten;
+    uint64_t writeUs;           // Time spent inside sector writes
+    uint32_t maxWriteUs;
+    uint32_t maxRotateUs;
+    uint32_t busySkips;         // Slices that found the card busy
+    uint32_t entriesLost;
+    uint32_t peakFill;
+    uint16_t errors;
+};
+
+#if SESSION_RECORDER > 0
+extern SessionRecorder sessionRecorder;
+#endif
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <Arduino.h>
+#include "config.h"
+#include "perf_monitor.h"
+
+/**
+ * @brief Cycle-accurate per-stage profiler
+ *
+ * Times the main-loop stages (same PerfStage ids as PerfMonitor) with the
+ * ARM DWT cycle counter and collects every sample into a LogHistogram plus
+ * min/total, so the profile covers all calls since the last reset rather
+ * than one PerfMonitor window. No allocation; one histogram per stage.
+ *
+ * Wrap a stage with STAGE_SCOPE(monitor, stage) at the top of a block. The
+ * scope takes one timestamp at each end and feeds the same sample to both
+ * the profiler (in cycles) and the PerfMonitor window (in microseconds).
+ * With PROFILE == 0 the profiler is not built and only PerfMonitor is fed.
+ *
+ * The Pi (or a terminal) requests a text dump with the PROFILE_DUMP serial
+ * command and clears the counters with PROFILE_RESET.
+ */
+
+class StageProfiler {
+public:
+    struct StageProfile {
+        LogHistogram histogram;   // Cycles per call
+        uint32_t minCycles;
+        uint64_t totalCycles;
+    };
+
+    StageProfiler();
+
+    /**
+     * @brief Enable the DWT cycle counter; call once from setup()
+     */
+    void begin();
+
+    /**
+     * @brief Current cycle count (CPU clock ticks, wraps every ~7 s at 600 MHz)
+     */
+    static inline uint32_t cycles() {
+        #ifdef ARM_DWT_CYCCNT
+        return ARM_DWT_CYCCNT;
+        #else
+        return micros();  // Host builds: microseconds stand in for cycles
+        #endif
+    }
+
+    /**
+     * @brief Convert a cycles() difference to microseconds
+     */
+    static inline uint32_t toMicros(uint32_t cycleCount) {
+        #ifdef ARM_DWT_CYCCNT
+        return cycleCount / (F_CPU_ACTUAL / 1000000);
+        #else
+        return cycleCount;
+        #endif
+    }
+
+    void record(PerfStage stage, uint32_t cycleCount) {
+        StageProfile& profile = stages[stage];
+        profile.histogram.add(cycleCount);
+        profile.totalCycles += cycleCount;
+        if (cycleCount < profile.minCycles) profile.minCycles = cycleCount;
+    }
+
+    void reset();
+
+    /**
+     * @brief Print min/avg/max/p50/p99 and non-empty bins for every stage
+     */
+    void dump(Print& out) const;
+
+    const StageProfile& getProfile(uint8_t stage) const { return stages[stage]; }
+
+private:
+    StageProfile stages[PERF_STAGE_COUNT];
+};
+
+/**
+ * @brief Records the cycles between construction and destruction
+ */
+class ProfileScope {
+public:
+    ProfileScope(StageProfiler& profiler, PerfStage stage)
+        : profiler(profiler), stage(stage), start(StageProfiler::cycles()) {}
+
+    ~ProfileScope() { profiler.record(stage, StageProfiler::cycles() - start); }
+
+private:
+    StageProfiler& profiler;
+    PerfStage stage;
+    uint32_t start;
+};
+
+#if PROFILE > 0
+extern StageProfiler stageProfiler;
+#endif
+
+/**
+ * @brief Times one main-loop stage for both the profiler and PerfMonitor
+ *
+ * Marks the stage current for the loop watchdog's stall report on entry.
+ */
+class StageScope {
+public:
+    StageScope(PerfMonitor& monitor, PerfStage stage)
+        : monitor(monitor), stage(stage), start(StageProfiler::cycles()) {
+        monitor.beginStage(stage);
+    }
+
+    ~StageScope() {
+        const uint32_t elapsed = StageProfiler::cycles() - start;
+        #if PROFILE > 0
+        stageProfiler.record(stage, elapsed);
+        #endif
+        monitor.endStage(stage, StageProfiler::toMicros(elapsed));
+    }
+
+private:
+    PerfMonitor& monitor;
+    PerfStage stage;
+    uint32_t start;
+};
+
+#define STAGE_SCOPE_CONCAT_INNER(a, b) a##b
+#define STAGE_SCOPE_CONCAT(a, b) STAGE_SCOPE_CONCAT_INNER(a, b)
+#define STAGE_SCOPE(monitor, stage) StageScope STAGE_SCOPE_CONCAT(stageScope_, __LINE__)(monitor, stage)
@@ -0,0 +1,527 @@
+#pragma once
+
+#include <Arduino.h>
+#include <utility>
+#include "pins.h"
+#include "config.h"
+#include "config_store.h"
+#include "flight_recorder.h"
+#include "event_log.h"
+#include "robust_input_processor.h"
+#include "input_health.h"
+#include "input_trace.h"
+
+/**
+ * @brief Compile-time specialized input pipeline
+ *
+ * StaticInputProcessor has the same public API as RobustInputProcessor.
+ * The scanner, debouncer and smoother are folded into templates over
+ * constexpr pin lists and a read policy:
+ * - Each bank updates through a fold over an index_sequence. The loop is
+ *   fully unrolled and every pin is a constant, so on Teensy
+ *   digitalReadFast() becomes a single GPIO register load.
+ * - Digital state is three bitmasks per bank, not one Debouncer object
+ *   per input. Getters shift and mask instead of bounds-checking; bits
+ *   past the bank size are always clear, so out-of-range indexes still
+ *   read false.
+ * - The smoothing alpha and the large-change threshold are compile-time
+ *   constants.
+ *
+ * Runtime tuning from ConfigStore still applies, per bank, and the input
+ * health monitor quarantines inputs as it does for RobustInputProcessor.
+ * Trace replay goes through update(frame), which reads the same banks
+ * through FrameInputPolicy instead of the pins.
+ *
+ * Build with STATIC_INPUT_PIPELINE=1 to use it; `InputProcessor` names
+ * whichever implementation is built. test_input_pipeline checks step-by-
+ * step equivalence with Debouncer/AnalogSmoother and benchmarks both.
+ */
+
+template <uint8_t... Pins>
+struct PinList {
+    static constexpr uint8_t count = sizeof...(Pins);
+    static constexpr uint8_t pins[] = {Pins...};
+};
+
+// Position of a pin in a list, -1 if it is not there
+template <typename List>
+constexpr int pinIndex(uint8_t pin) {
+    for (uint8_t i = 0; i < List::count; i++) {
+        if (List::pins[i] == pin) return i;
+    }
+    return -1;
+}
+
+// Hardware reads: active-low digital inputs with pull-ups, 10-bit analog
+struct HardwareInputPolicy {
+    static void configureDigital(uint8_t pin) { pinMode(pin, INPUT_PULLUP); }
+
+    template <uint8_t Pin>
+    static bool readDigital() {
+        #ifdef __IMXRT1062__
+        return !digitalReadFast(Pin);
+        #else
+        return !digitalRead(Pin);
+        #endif
+    }
+
+    template <uint8_t Pin>
+    static uint16_t readAnalog() { return analogRead(Pin); }
+
+    static uint32_t nowMs() { return millis(); }
+};
+
+/**
+ * @brief Reads pin levels from a RawInputFrame instead of the pins
+ *
+ * Each pin is looked up in the processor's pin lists at compile time, so a
+ * read is one bit test (or one load for a pot) on the current frame. Time
+ * still comes from the processor's own policy.
+ */
+template <typename ButtonPins, typename JoystickPins, typename SwitchPins, typename PotPins, typename Clock>
+struct FrameInputPolicy {
+    static inline const RawInputFrame* frame = nullptr;
+
+    template <uint8_t Pin>
+    static bool readDigital() {
+        if constexpr (pinIndex<ButtonPins>(Pin) >= 0) {
+            return (frame->buttons >> pinIndex<ButtonPins>(Pin)) & 1;
+        } else if constexpr (pinIndex<JoystickPins>(Pin) >= 0) {
+            return (frame->joystick >> pinIndex<JoystickPins>(Pin)) & 1;
+        } else {
+            static_assert(pinIndex<SwitchPins>(Pin) >= 0, "pin is in none of the digital pin lists");
+            return (frame->switches >> pinIndex<SwitchPins>(Pin)) & 1;
+        }
+    }
+
+    template <uint8_t Pin>
+    static uint16_t readAnalog() {
+        static_assert(pinIndex<PotPins>(Pin) >= 0, "pin is not in the pot pin list");
+        return frame->pots[pinIndex<PotPins>(Pin)];
+    }
+
+    static uint32_t nowMs() { return Clock::nowMs(); }
+};
+
+/**
+ * @brief Debounced bank of digital inputs (same algorithm as Debouncer)
+ */
+template <typename Pins, typename Policy>
+class DigitalBank {
+public:
+    static constexpr uint8_t COUNT = Pins::count;
+    static_assert(COUNT > 0 && COUNT <= 32, "DigitalBank keeps its state in 32-bit masks");
+    static constexpr uint32_t ALL = COUNT == 32 ? 0xFFFFFFFFUL : (1UL << COUNT) - 1;
+
+    void begin() {
+        for (uint8_t i = 0; i < COUNT; i++) {
+            Policy::configureDigital(Pins::pins[i]);
+        }
+    }
+
+    void setDebounceMs(uint8_t ms) { debounceMs = ms; }
+
+    // Everything released, as Debouncer::reset()
+    void reset() {
+        raw = stable = changed = 0;
+        memset(lastChange, 0, sizeof(lastChange));
+    }
+
+    /**
+     * @brief Read and debounce every input
+     * @param enabledMask Inputs whose bit is clear read as released
+     * @return Mask of inputs whose stable state changed
+     * @tparam Reader Where the levels come from (default: the bank's policy)
+     */
+    template <typename Reader = Policy>
+    uint32_t update(uint32_t nowMs, uint32_t enabledMask = ALL) {
+        changed = 0;
+        updateAll<Reader>(nowMs, enabledMask, std::make_index_sequence<COUNT>{});
+        return changed;
+    }
+
+    bool isPressed(uint8_t index) const { return bit(stable, index); }
+    bool justPressed(uint8_t index) const { return bit(stable & changed, index); }
+    bool justReleased(uint8_t index) const { return bit(~stable & changed, index); }
+    bool justChanged(uint8_t index) const { return bit(changed, index); }
+
+    uint32_t getStableMask() const { return stable; }
+    uint32_t getChangedMask() const { return changed; }
+    uint32_t getRawMask() const { return raw; }
+
+private:
+    uint32_t raw = 0;
+    uint32_t stable = 0;
+    uint32_t changed = 0;
+    uint32_t lastChange[COUNT] = {};
+    uint8_t debounceMs = DEBOUNCE_MS;
+
+    static bool bit(uint32_t mask, uint8_t index) { return (mask >> (index & 31)) & 1; }
+
+    template <typename Reader, size_t... I>
+    void updateAll(uint32_t nowMs, uint32_t enabledMask, std::index_sequence<I...>) {
+        (updateOne<Reader, I>(nowMs, enabledMask), ...);
+    }
+
+    template <typename Reader, size_t I>
+    void updateOne(uint32_t nowMs, uint32_t enabledMask) {
+        constexpr uint32_t m = 1UL << I;
+        const bool state = (enabledMask & m) && Reader::template readDigital<Pins::pins[I]>();
+        if (state != ((raw & m) != 0)) {
+            raw ^= m;
+            lastChange[I] = nowMs;
+        }
+        if ((nowMs - lastChange[I]) >= debounceMs && ((raw ^ stable) & m)) {
+            stable ^= m;
+            changed |= m;
+        }
+    }
+};
+
+/**
+ * @brief Smoothed bank of analog inputs (same algorithm as AnalogSmoother)
+ */
+template <typename Pins, typename Policy,
+          uint8_t Alpha = POT_SMOOTHING_ALPHA, uint8_t LargeChange = POT_LARGE_CHANGE_THRESHOLD>
+class AnalogBank {
+public:
+    static constexpr uint8_t COUNT = Pins::count;
+    static_assert(COUNT > 0 && COUNT <= 32, "AnalogBank keeps its flags in 32-bit masks");
+
+    // Start every filter at the current reading to prevent startup spikes
+    void begin() {
+        resetAll(std::make_index_sequence<COUNT>{});
+    }
+
+    void setLimits(uint8_t newDeadband, uint8_t newRateLimitMs) {
+        deadband = newDeadband;
+        rateLimitMs = newRateLimitMs;
+    }
+
+    void reset(uint8_t index, uint16_t value) {
+        if (index >= COUNT) return;
+        filtered[index] = value;
+        reading[index] = value;
+        midi[index] = mapToMidi(value);
+        lastSent[index] = midi[index];
+        lastSend[index] = 0;
+        significant &= ~(1UL << index);
+        forceSend &= ~(1UL << index);
+    }
+
+    /**
+     * @brief Read and filter every input
+     * @return Mask of inputs whose value should be sent
+     * @tparam Reader Where the readings come from (default: the bank's policy)
+     */
+    template <typename Reader = Policy>
+    uint32_t update(uint32_t nowMs) {
+        uint32_t sent = 0;
+        significant = 0;
+        updateAll<Reader>(nowMs, sent, std::make_index_sequence<COUNT>{});
+        return sent;
+    }
+
+    uint8_t getMidiValue(uint8_t index) const { return midi[index < COUNT ? index : 0]; }
+    uint16_t getRawFiltered(uint8_t index) const { return filtered[index < COUNT ? index : 0]; }
+    uint16_t getRawReading(uint8_t index) const { return reading[index < COUNT ? index : 0]; }
+    bool hasSignificantChange(uint8_t index) const { return (significant >> (index & 31)) & 1; }
+
+    static constexpr uint8_t mapToMidi(uint16_t value) {
+        return (value * 127) / 1023 < 127 ? (value * 127) / 1023 : 127;
+    }
+
+private:
+    uint16_t filtered[COUNT] = {};
+    uint16_t reading[COUNT] = {};   // Last ADC reading, before smoothing
+    uint8_t midi[COUNT] = {};
+    uint8_t lastSent[COUNT] = {};
+    uint32_t lastSend[COUNT] = {};
+    uint32_t significant = 0;
+    uint32_t forceSend = 0;
+    uint8_t deadband = POT_DEADBAND;
+    uint8_t rateLimitMs = POT_RATE_LIMIT_MS;
+
+    template <size_t... I>
+    void resetAll(std::index_sequence<I...>) {
+        (reset(I, Policy::template readAnalog<Pins::pins[I]>()), ...);
+    }
+
+    template <typename Reader, size_t... I>
+    void updateAll(uint32_t nowMs, uint32_t& sent, std::index_sequence<I...>) {
+        ((sent |= updateOne<Reader, I>(nowMs) ? (1UL << I) : 0), ...);
+    }
+
+    template <typename Reader, size_t I>
+    bool updateOne(uint32_t nowMs) {
+        constexpr uint32_t m = 1UL << I;
+        reading[I] = Reader::template readAnalog<Pins::pins[I]>();
+        const int32_t error = (int32_t)reading[I] - (int32_t)filtered[I];
+        filtered[I] += (error * Alpha) >> 8;
+
+        const uint8_t value = mapToMidi(filtered[I]);
+        const uint8_t delta = value > lastSent[I] ? value - lastSent[I] : lastSent[I] - value;
+        if (delta >= deadband) {
+            significant |= m;
+        }
+        midi[I] = value;
+
+        bool send = false;
+        if (forceSend & m) {
+            send = true;
+            forceSend &= ~m;
+        } else if ((significant & m) && (nowMs - lastSend[I]) >= rateLimitMs) {
+            send = true;
+        } else if (delta >= LargeChange) {
+            send = true;
+            forceSend |= m;
+        }
+
+        if (send) {
+            lastSent[I] = value;
+            lastSend[I] = nowMs;
+        }
+        return send;
+    }
+};
+
+/**
+ * @brief Drop-in for RobustInputProcessor built from the banks above
+ */
+template <typename ButtonPins, typename JoystickPins, typename SwitchPins, typename PotPins,
+          typename Policy = HardwareInputPolicy>
+class StaticInputProcessor {
+public:
+    static_assert(JoystickPins::count == 4, "Joystick pin list is Up, Down, Left, Right");
+    static_assert(ButtonPins::count <= BUTTON_COUNT && SwitchPins::count <= SWITCH_COUNT &&
+                  PotPins::count <= POT_COUNT, "input health has a channel per pins.h input");
+
+    void begin() {
+        buttons.begin();
+        joystick.begin();
+        switches.begin();
+        pots.begin();
+        lastActivityTime = Policy::nowMs();
+        health.reset(lastActivityTime);
+
+        #if DEBUG
+        Serial.println("StaticInputProcessor: Initialized (compile-time pipeline)");
+        Serial.printf("  %d buttons, %d switches, %d pots\n", ButtonPins::count, SwitchPins::count, PotPins::count);
+        #endif
+    }
+
+    void update() {
+        updateFrom<Policy>();
+    }
+
+    // Same as update(), with the raw readings taken from a trace frame
+    void update(const RawInputFrame& frame) {
+        FramePolicy::frame = &frame;
+        updateFrom<FramePolicy>();
+    }
+
+    // Start over from a frame as begin() does from the pins: everything
+    // released, pot filters at the frame's readings. Tuning is kept.
+    void restart(const RawInputFrame& frame) {
+        buttons.reset();
+        joystick.reset();
+        switches.reset();
+        for (uint8_t i = 0; i < PotPins::count; i++) {
+            pots.reset(i, frame.pots[i]);
+        }
+        memset(joystickRearmTime, 0, sizeof(joystickRearmTime));
+        joystickRaw = frame.joystick;
+        lastActivityTime = Policy::nowMs();
+        health.reset(lastActivityTime);
+    }
+
+    // Raw readings used by the last update, for trace capture
+    void getRawFrame(RawInputFrame& frame) const {
+        frame.buttons = buttons.getRawMask();
+        frame.joystick = joystickRaw;
+        frame.switches = switches.getRawMask();
+        for (uint8_t i = 0; i < POT_COUNT; i++) {
+            frame.pots[i] = i < PotPins::count ? pots.getRawReading(i) : 0;
+        }
+    }
+
+    void applyConfig(const RuntimeConfig& config) {
+        buttons.setDebounceMs(config.debounceMs);
+        joystick.setDebounceMs(config.debounceMs);
+        switches.setDebounceMs(config.debounceMs);
+        pots.setLimits(config.potDeadband, config.potRateLimitMs);
+        joystickRearmMs = config.joystickRearmMs;
+        idleTimeoutMs = config.idleTimeoutMs;
+    }
+
+    // Debounced button access
+    bool getButtonPressed(uint8_t buttonIndex) const { return buttons.justPressed(buttonIndex) && healthy(InputHealthMonitor::BUTTON_CHANNEL, buttonIndex); }
+    bool getButtonReleased(uint8_t buttonIndex) const { return buttons.justReleased(buttonIndex) && healthy(InputHealthMonitor::BUTTON_CHANNEL, buttonIndex); }
+    bool getButtonState(uint8_t buttonIndex) const { return buttons.isPressed(buttonIndex) && healthy(InputHealthMonitor::BUTTON_CHANNEL, buttonIndex); }
+
+    // Debounced joystick access (single pulse per press)
+    bool getJoystickPressed(uint8_t direction) const { return joystick.justPressed(direction) && healthy(InputHealthMonitor::JOYSTICK_CHANNEL, direction); }
+
+    // Debounced switch access
+    bool getSwitchState(uint8_t switchIndex) const { return switches.isPressed(switchIndex) && healthy(InputHealthMonitor::SWITCH_CHANNEL, switchIndex); }
+    bool getSwitchChanged(uint8_t switchIndex) const { return switches.justChanged(switchIndex) && healthy(InputHealthMonitor::SWITCH_CHANNEL, switchIndex); }
+
+    // Smoothed potentiometer access (out-of-range indexes read pot 0)
+    uint8_t getPotMidiValue(uint8_t potIndex) const { return pots.getMidiValue(potIndex); }
+    bool getPotChanged(uint8_t potIndex) const { return pots.hasSignificantChange(potIndex) && healthy(InputHealthMonitor::POT_CHANNEL, potIndex); }
+
+    // Idle detection
+    uint32_t getTimeSinceLastActivity() const { return Policy::nowMs() - lastActivityTime; }
+    bool isIdle() const { return getTimeSinceLastActivity() >= idleTimeoutMs; }
+
+    // Chattering, stuck and noisy inputs
+    const InputHealthMonitor& getHealth() const { return health; }
+
+    // Test mode support
+    void enableTestMode(bool enable) { testModeEnabled = enable; }
+
+    void dumpTestValues(Print& out) const {
+        if (!testModeEnabled) return;
+
+        out.println("=== INPUT STATE DUMP ===");
+        out.print("Buttons: ");
+        for (uint8_t i = 0; i < ButtonPins::count; i++) {
+            out.printf("%d:%s ", i, getButtonState(i) ? "ON" : "OFF");
+        }
+        out.println();
+        out.print("Switches: ");
+        for (uint8_t i = 0; i < SwitchPins::count; i++) {
+            out.printf("%d:%s ", i, getSwitchState(i) ? "ON" : "OFF");
+        }
+        out.println();
+        out.print("Pots: ");
+        for (uint8_t i = 0; i < PotPins::count; i++) {
+            out.printf("%d:MIDI_%d ", i, getPotMidiValue(i));
+        }
+        out.println();
+        out.printf("Activity: %lums ago, Idle: %s\n",
+                      (unsigned long)getTimeSinceLastActivity(), isIdle() ? "YES" : "NO");
+        out.println("========================");
+    }
+
+private:
+    using FramePolicy = FrameInputPolicy<ButtonPins, JoystickPins, SwitchPins, PotPins, Policy>;
+
+    DigitalBank<ButtonPins, Policy> buttons;
+    DigitalBank<JoystickPins, Policy> joystick;
+    DigitalBank<SwitchPins, Policy> switches;
+    AnalogBank<PotPins, Policy> pots;
+
+    uint32_t joystickRearmTime[4] = {};
+    uint8_t joystickRaw = 0;            // Direction levels, ignoring the rearm window
+    uint16_t joystickRearmMs = JOYSTICK_REARM_MS;
+    uint32_t lastActivityTime = 0;
+    uint32_t idleTimeoutMs = IDLE_TIMEOUT_MS;
+    bool testModeEnabled = false;
+    InputHealthMonitor health;
+
+    bool healthy(uint8_t base, uint8_t index) const { return !health.isQuarantined(base + index); }
+
+    template <typename Reader, size_t... I>
+    static uint32_t readJoystick(std::index_sequence<I...>) {
+        return (((uint32_t)Reader::template readDigital<JoystickPins::pins[I]>() << I) | ...);
+    }
+
+    template <typename Reader>
+    void updateFrom() {
+        const uint32_t now = Reader::nowMs();
+
+        uint32_t changed = buttons.template update<Reader>(now);
+        if (changed) {
+            onDigitalChanges(changed, buttons.getStableMask(), FLIGHT_BUTTON, LOG_INPUT_BUTTON,
+                             InputHealthMonitor::BUTTON_CHANNEL, now);
+        }
+
+        // Directions still in their rearm window read as released
+        uint32_t armed = 0;
+        for (uint8_t i = 0; i < 4; i++) {
+            if (now >= joystickRearmTime[i]) armed |= 1UL << i;
+        }
+        changed = joystick.template update<Reader>(now, armed);
+        const uint32_t healthy = health.recordEdges(changed << InputHealthMonitor::JOYSTICK_CHANNEL, now);
+        uint32_t pressed = changed & joystick.getStableMask();
+        if (pressed) {
+            if (healthy & (pressed << InputHealthMonitor::JOYSTICK_CHANNEL)) lastActivityTime = now;
+            for (uint8_t i = 0; i < 4; i++) {
+                if (pressed & (1UL << i)) {
+                    joystickRearmTime[i] = now + joystickRearmMs;
+                    FLIGHT_RECORD(FLIGHT_JOYSTICK, i, 1);
+                    LOG_EVENT(LOG_INPUT_JOYSTICK, i, joystickRearmMs);
+                }
+            }
+        }
+
+        changed = switches.template update<Reader>(now);
+        if (changed) {
+            onDigitalChanges(changed, switches.getStableMask(), FLIGHT_SWITCH, LOG_INPUT_SWITCH,
+                             InputHealthMonitor::SWITCH_CHANNEL, now);
+        }
+
+        uint32_t sent = pots.template update<Reader>(now);
+        if (sent) {
+            for (uint8_t i = 0; i < PotPins::count; i++) {
+                if (sent & (1UL << i)) {
+                    if (health.recordPot(i, pots.getMidiValue(i), now)) lastActivityTime = now;
+                    FLIGHT_RECORD(FLIGHT_POT, i, pots.getRawFiltered(i));
+                    LOG_EVENT(LOG_INPUT_POT, i, pots.getRawReading(i), pots.getMidiValue(i));
+                }
+            }
+        }
+
+        // Raw levels for stuck buttons; joystick directions ignore the rearm window
+        joystickRaw = readJoystick<Reader>(std::make_index_sequence<4>{});
+        const uint32_t rawActive = buttons.getRawMask() << InputHealthMonitor::BUTTON_CHANNEL |
+                                   joystickRaw << InputHealthMonitor::JOYSTICK_CHANNEL;
+        health.update(rawActive, now);
+    }
+
+    void onDigitalChanges(uint32_t changed, uint32_t stable, FlightEventType type, LogId logId,
+                          uint8_t channel, uint32_t now) {
+        if (health.recordEdges(changed << channel, now)) lastActivityTime = now;
+        #if FLIGHT_RECORDER > 0 || EVENT_LOG > 0
+        for (uint8_t i = 0; i < 32 && changed; i++, changed >>= 1, stable >>= 1) {
+            if (changed & 1) {
+                FLIGHT_RECORD(type, i, stable & 1);
+                LOG_EVENT(logId, i, stable & 1);
+            }
+        }
+        #endif
+        (void)stable;
+        (void)type;
+        (void)logId;
+    }
+};
+
+// ===== FIRMWARE PIN LISTS =====
+// Template mirrors of pins.h; the asserts below keep them in sync
+using ButtonPinList = PinList<2, 3, 4, 5, 6, 7, 8, 9, 10, 11>;
+using JoystickPinList = PinList<JOYSTICK_UP, JOYSTICK_DOWN, JOYSTICK_LEFT, JOYSTICK_RIGHT>;
+using SwitchPinList = PinList<22, 23, 24, 25, 26, 27, 28, 29, 16, 17, 18, 21>;
+using PotPinList = PinList<A0, A1, A2, A3>;
+
+template <typename List, size_t N>
+constexpr bool pinListMatches(const uint8_t (&pins)[N]) {
+    if (List::count != N) return false;
+    for (size_t i = 0; i < N; i++) {
+        if (List::pins[i] != pins[i]) return false;
+    }
+    return true;
+}
+
+static_assert(pinListMatches<ButtonPinList>(BUTTON_PINS), "ButtonPinList must match BUTTON_PINS");
+static_assert(pinListMatches<SwitchPinList>(SWITCH_PINS), "SwitchPinList must match SWITCH_PINS");
+static_assert(pinListMatches<PotPinList>(POT_PINS), "PotPinList must match POT_PINS");
+
+using StaticRobustInputProcessor =
+    StaticInputProcessor<ButtonPinList, JoystickPinList, SwitchPinList, PotPinList>;
+
+#if STATIC_INPUT_PIPELINE > 0
+using InputProcessor = StaticRobustInputProcessor;
+#else
+using InputProcessor = RobustInputProcessor;
+#endif
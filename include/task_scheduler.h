@@ -0,0 +1,127 @@
+#pragma once
+
+#include <Arduino.h>
+#include "config.h"
+
+class LoopWatchdog;
+
+/**
+ * @brief Deadline-aware cooperative scheduler for the main loop
+ *
+ * Replaces the hand-written elapsedMicros/elapsedMillis blocks in loop().
+ * Each task has a period, a priority and a relative deadline. A release of
+ * a task (a "job") may be split into several slices: the task function
+ * returns true while it has more work, and the scheduler calls it again on
+ * a later run() so higher-priority tasks can go in between.
+ *
+ * run() executes at most one slice. It picks the highest-priority ready
+ * task whose estimated slice time fits before the next deadline of every
+ * higher-priority task (admission check), so a long OLED transfer chunk or
+ * LED show is deferred until just after the 1 kHz input tick instead of
+ * delaying it. A task whose own deadline has already passed is run anyway
+ * so low-priority work cannot starve.
+ *
+ * Per task it records slices, run time, worst slice, deadline overruns
+ * and releases skipped because the previous job was still running or the
+ * loop stalled for more than a period. All storage is static.
+ */
+
+enum TaskPriority : uint8_t {
+    TASK_PRIORITY_LOW = 0,       // Heartbeat, debug dumps
+    TASK_PRIORITY_NORMAL = 1,    // OLED
+    TASK_PRIORITY_HIGH = 2,      // Portal render
+    TASK_PRIORITY_CRITICAL = 3   // 1 kHz input scan
+};
+
+class TaskScheduler {
+public:
+    /**
+     * @brief Task body; runs one slice of the current job
+     * @return true if the job has more slices, false when it is complete
+     */
+    typedef bool (*TaskFunction)();
+
+    static constexpr uint8_t MAX_TASKS = 16;
+    static constexpr uint8_t INVALID_TASK = 0xFF;
+
+    struct TaskStats {
+        uint32_t jobs;            // Completed jobs
+        uint32_t slices;          // Slices executed
+        uint32_t totalUs;         // Time spent in the task
+        uint32_t maxSliceUs;      // Longest single slice
+        uint32_t maxJobUs;        // Longest release-to-completion time
+        uint32_t overruns;        // Jobs that completed after their deadline
+        uint32_t missedReleases;  // Releases skipped entirely
+        uint32_t deferrals;       // run() calls where admission held the task back
+    };
+
+    TaskScheduler();
+
+    /**
+     * @brief Register a task
+     * @param name Short name for diagnostics (not copied)
+     * @param function Task body
+     * @param periodUs Release period in microseconds
+     * @param priority Higher value wins
+     * @param deadlineUs Relative deadline; 0 = same as period
+     * @return Task id, or INVALID_TASK if the table is full
+     */
+    uint8_t addTask(const char* name, TaskFunction function, uint32_t periodUs,
+                    TaskPriority priority, uint32_t deadlineUs = 0);
+
+    /**
+     * @brief Align all first releases to now; call at the end of setup()
+     */
+    void begin();
+
+    /**
+     * @brief Run at most one task slice; call from loop()
+     * @return true if a slice ran
+     */
+    bool run();
+
+    /**
+     * @brief Enable or disable a task; re-enabling releases it immediately
+     */
+    void setEnabled(uint8_t id, bool enabled);
+
+    /**
+     * @brief Report slice starts and job completions to a watchdog (optional)
+     */
+    void setWatchdog(LoopWatchdog* dog) { watchdog = dog; }
+
+    // Diagnostics
+    uint8_t getTaskCount() const { return taskCount; }
+    const char* getTaskName(uint8_t id) const { return tasks[id].name; }
+    const TaskStats& getStats(uint8_t id) const { return tasks[id].stats; }
+    void resetStats();
+    void printStats(Print& out) const;
+
+private:
+    struct Task {
+        const char* name;
+        TaskFunction function;
+        uint32_t periodUs;
+        uint32_t deadlineUs;
+        TaskPriority priority;
+        bool enabled;
+
+        uint32_t nextRelease;     // Start of the next period
+        uint32_t jobRelease;      // Release time of the job in progress
+        bool jobActive;           // Job started and has more slices
+        uint32_t estimateUs;      // Decaying worst slice time, for admission
+
+        TaskStats stats;
+    };
+
+    Task tasks[MAX_TASKS];
+    uint8_t taskCount;
+    LoopWatchdog* watchdog;
+
+    bool isReady(Task& task, uint32_t now);
+    bool fitsBeforeHigherDeadlines(const Task& task, uint32_t now) const;
+    void runSlice(Task& task);
+
+    // Wrap-safe "a is at or after b" for micros() timestamps
+    static bool reached(uint32_t a, uint32_t b) { return (int32_t)(a - b) >= 0; }
+};
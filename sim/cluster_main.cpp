@@ -0,0 +1,497 @@
+/**
+ * @brief Several simulated boards chained over their cluster UARTs
+ *
+ * Usage: cluster_sim --primary LIB --secondary LIB [options]
+ *   --boards N            Boards in the chain, primary included (default 4)
+ *   --step US             Virtual time per loop() pass (default 50)
+ *   --presses N           Presses per board for the latency test (default 20)
+ *   --rounds N            Rounds of the ordering test (default 20)
+ *   --spacing-us US       Time between presses on different boards (default 1500)
+ *   --load-ms MS          Length of the throughput test (default 500)
+ *   --load-period-us US   Time between toggles of each loaded input (default 12000)
+ *   --quiet               Only the summaries
+ *
+ * Every board is the whole firmware, loaded from its own copy of the
+ * primary or secondary board library (cluster_node.h), so each has its own
+ * globals and clock. Clocks start far apart (one just short of the
+ * micros() wrap) and all boards step in lockstep. After each pass the bytes
+ * each UART has finished sending are handed to the board on the other end
+ * of its cable:
+ *   primary Serial5 <-> Serial5 board 1 Serial8 <-> Serial5 board 2 ...
+ *
+ * Phases:
+ *   1. enumeration: every secondary gets its number, the primary sees all
+ *   2. latency: button presses on each board to the primary's note on,
+ *      per hop
+ *   3. ordering: presses on different boards --spacing-us apart, in a
+ *      shuffled board order, must come out of the primary in press order
+ *   4. throughput: buttons and switches on every board toggling at once;
+ *      every edge must come out, nothing dropped or merged late
+ *   5. cues: SET_PROGRAM sent to the primary must reach every board; one
+ *      the primary NAKs (program out of range) must not be passed down
+ *   6. timeout: the last board is unplugged while holding a note; the
+ *      primary must release it and keep playing the others
+ *
+ * UART timing is modeled on the virtual clock at CLUSTER_BAUD; the frames
+ * themselves go through every board's real encoder, parser and merger.
+ * Exits 1 if any check fails.
+ *
+ * Build & run: make cluster-sim [CLUSTER_ARGS="--boards 8"]
+ */
+
+#include <algorithm>
+#include <dlfcn.h>
+#include <fstream>
+#include <math.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "cluster_node.h"
+#include "cluster_link.h"
+#include "serial_portal_protocol.h"
+
+namespace {
+
+constexpr uint64_t PHASE_TIMEOUT_US = 2000000;
+constexpr uint32_t HOLD_US = 20000;
+constexpr uint8_t LATENCY_BUTTON = 2;
+constexpr uint8_t ORDER_BUTTON = 3;
+constexpr uint8_t TIMEOUT_BUTTON = 4;
+constexpr uint8_t PORT_A = 5;   // Serial5
+constexpr uint8_t PORT_B = 8;   // Serial8
+
+struct Options {
+    const char* primary = nullptr;
+    const char* secondary = nullptr;
+    uint32_t boards = 4;
+    uint32_t stepUs = 50;
+    uint32_t presses = 20;
+    uint32_t rounds = 20;
+    uint32_t spacingUs = 1500;
+    uint32_t loadMs = 500;
+    uint32_t loadPeriodUs = 12000;
+    bool quiet = false;
+};
+
+Options options;
+
+struct Board {
+    const ClusterNodeApi* api;
+    uint64_t offsetUs;
+    bool plugged;
+};
+
+std::vector<Board> boards;
+uint64_t elapsedUs = 0;         // Shared time since start
+uint64_t linkBytes = 0;         // Bytes into the primary
+
+// Board number on the MIDI channel
+uint8_t channelOf(uint8_t board) {
+    return MIDI_CHANNEL + board;
+}
+
+const ClusterNodeApi& primary() {
+    return *boards[0].api;
+}
+
+void carry(Board& from, uint8_t fromPort, Board& to, uint8_t toPort) {
+    std::vector<uint8_t> bytes;
+    from.api->uartTake(fromPort, bytes);
+    if (!bytes.empty() && from.plugged && to.plugged) {
+        to.api->uartInput(toPort, bytes.data(), bytes.size());
+        if (&to == &boards[0]) linkBytes += bytes.size();
+    }
+}
+
+// One pass on every board, then the cables
+void round() {
+    elapsedUs += options.stepUs;
+    for (Board& board : boards) {
+        if (board.plugged) board.api->pass(board.offsetUs + elapsedUs);
+    }
+    for (size_t i = 1; i < boards.size(); i++) {
+        const uint8_t upPort = i == 1 ? PORT_A : PORT_B;
+        carry(boards[i - 1], upPort, boards[i], PORT_A);
+        carry(boards[i], PORT_A, boards[i - 1], upPort);
+    }
+}
+
+void runFor(uint64_t us) {
+    const uint64_t until = elapsedUs + us;
+    while (elapsedUs < until) round();
+}
+
+bool isNote(const sim::MidiEvent& event, bool on, uint8_t channel, uint8_t note) {
+    const bool noteOn = event.type == sim::MIDI_NOTE_ON && event.data2 > 0;
+    const bool noteOff = event.type == sim::MIDI_NOTE_OFF ||
+                         (event.type == sim::MIDI_NOTE_ON && event.data2 == 0);
+    return (on ? noteOn : noteOff) && event.channel == channel && event.data1 == note;
+}
+
+// Run until the primary plays a matching note; its time on the primary's clock
+bool waitNote(bool on, uint8_t channel, uint8_t note, uint64_t& atUs, uint64_t timeoutUs = PHASE_TIMEOUT_US) {
+    std::vector<sim::MidiEvent>& midi = primary().midiOutput();
+    size_t seen = midi.size();
+    const uint64_t until = elapsedUs + timeoutUs;
+    while (elapsedUs < until) {
+        round();
+        for (; seen < midi.size(); seen++) {
+            if (isNote(midi[seen], on, channel, note)) {
+                atUs = midi[seen].timeUs;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+double mean(const std::vector<double>& values) {
+    double sum = 0;
+    for (double v : values) sum += v;
+    return values.empty() ? 0 : sum / values.size();
+}
+
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, (size_t)(p * values.size()))];
+}
+
+// ===== PHASES =====
+
+bool runEnumeration() {
+    uint8_t expected = 0;
+    for (size_t i = 1; i < boards.size(); i++) expected |= 1 << i;
+
+    const uint64_t startUs = elapsedUs;
+    while (elapsedUs - startUs < PHASE_TIMEOUT_US) {
+        round();
+        bool numbered = primary().link().getActiveNodes() == expected;
+        for (size_t i = 1; i < boards.size() && numbered; i++) {
+            numbered = boards[i].api->link().getNodeId() == i;
+        }
+        if (numbered) {
+            printf("enumeration: %zu boards after %.1f ms\n", boards.size(), (elapsedUs - startUs) / 1000.0);
+            return true;
+        }
+    }
+    printf("FAIL enumeration: primary sees boards 0x%02X, expected 0x%02X\n",
+           primary().link().getActiveNodes(), expected);
+    return false;
+}
+
+bool runLatency() {
+    bool ok = true;
+    printf("\n%-6s %6s %9s %9s %9s\n", "board", "hops", "mean us", "p99 us", "max us");
+    for (size_t b = 0; b < boards.size(); b++) {
+        std::vector<double> latency;
+        for (uint32_t p = 0; p < options.presses; p++) {
+            const uint64_t pressUs = primary().nowMicros();
+            boards[b].api->setButton(LATENCY_BUTTON, true);
+            uint64_t onUs;
+            if (waitNote(true, channelOf(b), BUTTON_NOTES[LATENCY_BUTTON], onUs, HOLD_US * 5)) {
+                latency.push_back((double)(onUs - pressUs));
+            }
+            runFor(HOLD_US);
+            boards[b].api->setButton(LATENCY_BUTTON, false);
+            runFor(HOLD_US + (p * 137) % 1000);  // Vary the scan phase
+        }
+        printf("%-6zu %6zu %9.0f %9.0f %9.0f\n", b, b, mean(latency), percentile(latency, 0.99),
+               percentile(latency, 1.0));
+        if (latency.size() != options.presses) {
+            printf("FAIL board %zu: %zu of %u presses played\n", b, latency.size(), options.presses);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+bool runOrdering() {
+    std::vector<sim::MidiEvent>& midi = primary().midiOutput();
+    const size_t first = midi.size();
+    std::vector<uint8_t> expected;
+    std::vector<uint8_t> order(boards.size());
+    uint32_t seed = 12345;
+
+    for (uint32_t r = 0; r < options.rounds; r++) {
+        for (size_t i = 0; i < order.size(); i++) order[i] = i;
+        for (size_t i = order.size() - 1; i > 0; i--) {
+            seed = seed * 1103515245 + 12345;
+            std::swap(order[i], order[(seed >> 16) % (i + 1)]);
+        }
+        for (uint8_t b : order) {
+            boards[b].api->setButton(ORDER_BUTTON, true);
+            expected.push_back(channelOf(b));
+            runFor(options.spacingUs);
+        }
+        runFor(HOLD_US);
+        for (uint8_t b : order) boards[b].api->setButton(ORDER_BUTTON, false);
+        runFor(HOLD_US * 2);
+    }
+
+    std::vector<uint8_t> played;
+    for (size_t i = first; i < midi.size(); i++) {
+        if (isNote(midi[i], true, midi[i].channel, BUTTON_NOTES[ORDER_BUTTON])) played.push_back(midi[i].channel);
+    }
+    size_t wrong = 0;
+    for (size_t i = 0; i < std::min(played.size(), expected.size()); i++) {
+        if (played[i] != expected[i]) wrong++;
+    }
+    printf("\nordering: %zu presses %u us apart, %zu played, %zu out of place\n", expected.size(),
+           options.spacingUs, played.size(), wrong);
+    if (played.size() != expected.size() || wrong > 0) {
+        printf("FAIL merged order differs from press order\n");
+        return false;
+    }
+    return true;
+}
+
+bool runThroughput() {
+    constexpr uint8_t LOADED = 8;       // Buttons 2-9 and switches 0-7 on every board
+    std::vector<sim::MidiEvent>& midi = primary().midiOutput();
+    const size_t first = midi.size();
+    const uint32_t mergedBefore = primary().link().getEventsMerged();
+    const uint64_t bytesBefore = linkBytes;
+    const uint64_t startUs = elapsedUs;
+
+    std::vector<uint32_t> edges(boards.size(), 0);
+    bool on = false;
+    while (elapsedUs - startUs < options.loadMs * 1000ULL) {
+        on = !on;
+        for (size_t b = 0; b < boards.size(); b++) {
+            for (uint8_t i = 0; i < LOADED; i++) {
+                boards[b].api->setButton(2 + i, on);
+                boards[b].api->setSwitch(i, on);
+            }
+            edges[b] += LOADED * 2;
+        }
+        runFor(options.loadPeriodUs);
+    }
+    if (on) {
+        for (size_t b = 0; b < boards.size(); b++) {
+            for (uint8_t i = 0; i < LOADED; i++) {
+                boards[b].api->setButton(2 + i, false);
+                boards[b].api->setSwitch(i, false);
+            }
+            edges[b] += LOADED * 2;
+        }
+    }
+    const uint64_t loadUs = elapsedUs - startUs;
+    runFor(100000);
+
+    bool ok = true;
+    for (size_t b = 0; b < boards.size(); b++) {
+        uint32_t played = 0;
+        for (size_t i = first; i < midi.size(); i++) {
+            const sim::MidiEvent& event = midi[i];
+            if (event.channel != channelOf(b)) continue;
+            for (uint8_t n = 0; n < LOADED; n++) {
+                if ((event.type == sim::MIDI_NOTE_ON || event.type == sim::MIDI_NOTE_OFF) &&
+                    event.data1 == BUTTON_NOTES[2 + n]) played++;
+                if (event.type == sim::MIDI_CONTROL_CHANGE && event.data1 == SWITCH_CCS[n]) played++;
+            }
+        }
+        if (played != edges[b]) {
+            printf("FAIL board %zu: %u of %u edges played\n", b, played, edges[b]);
+            ok = false;
+        }
+    }
+
+    const ClusterMerger& merger = primary().link().getMerger();
+    const uint32_t merged = primary().link().getEventsMerged() - mergedBefore;
+    uint32_t forwardDrops = 0, crcErrors = primary().link().getCrcErrors(), overruns = 0;
+    for (const Board& board : boards) {
+        forwardDrops += board.api->link().getForwardDrops();
+        crcErrors += board.api == &primary() ? 0 : board.api->link().getCrcErrors();
+        overruns += board.api->uartOverruns(PORT_A) + board.api->uartOverruns(PORT_B);
+    }
+    const double linkLoad = (linkBytes - bytesBefore) * 10.0 * 1e6 / loadUs / CLUSTER_BAUD;
+    printf("\nthroughput: %u events in %.0f ms = %.0f events/s merged, link into primary %.0f%% busy\n",
+           merged, loadUs / 1000.0, merged * 1e6 / loadUs, linkLoad * 100);
+    printf("merge: worst delay %u us, %u by window, %u out of order, %u dropped; "
+           "%u forward drops, %u CRC errors, %u overruns\n",
+           merger.getMaxDelayUs(), merger.getLate(), merger.getOutOfOrder(), merger.getDropped(),
+           forwardDrops, crcErrors, overruns);
+    if (merger.getDropped() || merger.getOutOfOrder() || forwardDrops || crcErrors || overruns) {
+        printf("FAIL events lost or reordered under load\n");
+        ok = false;
+    }
+    return ok;
+}
+
+bool runCues() {
+    bool ok = true;
+    const uint32_t forwardedBefore = primary().link().getCuesForwarded();
+    for (uint8_t cue = 0; cue < 2; cue++) {
+        // A program no board shows yet (inputs can change it locally)
+        uint8_t program = 0;
+        while (std::any_of(boards.begin(), boards.end(),
+                           [&](const Board& board) { return board.api->currentProgram() == program; })) {
+            program++;
+        }
+        uint8_t frame[PORTAL_MSG_MIN_SIZE];
+        PortalMessage(PortalSerialCommand::SET_PROGRAM, program).toBytes(frame);
+        primary().serialInput(frame, sizeof(frame));
+
+        const uint64_t startUs = elapsedUs;
+        std::vector<double> reached(boards.size(), -1);
+        size_t count = 0;
+        while (count < boards.size() && elapsedUs - startUs < PHASE_TIMEOUT_US) {
+            round();
+            for (size_t b = 0; b < boards.size(); b++) {
+                if (reached[b] < 0 && boards[b].api->currentProgram() == program) {
+                    reached[b] = (double)(elapsedUs - startUs);
+                    count++;
+                }
+            }
+        }
+        printf("%scue SET_PROGRAM %u: on %zu of %zu boards, last after %.0f us\n", cue == 0 ? "\n" : "",
+               program, count, boards.size(), *std::max_element(reached.begin(), reached.end()));
+        if (count != boards.size()) {
+            printf("FAIL cue did not reach every board\n");
+            ok = false;
+        }
+    }
+
+    // Refused on the primary: NAK, and nothing goes down the chain
+    uint8_t frame[PORTAL_MSG_MIN_SIZE];
+    PortalMessage(PortalSerialCommand::SET_PROGRAM, PORTAL_PROGRAM_COUNT).toBytes(frame);
+    primary().serialInput(frame, sizeof(frame));
+    runFor(PHASE_TIMEOUT_US / 20);
+    const uint32_t forwarded = primary().link().getCuesForwarded() - forwardedBefore;
+    printf("cue SET_PROGRAM %u (out of range): %u of 3 cues passed down\n", PORTAL_PROGRAM_COUNT, forwarded);
+    if (forwarded != 2) {
+        printf("FAIL rejected cue was passed down\n");
+        ok = false;
+    }
+    return ok;
+}
+
+bool runTimeout() {
+    const uint8_t last = boards.size() - 1;
+    uint64_t atUs;
+    boards[last].api->setButton(TIMEOUT_BUTTON, true);
+    if (!waitNote(true, channelOf(last), BUTTON_NOTES[TIMEOUT_BUTTON], atUs)) {
+        printf("FAIL timeout: held note never played\n");
+        return false;
+    }
+
+    // Unplugged while the note is held
+    boards[last].plugged = false;
+    const uint64_t cutUs = primary().nowMicros();
+    if (!waitNote(false, channelOf(last), BUTTON_NOTES[TIMEOUT_BUTTON], atUs)) {
+        printf("FAIL timeout: held note never released\n");
+        return false;
+    }
+    const double releaseMs = (atUs - cutUs) / 1000.0;
+    const bool dropped = !(primary().link().getActiveNodes() & (1 << last));
+
+    // The rest still play
+    bool ok = true;
+    for (uint8_t b = 0; b < last; b++) {
+        const uint64_t pressUs = primary().nowMicros();
+        boards[b].api->setButton(TIMEOUT_BUTTON, true);
+        if (!waitNote(true, channelOf(b), BUTTON_NOTES[TIMEOUT_BUTTON], atUs, HOLD_US * 5) ||
+            atUs - pressUs > HOLD_US) {
+            printf("FAIL board %u stopped playing after board %u left\n", b, last);
+            ok = false;
+        }
+        runFor(HOLD_US);
+        boards[b].api->setButton(TIMEOUT_BUTTON, false);
+    }
+    printf("\ntimeout: board %u unplugged, note released after %.1f ms (limit %u ms), %s\n", last, releaseMs,
+           CLUSTER_NODE_TIMEOUT_MS, dropped ? "board dropped" : "board still listed");
+    if (!dropped || releaseMs > CLUSTER_NODE_TIMEOUT_MS + CLUSTER_ENUMERATE_MS) {
+        printf("FAIL silent board not dropped in time\n");
+        ok = false;
+    }
+    return ok;
+}
+
+// ===== SETUP =====
+
+// A private copy of the library, so each board gets its own globals
+const ClusterNodeApi* load(const char* path, size_t board) {
+    const std::string copy = std::string(path) + "." + std::to_string(board);
+    {
+        std::ifstream in(path, std::ios::binary);
+        std::ofstream out(copy, std::ios::binary | std::ios::trunc);
+        out << in.rdbuf();
+        if (!in || !out) return nullptr;
+    }
+    void* handle = dlopen(copy.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        fprintf(stderr, "%s\n", dlerror());
+        return nullptr;
+    }
+    auto entry = reinterpret_cast<const ClusterNodeApi* (*)()>(dlsym(handle, "clusterNodeApi"));
+    return entry ? entry() : nullptr;
+}
+
+bool parseOptions(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        auto value = [&]() -> uint32_t { return i + 1 < argc ? strtoul(argv[++i], nullptr, 0) : 0; };
+        if (arg == "--primary" && i + 1 < argc) options.primary = argv[++i];
+        else if (arg == "--secondary" && i + 1 < argc) options.secondary = argv[++i];
+        else if (arg == "--boards") options.boards = std::min<uint32_t>(std::max<uint32_t>(2, value()), CLUSTER_MAX_NODES);
+        else if (arg == "--step") options.stepUs = std::max<uint32_t>(1, value());
+        else if (arg == "--presses") options.presses = std::max<uint32_t>(1, value());
+        else if (arg == "--rounds") options.rounds = value();
+        else if (arg == "--spacing-us") options.spacingUs = std::max<uint32_t>(1, value());
+        else if (arg == "--load-ms") options.loadMs = value();
+        else if (arg == "--load-period-us") options.loadPeriodUs = std::max<uint32_t>(1, value());
+        else if (arg == "--quiet") options.quiet = true;
+        else {
+            fprintf(stderr, "unknown option %s\n", arg.c_str());
+            return false;
+        }
+    }
+    if (!options.primary || !options.secondary) {
+        fprintf(stderr, "usage: cluster_sim --primary LIB --secondary LIB [options]\n");
+        return false;
+    }
+    return true;
+}
+
+class StdoutPrint : public Print {
+public:
+    size_t write(uint8_t b) override { return fputc(b, stdout) == EOF ? 0 : 1; }
+    using Print::write;
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (!parseOptions(argc, argv)) return 2;
+
+    // Clocks far apart; the last board's micros() wraps two seconds in
+    for (size_t b = 0; b < options.boards; b++) {
+        const ClusterNodeApi* api = load(b == 0 ? options.primary : options.secondary, b);
+        if (!api || api->role != (b == 0 ? CLUSTER_PRIMARY : CLUSTER_SECONDARY)) {
+            printf("FAIL cannot load board %zu\n", b);
+            return 1;
+        }
+        const uint64_t offsetUs = b + 1 == options.boards ? 0xFFFFFFFFULL - 2000000 : b * 123456789ULL;
+        boards.push_back({api, offsetUs, true});
+    }
+    for (Board& board : boards) {
+        board.api->start(board.offsetUs);
+        if (!options.quiet) printf("%s", board.api->serialOutput().c_str());
+        board.api->serialOutput().clear();
+    }
+
+    bool ok = runEnumeration();
+    ok = runLatency() && ok;
+    ok = runOrdering() && ok;
+    ok = runThroughput() && ok;
+    ok = runCues() && ok;
+    ok = runTimeout() && ok;
+
+    if (!options.quiet) {
+        StdoutPrint out;
+        printf("\n");
+        for (const Board& board : boards) board.api->printStats(out);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,73 @@
+/**
+ * @brief Board library entry point for the cluster runner (see cluster_node.h)
+ *
+ * Built with -DCLUSTER_ROLE=1 or 2 into a shared object together with the
+ * firmware; -Wl,-Bsymbolic keeps every board's references on its own copy.
+ */
+
+#include "cluster_node.h"
+#include "cluster_link.h"
+#include "portal_controller.h"
+
+#if CLUSTER_ROLE == CLUSTER_STANDALONE
+#error "cluster_node needs -DCLUSTER_ROLE=1 (primary) or 2 (secondary)"
+#endif
+
+// Firmware entry points and globals, from src/main.cpp
+void setup();
+void loop();
+extern PortalController portalController;
+
+namespace {
+
+void start(uint64_t startUs) {
+    sim::reset();
+    sim::setMicros(startUs);
+    setup();
+    sim::endPass(0);
+}
+
+void pass(uint64_t untilUs) {
+    sim::beginPass();
+    loop();
+    sim::endPass(0);
+    if (sim::nowMicros() < untilUs) sim::advanceMicros(untilUs - sim::nowMicros());
+}
+
+uint8_t currentProgram() {
+    return portalController.getCurrentProgram();
+}
+
+const ClusterLink& link() {
+    return clusterLink;
+}
+
+void printStats(Print& out) {
+    clusterLink.printStats(out);
+}
+
+const ClusterNodeApi api = {
+    CLUSTER_ROLE,
+    start,
+    pass,
+    sim::nowMicros,
+    sim::setButton,
+    sim::setSwitch,
+    sim::setPot,
+    sim::uartTake,
+    sim::uartInput,
+    sim::uartOverruns,
+    sim::uartBlockedUs,
+    sim::serialInput,
+    sim::serialOutput,
+    sim::midiOutput,
+    currentProgram,
+    link,
+    printStats,
+};
+
+} // namespace
+
+extern "C" const ClusterNodeApi* clusterNodeApi() {
+    return &api;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <Arduino.h>
+#include <string>
+#include <vector>
+#include "sim_hardware.h"
+
+class ClusterLink;
+
+/**
+ * @brief One simulated cluster board, as seen by sim/cluster_main.cpp
+ *
+ * Each board is the whole firmware (every src file plus sim_hardware.cpp) built
+ * as a shared object with its own CLUSTER_ROLE. The runner loads a private
+ * copy per board, so every board has its own globals, pins, UARTs, MIDI
+ * output and virtual clock, and reaches them through this table.
+ */
+struct ClusterNodeApi {
+    uint8_t role;                               // CLUSTER_PRIMARY or CLUSTER_SECONDARY
+
+    // sim::reset(), clock to startUs, setup()
+    void (*start)(uint64_t startUs);
+    // One loop() pass, then the clock on to untilUs (unless the pass got there)
+    void (*pass)(uint64_t untilUs);
+    uint64_t (*nowMicros)();
+
+    void (*setButton)(uint8_t index, bool pressed);
+    void (*setSwitch)(uint8_t index, bool on);
+    void (*setPot)(uint8_t index, uint16_t value);
+
+    void (*uartTake)(uint8_t port, std::vector<uint8_t>& out);
+    void (*uartInput)(uint8_t port, const uint8_t* data, size_t length);
+    uint32_t (*uartOverruns)(uint8_t port);
+    uint64_t (*uartBlockedUs)();
+
+    void (*serialInput)(const uint8_t* data, size_t length);
+    std::string& (*serialOutput)();
+    std::vector<sim::MidiEvent>& (*midiOutput)();
+
+    uint8_t (*currentProgram)();
+    const ClusterLink& (*link)();
+    void (*printStats)(Print& out);
+};
+
+// Exported by each board library
+extern "C" const ClusterNodeApi* clusterNodeApi();
@@ -0,0 +1,93 @@
+#pragma once
+
+// Host stand-in for the subset of Adafruit GFX the OLED screens use
+// (see sim_hardware.h). Text uses the firmware's own 5x7 font.
+
+#include "Arduino.h"
+#include "oled_text.h"
+
+class Adafruit_GFX : public Print {
+public:
+    Adafruit_GFX(int16_t w, int16_t h) : _width(w), _height(h) {}
+
+    virtual void drawPixel(int16_t x, int16_t y, uint16_t color) = 0;
+
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+        for (int16_t i = 0; i < h; i++) drawPixel(x, y + i, color);
+    }
+
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+        for (int16_t i = 0; i < w; i++) drawPixel(x + i, y, color);
+    }
+
+    void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) {
+        // Bresenham
+        int16_t dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+        int16_t dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+        int16_t err = dx + dy;
+        while (true) {
+            drawPixel(x0, y0, color);
+            if (x0 == x1 && y0 == y1) break;
+            int16_t e2 = 2 * err;
+            if (e2 >= dy) { err += dy; x0 += sx; }
+            if (e2 <= dx) { err += dx; y0 += sy; }
+        }
+    }
+
+    void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+        drawFastHLine(x, y, w, color);
+        drawFastHLine(x, y + h - 1, w, color);
+        drawFastVLine(x, y, h, color);
+        drawFastVLine(x + w - 1, y, h, color);
+    }
+
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+        for (int16_t i = 0; i < w; i++) drawFastVLine(x + i, y, h, color);
+    }
+
+    void fillScreen(uint16_t color) { fillRect(0, 0, _width, _height, color); }
+
+    void setCursor(int16_t x, int16_t y) { cursorX = x; cursorY = y; }
+    void setTextSize(uint8_t size) { textSize = size ? size : 1; }
+    void setTextColor(uint16_t color) { textColor = color; }
+    void setTextWrap(bool wrap) { this->wrap = wrap; }
+
+    // Print interface: classic 6x8 cells, scaled by the text size
+    size_t write(uint8_t c) override {
+        if (c == '\n') {
+            cursorX = 0;
+            cursorY += 8 * textSize;
+        } else if (c != '\r') {
+            if (wrap && cursorX + 6 * textSize > _width) {
+                cursorX = 0;
+                cursorY += 8 * textSize;
+            }
+            drawChar(cursorX, cursorY, c);
+            cursorX += 6 * textSize;
+        }
+        return 1;
+    }
+    using Print::write;
+
+    int16_t width() const { return _width; }
+    int16_t height() const { return _height; }
+
+protected:
+    int16_t _width;
+    int16_t _height;
+    int16_t cursorX = 0;
+    int16_t cursorY = 0;
+    uint8_t textSize = 1;
+    uint16_t textColor = 1;
+    bool wrap = true;
+
+    void drawChar(int16_t x, int16_t y, uint8_t c) {
+        if (c < 0x20 || c > 0x7E) c = '?';
+        for (uint8_t col = 0; col < 5; col++) {
+            uint8_t line = OLED_FONT_5X7[(c - 0x20) * 5 + col];
+            for (uint8_t row = 0; row < 8; row++, line >>= 1) {
+                if (line & 1) fillRect(x + col * textSize, y + row * textSize, textSize, textSize, textColor);
+            }
+        }
+    }
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+// Host stand-in for Adafruit_SSD1306 (see sim_hardware.h). Commands and
+// frame data go out through the Wire stand-in, so the simulated panel only
+// shows what the firmware actually transferred.
+
+#include "Adafruit_GFX.h"
+#include "Wire.h"
+
+#define SSD1306_BLACK 0
+#define SSD1306_WHITE 1
+#define SSD1306_INVERSE 2
+
+#define SSD1306_SWITCHCAPVCC 0x02
+#define SSD1306_EXTERNALVCC 0x01
+#define SSD1306_COLUMNADDR 0x21
+#define SSD1306_PAGEADDR 0x22
+#define SSD1306_DISPLAYOFF 0xAE
+#define SSD1306_DISPLAYON 0xAF
+
+class Adafruit_SSD1306 : public Adafruit_GFX {
+public:
+    Adafruit_SSD1306(uint8_t w, uint8_t h, TwoWire* twi = &Wire, int8_t resetPin = -1,
+                     uint32_t clkDuring = 400000UL, uint32_t clkAfter = 100000UL)
+        : Adafruit_GFX(w, h), wire(twi) {
+        (void)resetPin;
+        (void)clkDuring;
+        (void)clkAfter;
+    }
+
+    ~Adafruit_SSD1306() { free(buffer); }
+
+    bool begin(uint8_t vcs = SSD1306_SWITCHCAPVCC, uint8_t addr = 0x3C,
+               bool reset = true, bool periphBegin = true) {
+        (void)vcs;
+        (void)reset;
+        if (!buffer) {
+            buffer = (uint8_t*)malloc(bufferSize());
+            if (!buffer) return false;
+        }
+        address = addr;
+        if (periphBegin) wire->begin();
+        clearDisplay();
+        ssd1306_command(SSD1306_DISPLAYON);
+        return true;
+    }
+
+    void clearDisplay() {
+        if (buffer) memset(buffer, 0, bufferSize());
+    }
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override {
+        if (!buffer || x < 0 || x >= _width || y < 0 || y >= _height) return;
+        uint8_t& cell = buffer[x + (y / 8) * _width];
+        const uint8_t bit = 1 << (y & 7);
+        switch (color) {
+            case SSD1306_WHITE: cell |= bit; break;
+            case SSD1306_BLACK: cell &= ~bit; break;
+            default: cell ^= bit; break;
+        }
+    }
+
+    // Full frame: address window, then the buffer in 32-byte data transactions
+    void display() {
+        if (!buffer) return;
+        ssd1306_command(SSD1306_PAGEADDR);
+        ssd1306_command(0);
+        ssd1306_command(_height / 8 - 1);
+        ssd1306_command(SSD1306_COLUMNADDR);
+        ssd1306_command(0);
+        ssd1306_command(_width - 1);
+        for (size_t offset = 0; offset < bufferSize(); offset += 32) {
+            wire->beginTransmission(address);
+            wire->write((uint8_t)0x40);
+            wire->write(buffer + offset, 32);
+            wire->endTransmission();
+        }
+    }
+
+    void ssd1306_command(uint8_t c) {
+        wire->beginTransmission(address);
+        wire->write((uint8_t)0x00);
+        wire->write(c);
+        wire->endTransmission();
+    }
+
+    uint8_t* getBuffer() { return buffer; }
+
+private:
+    TwoWire* wire;
+    uint8_t* buffer = nullptr;
+    uint8_t address = 0x3C;
+
+    size_t bufferSize() const { return (size_t)_width * ((_height + 7) / 8); }
+};
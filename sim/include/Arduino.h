@@ -0,0 +1,238 @@
+#pragma once
+
+// Host stand-in for the Teensy Arduino core (see sim_hardware.h)
+
+#include <ctype.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <type_traits>
+#include "sim_hardware.h"
+
+#ifndef F_CPU
+#define F_CPU 600000000UL
+#endif
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define INPUT_PULLDOWN 3
+
+#define F(string) (string)
+#define PROGMEM
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+// Teensy 4.1 analog pin numbers
+enum : uint8_t {
+    A0 = 14, A1 = 15, A2 = 16, A3 = 17, A4 = 18, A5 = 19, A6 = 20, A7 = 21,
+    A8 = 22, A9 = 23, A10 = 24, A11 = 25, A12 = 26, A13 = 27
+};
+
+// ===== TIME =====
+inline uint32_t micros() { return (uint32_t)sim::nowMicros(); }
+inline uint32_t millis() { return (uint32_t)(sim::nowMicros() / 1000); }
+inline void delayMicroseconds(uint32_t us) { sim::advanceMicros(us); }
+inline void delay(uint32_t ms) { sim::advanceMicros((uint64_t)ms * 1000); }
+inline void yield() {}
+
+class elapsedMillis {
+public:
+    elapsedMillis() : start(millis()) {}
+    elapsedMillis(uint32_t value) : start(millis() - value) {}
+    operator uint32_t() const { return millis() - start; }
+    elapsedMillis& operator=(uint32_t value) { start = millis() - value; return *this; }
+    elapsedMillis& operator+=(uint32_t value) { start -= value; return *this; }
+    elapsedMillis& operator-=(uint32_t value) { start += value; return *this; }
+private:
+    uint32_t start;
+};
+
+class elapsedMicros {
+public:
+    elapsedMicros() : start(micros()) {}
+    elapsedMicros(uint32_t value) : start(micros() - value) {}
+    operator uint32_t() const { return micros() - start; }
+    elapsedMicros& operator=(uint32_t value) { start = micros() - value; return *this; }
+    elapsedMicros& operator+=(uint32_t value) { start -= value; return *this; }
+    elapsedMicros& operator-=(uint32_t value) { start += value; return *this; }
+private:
+    uint32_t start;
+};
+
+// ===== PINS =====
+void pinMode(uint8_t pin, uint8_t mode);
+inline int digitalRead(uint8_t pin) { return sim::getDigital(pin) ? HIGH : LOW; }
+inline void digitalWrite(uint8_t pin, uint8_t value) { sim::setDigital(pin, value != LOW); }
+inline int digitalReadFast(uint8_t pin) { return digitalRead(pin); }
+inline void digitalWriteFast(uint8_t pin, uint8_t value) { digitalWrite(pin, value); }
+inline int analogRead(uint8_t pin) { return sim::getAnalog(pin); }
+inline void analogReadResolution(unsigned int) {}
+inline void analogReadAveraging(unsigned int) {}
+
+// ===== MATH =====
+#define PI 3.1415926535897932384626433832795
+#define HALF_PI 1.5707963267948966192313216916398
+#define TWO_PI 6.283185307179586476925286766559
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+
+template <typename T, typename U>
+inline typename std::common_type<T, U>::type min(T a, U b) { return a < b ? a : b; }
+
+template <typename T, typename U>
+inline typename std::common_type<T, U>::type max(T a, U b) { return a > b ? a : b; }
+
+template <typename T, typename L, typename H>
+inline T constrain(T value, L low, H high) {
+    return value < low ? (T)low : (value > high ? (T)high : value);
+}
+
+inline long map(long x, long inMin, long inMax, long outMin, long outMax) {
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+inline void randomSeed(uint32_t seed) { srand(seed); }
+inline long random(long howBig) { return howBig > 0 ? rand() % howBig : 0; }
+inline long random(long howSmall, long howBig) {
+    return howSmall < howBig ? howSmall + random(howBig - howSmall) : howSmall;
+}
+
+// ===== STRING =====
+// The parts of Arduino String the serial text commands use
+class String {
+public:
+    String(const char* s = "") : text(s ? s : "") {}
+    String(const std::string& s) : text(s) {}
+
+    unsigned int length() const { return text.size(); }
+    const char* c_str() const { return text.c_str(); }
+
+    void trim() {
+        size_t start = text.find_first_not_of(" \t\r\n");
+        size_t end = text.find_last_not_of(" \t\r\n");
+        text = start == std::string::npos ? "" : text.substr(start, end - start + 1);
+    }
+    void toLowerCase() {
+        for (char& c : text) c = tolower((unsigned char)c);
+    }
+    bool startsWith(const String& prefix) const { return text.compare(0, prefix.text.size(), prefix.text) == 0; }
+    String substring(unsigned int from) const { return from < text.size() ? text.substr(from) : ""; }
+    String substring(unsigned int from, unsigned int to) const {
+        return from < text.size() && to > from ? text.substr(from, to - from) : "";
+    }
+    long toInt() const { return atol(text.c_str()); }
+    float toFloat() const { return atof(text.c_str()); }
+
+    String& operator+=(char c) { text += c; return *this; }
+    String& operator+=(const String& s) { text += s.text; return *this; }
+    bool operator==(const String& s) const { return text == s.text; }
+    bool operator==(const char* s) const { return text == s; }
+    char operator[](unsigned int i) const { return i < text.size() ? text[i] : 0; }
+
+private:
+    std::string text;
+};
+
+// ===== PRINT / STREAM =====
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t b) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+        size_t n = 0;
+        while (size--) n += write(*buffer++);
+        return n;
+    }
+    size_t write(const char* str) { return write((const uint8_t*)str, strlen(str)); }
+    virtual int availableForWrite() { return 0; }
+    virtual void flush() {}
+
+    size_t print(const char* s) { return write(s); }
+    size_t print(const String& s) { return write(s.c_str()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int n) { return printf("%d", n); }
+    size_t print(unsigned int n) { return printf("%u", n); }
+    size_t print(long n) { return printf("%ld", n); }
+    size_t print(unsigned long n) { return printf("%lu", n); }
+    size_t print(double n, int digits = 2) { return printf("%.*f", digits, n); }
+
+    size_t println() { return write("\r\n"); }
+    template <typename T>
+    size_t println(T value) { size_t n = print(value); return n + println(); }
+
+    int printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        char buffer[256];
+        va_list args;
+        va_start(args, format);
+        int n = vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+        if (n > 0) write((const uint8_t*)buffer, (size_t)n < sizeof(buffer) ? n : sizeof(buffer) - 1);
+        return n;
+    }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() { return -1; }
+};
+
+// USB serial backed by sim::serialInput()/serialOutput()
+class usb_serial_class : public Stream {
+public:
+    void begin(uint32_t) {}
+    void end() {}
+    operator bool() const { return true; }
+    int available() override { return sim::detail::serialAvailable(); }
+    int read() override { return sim::detail::serialRead(); }
+    size_t write(uint8_t b) override { sim::detail::serialWrite(&b, 1); return 1; }
+    size_t write(const uint8_t* buffer, size_t size) override {
+        sim::detail::serialWrite(buffer, size);
+        return size;
+    }
+    using Print::write;
+    int availableForWrite() override { return 4096; }
+};
+
+extern usb_serial_class Serial;
+
+// Teensy UART; bytes leave at the baud rate on the virtual clock (see
+// sim::uartTake). A write that does not fit the transmit buffer blocks, as
+// on the Teensy, and the wait is counted by sim::uartBlockedUs().
+class HardwareSerial : public Stream {
+public:
+    explicit HardwareSerial(uint8_t port) : port(port) {}
+    void begin(uint32_t baud) { sim::detail::uartBegin(port, baud); }
+    void end() {}
+    void addMemoryForRead(void* buffer, size_t length) {
+        (void)buffer;
+        sim::detail::uartAddMemory(port, length, 0);
+    }
+    void addMemoryForWrite(void* buffer, size_t length) {
+        (void)buffer;
+        sim::detail::uartAddMemory(port, 0, length);
+    }
+    int available() override { return sim::detail::uartAvailable(port); }
+    int read() override { return sim::detail::uartRead(port); }
+    size_t write(uint8_t b) override { return write(&b, 1); }
+    size_t write(const uint8_t* buffer, size_t size) override {
+        sim::detail::uartWrite(port, buffer, size);
+        return size;
+    }
+    using Print::write;
+    int availableForWrite() override { return sim::detail::uartAvailableForWrite(port); }
+
+private:
+    uint8_t port;
+};
+
+extern HardwareSerial Serial1, Serial2, Serial3, Serial4, Serial5, Serial6, Serial7, Serial8;
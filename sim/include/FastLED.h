@@ -0,0 +1,162 @@
+#pragma once
+
+// Host stand-in for the subset of FastLED the portal uses (see sim_hardware.h).
+// Colour math is close to FastLED's, not bit-exact: hsv2rgb is a plain
+// six-sector conversion rather than the "rainbow" mapping.
+
+#include "Arduino.h"
+
+// ===== 8-BIT MATH =====
+inline uint8_t scale8(uint8_t i, uint8_t scale) { return ((uint16_t)i * (1 + (uint16_t)scale)) >> 8; }
+inline uint8_t scale8_video(uint8_t i, uint8_t scale) {
+    return (((uint16_t)i * scale) >> 8) + ((i && scale) ? 1 : 0);
+}
+inline uint8_t qadd8(uint8_t i, uint8_t j) { uint16_t t = i + j; return t > 255 ? 255 : t; }
+inline uint8_t qsub8(uint8_t i, uint8_t j) { return i > j ? i - j : 0; }
+
+inline uint16_t random16() {
+    static uint16_t seed = 1337;
+    seed = seed * 2053 + 13849;
+    return seed;
+}
+inline uint8_t random8() { uint16_t r = random16(); return (uint8_t)(r + (r >> 8)); }
+inline uint8_t random8(uint8_t lim) { return (uint8_t)(((uint16_t)random8() * lim) >> 8); }
+inline uint8_t random8(uint8_t min, uint8_t lim) { return min + random8(lim - min); }
+inline void random16_set_seed(uint16_t seed) { (void)seed; }
+
+inline uint8_t sin8(uint8_t theta) { return (uint8_t)(128 + 127.5 * sin(theta * (2 * M_PI / 256.0))); }
+inline uint8_t cos8(uint8_t theta) { return sin8(theta + 64); }
+
+// ===== COLOURS =====
+struct CHSV {
+    union {
+        struct { uint8_t h, s, v; };
+        uint8_t raw[3];
+    };
+    CHSV() : h(0), s(0), v(0) {}
+    CHSV(uint8_t h, uint8_t s, uint8_t v) : h(h), s(s), v(v) {}
+};
+
+struct CRGB;
+void hsv2rgb_spectrum(const CHSV& hsv, CRGB& rgb);
+
+struct CRGB {
+    union {
+        struct { uint8_t r, g, b; };
+        uint8_t raw[3];
+    };
+
+    enum HTMLColorCode : uint32_t {
+        Black = 0x000000,
+        White = 0xFFFFFF,
+        Red = 0xFF0000,
+        Green = 0x008000,
+        Blue = 0x0000FF
+    };
+
+    CRGB() : r(0), g(0), b(0) {}
+    CRGB(uint8_t r, uint8_t g, uint8_t b) : r(r), g(g), b(b) {}
+    CRGB(uint32_t code) : r((code >> 16) & 0xFF), g((code >> 8) & 0xFF), b(code & 0xFF) {}
+    CRGB(HTMLColorCode code) : CRGB((uint32_t)code) {}
+    CRGB(const CHSV& hsv) { hsv2rgb_spectrum(hsv, *this); }
+
+    CRGB& operator=(const CHSV& hsv) { hsv2rgb_spectrum(hsv, *this); return *this; }
+    CRGB& operator=(uint32_t code) { return *this = CRGB(code); }
+
+    uint8_t& operator[](uint8_t i) { return raw[i]; }
+    const uint8_t& operator[](uint8_t i) const { return raw[i]; }
+
+    CRGB& operator+=(const CRGB& rhs) {
+        r = qadd8(r, rhs.r);
+        g = qadd8(g, rhs.g);
+        b = qadd8(b, rhs.b);
+        return *this;
+    }
+    CRGB& operator+=(const CHSV& rhs) { return *this += CRGB(rhs); }
+
+    CRGB& operator-=(const CRGB& rhs) {
+        r = qsub8(r, rhs.r);
+        g = qsub8(g, rhs.g);
+        b = qsub8(b, rhs.b);
+        return *this;
+    }
+
+    CRGB& nscale8(uint8_t scale) {
+        r = scale8(r, scale);
+        g = scale8(g, scale);
+        b = scale8(b, scale);
+        return *this;
+    }
+    CRGB& fadeToBlackBy(uint8_t amount) { return nscale8(255 - amount); }
+
+    bool operator==(const CRGB& rhs) const { return r == rhs.r && g == rhs.g && b == rhs.b; }
+    bool operator!=(const CRGB& rhs) const { return !(*this == rhs); }
+};
+
+inline void hsv2rgb_spectrum(const CHSV& hsv, CRGB& rgb) {
+    if (hsv.s == 0) {
+        rgb = CRGB(hsv.v, hsv.v, hsv.v);
+        return;
+    }
+    const uint16_t scaled = hsv.h * 6;                   // 0..1529
+    const uint8_t sector = scaled >> 8;                  // 0..5
+    const uint8_t fraction = scaled & 0xFF;
+    const uint8_t p = scale8(hsv.v, 255 - hsv.s);
+    const uint8_t q = scale8(hsv.v, 255 - scale8(hsv.s, fraction));
+    const uint8_t t = scale8(hsv.v, 255 - scale8(hsv.s, 255 - fraction));
+    switch (sector) {
+        case 0:  rgb = CRGB(hsv.v, t, p); break;
+        case 1:  rgb = CRGB(q, hsv.v, p); break;
+        case 2:  rgb = CRGB(p, hsv.v, t); break;
+        case 3:  rgb = CRGB(p, q, hsv.v); break;
+        case 4:  rgb = CRGB(t, p, hsv.v); break;
+        default: rgb = CRGB(hsv.v, p, q); break;
+    }
+}
+
+inline void fill_solid(CRGB* leds, int count, const CRGB& color) {
+    for (int i = 0; i < count; i++) leds[i] = color;
+}
+
+inline void fadeToBlackBy(CRGB* leds, uint16_t count, uint8_t amount) {
+    for (uint16_t i = 0; i < count; i++) leds[i].fadeToBlackBy(amount);
+}
+
+// ===== CONTROLLER =====
+enum EOrder { RGB = 0012, RBG = 0021, GRB = 0102, GBR = 0120, BRG = 0201, BGR = 0210 };
+
+template <uint8_t DATA_PIN, EOrder RGB_ORDER> class WS2812B {};
+template <uint8_t DATA_PIN, EOrder RGB_ORDER> class WS2812 {};
+template <uint8_t DATA_PIN, EOrder RGB_ORDER> class NEOPIXEL {};
+
+class CFastLED {
+public:
+    template <template <uint8_t, EOrder> class CHIPSET, uint8_t DATA_PIN, EOrder RGB_ORDER>
+    CFastLED& addLeds(CRGB* data, int count) {
+        leds = data;
+        ledCount = count;
+        return *this;
+    }
+
+    void setBrightness(uint8_t scale) { brightness = scale; }
+    uint8_t getBrightness() const { return brightness; }
+
+    void clear(bool writeData = false) {
+        if (leds) fill_solid(leds, ledCount, CRGB::Black);
+        if (writeData) show();
+    }
+
+    // Latches the frame, scaled by brightness, into sim::ledFrame()
+    void show() {
+        sim::detail::ledShow(leds ? leds[0].raw : nullptr, leds ? ledCount : 0, brightness);
+    }
+
+    int size() const { return ledCount; }
+    CRGB* leds = nullptr;
+
+private:
+    int ledCount = 0;
+    uint8_t brightness = 255;
+};
+
+extern CFastLED FastLED;
@@ -0,0 +1,88 @@
+#pragma once
+
+// Host stand-in for the subset of QNEthernet the Ethernet OSC transport
+// uses. EthernetUDP is a real non-blocking UDP socket on 127.0.0.1, so a
+// peer process or thread can talk to the simulated firmware over loopback
+// (see sim_hardware.h). Addresses are kept but all traffic is loopback.
+
+#include "Arduino.h"
+#include "sim_hardware.h"
+
+class IPAddress {
+public:
+    IPAddress() : bytes{0, 0, 0, 0} {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : bytes{a, b, c, d} {}
+    explicit IPAddress(const uint8_t* address) : bytes{address[0], address[1], address[2], address[3]} {}
+
+    uint8_t operator[](int index) const { return bytes[index]; }
+    bool operator==(const IPAddress& other) const { return memcmp(bytes, other.bytes, 4) == 0; }
+
+private:
+    uint8_t bytes[4];
+};
+
+namespace qindesign {
+namespace network {
+
+class EthernetClass {
+public:
+    bool begin() { return true; }
+    bool begin(const IPAddress& ip, const IPAddress& mask, const IPAddress& gateway) {
+        address = ip;
+        (void)mask;
+        (void)gateway;
+        return true;
+    }
+    void loop() {}
+    bool linkState() const { return true; }
+    IPAddress localIP() const { return address; }
+
+private:
+    IPAddress address;
+};
+
+extern EthernetClass Ethernet;
+
+class EthernetUDP {
+public:
+    explicit EthernetUDP(size_t queueCapacity = 1) { (void)queueCapacity; }
+    ~EthernetUDP() { stop(); }
+
+    uint8_t begin(uint16_t port) {
+        stop();
+        fd = sim::detail::udpOpen(port);
+        return fd >= 0;
+    }
+
+    void stop() {
+        if (fd >= 0) sim::detail::udpClose(fd);
+        fd = -1;
+    }
+
+    // Next received datagram, or 0; data() points at it until the next call
+    int parsePacket() {
+        if (fd < 0) return 0;
+        int n = sim::detail::udpReceive(fd, buffer, sizeof(buffer), peerPort);
+        length = n > 0 ? n : 0;
+        return n > 0 ? n : 0;
+    }
+
+    const uint8_t* data() const { return buffer; }
+    size_t size() const { return length; }
+    IPAddress remoteIP() const { return IPAddress(127, 0, 0, 1); }
+    uint16_t remotePort() const { return peerPort; }
+
+    bool send(const IPAddress& ip, uint16_t port, const uint8_t* data, size_t size) {
+        (void)ip;
+        return fd >= 0 && sim::detail::udpSend(fd, port, data, size);
+    }
+
+private:
+    int fd = -1;
+    uint8_t buffer[1500];
+    size_t length = 0;
+    uint16_t peerPort = 0;
+};
+
+} // namespace network
+} // namespace qindesign
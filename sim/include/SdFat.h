@@ -0,0 +1,114 @@
+#pragma once
+
+// Host stand-in for the subset of SdFat the session recorder uses: a flat
+// in-memory volume (see sim_hardware.h). No card is present until
+// sim::sdInsert().
+
+#include <string>
+#include "Arduino.h"
+#include "sim_hardware.h"
+
+typedef int oflag_t;
+#ifndef O_RDONLY
+#define O_RDONLY 0x00
+#define O_WRONLY 0x01
+#define O_RDWR 0x02
+#endif
+#ifndef O_CREAT
+#define O_CREAT 0x40
+#define O_TRUNC 0x200
+#endif
+
+#define FIFO_SDIO 0
+#define DMA_SDIO 1
+
+class SdioConfig {
+public:
+    explicit SdioConfig(uint8_t options) { (void)options; }
+};
+
+class FsFile {
+public:
+    explicit operator bool() const { return opened; }
+    bool isOpen() const { return opened; }
+    bool isDir() const { return opened && directory; }
+
+    size_t write(const void* data, size_t length) {
+        if (!opened || directory || !writable) return 0;
+        size_t n = sim::detail::sdWrite(path, position, (const uint8_t*)data, length);
+        position += n;
+        return n;
+    }
+
+    bool isBusy() { return sim::detail::sdBusy(); }
+    bool preAllocate(uint64_t length) { return opened && sim::detail::sdReserve(length); }
+    bool truncate() { return opened && writable && sim::detail::sdTruncate(path, position); }
+    bool sync() { return opened && sim::detail::sdSync(); }
+    bool close() {
+        opened = false;
+        return true;
+    }
+
+    uint64_t curPosition() const { return position; }
+    uint64_t fileSize() const { return sim::detail::sdFileSize(path); }
+
+    // Next file in the (root) directory dir
+    bool openNext(FsFile* dir, oflag_t oflag = O_RDONLY) {
+        (void)oflag;
+        std::string name;
+        if (!dir || !dir->isDir() || !sim::detail::sdFileAt(dir->nextIndex++, name)) return false;
+        path = name;
+        opened = true;
+        directory = false;
+        writable = false;
+        position = 0;
+        return true;
+    }
+
+    size_t getName(char* name, size_t size) {
+        if (!opened || size == 0) return 0;
+        size_t n = path.copy(name, size - 1);
+        name[n] = '\0';
+        return n;
+    }
+
+private:
+    friend class SdFs;
+
+    std::string path;
+    bool opened = false;
+    bool directory = false;
+    bool writable = false;
+    uint64_t position = 0;
+    size_t nextIndex = 0;       // openNext() position when this is a directory
+};
+
+class SdFs {
+public:
+    bool begin(SdioConfig config) {
+        (void)config;
+        mounted = sim::detail::sdPresent();
+        return mounted;
+    }
+
+    FsFile open(const char* path, oflag_t oflag = O_RDONLY) {
+        FsFile file;
+        if (!mounted || !sim::detail::sdPresent()) return file;
+        if (strcmp(path, "/") == 0) {
+            file.opened = true;
+            file.directory = true;
+            return file;
+        }
+        if (!sim::detail::sdOpen(path, oflag & O_CREAT, oflag & O_TRUNC)) return file;
+        file.path = path;
+        file.opened = true;
+        file.writable = (oflag & (O_WRONLY | O_RDWR)) != 0;
+        return file;
+    }
+
+    bool exists(const char* path) { return mounted && sim::detail::sdExists(path); }
+    bool remove(const char* path) { return mounted && sim::detail::sdRemove(path); }
+
+private:
+    bool mounted = false;
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+// Host stand-in for the Teensy Wire (I2C) library (see sim_hardware.h)
+
+#include "Arduino.h"
+
+class TwoWire : public Print {
+public:
+    void begin() {}
+    void end() {}
+    void setClock(uint32_t) {}
+
+    void beginTransmission(uint8_t address) {
+        txAddress = address;
+        txLength = 0;
+    }
+
+    size_t write(uint8_t data) override {
+        if (txLength >= sizeof(txBuffer)) return 0;
+        txBuffer[txLength++] = data;
+        return 1;
+    }
+    size_t write(const uint8_t* data, size_t length) override {
+        size_t n = 0;
+        while (length-- && write(*data++)) n++;
+        return n;
+    }
+    using Print::write;
+
+    // Delivers the transaction to the simulated device; 0 = ACK
+    uint8_t endTransmission(bool sendStop = true) {
+        (void)sendStop;
+        sim::detail::oledWrite(txAddress, txBuffer, txLength);
+        txLength = 0;
+        return 0;
+    }
+
+    uint8_t requestFrom(uint8_t, uint8_t) { return 0; }
+    int available() { return 0; }
+    int read() { return -1; }
+
+private:
+    uint8_t txAddress = 0;
+    uint8_t txBuffer[1040];  // Whole SSD1306 frame plus control byte
+    size_t txLength = 0;
+};
+
+extern TwoWire Wire;
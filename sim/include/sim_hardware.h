@@ -0,0 +1,184 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Host simulator control surface
+ *
+ * The stand-in Arduino, usbMIDI, Serial, FastLED, Wire and SSD1306 headers
+ * in sim/include read and write the state below instead of hardware, so the
+ * unmodified firmware (setup()/loop() from src/main.cpp) runs on Linux.
+ *
+ * Time is virtual: micros()/millis() return the simulated clock, which only
+ * moves when the runner advances it (a fixed step per loop() pass) or the
+ * firmware calls delay(). With host timing enabled, time measured inside a
+ * pass also advances the clock, so the scheduler and profiler see real
+ * per-stage costs of the host CPU.
+ *
+ * Inputs are set in firmware terms (button 3 pressed, pot 1 at 700); the
+ * helpers translate them to the active-low pin levels the scanner reads.
+ */
+
+namespace sim {
+
+// ===== VIRTUAL CLOCK =====
+
+// Microseconds since reset, not wrapped (micros()/millis() wrap at 32 bits)
+uint64_t nowMicros();
+
+// Jump the clock, e.g. to start just before a millis() wrap
+void setMicros(uint64_t us);
+
+void advanceMicros(uint64_t us);
+
+// Advance the clock by host time spent inside each loop() pass
+void setHostTiming(bool enabled);
+bool isHostTiming();
+
+// Called by the runner around each loop() pass
+void beginPass();
+void endPass(uint32_t minStepUs);
+
+// ===== PINS =====
+
+constexpr uint8_t PIN_COUNT = 64;
+
+void setDigital(uint8_t pin, bool level);
+bool getDigital(uint8_t pin);
+void setAnalog(uint8_t pin, uint16_t value);
+uint16_t getAnalog(uint8_t pin);
+uint8_t getPinMode(uint8_t pin);
+
+// Firmware-level inputs (indexes as in pins.h; joystick 0-3 = Up, Down, Left, Right)
+void setButton(uint8_t index, bool pressed);
+void setSwitch(uint8_t index, bool on);
+void setJoystick(uint8_t direction, bool pressed);
+void setPot(uint8_t index, uint16_t value);
+
+// ===== USB SERIAL =====
+
+// Bytes from the host (Pi) to the firmware
+void serialInput(const uint8_t* data, size_t length);
+
+// Everything the firmware wrote; the caller may clear it
+std::string& serialOutput();
+
+// Echo firmware output to stdout as it is written
+void setSerialEcho(bool enabled);
+
+// ===== USB MIDI =====
+
+enum MidiType : uint8_t {
+    MIDI_NOTE_OFF = 0x80,
+    MIDI_NOTE_ON = 0x90,
+    MIDI_CONTROL_CHANGE = 0xB0,
+    MIDI_SYSEX = 0xF0
+};
+
+struct MidiEvent {
+    uint64_t timeUs;
+    uint8_t type;       // MidiType
+    uint8_t channel;    // 1-16, 0 for SysEx
+    uint8_t data1;
+    uint8_t data2;
+    std::vector<uint8_t> sysex;
+};
+
+// Messages the firmware sent
+std::vector<MidiEvent>& midiOutput();
+
+// Messages from the host, returned by usbMIDI.read() in order
+void midiInput(uint8_t type, uint8_t channel, uint8_t data1, uint8_t data2);
+void midiInputSysEx(const uint8_t* data, size_t length);
+
+// ===== LED STRIP AND OLED =====
+
+// FastLED.show() calls, and the last frame after brightness scaling (r, g, b per LED)
+uint32_t ledShowCount();
+const std::vector<uint8_t>& ledFrame();
+
+// SSD1306 data bytes written over I2C, and the 128x64 page buffer they build
+uint32_t oledBytesWritten();
+const uint8_t* oledFrame();
+
+// ===== SD CARD =====
+
+// In-memory volume behind the SdFat stand-in; the slot is empty after reset()
+void sdInsert(uint64_t capacityBytes = 64ULL << 20);
+void sdEject();
+
+// Card busy time after each 512 bytes written, plus a longer spike every
+// spikeEvery sectors (flash erase); a write or sync while busy blocks the
+// caller on the virtual clock
+void sdSetBusy(uint32_t sectorUs, uint32_t spikeUs = 0, uint32_t spikeEvery = 0);
+
+// Files on the card by name, and virtual time the firmware spent blocked
+const std::map<std::string, std::vector<uint8_t>>& sdFiles();
+uint64_t sdBlockedUs();
+
+// ===== UDP =====
+
+// The Ethernet stand-in binds real UDP sockets on 127.0.0.1. By default
+// udp.begin(port) binds the port the firmware asks for; setUdpPort() binds
+// another one instead, 0 = an ephemeral port (read it with udpBoundPort())
+void setUdpPort(int port);
+uint16_t udpBoundPort();
+
+// ===== UARTS =====
+
+// Serial1-Serial8. Bytes written to port N move from its transmit buffer
+// onto the wire at the port's baud rate (10 bits per byte); uartTake()
+// appends the bytes that have finished transmitting by now. uartInput()
+// delivers bytes to the receive buffer, and bytes beyond it are lost
+// (overrun), as on the Teensy.
+void uartTake(uint8_t port, std::vector<uint8_t>& out);
+void uartInput(uint8_t port, const uint8_t* data, size_t length);
+uint32_t uartOverruns(uint8_t port);
+
+// Virtual time the firmware spent blocked in a write to a full transmit buffer
+uint64_t uartBlockedUs();
+
+// ===== RESET =====
+
+// Clock to zero, all inputs released, pots at 0, captured output cleared,
+// SD slot empty, UARTs closed
+void reset();
+
+// Internal hooks for the stand-in headers
+namespace detail {
+void serialWrite(const uint8_t* data, size_t length);
+int serialRead();
+int serialAvailable();
+bool midiRead(MidiEvent& event);
+void midiSend(uint8_t type, uint8_t channel, uint8_t data1, uint8_t data2);
+void midiSendSysEx(const uint8_t* data, size_t length);
+void ledShow(const uint8_t* rgb, size_t count, uint8_t brightness);
+void oledWrite(uint8_t address, const uint8_t* data, size_t length);
+bool sdPresent();
+bool sdOpen(const std::string& path, bool create, bool truncate);
+size_t sdWrite(const std::string& path, uint64_t position, const uint8_t* data, size_t length);
+bool sdBusy();
+bool sdReserve(uint64_t length);
+bool sdTruncate(const std::string& path, uint64_t length);
+bool sdSync();
+bool sdExists(const std::string& path);
+uint64_t sdFileSize(const std::string& path);
+bool sdFileAt(size_t index, std::string& name);
+bool sdRemove(const std::string& path);
+int udpOpen(uint16_t port);
+void udpClose(int fd);
+int udpReceive(int fd, uint8_t* buffer, size_t size, uint16_t& port);
+bool udpSend(int fd, uint16_t port, const uint8_t* data, size_t size);
+void uartBegin(uint8_t port, uint32_t baud);
+void uartAddMemory(uint8_t port, size_t rxBytes, size_t txBytes);
+int uartAvailable(uint8_t port);
+int uartRead(uint8_t port);
+void uartWrite(uint8_t port, const uint8_t* data, size_t length);
+int uartAvailableForWrite(uint8_t port);
+}
+
+} // namespace sim
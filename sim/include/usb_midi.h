@@ -0,0 +1,59 @@
+#pragma once
+
+// Host stand-in for the Teensy usbMIDI object (see sim_hardware.h)
+
+#include "Arduino.h"
+
+class usb_midi_class {
+public:
+    enum MidiType : uint8_t {
+        NoteOff = 0x80,
+        NoteOn = 0x90,
+        ControlChange = 0xB0,
+        SystemExclusive = 0xF0
+    };
+
+    void sendNoteOn(uint8_t note, uint8_t velocity, uint8_t channel, uint8_t cable = 0) {
+        (void)cable;
+        sim::detail::midiSend(NoteOn, channel, note, velocity);
+    }
+
+    void sendNoteOff(uint8_t note, uint8_t velocity, uint8_t channel, uint8_t cable = 0) {
+        (void)cable;
+        sim::detail::midiSend(NoteOff, channel, note, velocity);
+    }
+
+    void sendControlChange(uint8_t control, uint8_t value, uint8_t channel, uint8_t cable = 0) {
+        (void)cable;
+        sim::detail::midiSend(ControlChange, channel, control, value);
+    }
+
+    void sendSysEx(uint32_t length, const uint8_t* data, bool hasTerm = false, uint8_t cable = 0) {
+        (void)cable;
+        if (hasTerm) {
+            sim::detail::midiSendSysEx(data, length);
+        } else {
+            // Without terminators the core adds F0 ... F7
+            std::vector<uint8_t> framed;
+            framed.push_back(0xF0);
+            framed.insert(framed.end(), data, data + length);
+            framed.push_back(0xF7);
+            sim::detail::midiSendSysEx(framed.data(), framed.size());
+        }
+    }
+
+    void send_now() {}
+
+    bool read() { return sim::detail::midiRead(current); }
+    uint8_t getType() const { return current.type; }
+    uint8_t getChannel() const { return current.channel; }
+    uint8_t getData1() const { return current.data1; }
+    uint8_t getData2() const { return current.data2; }
+    const uint8_t* getSysExArray() const { return current.sysex.data(); }
+    uint16_t getSysExArrayLength() const { return (uint16_t)current.sysex.size(); }
+
+private:
+    sim::MidiEvent current = {};
+};
+
+extern usb_midi_class usbMIDI;
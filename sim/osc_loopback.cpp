@@ -0,0 +1,408 @@
+/**
+ * @brief Ethernet OSC transport against a loopback UDP peer, vs USB serial
+ *
+ * Usage: osc_loopback [options]
+ *   --cues N              Cues per transport (default 512)
+ *   --presses N           Button presses streamed as /input/button (default 20)
+ *   --cues-per-packet N   Cues bundled into one OSC packet (default 16)
+ *   --window N            OSC packets in flight before waiting (default 4)
+ *   --udp-latency-us US   One-way Pi <-> Teensy UDP latency (default 100)
+ *   --serial-frame-us US  Serial host poll granularity (default 1000)
+ *   --step US             Virtual time per loop() pass (default 100)
+ *   --quiet               Only the summary table
+ *
+ * Runs the whole firmware built with ETHERNET_OSC=1. The transport binds a
+ * real UDP socket on 127.0.0.1 (sim::setUdpPort(0), an ephemeral port) and
+ * this program is the Pi on the other end of it, with its own socket:
+ *   1. /ping, expecting /portal/reply PONG
+ *   2. button presses, each expected back as /input/button with its index
+ *   3. SET_HUE cues as OSC bundles, pipelined up to --window packets ahead,
+ *      each expecting its /portal/reply ACK
+ *   4. the same cues as 5-byte frames over USB serial, stop-and-wait as the
+ *      Pi bridge does, each expecting its ACK frame
+ *
+ * Link timing is modeled on the virtual clock; the datagrams themselves
+ * really go through the socket and the firmware's OSC parser. UDP packets
+ * take --udp-latency-us each way. Serial bytes move at the host's poll
+ * granularity (USB frames and the tty layer): the Teensy sees a frame at
+ * the next --serial-frame-us boundary after the Pi writes it, and the Pi
+ * sees the reply at the next boundary after the Teensy writes it.
+ *
+ * Prints cues/s and ack latency (mean, p99, jitter = standard deviation)
+ * per transport. Exits 1 unless every cue was acked, every press was
+ * reported and OSC delivers more cues per second than serial.
+ *
+ * Build & run: make osc-loopback [OSC_ARGS="--window 1"]
+ */
+
+#include <Arduino.h>
+#include <algorithm>
+#include <arpa/inet.h>
+#include <deque>
+#include <math.h>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+#include "sim_hardware.h"
+#include "config.h"
+#include "osc_codec.h"
+#include "serial_portal_protocol.h"
+
+#if ETHERNET_OSC == 0
+#error "osc_loopback needs -DETHERNET_OSC=1"
+#endif
+
+// Firmware entry points, from src/main.cpp
+void setup();
+void loop();
+
+namespace {
+
+constexpr uint64_t PHASE_TIMEOUT_US = 3000000;
+constexpr uint32_t PRESS_HOLD_US = 40000;
+constexpr uint32_t PRESS_GAP_US = 60000;
+
+struct Options {
+    uint32_t cues = 512;
+    uint32_t presses = 20;
+    uint32_t cuesPerPacket = 16;
+    uint32_t window = 4;
+    uint32_t udpLatencyUs = 100;
+    uint32_t serialFrameUs = 1000;
+    uint32_t stepUs = 100;
+    bool quiet = false;
+};
+
+Options options;
+
+struct Result {
+    const char* name;
+    uint32_t sent = 0;
+    uint32_t acked = 0;
+    uint64_t elapsedUs = 0;
+    std::vector<double> latencyUs;
+};
+
+// A datagram or message on the modeled wire
+struct Pending {
+    uint64_t atUs;
+    std::vector<uint8_t> bytes;
+};
+
+// Message received by the Pi, flattened out of its bundle
+struct Received {
+    uint64_t atUs;
+    std::string address;
+    int32_t args[4];
+};
+
+int peer = -1;
+sockaddr_in firmwareAddress;
+std::deque<Pending> toFirmware;     // Sent by the Pi, not yet on the wire
+std::deque<Received> fromFirmware;  // Arrived or arriving at the Pi
+
+uint64_t nextBoundary(uint64_t us, uint32_t period) {
+    return period ? (us / period + 1) * period : us;
+}
+
+void onMessage(const OscMessage& message, void* context) {
+    Received received;
+    received.atUs = *static_cast<uint64_t*>(context);
+    received.address = message.address;
+    for (uint8_t i = 0; i < 4; i++) {
+        if (!message.getInt(i, received.args[i])) received.args[i] = 0;
+    }
+    fromFirmware.push_back(received);
+}
+
+// One loop() pass with the UDP wire around it
+void pass() {
+    while (!toFirmware.empty() && toFirmware.front().atUs <= sim::nowMicros()) {
+        const Pending& packet = toFirmware.front();
+        sendto(peer, packet.bytes.data(), packet.bytes.size(), 0,
+               reinterpret_cast<const sockaddr*>(&firmwareAddress), sizeof(firmwareAddress));
+        toFirmware.pop_front();
+    }
+
+    sim::beginPass();
+    loop();
+    sim::endPass(options.stepUs);
+
+    uint8_t buffer[2048];
+    ssize_t n;
+    while ((n = recv(peer, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0) {
+        uint64_t arriveUs = sim::nowMicros() + options.udpLatencyUs;
+        OscReader::parse(buffer, n, onMessage, &arriveUs);
+    }
+}
+
+void sendOsc(const OscWriter& writer) {
+    Pending packet;
+    packet.atUs = sim::nowMicros() + options.udpLatencyUs;
+    packet.bytes.assign(writer.getData(), writer.getData() + writer.getLength());
+    toFirmware.push_back(packet);
+}
+
+// Next message for the Pi with this address that has arrived by now
+bool takeMessage(const char* address, Received& out) {
+    for (auto it = fromFirmware.begin(); it != fromFirmware.end(); ++it) {
+        if (it->atUs > sim::nowMicros()) break;
+        if (it->address == address) {
+            out = *it;
+            fromFirmware.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+double mean(const std::vector<double>& values) {
+    double sum = 0;
+    for (double v : values) sum += v;
+    return values.empty() ? 0 : sum / values.size();
+}
+
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, (size_t)(p * values.size()))];
+}
+
+double deviation(const std::vector<double>& values) {
+    const double m = mean(values);
+    double sum = 0;
+    for (double v : values) sum += (v - m) * (v - m);
+    return values.empty() ? 0 : sqrt(sum / values.size());
+}
+
+double cuesPerSecond(const Result& result) {
+    return result.elapsedUs ? result.acked * 1e6 / result.elapsedUs : 0;
+}
+
+bool runPing() {
+    uint8_t buffer[64];
+    OscWriter writer(buffer, sizeof(buffer));
+    writer.beginMessage("/ping", "");
+    writer.endMessage();
+    sendOsc(writer);
+
+    const uint64_t startUs = sim::nowMicros();
+    Received reply;
+    while (sim::nowMicros() - startUs < PHASE_TIMEOUT_US) {
+        pass();
+        if (takeMessage("/portal/reply", reply)) {
+            const bool pong = reply.args[0] == (int32_t)PortalSerialCommand::PONG;
+            printf("ping: %s after %.0f us\n", pong ? "PONG" : "wrong reply",
+                   (double)(reply.atUs - startUs));
+            return pong;
+        }
+    }
+    printf("FAIL ping: no reply\n");
+    return false;
+}
+
+Result runPresses() {
+    Result result;
+    result.name = "button";
+    const uint64_t startUs = sim::nowMicros();
+
+    for (uint32_t i = 0; i < options.presses; i++) {
+        const uint8_t button = 2 + i % 2;  // Buttons 0/1 page the OLED
+        sim::setButton(button, true);
+        const uint64_t pressUs = sim::nowMicros();
+        result.sent++;
+
+        bool seen = false;
+        while (sim::nowMicros() - pressUs < PRESS_HOLD_US + PRESS_GAP_US) {
+            if (sim::nowMicros() - pressUs >= PRESS_HOLD_US) sim::setButton(button, false);
+            pass();
+            Received event;
+            while (takeMessage("/input/button", event)) {
+                if (!seen && event.args[1] == button && event.args[2] == 1) {
+                    seen = true;
+                    result.acked++;
+                    result.latencyUs.push_back((double)(event.atUs - pressUs));
+                }
+            }
+        }
+        if (!seen && !options.quiet) printf("press %u on button %u: not reported\n", i, button);
+    }
+    result.elapsedUs = sim::nowMicros() - startUs;
+    return result;
+}
+
+Result runOscCues() {
+    Result result;
+    result.name = "osc";
+    std::deque<uint64_t> outstanding;  // Send time per cue awaiting its ACK
+    std::deque<uint32_t> packetEnds;   // Cue count at the end of each packet in flight
+    static uint8_t buffer[ETHERNET_PACKET_BYTES];
+
+    const uint64_t startUs = sim::nowMicros();
+    while (result.acked < options.cues && sim::nowMicros() - startUs < PHASE_TIMEOUT_US) {
+        while (result.sent < options.cues && packetEnds.size() < options.window) {
+            OscWriter writer(buffer, sizeof(buffer));
+            writer.beginBundle();
+            for (uint32_t i = 0; i < options.cuesPerPacket && result.sent < options.cues; i++) {
+                writer.beginMessage("/portal/hue", "i");
+                writer.addInt(result.sent & 0xFF);
+                if (!writer.endMessage()) break;
+                outstanding.push_back(sim::nowMicros());
+                result.sent++;
+            }
+            sendOsc(writer);
+            packetEnds.push_back(result.sent);
+        }
+
+        pass();
+        Received reply;
+        while (takeMessage("/portal/reply", reply)) {
+            if (outstanding.empty()) continue;
+            if (reply.args[0] == (int32_t)PortalSerialCommand::ACK) {
+                result.acked++;
+                result.latencyUs.push_back((double)(reply.atUs - outstanding.front()));
+            }
+            outstanding.pop_front();
+            while (!packetEnds.empty() && packetEnds.front() <= result.sent - outstanding.size()) {
+                packetEnds.pop_front();
+            }
+        }
+    }
+    result.elapsedUs = sim::nowMicros() - startUs;
+    return result;
+}
+
+// Index just past the next valid reply frame in output, or 0
+size_t findReply(const std::string& output, uint8_t& command) {
+    for (size_t i = 0; i + PORTAL_MSG_MIN_SIZE <= output.size(); i++) {
+        const PortalMessage message = PortalMessage::fromBytes(reinterpret_cast<const uint8_t*>(output.data() + i));
+        if (message.isValid()) {
+            command = static_cast<uint8_t>(message.command);
+            return i + PORTAL_MSG_MIN_SIZE;
+        }
+    }
+    return 0;
+}
+
+Result runSerialCues() {
+    Result result;
+    result.name = "serial";
+    sim::serialOutput().clear();
+
+    const uint64_t startUs = sim::nowMicros();
+    while (result.sent < options.cues && sim::nowMicros() - startUs < PHASE_TIMEOUT_US) {
+        uint8_t frame[PORTAL_MSG_MIN_SIZE];
+        PortalMessage(PortalSerialCommand::SET_HUE, result.sent & 0xFF).toBytes(frame);
+        const uint64_t sentUs = sim::nowMicros();
+        result.sent++;
+
+        const uint64_t deliverUs = nextBoundary(sentUs, options.serialFrameUs);
+        while (sim::nowMicros() < deliverUs) pass();
+        sim::serialInput(frame, sizeof(frame));
+
+        uint64_t replyUs = 0;
+        uint8_t command = 0;
+        while (sim::nowMicros() - sentUs < PHASE_TIMEOUT_US) {
+            pass();
+            const size_t end = findReply(sim::serialOutput(), command);
+            if (end) {
+                sim::serialOutput().erase(0, end);
+                replyUs = nextBoundary(sim::nowMicros(), options.serialFrameUs);
+                break;
+            }
+        }
+        if (!replyUs) break;
+
+        // The Pi sends the next cue once it has read this reply
+        while (sim::nowMicros() < replyUs) pass();
+        if (command == (uint8_t)PortalSerialCommand::ACK) {
+            result.acked++;
+            result.latencyUs.push_back((double)(replyUs - sentUs));
+        }
+    }
+    result.elapsedUs = sim::nowMicros() - startUs;
+    return result;
+}
+
+void printResult(const Result& result, bool cues) {
+    printf("%-8s %6u/%-6u %9.0f %9.0f %9.0f %9.0f\n", result.name, result.acked, result.sent,
+           cues ? cuesPerSecond(result) : 0.0, mean(result.latencyUs),
+           percentile(result.latencyUs, 0.99), deviation(result.latencyUs));
+}
+
+bool parseOptions(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        auto value = [&]() -> uint32_t { return i + 1 < argc ? strtoul(argv[++i], nullptr, 0) : 0; };
+        if (arg == "--cues") options.cues = value();
+        else if (arg == "--presses") options.presses = value();
+        else if (arg == "--cues-per-packet") options.cuesPerPacket = std::max<uint32_t>(1, value());
+        else if (arg == "--window") options.window = std::max<uint32_t>(1, value());
+        else if (arg == "--udp-latency-us") options.udpLatencyUs = value();
+        else if (arg == "--serial-frame-us") options.serialFrameUs = value();
+        else if (arg == "--step") options.stepUs = std::max<uint32_t>(1, value());
+        else if (arg == "--quiet") options.quiet = true;
+        else {
+            fprintf(stderr, "unknown option %s\n", arg.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (!parseOptions(argc, argv)) return 2;
+
+    sim::reset();
+    sim::setUdpPort(0);
+    setup();
+    sim::endPass(0);
+    if (!sim::udpBoundPort()) {
+        printf("FAIL transport did not open its UDP port\n");
+        return 1;
+    }
+    if (!options.quiet) printf("%s", sim::serialOutput().c_str());
+    sim::serialOutput().clear();
+
+    peer = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in local = {};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (peer < 0 || bind(peer, reinterpret_cast<const sockaddr*>(&local), sizeof(local)) != 0) {
+        printf("FAIL cannot open the peer socket\n");
+        return 1;
+    }
+    firmwareAddress = local;
+    firmwareAddress.sin_port = htons(sim::udpBoundPort());
+
+    bool ok = runPing();
+    const Result presses = runPresses();
+    const Result osc = runOscCues();
+    const Result serial = runSerialCues();
+    close(peer);
+
+    printf("\n%-8s %13s %9s %9s %9s %9s\n", "link", "acked/sent", "cues/s", "mean us", "p99 us", "jitter");
+    printResult(osc, true);
+    printResult(serial, true);
+    printResult(presses, false);
+    printf("(osc: %u cues/packet, %u packets in flight, %u us each way; serial: %u us polls)\n",
+           options.cuesPerPacket, options.window, options.udpLatencyUs, options.serialFrameUs);
+
+    if (osc.acked != options.cues || serial.acked != options.cues) {
+        printf("FAIL not every cue was acked\n");
+        ok = false;
+    }
+    if (presses.acked != options.presses) {
+        printf("FAIL %u of %u presses reported\n", presses.acked, options.presses);
+        ok = false;
+    }
+    if (cuesPerSecond(osc) <= cuesPerSecond(serial)) {
+        printf("FAIL osc throughput is not above serial\n");
+        ok = false;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,620 @@
+#include "sim_hardware.h"
+#include <Arduino.h>
+#include <FastLED.h>
+#include <QNEthernet.h>
+#include <Wire.h>
+#include <arpa/inet.h>
+#include <chrono>
+#include <deque>
+#include <math.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <usb_midi.h>
+#include "pins.h"
+
+// Stand-in globals the firmware links against
+usb_serial_class Serial;
+usb_midi_class usbMIDI;
+CFastLED FastLED;
+TwoWire Wire;
+qindesign::network::EthernetClass qindesign::network::Ethernet;
+HardwareSerial Serial1(1), Serial2(2), Serial3(3), Serial4(4), Serial5(5), Serial6(6), Serial7(7), Serial8(8);
+
+namespace sim {
+
+namespace {
+
+struct OledPanel {
+    uint8_t frame[OLED_WIDTH * OLED_HEIGHT / 8];
+    uint8_t pageStart, pageEnd, columnStart, columnEnd;
+    uint8_t page, column;
+    uint8_t pendingCommand;
+    uint8_t pendingArgs;
+    uint32_t bytesWritten;
+};
+
+struct SdCard {
+    bool present;
+    uint64_t capacity;
+    std::map<std::string, std::vector<uint8_t>> files;
+    uint32_t sectorUs;
+    uint32_t spikeUs;
+    uint32_t spikeEvery;
+    uint64_t sectors;       // Written since insertion, for the spike cadence
+    uint64_t busyUntilUs;
+    uint64_t blockedUs;
+};
+
+// Teensy 4 HardwareSerial default buffers, before addMemoryFor*()
+constexpr size_t UART_RX_BUFFER = 64;
+constexpr size_t UART_TX_BUFFER = 40;
+constexpr uint8_t UART_PORTS = 9;   // Serial1-Serial8, index 0 unused
+
+struct Uart {
+    uint32_t baud;
+    size_t rxCapacity;
+    size_t txCapacity;
+    std::deque<uint8_t> rx;
+    std::deque<uint8_t> tx;
+    std::deque<double> txDoneUs;    // When each queued byte has left the wire
+    double lineFreeUs;              // When the last queued byte has left
+    std::vector<uint8_t> wire;      // Sent, not yet taken
+    uint32_t overruns;
+};
+
+struct State {
+    uint64_t clockUs;
+    bool hostTiming;
+    std::chrono::steady_clock::time_point passStart;
+
+    bool digital[PIN_COUNT];
+    uint16_t analog[PIN_COUNT];
+    uint8_t mode[PIN_COUNT];
+
+    std::deque<uint8_t> serialIn;
+    std::string serialOut;
+    bool serialEcho;
+
+    std::deque<MidiEvent> midiIn;
+    std::vector<MidiEvent> midiOut;
+
+    uint32_t ledShows;
+    std::vector<uint8_t> ledFrame;
+
+    OledPanel oled;
+
+    SdCard sd;
+
+    int udpPort;            // -1 = as requested
+    uint16_t udpBound;
+
+    Uart uart[UART_PORTS];
+    uint64_t uartBlockedUs;
+};
+
+State state;
+
+const uint8_t JOYSTICK_PINS[4] = {JOYSTICK_UP, JOYSTICK_DOWN, JOYSTICK_LEFT, JOYSTICK_RIGHT};
+
+uint64_t hostElapsedUs() {
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now() - state.passStart).count();
+}
+
+void oledCommand(OledPanel& oled, uint8_t byte) {
+    if (oled.pendingArgs > 0) {
+        const bool first = oled.pendingArgs == 2;
+        if (oled.pendingCommand == 0x22) {
+            (first ? oled.pageStart : oled.pageEnd) = byte & 7;
+            oled.page = oled.pageStart;
+        } else {
+            (first ? oled.columnStart : oled.columnEnd) = byte & 0x7F;
+            oled.column = oled.columnStart;
+        }
+        oled.pendingArgs--;
+        return;
+    }
+    if (byte == 0x21 || byte == 0x22) {  // COLUMNADDR / PAGEADDR: two arguments
+        oled.pendingCommand = byte;
+        oled.pendingArgs = 2;
+    }
+}
+
+void oledData(OledPanel& oled, uint8_t byte) {
+    oled.frame[oled.page * OLED_WIDTH + oled.column] = byte;
+    oled.bytesWritten++;
+    if (oled.column < oled.columnEnd) {
+        oled.column++;
+    } else {
+        oled.column = oled.columnStart;
+        oled.page = oled.page < oled.pageEnd ? oled.page + 1 : oled.pageStart;
+    }
+}
+
+Uart* uartAt(uint8_t port) {
+    return port > 0 && port < UART_PORTS ? &state.uart[port] : nullptr;
+}
+
+void uartDrain(Uart& uart) {
+    const double now = (double)nowMicros();
+    while (!uart.tx.empty() && uart.txDoneUs.front() <= now) {
+        uart.wire.push_back(uart.tx.front());
+        uart.tx.pop_front();
+        uart.txDoneUs.pop_front();
+    }
+}
+
+} // namespace
+
+// ===== VIRTUAL CLOCK =====
+
+uint64_t nowMicros() {
+    return state.hostTiming ? state.clockUs + hostElapsedUs() : state.clockUs;
+}
+
+void setMicros(uint64_t us) {
+    state.clockUs = us;
+    state.passStart = std::chrono::steady_clock::now();
+}
+
+void advanceMicros(uint64_t us) {
+    state.clockUs += us;
+}
+
+void setHostTiming(bool enabled) {
+    state.hostTiming = enabled;
+    state.passStart = std::chrono::steady_clock::now();
+}
+
+bool isHostTiming() {
+    return state.hostTiming;
+}
+
+void beginPass() {
+    state.passStart = std::chrono::steady_clock::now();
+}
+
+void endPass(uint32_t minStepUs) {
+    uint64_t step = state.hostTiming ? hostElapsedUs() : 0;
+    state.clockUs += step > minStepUs ? step : minStepUs;
+    state.passStart = std::chrono::steady_clock::now();
+}
+
+// ===== PINS =====
+
+void setDigital(uint8_t pin, bool level) {
+    if (pin < PIN_COUNT) state.digital[pin] = level;
+}
+
+bool getDigital(uint8_t pin) {
+    return pin < PIN_COUNT ? state.digital[pin] : true;
+}
+
+void setAnalog(uint8_t pin, uint16_t value) {
+    if (pin < PIN_COUNT) state.analog[pin] = value > 1023 ? 1023 : value;
+}
+
+uint16_t getAnalog(uint8_t pin) {
+    return pin < PIN_COUNT ? state.analog[pin] : 0;
+}
+
+uint8_t getPinMode(uint8_t pin) {
+    return pin < PIN_COUNT ? state.mode[pin] : INPUT;
+}
+
+// Inputs are active-low with pull-ups: pressed = LOW
+void setButton(uint8_t index, bool pressed) {
+    if (index < BUTTON_COUNT) setDigital(BUTTON_PINS[index], !pressed);
+}
+
+void setSwitch(uint8_t index, bool on) {
+    if (index < SWITCH_COUNT) setDigital(SWITCH_PINS[index], !on);
+}
+
+void setJoystick(uint8_t direction, bool pressed) {
+    if (direction < 4) setDigital(JOYSTICK_PINS[direction], !pressed);
+}
+
+void setPot(uint8_t index, uint16_t value) {
+    if (index < POT_COUNT) setAnalog(POT_PINS[index], value);
+}
+
+// ===== USB SERIAL =====
+
+void serialInput(const uint8_t* data, size_t length) {
+    state.serialIn.insert(state.serialIn.end(), data, data + length);
+}
+
+std::string& serialOutput() {
+    return state.serialOut;
+}
+
+void setSerialEcho(bool enabled) {
+    state.serialEcho = enabled;
+}
+
+// ===== USB MIDI =====
+
+std::vector<MidiEvent>& midiOutput() {
+    return state.midiOut;
+}
+
+void midiInput(uint8_t type, uint8_t channel, uint8_t data1, uint8_t data2) {
+    state.midiIn.push_back(MidiEvent{nowMicros(), type, channel, data1, data2, {}});
+}
+
+void midiInputSysEx(const uint8_t* data, size_t length) {
+    MidiEvent event{nowMicros(), MIDI_SYSEX, 0, 0, 0, {}};
+    event.sysex.assign(data, data + length);
+    state.midiIn.push_back(event);
+}
+
+// ===== LED STRIP AND OLED =====
+
+uint32_t ledShowCount() {
+    return state.ledShows;
+}
+
+const std::vector<uint8_t>& ledFrame() {
+    return state.ledFrame;
+}
+
+uint32_t oledBytesWritten() {
+    return state.oled.bytesWritten;
+}
+
+const uint8_t* oledFrame() {
+    return state.oled.frame;
+}
+
+// ===== SD CARD =====
+
+void sdInsert(uint64_t capacityBytes) {
+    state.sd.present = true;
+    state.sd.capacity = capacityBytes;
+    state.sd.busyUntilUs = 0;
+}
+
+void sdEject() {
+    state.sd.present = false;
+}
+
+void sdSetBusy(uint32_t sectorUs, uint32_t spikeUs, uint32_t spikeEvery) {
+    state.sd.sectorUs = sectorUs;
+    state.sd.spikeUs = spikeUs;
+    state.sd.spikeEvery = spikeEvery;
+}
+
+const std::map<std::string, std::vector<uint8_t>>& sdFiles() {
+    return state.sd.files;
+}
+
+uint64_t sdBlockedUs() {
+    return state.sd.blockedUs;
+}
+
+// ===== UDP =====
+
+void setUdpPort(int port) {
+    state.udpPort = port;
+}
+
+uint16_t udpBoundPort() {
+    return state.udpBound;
+}
+
+// ===== UARTS =====
+
+void uartTake(uint8_t port, std::vector<uint8_t>& out) {
+    Uart* uart = uartAt(port);
+    if (!uart) return;
+    uartDrain(*uart);
+    out.insert(out.end(), uart->wire.begin(), uart->wire.end());
+    uart->wire.clear();
+}
+
+void uartInput(uint8_t port, const uint8_t* data, size_t length) {
+    Uart* uart = uartAt(port);
+    if (!uart) return;
+    for (size_t i = 0; i < length; i++) {
+        if (uart->rx.size() < uart->rxCapacity) {
+            uart->rx.push_back(data[i]);
+        } else {
+            uart->overruns++;
+        }
+    }
+}
+
+uint32_t uartOverruns(uint8_t port) {
+    Uart* uart = uartAt(port);
+    return uart ? uart->overruns : 0;
+}
+
+uint64_t uartBlockedUs() {
+    return state.uartBlockedUs;
+}
+
+// ===== RESET =====
+
+void reset() {
+    state.clockUs = 0;
+    state.passStart = std::chrono::steady_clock::now();
+    for (uint8_t pin = 0; pin < PIN_COUNT; pin++) {
+        state.digital[pin] = true;  // Released: pulled up
+        state.analog[pin] = 0;
+        state.mode[pin] = INPUT;
+    }
+    state.serialIn.clear();
+    state.serialOut.clear();
+    state.midiIn.clear();
+    state.midiOut.clear();
+    state.ledShows = 0;
+    state.ledFrame.clear();
+    memset(&state.oled, 0, sizeof(state.oled));
+    state.oled.pageEnd = OLED_HEIGHT / 8 - 1;
+    state.oled.columnEnd = OLED_WIDTH - 1;
+    state.sd = SdCard{};
+    state.udpPort = -1;
+    state.udpBound = 0;
+    for (Uart& uart : state.uart) {
+        uart = Uart{};
+        uart.rxCapacity = UART_RX_BUFFER;
+        uart.txCapacity = UART_TX_BUFFER;
+    }
+    state.uartBlockedUs = 0;
+}
+
+// ===== STAND-IN HOOKS =====
+
+namespace detail {
+
+void serialWrite(const uint8_t* data, size_t length) {
+    state.serialOut.append((const char*)data, length);
+    if (state.serialEcho) fwrite(data, 1, length, stdout);
+}
+
+int serialRead() {
+    if (state.serialIn.empty()) return -1;
+    uint8_t byte = state.serialIn.front();
+    state.serialIn.pop_front();
+    return byte;
+}
+
+int serialAvailable() {
+    return (int)state.serialIn.size();
+}
+
+bool midiRead(MidiEvent& event) {
+    if (state.midiIn.empty()) return false;
+    event = state.midiIn.front();
+    state.midiIn.pop_front();
+    return true;
+}
+
+void midiSend(uint8_t type, uint8_t channel, uint8_t data1, uint8_t data2) {
+    state.midiOut.push_back(MidiEvent{nowMicros(), type, channel, data1, data2, {}});
+}
+
+void midiSendSysEx(const uint8_t* data, size_t length) {
+    MidiEvent event{nowMicros(), MIDI_SYSEX, 0, 0, 0, {}};
+    event.sysex.assign(data, data + length);
+    state.midiOut.push_back(event);
+}
+
+void ledShow(const uint8_t* rgb, size_t count, uint8_t brightness) {
+    state.ledShows++;
+    state.ledFrame.resize(count * 3);
+    for (size_t i = 0; i < count * 3; i++) {
+        state.ledFrame[i] = scale8(rgb[i], brightness);
+    }
+}
+
+void oledWrite(uint8_t address, const uint8_t* data, size_t length) {
+    if (address != OLED_I2C_ADDRESS || length == 0) return;
+    // First byte is the SSD1306 control byte: 0x00 commands, 0x40 data
+    const bool isData = data[0] & 0x40;
+    for (size_t i = 1; i < length; i++) {
+        if (isData) {
+            oledData(state.oled, data[i]);
+        } else {
+            oledCommand(state.oled, data[i]);
+        }
+    }
+}
+
+bool sdPresent() {
+    return state.sd.present;
+}
+
+bool sdOpen(const std::string& path, bool create, bool truncate) {
+    auto file = state.sd.files.find(path);
+    if (file == state.sd.files.end()) {
+        if (!create) return false;
+        state.sd.files[path];
+    } else if (truncate) {
+        file->second.clear();
+    }
+    return true;
+}
+
+// A busy card holds the caller until it is ready
+static void sdWaitReady() {
+    const uint64_t now = nowMicros();
+    if (now < state.sd.busyUntilUs) {
+        state.sd.blockedUs += state.sd.busyUntilUs - now;
+        advanceMicros(state.sd.busyUntilUs - now);
+    }
+}
+
+static uint64_t sdUsed() {
+    uint64_t used = 0;
+    for (const auto& file : state.sd.files) used += file.second.size();
+    return used;
+}
+
+size_t sdWrite(const std::string& path, uint64_t position, const uint8_t* data, size_t length) {
+    auto file = state.sd.files.find(path);
+    if (!state.sd.present || file == state.sd.files.end()) return 0;
+    const uint64_t end = position + length;
+    if (end > file->second.size() && sdUsed() + end - file->second.size() > state.sd.capacity) return 0;
+
+    sdWaitReady();
+    if (end > file->second.size()) file->second.resize(end);
+    memcpy(file->second.data() + position, data, length);
+
+    uint64_t busy = 0;
+    for (size_t done = 0; done < length; done += 512) {
+        busy += state.sd.sectorUs;
+        state.sd.sectors++;
+        if (state.sd.spikeEvery && state.sd.sectors % state.sd.spikeEvery == 0) busy += state.sd.spikeUs;
+    }
+    state.sd.busyUntilUs = nowMicros() + busy;
+    return length;
+}
+
+bool sdBusy() {
+    return state.sd.present && nowMicros() < state.sd.busyUntilUs;
+}
+
+bool sdReserve(uint64_t length) {
+    return state.sd.present && sdUsed() + length <= state.sd.capacity;
+}
+
+bool sdTruncate(const std::string& path, uint64_t length) {
+    auto file = state.sd.files.find(path);
+    if (!state.sd.present || file == state.sd.files.end()) return false;
+    if (length < file->second.size()) file->second.resize(length);
+    return true;
+}
+
+bool sdSync() {
+    if (!state.sd.present) return false;
+    sdWaitReady();
+    state.sd.busyUntilUs = nowMicros() + state.sd.sectorUs;
+    return true;
+}
+
+bool sdExists(const std::string& path) {
+    return state.sd.files.count(path) > 0;
+}
+
+uint64_t sdFileSize(const std::string& path) {
+    auto file = state.sd.files.find(path);
+    return file == state.sd.files.end() ? 0 : file->second.size();
+}
+
+bool sdFileAt(size_t index, std::string& name) {
+    if (!state.sd.present || index >= state.sd.files.size()) return false;
+    auto file = state.sd.files.begin();
+    std::advance(file, index);
+    name = file->first;
+    return true;
+}
+
+bool sdRemove(const std::string& path) {
+    return state.sd.present && state.sd.files.erase(path) > 0;
+}
+
+static sockaddr_in loopbackAddress(uint16_t port) {
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    return address;
+}
+
+int udpOpen(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) return -1;
+    sockaddr_in address = loopbackAddress(state.udpPort >= 0 ? state.udpPort : port);
+    socklen_t length = sizeof(address);
+    if (bind(fd, (sockaddr*)&address, sizeof(address)) != 0 ||
+        getsockname(fd, (sockaddr*)&address, &length) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    state.udpBound = ntohs(address.sin_port);
+    return fd;
+}
+
+void udpClose(int fd) {
+    ::close(fd);
+}
+
+int udpReceive(int fd, uint8_t* buffer, size_t size, uint16_t& port) {
+    sockaddr_in from = {};
+    socklen_t length = sizeof(from);
+    ssize_t n = recvfrom(fd, buffer, size, 0, (sockaddr*)&from, &length);
+    if (n <= 0) return 0;
+    port = ntohs(from.sin_port);
+    return (int)n;
+}
+
+bool udpSend(int fd, uint16_t port, const uint8_t* data, size_t size) {
+    sockaddr_in to = loopbackAddress(port);
+    return sendto(fd, data, size, 0, (sockaddr*)&to, sizeof(to)) == (ssize_t)size;
+}
+
+void uartBegin(uint8_t port, uint32_t baud) {
+    Uart* uart = uartAt(port);
+    if (uart) uart->baud = baud;
+}
+
+void uartAddMemory(uint8_t port, size_t rxBytes, size_t txBytes) {
+    Uart* uart = uartAt(port);
+    if (!uart) return;
+    uart->rxCapacity += rxBytes;
+    uart->txCapacity += txBytes;
+}
+
+int uartAvailable(uint8_t port) {
+    Uart* uart = uartAt(port);
+    return uart ? (int)uart->rx.size() : 0;
+}
+
+int uartRead(uint8_t port) {
+    Uart* uart = uartAt(port);
+    if (!uart || uart->rx.empty()) return -1;
+    uint8_t byte = uart->rx.front();
+    uart->rx.pop_front();
+    return byte;
+}
+
+void uartWrite(uint8_t port, const uint8_t* data, size_t length) {
+    Uart* uart = uartAt(port);
+    if (!uart || uart->baud == 0) return;
+    const double byteUs = 1e7 / uart->baud;
+    for (size_t i = 0; i < length; i++) {
+        uartDrain(*uart);
+        if (uart->tx.size() >= uart->txCapacity) {
+            // Full: wait on the virtual clock for the oldest byte to leave
+            const uint64_t until = (uint64_t)ceil(uart->txDoneUs.front());
+            state.uartBlockedUs += until - state.clockUs;
+            state.clockUs = until;
+            uartDrain(*uart);
+        }
+        const double start = uart->lineFreeUs > nowMicros() ? uart->lineFreeUs : (double)nowMicros();
+        uart->lineFreeUs = start + byteUs;
+        uart->tx.push_back(data[i]);
+        uart->txDoneUs.push_back(uart->lineFreeUs);
+    }
+}
+
+int uartAvailableForWrite(uint8_t port) {
+    Uart* uart = uartAt(port);
+    if (!uart) return 0;
+    uartDrain(*uart);
+    return (int)(uart->txCapacity - uart->tx.size());
+}
+
+} // namespace detail
+
+} // namespace sim
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    if (pin >= sim::PIN_COUNT) return;
+    sim::state.mode[pin] = mode;
+}
@@ -0,0 +1,407 @@
+/**
+ * @brief Host simulator runner: the real setup()/loop() on a virtual clock
+ *
+ * Usage: sim [options] [script]
+ *   --duration MS    Simulated run time after setup() (default: last script
+ *                    event + 500 ms, or 5000 ms without a script)
+ *   --step US        Virtual time per loop() pass (default 10)
+ *   --start-us US    Initial clock, e.g. 4294000000 to cross the micros() wrap
+ *   --host-timing    Also advance the clock by host time spent in each pass
+ *   --serial         Echo firmware Serial output
+ *   --quiet          Don't print MIDI output as it happens
+ *
+ * Script lines are "<ms after setup> <command> <args>", '#' starts a comment;
+ * "boot" in place of the time runs the command before setup():
+ *   button <i> down|up           switch <i> on|off
+ *   joystick up|down|left|right down|up
+ *   pot <i> <0-1023>
+ *   frame <command> <value>      5-byte portal protocol frame from the Pi
+ *   serial <hex bytes>           raw bytes from the Pi
+ *   cc <channel> <cc> <value>    MIDI CC from the host
+ *   sysex <hex bytes>            MIDI SysEx from the host (F0 ... F7)
+ *   sd insert [<MB>]             card in the slot (64 MB by default)
+ *   sd eject
+ *   sd busy <us> [<spike us> <every>]
+ *                                card busy time per 512-byte sector, plus a
+ *                                spike every <every> sectors
+ *   expect note_on|note_off|cc <channel> <data1> [<data2>]
+ *                                an unmatched MIDI message like this was sent
+ *   expect sysex <hex bytes>     an unmatched SysEx message like this was sent
+ *   expect no_midi               every MIDI message sent so far was matched
+ *   expect serial <text>         Serial output so far contains <text>
+ *   expect frame <command> [<value>]
+ *                                Serial output so far contains a reply frame
+ *   expect sd_file <name> [<min bytes>]
+ *                                the card holds this file
+ *   expect sd_entry <type> <a> [<b>]
+ *                                a session file on the card holds this
+ *                                flight recorder entry
+ *   expect sd_blocked <max us>   the firmware waited on a busy card at most
+ *                                this long in total
+ *
+ * Exits 1 if an expectation fails or the script has errors.
+ *
+ * Build & run: make sim SCRIPT=sim/scenarios/<name>.sim
+ */
+
+#include <Arduino.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "sim_hardware.h"
+#include "task_scheduler.h"
+
+// Firmware entry points and the scheduler, from src/main.cpp
+void setup();
+void loop();
+extern TaskScheduler scheduler;
+
+namespace {
+
+struct ScriptEvent {
+    bool boot;
+    uint32_t timeMs;
+    int line;
+    std::vector<std::string> words;
+};
+
+struct Options {
+    uint32_t durationMs = 0;
+    uint32_t stepUs = 10;
+    uint64_t startUs = 0;
+    bool hostTiming = false;
+    bool serialEcho = false;
+    bool quiet = false;
+    const char* script = nullptr;
+};
+
+int failures = 0;
+
+std::vector<uint8_t> hexBytes(const ScriptEvent& event, size_t first) {
+    std::vector<uint8_t> bytes;
+    for (size_t i = first; i < event.words.size(); i++) {
+        bytes.push_back(strtoul(event.words[i].c_str(), nullptr, 16));
+    }
+    return bytes;
+}
+
+std::vector<std::string> splitWords(const std::string& text) {
+    std::vector<std::string> words;
+    size_t i = 0;
+    while (i < text.size()) {
+        while (i < text.size() && isspace((unsigned char)text[i])) i++;
+        size_t start = i;
+        while (i < text.size() && !isspace((unsigned char)text[i])) i++;
+        if (i > start) words.push_back(text.substr(start, i - start));
+    }
+    return words;
+}
+
+bool loadScript(const char* path, std::vector<ScriptEvent>& events) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "sim: cannot open %s\n", path);
+        return false;
+    }
+    char buffer[512];
+    int line = 0;
+    bool ok = true;
+    while (fgets(buffer, sizeof(buffer), file)) {
+        line++;
+        std::string text(buffer);
+        size_t comment = text.find('#');
+        if (comment != std::string::npos) text.erase(comment);
+        std::vector<std::string> words = splitWords(text);
+        if (words.empty()) continue;
+        if (words.size() < 2) {
+            fprintf(stderr, "%s:%d: expected \"<ms> <command> ...\"\n", path, line);
+            ok = false;
+            continue;
+        }
+        ScriptEvent event;
+        event.boot = words[0] == "boot";
+        event.timeMs = event.boot ? 0 : strtoul(words[0].c_str(), nullptr, 0);
+        event.line = line;
+        event.words.assign(words.begin() + 1, words.end());
+        events.push_back(event);
+    }
+    fclose(file);
+    return ok;
+}
+
+long argAt(const ScriptEvent& event, size_t index) {
+    return index < event.words.size() ? strtol(event.words[index].c_str(), nullptr, 0) : -1;
+}
+
+bool isDown(const std::string& word) {
+    return word == "down" || word == "on";
+}
+
+const char* midiTypeName(uint8_t type) {
+    switch (type) {
+        case sim::MIDI_NOTE_ON: return "note_on";
+        case sim::MIDI_NOTE_OFF: return "note_off";
+        case sim::MIDI_CONTROL_CHANGE: return "cc";
+        case sim::MIDI_SYSEX: return "sysex";
+        default: return "?";
+    }
+}
+
+void fail(const ScriptEvent& event, const char* what) {
+    std::string text;
+    for (const std::string& word : event.words) text += " " + word;
+    printf("FAIL line %d at %lu ms:%s (%s)\n", event.line,
+           (unsigned long)event.timeMs, text.c_str(), what);
+    failures++;
+}
+
+void expect(const ScriptEvent& event, std::vector<bool>& matched) {
+    const std::string& what = event.words.size() > 1 ? event.words[1] : "";
+    std::vector<sim::MidiEvent>& midi = sim::midiOutput();
+    matched.resize(midi.size(), false);
+
+    if (what == "no_midi") {
+        for (size_t i = 0; i < midi.size(); i++) {
+            if (!matched[i]) {
+                fail(event, "unexpected MIDI output");
+                matched[i] = true;
+                return;
+            }
+        }
+    } else if (what == "serial") {
+        std::string text;
+        for (size_t i = 2; i < event.words.size(); i++) text += (i > 2 ? " " : "") + event.words[i];
+        if (sim::serialOutput().find(text) == std::string::npos) fail(event, "not in Serial output");
+    } else if (what == "frame") {
+        const std::string& out = sim::serialOutput();
+        const long command = argAt(event, 2), value = argAt(event, 3);
+        bool found = false;
+        for (size_t i = 0; !found && i + 5 <= out.size(); i++) {
+            const uint8_t* f = (const uint8_t*)out.data() + i;
+            found = f[0] == 0xAA && f[4] == 0x55 && f[3] == (f[1] ^ f[2]) &&
+                    f[1] == command && (value < 0 || f[2] == value);
+        }
+        if (!found) fail(event, "no such frame in Serial output");
+    } else if (what == "note_on" || what == "note_off" || what == "cc") {
+        const uint8_t type = what == "note_on" ? sim::MIDI_NOTE_ON
+                           : what == "note_off" ? sim::MIDI_NOTE_OFF : sim::MIDI_CONTROL_CHANGE;
+        const long channel = argAt(event, 2), data1 = argAt(event, 3), data2 = argAt(event, 4);
+        for (size_t i = 0; i < midi.size(); i++) {
+            if (!matched[i] && midi[i].type == type && midi[i].channel == channel &&
+                midi[i].data1 == data1 && (data2 < 0 || midi[i].data2 == data2)) {
+                matched[i] = true;
+                return;
+            }
+        }
+        fail(event, "no matching MIDI output");
+    } else if (what == "sysex") {
+        const std::vector<uint8_t> bytes = hexBytes(event, 2);
+        for (size_t i = 0; i < midi.size(); i++) {
+            if (!matched[i] && midi[i].type == sim::MIDI_SYSEX && midi[i].sysex == bytes) {
+                matched[i] = true;
+                return;
+            }
+        }
+        fail(event, "no matching SysEx output");
+    } else if (what == "sd_file") {
+        const std::string name = event.words.size() > 2 ? event.words[2] : "";
+        const auto& files = sim::sdFiles();
+        auto file = files.find(name);
+        const long minBytes = argAt(event, 3);
+        if (file == files.end()) {
+            fail(event, "no such file on the card");
+        } else if (minBytes > 0 && file->second.size() < (size_t)minBytes) {
+            fail(event, "file is shorter");
+        }
+    } else if (what == "sd_entry") {
+        // Session files: a 512-byte header sector, then 8-byte entries
+        const long type = argAt(event, 2), a = argAt(event, 3), b = argAt(event, 4);
+        for (const auto& file : sim::sdFiles()) {
+            const std::vector<uint8_t>& data = file.second;
+            if (data.size() < 512 || memcmp(data.data(), "SESS", 4) != 0) continue;
+            for (size_t i = 512; i + 8 <= data.size(); i += 8) {
+                const uint16_t entryB = data[i + 6] | (data[i + 7] << 8);
+                if (data[i + 4] == type && data[i + 5] == a && (b < 0 || entryB == b)) return;
+            }
+        }
+        fail(event, "no such entry in the session files");
+    } else if (what == "sd_blocked") {
+        if (sim::sdBlockedUs() > (uint64_t)argAt(event, 2)) {
+            printf("  blocked on the card for %llu us\n", (unsigned long long)sim::sdBlockedUs());
+            fail(event, "waited on a busy card");
+        }
+    } else {
+        fail(event, "unknown expectation");
+    }
+}
+
+void applyEvent(const ScriptEvent& event, std::vector<bool>& matched) {
+    const std::string& command = event.words[0];
+    const std::string last = event.words.back();
+
+    if (command == "button") {
+        sim::setButton(argAt(event, 1), isDown(last));
+    } else if (command == "switch") {
+        sim::setSwitch(argAt(event, 1), isDown(last));
+    } else if (command == "joystick" && event.words.size() == 3) {
+        static const char* const DIRECTIONS[] = {"up", "down", "left", "right"};
+        for (uint8_t i = 0; i < 4; i++) {
+            if (event.words[1] == DIRECTIONS[i]) sim::setJoystick(i, isDown(last));
+        }
+    } else if (command == "pot") {
+        sim::setPot(argAt(event, 1), argAt(event, 2));
+    } else if (command == "frame") {
+        const uint8_t cmd = argAt(event, 1), value = argAt(event, 2);
+        const uint8_t frame[5] = {0xAA, cmd, value, (uint8_t)(cmd ^ value), 0x55};
+        sim::serialInput(frame, sizeof(frame));
+    } else if (command == "serial") {
+        const std::vector<uint8_t> bytes = hexBytes(event, 1);
+        sim::serialInput(bytes.data(), bytes.size());
+    } else if (command == "cc") {
+        sim::midiInput(sim::MIDI_CONTROL_CHANGE, argAt(event, 1), argAt(event, 2), argAt(event, 3));
+    } else if (command == "sysex") {
+        const std::vector<uint8_t> bytes = hexBytes(event, 1);
+        sim::midiInputSysEx(bytes.data(), bytes.size());
+    } else if (command == "sd" && event.words.size() >= 2) {
+        if (event.words[1] == "insert") {
+            const long megabytes = argAt(event, 2);
+            sim::sdInsert((uint64_t)(megabytes > 0 ? megabytes : 64) << 20);
+        } else if (event.words[1] == "eject") {
+            sim::sdEject();
+        } else if (event.words[1] == "busy") {
+            const long spikeUs = argAt(event, 3), every = argAt(event, 4);
+            sim::sdSetBusy(argAt(event, 2), spikeUs > 0 ? spikeUs : 0, every > 0 ? every : 0);
+        } else {
+            fail(event, "unknown sd command");
+        }
+    } else if (command == "expect") {
+        expect(event, matched);
+    } else {
+        fail(event, "unknown command");
+    }
+}
+
+void printMidi(const sim::MidiEvent& event, uint64_t bootUs) {
+    printf("%10.3f ms  %-8s", (event.timeUs - bootUs) / 1000.0, midiTypeName(event.type));
+    if (event.type == sim::MIDI_SYSEX) {
+        for (uint8_t byte : event.sysex) printf(" %02X", byte);
+        printf("\n");
+    } else {
+        printf(" ch%-2u %3u %3u\n", event.channel, event.data1, event.data2);
+    }
+}
+
+void printSchedulerStats() {
+    printf("Task      Jobs     AvgUs MaxSlice Overrun Missed\n");
+    for (uint8_t i = 0; i < scheduler.getTaskCount(); i++) {
+        const TaskScheduler::TaskStats& stats = scheduler.getStats(i);
+        printf("%-9s %7lu %6lu %8lu %7lu %6lu\n", scheduler.getTaskName(i),
+               (unsigned long)stats.jobs,
+               (unsigned long)(stats.jobs ? stats.totalUs / stats.jobs : 0),
+               (unsigned long)stats.maxSliceUs, (unsigned long)stats.overruns,
+               (unsigned long)stats.missedReleases);
+    }
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--duration" && hasValue) {
+            options.durationMs = strtoul(argv[++i], nullptr, 0);
+        } else if (arg == "--step" && hasValue) {
+            options.stepUs = strtoul(argv[++i], nullptr, 0);
+        } else if (arg == "--start-us" && hasValue) {
+            options.startUs = strtoull(argv[++i], nullptr, 0);
+        } else if (arg == "--host-timing") {
+            options.hostTiming = true;
+        } else if (arg == "--serial") {
+            options.serialEcho = true;
+        } else if (arg == "--quiet") {
+            options.quiet = true;
+        } else if (arg[0] != '-' && !options.script) {
+            options.script = argv[i];
+        } else {
+            fprintf(stderr, "sim: unknown option %s\n", arg.c_str());
+            return false;
+        }
+    }
+    if (options.stepUs == 0) options.stepUs = 1;
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) return 2;
+
+    std::vector<ScriptEvent> events;
+    if (options.script && !loadScript(options.script, events)) return 2;
+    std::stable_sort(events.begin(), events.end(), [](const ScriptEvent& a, const ScriptEvent& b) {
+        return a.boot != b.boot ? a.boot : a.timeMs < b.timeMs;
+    });
+
+    if (options.durationMs == 0) {
+        options.durationMs = events.empty() ? 5000 : events.back().timeMs + 500;
+    }
+
+    sim::reset();
+    sim::setMicros(options.startUs);
+    sim::setSerialEcho(options.serialEcho);
+    sim::setHostTiming(options.hostTiming);
+
+    std::vector<bool> matched;
+    size_t nextEvent = 0;
+    while (nextEvent < events.size() && events[nextEvent].boot) {
+        applyEvent(events[nextEvent++], matched);
+    }
+
+    const auto hostStart = std::chrono::steady_clock::now();
+    setup();
+    sim::endPass(0);  // Commit host time spent in setup()
+    const uint64_t bootUs = sim::nowMicros();
+    const uint64_t endUs = bootUs + (uint64_t)options.durationMs * 1000;
+
+    size_t printed = 0;
+    uint64_t passes = 0;
+
+    while (sim::nowMicros() < endUs) {
+        sim::beginPass();
+        const uint64_t elapsedMs = (sim::nowMicros() - bootUs) / 1000;
+        while (nextEvent < events.size() && events[nextEvent].timeMs <= elapsedMs) {
+            applyEvent(events[nextEvent++], matched);
+        }
+
+        loop();
+        sim::endPass(options.stepUs);
+        passes++;
+
+        if (!options.quiet) {
+            const std::vector<sim::MidiEvent>& midi = sim::midiOutput();
+            for (; printed < midi.size(); printed++) printMidi(midi[printed], bootUs);
+        }
+    }
+    // Expectations scheduled at or after the end still run
+    while (nextEvent < events.size()) {
+        applyEvent(events[nextEvent++], matched);
+    }
+
+    const double hostMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - hostStart).count();
+    printf("\nSimulated %lu ms in %.1f ms host time (%.1fx), %llu loop passes\n",
+           (unsigned long)options.durationMs, hostMs, options.durationMs / (hostMs > 0 ? hostMs : 1),
+           (unsigned long long)passes);
+    printf("MIDI out: %zu messages, LED frames: %lu, OLED bytes: %lu, Serial out: %zu bytes\n",
+           sim::midiOutput().size(), (unsigned long)sim::ledShowCount(),
+           (unsigned long)sim::oledBytesWritten(), sim::serialOutput().size());
+    printSchedulerStats();
+
+    if (failures) {
+        printf("%d expectation(s) FAILED\n", failures);
+        return 1;
+    }
+    if (options.script) printf("All expectations passed\n");
+    return 0;
+}
@@ -0,0 +1,522 @@
+/**
+ * @brief Accelerated-time soak: weeks of uptime of the real firmware loop
+ *
+ * Usage: soak [options]
+ *   --days N          Simulated uptime (default 14, fractions allowed)
+ *   --seed N          Input and protocol randomization seed (default 1)
+ *   --start-ms MS     Clock at boot (default: half the run before the
+ *                     millis() wrap, so the wrap lands mid-soak)
+ *   --step US         Virtual time per loop() pass during play (default 100)
+ *   --max-gap-ms MS   Longest pause between bursts (default 25000, below the
+ *                     idle timeout so the piece stays in play)
+ *   --program-every-h H
+ *                     Hours between SET_PROGRAM cues (default 168; 0 = never)
+ *   --quiet           Only the summary, no per-day table
+ *
+ * The run is a sequence of cycles. A cycle is a pause, where the clock jumps
+ * forward with no loop() passes (as if nobody touched anything and nothing
+ * ran late), followed by a burst of 120-300 ms of normal loop() passes with
+ * randomized play:
+ *   - 1-3 button presses with contact bounce, all released before the end
+ *   - pot moves with ADC jitter, joystick pushes, switches 1-11
+ *   - 0-2 Pi protocol frames (never CONFIG/TRACE/dumps), sometimes after
+ *     line noise
+ * Switch 0 cycles the portal program, so it is left alone; programs change
+ * only through the SET_PROGRAM cue.
+ *
+ * Invariants, checked every burst:
+ *   - no stuck notes: every note that went on is off again, no double ons
+ *     (the looper's channel keeps playing after release, so it is only
+ *     checked for order)
+ *   - every protocol frame got exactly one reply
+ *   - stable animation speed: animationPhase advances at 1 s/s and bpmPhase
+ *     at bpm/60 beats/s (within 2 %), over the burst's portal frames
+ *   - bounded loop time: p99 host time per loop() pass below one scan period
+ *
+ * Drift metrics are printed per simulated day. Exits 1 on any violation.
+ *
+ * Build & run: make soak-test [SOAK_ARGS="--days 30 --seed 7"]
+ */
+
+#include <Arduino.h>
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <string>
+#include <vector>
+#include "sim_hardware.h"
+#include "config.h"
+#include "pins.h"
+#include "perf_monitor.h"
+#include "portal_controller.h"
+#include "serial_portal_protocol.h"
+
+// Firmware entry points and state, from src/main.cpp
+void setup();
+void loop();
+extern PortalController portalController;
+
+namespace {
+
+constexpr uint32_t BURST_MIN_MS = 120;
+constexpr uint32_t BURST_MAX_MS = 300;
+constexpr uint32_t GAP_MIN_MS = 500;
+constexpr uint32_t SPEED_MIN_SPAN_MS = 50;     // Shortest burst span that is measured
+constexpr double SPEED_TOLERANCE = 0.02;
+constexpr uint32_t MAX_REPORTS = 10;           // FAIL lines printed per invariant
+constexpr uint64_t DAY_US = 86400ULL * 1000000;
+
+struct Options {
+    double days = 14;
+    uint32_t seed = 1;
+    uint64_t startMs = UINT64_MAX;
+    uint32_t stepUs = 100;
+    uint32_t maxGapMs = 25000;
+    uint32_t programEveryH = 168;
+    bool quiet = false;
+};
+
+// xorshift32: deterministic across hosts
+struct Random {
+    uint32_t state;
+    explicit Random(uint32_t seed) : state(seed ? seed : 1) {}
+    uint32_t next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+    uint32_t range(uint32_t low, uint32_t high) { return low + next() % (high - low + 1); }
+    bool chance(uint32_t percent) { return next() % 100 < percent; }
+};
+
+enum ActionType : uint8_t { ACT_BUTTON, ACT_SWITCH, ACT_JOYSTICK, ACT_POT };
+
+struct Action {
+    uint32_t atUs;  // Offset into the burst
+    ActionType type;
+    uint8_t index;
+    uint16_t value;
+};
+
+struct Violations {
+    const char* name;
+    uint32_t count = 0;
+};
+
+// Per simulated day
+struct DayStats {
+    uint32_t cycles = 0;
+    uint32_t presses = 0;
+    uint32_t frames = 0;
+    uint32_t speedSamples = 0;
+    double animMin = 1e9, animMax = 0;
+    double bpmMin = 1e9, bpmMax = 0;
+    float animPhaseMax = 0;
+    float bpmPhaseMax = 0;
+    uint64_t passNsTotal = 0;
+    uint64_t passes = 0;
+    LogHistogram passNs;
+};
+
+// Portal state sampled on the first and last portal frame of a burst
+struct PhaseSample {
+    bool valid = false;
+    uint32_t ms = 0;
+    float animation = 0;
+    float bpmPhase = 0;
+    float bpm = 0;
+    uint8_t program = 0;
+};
+
+Options options;
+Violations stuckNotes{"stuck notes"};
+Violations noteOrder{"note on/off order"};
+Violations replies{"protocol replies"};
+Violations animationSpeed{"animation speed"};
+Violations bpmSpeed{"bpm phase speed"};
+Violations loopTime{"loop time"};
+uint64_t bootUs;
+
+std::string uptime(uint64_t us) {
+    const uint64_t s = (us - bootUs) / 1000000;
+    char text[32];
+    snprintf(text, sizeof(text), "%llud+%02llu:%02llu:%02llu", (unsigned long long)(s / 86400),
+             (unsigned long long)(s / 3600 % 24), (unsigned long long)(s / 60 % 60),
+             (unsigned long long)(s % 60));
+    return text;
+}
+
+void violation(Violations& kind, const char* format, ...) {
+    if (kind.count++ >= MAX_REPORTS) return;
+    char detail[160];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(detail, sizeof(detail), format, args);
+    va_end(args);
+    printf("FAIL %s at %s: %s\n", kind.name, uptime(sim::nowMicros()).c_str(), detail);
+}
+
+// Phase advance between two samples; the firmware wraps both phases
+double phaseDelta(float from, float to, float wrap) {
+    double delta = (double)to - from;
+    if (delta < 0) delta += wrap;
+    return delta;
+}
+
+void planButton(std::vector<Action>& plan, uint8_t button, uint32_t pressUs, uint32_t releaseUs) {
+    // Contact bounce on both edges, settled within 1 ms
+    plan.push_back({pressUs, ACT_BUTTON, button, 1});
+    plan.push_back({pressUs + 300, ACT_BUTTON, button, 0});
+    plan.push_back({pressUs + 700, ACT_BUTTON, button, 1});
+    plan.push_back({releaseUs, ACT_BUTTON, button, 0});
+    plan.push_back({releaseUs + 400, ACT_BUTTON, button, 1});
+    plan.push_back({releaseUs + 900, ACT_BUTTON, button, 0});
+}
+
+std::vector<Action> planBurst(Random& random, uint32_t burstMs, uint16_t* pots, bool* switches,
+                              DayStats& day) {
+    std::vector<Action> plan;
+
+    // Distinct buttons, each released at least 30 ms before the burst ends
+    const uint8_t presses = random.range(1, 3);
+    const uint8_t first = random.range(0, BUTTON_COUNT - 1);
+    for (uint8_t p = 0; p < presses; p++) {
+        const uint8_t button = (first + p * 3) % BUTTON_COUNT;
+        const uint32_t pressUs = random.range(5, burstMs - 100) * 1000;
+        planButton(plan, button, pressUs, pressUs + random.range(20, 69) * 1000);
+    }
+    day.presses += presses;
+
+    // Pot moves: a few steps toward a target, each reading with ±2 jitter
+    for (uint8_t m = random.range(0, 2); m > 0; m--) {
+        const uint8_t pot = random.range(0, POT_COUNT - 1);
+        const uint16_t target = random.range(0, 1023);
+        const uint32_t startUs = random.range(5, burstMs - 80) * 1000;
+        for (uint8_t step = 1; step <= 5; step++) {
+            int value = pots[pot] + ((int)target - pots[pot]) * step / 5 + (int)random.range(0, 4) - 2;
+            plan.push_back({startUs + step * 8000, ACT_POT, pot, (uint16_t)constrain(value, 0, 1023)});
+        }
+        pots[pot] = target;
+    }
+
+    if (random.chance(20)) {
+        const uint8_t direction = random.range(0, 3);
+        const uint32_t pushUs = random.range(5, burstMs - 70) * 1000;
+        plan.push_back({pushUs, ACT_JOYSTICK, direction, 1});
+        plan.push_back({pushUs + 30000, ACT_JOYSTICK, direction, 0});
+    }
+
+    if (random.chance(10)) {
+        const uint8_t sw = random.range(1, SWITCH_COUNT - 1);
+        switches[sw] = !switches[sw];
+        plan.push_back({random.range(5, burstMs - 30) * 1000, ACT_SWITCH, sw, switches[sw]});
+    }
+
+    std::stable_sort(plan.begin(), plan.end(), [](const Action& a, const Action& b) { return a.atUs < b.atUs; });
+    return plan;
+}
+
+void apply(const Action& action) {
+    switch (action.type) {
+        case ACT_BUTTON: sim::setButton(action.index, action.value); break;
+        case ACT_SWITCH: sim::setSwitch(action.index, action.value); break;
+        case ACT_JOYSTICK: sim::setJoystick(action.index, action.value); break;
+        case ACT_POT: sim::setPot(action.index, action.value); break;
+    }
+}
+
+/**
+ * @brief Queue 0-2 Pi frames, sometimes after line noise
+ * @return Frames sent (each must be answered)
+ */
+uint32_t sendProtocolTraffic(Random& random, bool programDue) {
+    static const PortalSerialCommand COMMANDS[] = {
+        PortalSerialCommand::SET_BPM, PortalSerialCommand::SET_INTENSITY,
+        PortalSerialCommand::SET_HUE, PortalSerialCommand::SET_BRIGHTNESS,
+        PortalSerialCommand::TRIGGER_FLASH, PortalSerialCommand::TRIGGER_RIPPLE,
+        PortalSerialCommand::PING
+    };
+    constexpr uint8_t COMMAND_COUNT = sizeof(COMMANDS) / sizeof(COMMANDS[0]);
+
+    std::vector<uint8_t> bytes;
+    if (random.chance(5)) {
+        // Noise never contains the start byte, so it cannot fake a frame
+        for (uint8_t n = random.range(1, 3); n > 0; n--) {
+            uint8_t noise = random.next();
+            bytes.push_back(noise == PORTAL_MSG_START_BYTE ? 0 : noise);
+        }
+    }
+
+    std::vector<PortalMessage> messages;
+    for (uint8_t f = random.range(0, 2); f > 0; f--) {
+        messages.push_back(PortalMessage(COMMANDS[random.next() % COMMAND_COUNT], random.next()));
+    }
+    if (programDue) {
+        messages.push_back(PortalMessage(PortalSerialCommand::SET_PROGRAM,
+                                         random.range(0, PORTAL_PROGRAM_COUNT - 1)));
+    }
+
+    for (const PortalMessage& message : messages) {
+        uint8_t frame[PORTAL_MSG_MIN_SIZE];
+        message.toBytes(frame);
+        bytes.insert(bytes.end(), frame, frame + sizeof(frame));
+    }
+    if (!bytes.empty()) sim::serialInput(bytes.data(), bytes.size());
+    return messages.size();
+}
+
+uint32_t countReplies(const std::string& out) {
+    uint32_t count = 0;
+    for (size_t i = 0; i + PORTAL_MSG_MIN_SIZE <= out.size(); i++) {
+        const uint8_t* f = (const uint8_t*)out.data() + i;
+        if (f[0] == PORTAL_MSG_START_BYTE && f[4] == PORTAL_MSG_END_BYTE && f[3] == (f[1] ^ f[2]) &&
+            f[1] >= static_cast<uint8_t>(PortalSerialCommand::PONG) &&
+            f[1] <= static_cast<uint8_t>(PortalSerialCommand::STATUS)) {
+            count++;
+            i += PORTAL_MSG_MIN_SIZE - 1;
+        }
+    }
+    return count;
+}
+
+void checkNotes(bool (*notesOn)[128]) {
+    for (const sim::MidiEvent& event : sim::midiOutput()) {
+        const bool on = event.type == sim::MIDI_NOTE_ON && event.data2 > 0;
+        const bool off = event.type == sim::MIDI_NOTE_OFF || (event.type == sim::MIDI_NOTE_ON && event.data2 == 0);
+        bool* channel = notesOn[(event.channel - 1) & 0x0F];
+        if (on) {
+            if (channel[event.data1]) violation(noteOrder, "note %u on twice (channel %u)", event.data1, event.channel);
+            channel[event.data1] = true;
+        } else if (off) {
+            if (!channel[event.data1]) violation(noteOrder, "note %u off while off (channel %u)", event.data1, event.channel);
+            channel[event.data1] = false;
+        }
+    }
+    sim::midiOutput().clear();
+
+    // Every button is up and settled: nothing may still sound, except the loop
+    for (uint8_t ch = 0; ch < 16; ch++) {
+        #if MIDI_LOOPER > 0
+        if (ch + 1 == LOOPER_MIDI_CHANNEL) continue;
+        #endif
+        for (uint8_t note = 0; note < 128; note++) {
+            if (notesOn[ch][note]) {
+                violation(stuckNotes, "note %u still on after release (channel %u)", note, ch + 1);
+                notesOn[ch][note] = false;
+            }
+        }
+    }
+}
+
+void checkSpeed(const PhaseSample& first, const PhaseSample& last, DayStats& day) {
+    if (!first.valid || !last.valid) return;
+    if (first.program != last.program || first.bpm != last.bpm) return;
+    const uint32_t spanMs = last.ms - first.ms;
+    if (spanMs < SPEED_MIN_SPAN_MS) return;
+    const double seconds = spanMs / 1000.0;
+
+    const double anim = phaseDelta(first.animation, last.animation, PORTAL_ANIMATION_PHASE_WRAP) / seconds;
+    const double beats = phaseDelta(first.bpmPhase, last.bpmPhase, PORTAL_BPM_PHASE_WRAP) /
+                         (seconds * first.bpm / 60.0);
+    day.speedSamples++;
+    day.animMin = std::min(day.animMin, anim);
+    day.animMax = std::max(day.animMax, anim);
+    day.bpmMin = std::min(day.bpmMin, beats);
+    day.bpmMax = std::max(day.bpmMax, beats);
+
+    if (fabs(anim - 1.0) > SPEED_TOLERANCE) {
+        violation(animationSpeed, "%.3f s/s over %lu ms (phase %.4f -> %.4f)", anim,
+                  (unsigned long)spanMs, first.animation, last.animation);
+    }
+    if (fabs(beats - 1.0) > SPEED_TOLERANCE) {
+        violation(bpmSpeed, "%.3fx of %.0f bpm over %lu ms (phase %.4f -> %.4f)", beats, first.bpm,
+                  (unsigned long)spanMs, first.bpmPhase, last.bpmPhase);
+    }
+}
+
+void printDay(uint32_t index, const DayStats& day) {
+    printf("%4lu %7lu %8lu %7lu  %6.4f..%6.4f  %6.4f..%6.4f  %10.1f %8.2f  %6llu %6lu %8lu\n",
+           (unsigned long)index, (unsigned long)day.cycles, (unsigned long)day.presses,
+           (unsigned long)day.frames,
+           day.speedSamples ? day.animMin : 0.0, day.speedSamples ? day.animMax : 0.0,
+           day.speedSamples ? day.bpmMin : 0.0, day.speedSamples ? day.bpmMax : 0.0,
+           day.animPhaseMax, day.bpmPhaseMax,
+           (unsigned long long)(day.passes ? day.passNsTotal / day.passes : 0),
+           (unsigned long)day.passNs.percentile(99), (unsigned long)day.passNs.maxValue);
+}
+
+bool parseOptions(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--days" && hasValue) {
+            options.days = strtod(argv[++i], nullptr);
+        } else if (arg == "--seed" && hasValue) {
+            options.seed = strtoul(argv[++i], nullptr, 0);
+        } else if (arg == "--start-ms" && hasValue) {
+            options.startMs = strtoull(argv[++i], nullptr, 0);
+        } else if (arg == "--step" && hasValue) {
+            options.stepUs = strtoul(argv[++i], nullptr, 0);
+        } else if (arg == "--max-gap-ms" && hasValue) {
+            options.maxGapMs = strtoul(argv[++i], nullptr, 0);
+        } else if (arg == "--program-every-h" && hasValue) {
+            options.programEveryH = strtoul(argv[++i], nullptr, 0);
+        } else if (arg == "--quiet") {
+            options.quiet = true;
+        } else {
+            fprintf(stderr, "soak: unknown option %s\n", arg.c_str());
+            return false;
+        }
+    }
+    if (options.stepUs == 0) options.stepUs = 1;
+    if (options.maxGapMs < GAP_MIN_MS) options.maxGapMs = GAP_MIN_MS;
+    return options.days > 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (!parseOptions(argc, argv)) return 2;
+
+    const uint64_t durationUs = (uint64_t)(options.days * DAY_US);
+    if (options.startMs == UINT64_MAX) {
+        options.startMs = (1ULL << 32) - std::min<uint64_t>(durationUs / 2000, 1ULL << 31);
+    }
+
+    sim::reset();
+    sim::setMicros(options.startMs * 1000);
+    const auto hostStart = std::chrono::steady_clock::now();
+    setup();
+    sim::endPass(0);
+    bootUs = sim::nowMicros();
+    const uint64_t endUs = bootUs + durationUs;
+
+    printf("Soak: %.2f days from millis() = %llu (seed %lu)\n", options.days,
+           (unsigned long long)(bootUs / 1000), (unsigned long)options.seed);
+    if (!options.quiet) {
+        printf(" day  cycles  presses  frames  anim s/s          bpm speed          anim phase bpm phase  ns/pass    p99      max\n");
+    }
+
+    Random random(options.seed);
+    uint16_t pots[POT_COUNT];
+    for (uint8_t i = 0; i < POT_COUNT; i++) pots[i] = 512;
+    bool switches[SWITCH_COUNT] = {};
+    bool notesOn[16][128] = {};
+
+    std::vector<DayStats> days(1);
+    uint64_t dayStartUs = bootUs;
+    uint64_t nextProgramUs = bootUs + (uint64_t)options.programEveryH * 3600 * 1000000;
+    uint32_t framesSent = 0, repliesSeen = 0;
+    uint32_t millisWraps = 0, microsWraps = 0;
+    uint32_t lastMillis = millis(), lastMicros = micros();
+
+    while (sim::nowMicros() < endUs) {
+        // Pause: nothing runs, nothing is touched
+        sim::advanceMicros((uint64_t)random.range(GAP_MIN_MS, options.maxGapMs) * 1000);
+        if (sim::nowMicros() - dayStartUs >= DAY_US) {
+            if (!options.quiet) printDay(days.size(), days.back());
+            days.emplace_back();
+            dayStartUs += DAY_US;
+        }
+        DayStats& day = days.back();
+        day.cycles++;
+
+        // Burst of play
+        const uint32_t burstMs = random.range(BURST_MIN_MS, BURST_MAX_MS);
+        const std::vector<Action> plan = planBurst(random, burstMs, pots, switches, day);
+        const bool programDue = options.programEveryH && sim::nowMicros() >= nextProgramUs;
+        if (programDue) nextProgramUs += (uint64_t)options.programEveryH * 3600 * 1000000;
+        const uint32_t sent = sendProtocolTraffic(random, programDue);
+        framesSent += sent;
+
+        const uint64_t burstStartUs = sim::nowMicros();
+        size_t nextAction = 0;
+        uint32_t lastFrame = portalController.getFrameCount();
+        PhaseSample first, last;
+        while (sim::nowMicros() - burstStartUs < burstMs * 1000ULL) {
+            const uint64_t offsetUs = sim::nowMicros() - burstStartUs;
+            while (nextAction < plan.size() && plan[nextAction].atUs <= offsetUs) {
+                apply(plan[nextAction++]);
+            }
+
+            sim::beginPass();
+            const auto passStart = std::chrono::steady_clock::now();
+            loop();
+            const uint32_t passNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - passStart).count();
+            sim::endPass(options.stepUs);
+            day.passNs.add(passNs);
+            day.passNsTotal += passNs;
+            day.passes++;
+
+            // Millis/micros wraps crossed (the pause may cross them too)
+            if (millis() < lastMillis) millisWraps++;
+            if (micros() < lastMicros) microsWraps++;
+            lastMillis = millis();
+            lastMicros = micros();
+
+            const uint32_t frame = portalController.getFrameCount();
+            if (frame != lastFrame) {
+                lastFrame = frame;
+                day.frames++;
+                PhaseSample sample;
+                sample.valid = true;
+                sample.ms = millis();
+                sample.animation = portalController.getAnimationPhase();
+                sample.bpmPhase = portalController.getBpmPhase();
+                sample.bpm = portalController.getBpm();
+                sample.program = portalController.getCurrentProgram();
+                day.animPhaseMax = std::max(day.animPhaseMax, sample.animation);
+                day.bpmPhaseMax = std::max(day.bpmPhaseMax, sample.bpmPhase);
+                // The first frame after the pause covers the pause; cues land in the first ms
+                if (offsetUs >= 10000) {
+                    if (!first.valid) first = sample;
+                    last = sample;
+                }
+            }
+        }
+
+        checkNotes(notesOn);
+        checkSpeed(first, last, day);
+
+        const uint32_t seen = countReplies(sim::serialOutput());
+        repliesSeen += seen;
+        if (seen != sent) violation(replies, "%lu frames, %lu replies", (unsigned long)sent, (unsigned long)seen);
+        sim::serialOutput().clear();
+    }
+    if (!options.quiet) printDay(days.size(), days.back());
+
+    // Drift over the run, from whole days only
+    const DayStats& firstDay = days.front();
+    const DayStats& lastDay = days.size() > 1 ? days[days.size() - 2] : days.back();
+    uint32_t worstP99 = 0;
+    for (const DayStats& day : days) worstP99 = std::max(worstP99, day.passNs.percentile(99));
+    if (worstP99 > SCAN_PERIOD_US * 1000) {
+        violation(loopTime, "p99 %lu ns per loop() pass exceeds the %lu us scan period",
+                  (unsigned long)worstP99, (unsigned long)SCAN_PERIOD_US);
+    }
+
+    const double hostS = std::chrono::duration<double>(std::chrono::steady_clock::now() - hostStart).count();
+    const double firstMean = firstDay.passes ? (double)firstDay.passNsTotal / firstDay.passes : 0;
+    const double lastMean = lastDay.passes ? (double)lastDay.passNsTotal / lastDay.passes : 0;
+    printf("\nSimulated %s in %.1f s host time (%.0fx)\n", uptime(sim::nowMicros()).c_str(), hostS,
+           (sim::nowMicros() - bootUs) / 1e6 / (hostS > 0 ? hostS : 1));
+    printf("Wraps crossed: millis() %lu, micros() %lu\n", (unsigned long)millisWraps, (unsigned long)microsWraps);
+    printf("Protocol: %lu frames, %lu replies\n", (unsigned long)framesSent, (unsigned long)repliesSeen);
+    printf("Loop pass drift: %.0f ns/pass on day 1, %.0f ns/pass on day %lu (%.2fx)\n", firstMean, lastMean,
+           (unsigned long)(days.size() > 1 ? days.size() - 1 : 1), firstMean > 0 ? lastMean / firstMean : 0);
+
+    const Violations* kinds[] = {&stuckNotes, &noteOrder, &replies, &animationSpeed, &bpmSpeed, &loopTime};
+    uint32_t total = 0;
+    for (const Violations* kind : kinds) {
+        printf("  %-18s %s (%lu)\n", kind->name, kind->count ? "FAIL" : "ok", (unsigned long)kind->count);
+        total += kind->count;
+    }
+    if (total) {
+        printf("%lu invariant violation(s)\n", (unsigned long)total);
+        return 1;
+    }
+    printf("All invariants held\n");
+    return 0;
+}
@@ -0,0 +1,469 @@
+/**
+ * @brief Input trace replay: raw input trace -> RobustInputProcessor ->
+ * RobustMidiMapper -> MIDI stream, deterministically, on the host
+ *
+ * Usage: trace_replay [options] <trace>
+ *   <trace> is a binary trace as streamed by TRACE_DUMP (see input_trace.h)
+ *   or a text trace (*.trace, below), encoded with the same recorder.
+ *   --golden FILE     Compare the output with FILE; exit 1 on any difference
+ *   --update          Write the output to the --golden file instead
+ *   --encode FILE     Write the binary trace to FILE (e.g. from a text trace)
+ *   --debounce MS     Runtime tuning for the replay (default: config.h)
+ *   --pot-deadband N
+ *   --pot-rate-limit MS
+ *   --rearm MS
+ *   --quiet           Print only the metrics
+ *
+ * Text trace lines are "<ms> <command> <args>", '#' starts a comment:
+ *   button <i> down|up [bounce <ms>]     switch <i> on|off [bounce <ms>]
+ *   joystick up|down|left|right down|up [bounce <ms>]
+ *   pot <i> <0-1023>
+ *   noise <i> <amplitude>      pot i reads +-amplitude around its value every tick
+ *   end                        trace length (default: last line + 500 ms)
+ * "bounce" makes the contact chatter (toggle every tick) before it settles.
+ * Noise comes from a fixed-seed generator, so text traces are deterministic.
+ *
+ * Output: one line per MIDI message (ms since replay start), then "#" metric
+ * lines: message counts, and debounced gestures found in the raw input
+ * against the messages they should produce. A filter or debounce change that
+ * drops a gesture shows as "lost" there and as a golden diff.
+ *
+ * Build & run: make trace-replay TRACE=sim/traces/<name>.trace
+ */
+
+#include <Arduino.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "sim_hardware.h"
+#include "input_trace.h"
+#include "robust_input_processor.h"
+#include "robust_midi_mapper.h"
+#include "midi_out.h"
+#include "config_store.h"
+
+namespace {
+
+// The replay starts with the clock here, so rate-limit windows that are
+// measured from zero are already open, as on a running device
+constexpr uint64_t REPLAY_START_US = 1000000;
+
+// A raw digital change that holds this long counts as a gesture
+constexpr uint32_t GESTURE_MIN_MS = 20;
+
+struct Options {
+    const char* trace = nullptr;
+    const char* golden = nullptr;
+    const char* encode = nullptr;
+    bool update = false;
+    bool quiet = false;
+    RuntimeConfig config = ConfigStore::defaults();
+};
+
+std::vector<std::string> splitWords(const std::string& text) {
+    std::vector<std::string> words;
+    size_t i = 0;
+    while (i < text.size()) {
+        while (i < text.size() && isspace((unsigned char)text[i])) i++;
+        size_t start = i;
+        while (i < text.size() && !isspace((unsigned char)text[i])) i++;
+        if (i > start) words.push_back(text.substr(start, i - start));
+    }
+    return words;
+}
+
+bool readFile(const char* path, std::vector<uint8_t>& data) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+    uint8_t buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        data.insert(data.end(), buffer, buffer + n);
+    }
+    fclose(file);
+    return true;
+}
+
+bool writeFile(const char* path, const void* data, size_t length) {
+    FILE* file = fopen(path, "wb");
+    if (!file) return false;
+    bool ok = fwrite(data, 1, length, file) == length;
+    return fclose(file) == 0 && ok;
+}
+
+// ===== TEXT TRACES =====
+
+struct TextEvent {
+    uint32_t timeMs;
+    int line;
+    std::vector<std::string> words;
+};
+
+// Digital input as the contacts see it
+struct Contact {
+    bool level = false;
+    uint32_t bounceUntilMs = 0;
+};
+
+void setBit(uint16_t& mask, uint8_t bit, bool on) {
+    mask = on ? (mask | (1 << bit)) : (mask & ~(1 << bit));
+}
+
+/**
+ * @brief Build a binary trace from a text trace, one frame per tick
+ */
+bool encodeText(const char* path, std::vector<uint8_t>& trace) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "trace_replay: cannot open %s\n", path);
+        return false;
+    }
+
+    std::vector<TextEvent> events;
+    uint32_t endMs = 0;
+    bool hasEnd = false;
+    bool ok = true;
+    char buffer[256];
+    int line = 0;
+    while (fgets(buffer, sizeof(buffer), file)) {
+        line++;
+        std::string text(buffer);
+        size_t comment = text.find('#');
+        if (comment != std::string::npos) text.erase(comment);
+        std::vector<std::string> words = splitWords(text);
+        if (words.empty()) continue;
+        if (words.size() < 2) {
+            fprintf(stderr, "%s:%d: expected \"<ms> <command> ...\"\n", path, line);
+            ok = false;
+            continue;
+        }
+        TextEvent event{(uint32_t)strtoul(words[0].c_str(), nullptr, 0), line, {}};
+        event.words.assign(words.begin() + 1, words.end());
+        if (event.words[0] == "end") {
+            endMs = event.timeMs;
+            hasEnd = true;
+        } else {
+            events.push_back(event);
+        }
+    }
+    fclose(file);
+    if (!ok) return false;
+    std::stable_sort(events.begin(), events.end(),
+                     [](const TextEvent& a, const TextEvent& b) { return a.timeMs < b.timeMs; });
+    if (!hasEnd) endMs = events.empty() ? 500 : events.back().timeMs + 500;
+
+    // Contacts: buttons, then joystick, then switches
+    Contact contacts[BUTTON_COUNT + 4 + SWITCH_COUNT];
+    uint16_t potValue[POT_COUNT] = {};
+    uint16_t potNoise[POT_COUNT] = {};
+    uint32_t seed = 0x12345678;
+
+    const uint32_t ticks = endMs * 1000 / SCAN_PERIOD_US;
+    trace.assign(InputTraceRecorder::HEADER_SIZE + (size_t)ticks * (3 + POT_COUNT + 1) * 3 + 64, 0);
+    InputTraceRecorder recorder(trace.data(), trace.size());
+    recorder.begin(0);
+
+    size_t next = 0;
+    for (uint32_t tick = 0; tick < ticks; tick++) {
+        const uint32_t nowUs = tick * SCAN_PERIOD_US;
+        const uint32_t nowMs = nowUs / 1000;
+        while (next < events.size() && events[next].timeMs <= nowMs) {
+            const TextEvent& event = events[next++];
+            const std::vector<std::string>& w = event.words;
+            const std::string& command = w[0];
+            long index = w.size() > 1 ? strtol(w[1].c_str(), nullptr, 0) : -1;
+            int contact = -1;
+            if (command == "joystick" && w.size() > 1) {
+                const char* directions[] = {"up", "down", "left", "right"};
+                for (int d = 0; d < 4; d++) {
+                    if (w[1] == directions[d]) contact = BUTTON_COUNT + d;
+                }
+            } else if (command == "button" && index >= 0 && index < BUTTON_COUNT) {
+                contact = index;
+            } else if (command == "switch" && index >= 0 && index < SWITCH_COUNT) {
+                contact = BUTTON_COUNT + 4 + index;
+            }
+
+            if (contact >= 0 && w.size() > 2) {
+                contacts[contact].level = w[2] == "down" || w[2] == "on";
+                contacts[contact].bounceUntilMs =
+                    w.size() > 4 && w[3] == "bounce" ? nowMs + strtoul(w[4].c_str(), nullptr, 0) : 0;
+            } else if (command == "pot" && index >= 0 && index < POT_COUNT && w.size() > 2) {
+                potValue[index] = constrain(strtol(w[2].c_str(), nullptr, 0), 0L, 1023L);
+            } else if (command == "noise" && index >= 0 && index < POT_COUNT && w.size() > 2) {
+                potNoise[index] = strtoul(w[2].c_str(), nullptr, 0);
+            } else {
+                fprintf(stderr, "%s:%d: bad command\n", path, event.line);
+                return false;
+            }
+        }
+
+        RawInputFrame frame{};
+        for (int c = 0; c < BUTTON_COUNT + 4 + SWITCH_COUNT; c++) {
+            bool level = contacts[c].level;
+            if (nowMs < contacts[c].bounceUntilMs) level = tick & 1 ? level : !level;
+            if (c < BUTTON_COUNT) {
+                setBit(frame.buttons, c, level);
+            } else if (c < BUTTON_COUNT + 4) {
+                if (level) frame.joystick |= 1 << (c - BUTTON_COUNT);
+            } else {
+                setBit(frame.switches, c - BUTTON_COUNT - 4, level);
+            }
+        }
+        for (uint8_t i = 0; i < POT_COUNT; i++) {
+            int32_t value = potValue[i];
+            if (potNoise[i]) {
+                seed = seed * 1664525 + 1013904223;
+                value += (int32_t)((seed >> 16) % (2 * potNoise[i] + 1)) - potNoise[i];
+            }
+            frame.pots[i] = constrain(value, 0L, 1023L);
+        }
+        recorder.capture(frame, nowUs);
+    }
+    recorder.end(ticks * SCAN_PERIOD_US);
+    trace.resize(recorder.size());
+    return true;
+}
+
+// ===== REPLAY =====
+
+const char* midiTypeName(uint8_t type) {
+    switch (type) {
+        case sim::MIDI_NOTE_ON: return "note_on";
+        case sim::MIDI_NOTE_OFF: return "note_off";
+        case sim::MIDI_CONTROL_CHANGE: return "cc";
+        default: return "?";
+    }
+}
+
+// Raw digital gestures: changes that hold for GESTURE_MIN_MS
+class GestureCounter {
+public:
+    uint32_t presses = 0;    // Rising edges
+    uint32_t changes = 0;    // Both edges
+
+    void update(bool level, uint32_t nowMs) {
+        if (level != raw) {
+            raw = level;
+            since = nowMs;
+        }
+        if (raw != stable && nowMs - since >= GESTURE_MIN_MS) {
+            stable = raw;
+            changes++;
+            if (stable) presses++;
+        }
+    }
+
+private:
+    bool raw = false;
+    bool stable = false;
+    uint32_t since = 0;
+};
+
+std::string replay(const std::vector<uint8_t>& trace, const RuntimeConfig& config, bool& ok) {
+    std::string out;
+    char line[128];
+
+    InputTracePlayer player;
+    if (!player.begin(trace.data(), trace.size())) {
+        ok = false;
+        return out;
+    }
+
+    sim::reset();
+    sim::setMicros(REPLAY_START_US);
+
+    RobustInputProcessor processor;
+    MidiOut midiOut;
+    RobustMidiMapper mapper(processor, midiOut);
+    processor.begin();
+    processor.applyConfig(config);
+    processor.restart(player.getInitialFrame());
+    midiOut.begin();
+
+    GestureCounter buttons[BUTTON_COUNT];
+    GestureCounter joystick[4];
+    GestureCounter switches[SWITCH_COUNT];
+
+    // Replay at this build's scan rate, whatever rate the trace was taken at
+    RawInputFrame frame;
+    for (uint32_t elapsedUs = 0; player.advance(elapsedUs, frame); elapsedUs += SCAN_PERIOD_US) {
+        sim::setMicros(REPLAY_START_US + elapsedUs);
+        processor.update(frame);
+        mapper.processInputs();
+
+        const uint32_t nowMs = elapsedUs / 1000;
+        for (uint8_t i = 0; i < BUTTON_COUNT; i++) buttons[i].update((frame.buttons >> i) & 1, nowMs);
+        for (uint8_t i = 0; i < 4; i++) joystick[i].update((frame.joystick >> i) & 1, nowMs);
+        for (uint8_t i = 0; i < SWITCH_COUNT; i++) switches[i].update((frame.switches >> i) & 1, nowMs);
+    }
+
+    // MIDI stream
+    uint32_t noteOn = 0, noteOff = 0, cc = 0;
+    uint32_t potCcs[POT_COUNT] = {};
+    uint32_t joystickCcs = 0, switchCcs = 0;
+    for (const sim::MidiEvent& event : sim::midiOutput()) {
+        snprintf(line, sizeof(line), "%10.3f ms  %-8s ch%-2u %3u %3u\n",
+                 (event.timeUs - REPLAY_START_US) / 1000.0, midiTypeName(event.type),
+                 event.channel, event.data1, event.data2);
+        out += line;
+
+        if (event.type == sim::MIDI_NOTE_ON) noteOn++;
+        if (event.type == sim::MIDI_NOTE_OFF) noteOff++;
+        if (event.type != sim::MIDI_CONTROL_CHANGE) continue;
+        cc++;
+        for (uint8_t i = 0; i < POT_COUNT; i++) {
+            if (event.data1 == POT_CCS[i]) potCcs[i]++;
+        }
+        if (event.data1 >= JOY_UP_CC && event.data1 <= JOY_RIGHT_CC) joystickCcs++;
+        for (uint8_t i = 0; i < SWITCH_COUNT; i++) {
+            if (event.data1 == SWITCH_CCS[i]) switchCcs++;
+        }
+    }
+
+    // Metrics
+    uint32_t buttonPresses = 0, joystickPresses = 0, switchChanges = 0;
+    for (const GestureCounter& g : buttons) buttonPresses += g.presses;
+    for (const GestureCounter& g : joystick) joystickPresses += g.presses;
+    for (const GestureCounter& g : switches) switchChanges += g.changes;
+
+    const uint32_t total = noteOn + noteOff + cc;
+    const float seconds = player.getDurationUs() / 1e6f;
+    snprintf(line, sizeof(line), "# trace: %.3f s, tick %u us, replayed at %lu us\n",
+             seconds, player.getTickUs(), (unsigned long)SCAN_PERIOD_US);
+    out += line;
+    snprintf(line, sizeof(line), "# messages: %lu (note_on %lu, note_off %lu, cc %lu), %.1f/s\n",
+             (unsigned long)total, (unsigned long)noteOn, (unsigned long)noteOff,
+             (unsigned long)cc, seconds > 0 ? total / seconds : 0.0f);
+    out += line;
+    out += "# pot cc:";
+    for (uint8_t i = 0; i < POT_COUNT; i++) {
+        snprintf(line, sizeof(line), " %lu", (unsigned long)potCcs[i]);
+        out += line;
+    }
+    out += "\n";
+
+    auto gestureLine = [&](const char* name, uint32_t gestures, uint32_t messages) {
+        snprintf(line, sizeof(line), "# %s: %lu gestures -> %lu messages%s\n", name,
+                 (unsigned long)gestures, (unsigned long)messages,
+                 messages < gestures ? " (lost)" : "");
+        out += line;
+    };
+    gestureLine("buttons", buttonPresses, noteOn);
+    gestureLine("joystick", joystickPresses, joystickCcs);
+    gestureLine("switches", switchChanges, switchCcs);
+    return out;
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--golden" && hasValue) {
+            options.golden = argv[++i];
+        } else if (arg == "--encode" && hasValue) {
+            options.encode = argv[++i];
+        } else if (arg == "--update") {
+            options.update = true;
+        } else if (arg == "--quiet") {
+            options.quiet = true;
+        } else if (arg == "--debounce" && hasValue) {
+            options.config.debounceMs = strtoul(argv[++i], nullptr, 0);
+        } else if (arg == "--pot-deadband" && hasValue) {
+            options.config.potDeadband = strtoul(argv[++i], nullptr, 0);
+        } else if (arg == "--pot-rate-limit" && hasValue) {
+            options.config.potRateLimitMs = strtoul(argv[++i], nullptr, 0);
+        } else if (arg == "--rearm" && hasValue) {
+            options.config.joystickRearmMs = strtoul(argv[++i], nullptr, 0);
+        } else if (arg[0] != '-' && !options.trace) {
+            options.trace = argv[i];
+        } else {
+            fprintf(stderr, "trace_replay: unknown option %s\n", arg.c_str());
+            return false;
+        }
+    }
+    if (!options.trace || (options.update && !options.golden)) {
+        fprintf(stderr, "usage: trace_replay [--golden FILE [--update]] [--encode FILE] "
+                        "[--debounce MS] [--pot-deadband N] [--pot-rate-limit MS] [--rearm MS] "
+                        "[--quiet] <trace>\n");
+        return false;
+    }
+    return true;
+}
+
+bool isTextTrace(const char* path) {
+    std::string name(path);
+    return name.size() > 6 && name.compare(name.size() - 6, 6, ".trace") == 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) return 2;
+
+    std::vector<uint8_t> trace;
+    if (isTextTrace(options.trace)) {
+        if (!encodeText(options.trace, trace)) return 2;
+    } else if (!readFile(options.trace, trace)) {
+        fprintf(stderr, "trace_replay: cannot open %s\n", options.trace);
+        return 2;
+    }
+
+    if (options.encode && !writeFile(options.encode, trace.data(), trace.size())) {
+        fprintf(stderr, "trace_replay: cannot write %s\n", options.encode);
+        return 2;
+    }
+
+    bool ok = true;
+    const std::string output = replay(trace, options.config, ok);
+    if (!ok) {
+        fprintf(stderr, "trace_replay: %s is not a trace for this build\n", options.trace);
+        return 2;
+    }
+
+    if (options.quiet) {
+        for (size_t start = 0; start < output.size();) {
+            size_t end = output.find('\n', start);
+            if (output[start] == '#') fwrite(&output[start], 1, end - start + 1, stdout);
+            start = end + 1;
+        }
+    } else {
+        fwrite(output.data(), 1, output.size(), stdout);
+    }
+
+    if (!options.golden) return 0;
+
+    if (options.update) {
+        if (!writeFile(options.golden, output.data(), output.size())) {
+            fprintf(stderr, "trace_replay: cannot write %s\n", options.golden);
+            return 2;
+        }
+        printf("Updated %s\n", options.golden);
+        return 0;
+    }
+
+    // Golden diff: first differing line
+    std::vector<uint8_t> expected;
+    if (!readFile(options.golden, expected)) {
+        printf("FAIL no golden output %s (run with --update)\n", options.golden);
+        return 1;
+    }
+    const std::string golden(expected.begin(), expected.end());
+    if (golden == output) return 0;
+
+    size_t a = 0, b = 0;
+    int lineNumber = 1;
+    while (a < golden.size() && b < output.size()) {
+        size_t endA = golden.find('\n', a);
+        size_t endB = output.find('\n', b);
+        if (golden.compare(a, endA - a, output, b, endB - b) != 0) break;
+        a = endA + 1;
+        b = endB + 1;
+        lineNumber++;
+    }
+    printf("FAIL golden mismatch at line %d of %s\n", lineNumber, options.golden);
+    printf("  expected: %s\n", a < golden.size() ? golden.substr(a, golden.find('\n', a) - a).c_str() : "<end>");
+    printf("  actual:   %s\n", b < output.size() ? output.substr(b, output.find('\n', b) - b).c_str() : "<end>");
+    return 1;
+}
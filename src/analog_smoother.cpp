@@ -1,4 +1,5 @@
 #include "analog_smoother.h"
+#include "memory_placement.h"
 
 AnalogSmoother::AnalogSmoother(uint8_t alpha, uint8_t deadband, uint8_t rateLimitMs)
     : alpha(alpha)
@@ -13,7 +14,7 @@ AnalogSmoother::AnalogSmoother(uint8_t alpha, uint8_t deadband, uint8_t rateLimi
 {
 }
 
-bool AnalogSmoother::update(uint16_t rawValue, uint32_t timestampMs) {
+FASTRUN bool AnalogSmoother::update(uint16_t rawValue, uint32_t timestampMs) {
     significantChange = false;
     
     // Apply EMA filter using fixed-point arithmetic
@@ -0,0 +1,558 @@
+#include "cluster_link.h"
+#include "memory_placement.h"
+#include "serial_mux.h"
+#include "event_log.h"
+
+static_assert((CLUSTER_NODE_EVENTS & (CLUSTER_NODE_EVENTS - 1)) == 0 && CLUSTER_NODE_EVENTS <= 128,
+              "CLUSTER_NODE_EVENTS must be a power of two up to 128");
+static_assert(CLUSTER_MAX_NODES <= 8, "node masks are 8 bits");
+
+#if CLUSTER_ROLE != CLUSTER_STANDALONE
+extern PortalCueHandler portalCueHandler;
+extern RobustMidiMapper inputMapper;
+
+// Only the UART interrupts touch these, so cached OCRAM is fine
+DMAMEM static ClusterLink::Buffers clusterBuffers;
+#if FLIGHT_RECORDER > 0
+ClusterLink clusterLink(CLUSTER_ROLE, {&Serial5, CLUSTER_PORT_A_RX_PIN, CLUSTER_PORT_A_TX_PIN},
+                        {&Serial8, CLUSTER_PORT_B_RX_PIN, CLUSTER_PORT_B_TX_PIN}, inputMapper,
+                        portalCueHandler, &flightRecorder, &clusterBuffers);
+#else
+ClusterLink clusterLink(CLUSTER_ROLE, {&Serial5, CLUSTER_PORT_A_RX_PIN, CLUSTER_PORT_A_TX_PIN},
+                        {&Serial8, CLUSTER_PORT_B_RX_PIN, CLUSTER_PORT_B_TX_PIN}, inputMapper,
+                        portalCueHandler, nullptr, &clusterBuffers);
+#endif
+#endif
+
+namespace {
+
+const uint8_t JOYSTICK_PINS[4] = {JOYSTICK_UP, JOYSTICK_DOWN, JOYSTICK_LEFT, JOYSTICK_RIGHT};
+
+// Replies to cues applied on a secondary go nowhere
+class DiscardOutput : public Print {
+public:
+    size_t write(uint8_t) override { return 1; }
+    using Print::write;
+    int availableForWrite() override { return PORTAL_MSG_MAX_SIZE; }
+};
+
+DiscardOutput discardOutput;
+
+// Time for bytes to cross the chain at CLUSTER_BAUD (10 bits per byte)
+uint32_t wireUs(uint32_t bytes) {
+    return (uint32_t)((bytes * 10000000ULL) / CLUSTER_BAUD);
+}
+
+bool before(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) < 0;
+}
+
+void putU16(uint8_t* p, uint32_t value) {
+    if (value > 0xFFFF) value = 0xFFFF;
+    p[0] = value & 0xFF;
+    p[1] = value >> 8;
+}
+
+uint16_t getU16(const uint8_t* p) {
+    return p[0] | (p[1] << 8);
+}
+
+} // namespace
+
+// ===== FRAMES =====
+
+size_t ClusterFrameParser::encode(uint8_t type, uint8_t node, const uint8_t* payload, uint8_t length, uint8_t* out) {
+    out[0] = START_BYTE;
+    out[1] = type;
+    out[2] = node;
+    out[3] = length;
+    memcpy(out + 4, payload, length);
+    out[4 + length] = SerialMux::crc8(out + 1, length + 3);
+    return length + OVERHEAD;
+}
+
+bool ClusterFrameParser::receive(uint8_t byte) {
+    switch (state) {
+        case 0:
+            if (byte == START_BYTE) state = 1;
+            return false;
+        case 1:
+            current.type = byte;
+            state = 2;
+            return false;
+        case 2:
+            current.node = byte;
+            state = 3;
+            return false;
+        case 3:
+            current.length = byte;
+            received = 0;
+            state = byte > 0 ? 4 : 5;
+            return false;
+        case 4:
+            current.payload[received++] = byte;
+            if (received == current.length) state = 5;
+            return false;
+        default: {
+            state = 0;
+            // CRC over type, node, length and payload
+            uint8_t header[3] = {current.type, current.node, current.length};
+            uint8_t crc = SerialMux::crc8(header, 3);
+            for (uint8_t i = 0; i < current.length; i++) {
+                crc ^= current.payload[i];
+                for (uint8_t bit = 0; bit < 8; bit++) {
+                    crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+                }
+            }
+            if (crc != byte) {
+                crcErrors++;
+                return false;
+            }
+            return true;
+        }
+    }
+}
+
+// ===== MERGER =====
+
+ClusterMerger::ClusterMerger() {
+    reset();
+}
+
+void ClusterMerger::reset() {
+    for (Queue& queue : queues) {
+        queue.head = 0;
+        queue.tail = 0;
+        queue.watermark = 0;
+        queue.active = false;
+    }
+    lastReleased = 0;
+    released = false;
+    dropped = 0;
+    late = 0;
+    outOfOrder = 0;
+    maxDelayUs = 0;
+    maxDepth = 0;
+}
+
+bool ClusterMerger::push(const ClusterEvent& event) {
+    if (event.node >= CLUSTER_MAX_NODES) return false;
+    Queue& queue = queues[event.node];
+    const uint8_t depth = queue.head - queue.tail;
+    if (depth >= CLUSTER_NODE_EVENTS) {
+        dropped++;
+        return false;
+    }
+    queue.events[queue.head & (CLUSTER_NODE_EVENTS - 1)] = event;
+    queue.head++;
+    if (depth + 1 > maxDepth) maxDepth = depth + 1;
+    return true;
+}
+
+void ClusterMerger::advance(uint8_t node, uint32_t watermark) {
+    if (node < CLUSTER_MAX_NODES) queues[node].watermark = watermark;
+}
+
+void ClusterMerger::setActive(uint8_t node, bool active) {
+    if (node < CLUSTER_MAX_NODES) queues[node].active = active;
+}
+
+FASTRUN uint16_t ClusterMerger::release(uint32_t now, uint32_t windowUs, Sink sink, void* context) {
+    uint16_t count = 0;
+    for (;;) {
+        // Earliest head across all boards
+        int8_t first = -1;
+        uint32_t time = 0;
+        for (uint8_t n = 0; n < CLUSTER_MAX_NODES; n++) {
+            const Queue& queue = queues[n];
+            if (queue.head == queue.tail) continue;
+            const uint32_t t = queue.events[queue.tail & (CLUSTER_NODE_EVENTS - 1)].time;
+            if (first < 0 || before(t, time)) {
+                first = n;
+                time = t;
+            }
+        }
+        if (first < 0) break;
+
+        // Could an active board with nothing queued still send something earlier?
+        bool covered = true;
+        for (uint8_t n = 0; n < CLUSTER_MAX_NODES && covered; n++) {
+            const Queue& queue = queues[n];
+            if (n != first && queue.active && queue.head == queue.tail && before(queue.watermark, time)) {
+                covered = false;
+            }
+        }
+        const uint32_t age = now - time;
+        if (!covered) {
+            if ((int32_t)age < (int32_t)windowUs) break;
+            late++;
+        }
+
+        Queue& queue = queues[first];
+        const ClusterEvent event = queue.events[queue.tail & (CLUSTER_NODE_EVENTS - 1)];
+        queue.tail++;
+        if (released && before(time, lastReleased)) outOfOrder++;
+        lastReleased = time;
+        released = true;
+        if ((int32_t)age > 0 && age > maxDelayUs) maxDelayUs = age;
+        sink(event, context);
+        count++;
+    }
+    return count;
+}
+
+// ===== LINK =====
+
+ClusterLink::ClusterLink(uint8_t role, const Port& portA, const Port& portB, RobustMidiMapper& mapper,
+                         PortalCueHandler& cues, FlightRecorder* events, Buffers* buffers)
+    : role(role)
+    , portA(portA)
+    , portB(portB)
+    , mapper(mapper)
+    , cues(cues)
+    , events(events)
+    , buffers(buffers)
+    , capacityA(0)
+    , capacityB(0)
+    , started(false)
+    , nodeId(0)
+    , ignoredButtons(0)
+    , ignoredSwitches(0)
+    , ignoredJoystick(0)
+    , lastButtons(0)
+    , lastSwitches(0)
+    , pendingHead(0)
+    , pendingTail(0)
+    , lastSendUs(0)
+    , lastPollA(0)
+    , lastPollB(0)
+    , activeNodes(0)
+    , lastEnumerateMs(0)
+    , framesSent(0)
+    , framesReceived(0)
+    , eventsSent(0)
+    , eventsMerged(0)
+    , eventsDropped(0)
+    , framesForwarded(0)
+    , forwardDrops(0)
+    , cuesForwarded(0)
+    , maxTransitUs(0)
+    , pendingPeak(0)
+{
+    memset(lastPots, 0, sizeof(lastPots));
+    memset(lastFrameMs, 0, sizeof(lastFrameMs));
+}
+
+FLASHMEM void ClusterLink::begin() {
+    const bool secondary = role == CLUSTER_SECONDARY;
+
+    portA.serial->begin(CLUSTER_BAUD);
+    portA.serial->addMemoryForRead(buffers->rxA, sizeof(buffers->rxA));
+    portA.serial->addMemoryForWrite(buffers->txA, sizeof(buffers->txA));
+    capacityA = portA.serial->availableForWrite();
+    if (secondary) {
+        portB.serial->begin(CLUSTER_BAUD);
+        portB.serial->addMemoryForRead(buffers->rxB, sizeof(buffers->rxB));
+        portB.serial->addMemoryForWrite(buffers->txB, sizeof(buffers->txB));
+        capacityB = portB.serial->availableForWrite();
+    }
+
+    // Inputs wired to pins the chain took read UART traffic, not a player
+    auto claimed = [&](uint8_t pin) {
+        return pin == portA.rxPin || pin == portA.txPin ||
+               (secondary && (pin == portB.rxPin || pin == portB.txPin));
+    };
+    for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+        if (claimed(BUTTON_PINS[i])) ignoredButtons |= 1 << i;
+    }
+    for (uint8_t i = 0; i < SWITCH_COUNT; i++) {
+        if (claimed(SWITCH_PINS[i])) ignoredSwitches |= 1 << i;
+    }
+    for (uint8_t i = 0; i < 4; i++) {
+        if (claimed(JOYSTICK_PINS[i])) ignoredJoystick |= 1 << i;
+    }
+
+    lastPollA = micros();
+    lastPollB = lastPollA;
+    if (role == CLUSTER_PRIMARY) {
+        merger.setActive(0, true);
+        cues.setCueListener(onCue, this);
+    }
+    started = true;
+
+    Serial.printf("Cluster: %s at %lu baud, ignoring buttons 0x%03X switches 0x%03X joystick 0x%X\n",
+                  secondary ? "secondary" : "primary", (unsigned long)CLUSTER_BAUD,
+                  ignoredButtons, ignoredSwitches, ignoredJoystick);
+}
+
+// ===== CAPTURE =====
+
+FASTRUN void ClusterLink::queueEvent(uint8_t type, uint8_t index, uint8_t value, uint32_t time) {
+    if (role == CLUSTER_PRIMARY) {
+        merger.push({time, 0, type, index, value});
+        return;
+    }
+    const uint8_t depth = pendingHead - pendingTail;
+    if (depth >= CLUSTER_NODE_EVENTS) {
+        eventsDropped++;
+        return;
+    }
+    pending[pendingHead & (CLUSTER_NODE_EVENTS - 1)] = {time, 0, type, index, value};
+    pendingHead++;
+    if (depth + 1 > pendingPeak) pendingPeak = depth + 1;
+}
+
+FASTRUN void ClusterLink::captureInputs(const InputProcessor& inputs, uint32_t tickStart) {
+    for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+        const uint16_t bit = 1 << i;
+        const bool pressed = inputs.getButtonState(i);
+        if ((ignoredButtons & bit) || pressed == ((lastButtons & bit) != 0)) continue;
+        lastButtons ^= bit;
+        queueEvent(CLUSTER_BUTTON, i, pressed, tickStart);
+    }
+    for (uint8_t i = 0; i < POT_COUNT; i++) {
+        const uint8_t value = inputs.getPotMidiValue(i);
+        if (!inputs.getPotChanged(i) || value == lastPots[i]) continue;
+        lastPots[i] = value;
+        queueEvent(CLUSTER_POT, i, value, tickStart);
+    }
+    for (uint8_t i = 0; i < 4; i++) {
+        if (!(ignoredJoystick & (1 << i)) && inputs.getJoystickPressed(i)) {
+            queueEvent(CLUSTER_JOYSTICK, i, 1, tickStart);
+        }
+    }
+    for (uint8_t i = 0; i < SWITCH_COUNT; i++) {
+        const uint16_t bit = 1 << i;
+        const bool on = inputs.getSwitchState(i);
+        if ((ignoredSwitches & bit) || on == ((lastSwitches & bit) != 0)) continue;
+        lastSwitches ^= bit;
+        queueEvent(CLUSTER_SWITCH, i, on, tickStart);
+    }
+
+    if (role == CLUSTER_PRIMARY) {
+        // Everything of ours up to this tick is in
+        merger.advance(0, tickStart);
+        merger.release(micros(), CLUSTER_MERGE_WINDOW_US, onRelease, this);
+    } else if (started) {
+        sendEvents(micros());
+    }
+}
+
+// ===== SEND =====
+
+bool ClusterLink::writeFrame(HardwareSerial& serial, uint16_t capacity, uint8_t type, uint8_t node,
+                             uint8_t* payload, uint8_t length, uint32_t transitUs, bool wait) {
+    const int space = serial.availableForWrite();
+    if (space < length + ClusterFrameParser::OVERHEAD) {
+        if (!wait) forwardDrops++;
+        return false;
+    }
+    if (type == FRAME_EVENTS) {
+        // Until the last byte is at the next board: what is queued ahead, then this frame
+        const uint32_t queued = capacity > space ? capacity - space : 0;
+        putU16(payload, transitUs + wireUs(queued + length + ClusterFrameParser::OVERHEAD));
+    }
+    uint8_t frame[255 + ClusterFrameParser::OVERHEAD];
+    serial.write(frame, ClusterFrameParser::encode(type, node, payload, length, frame));
+    return true;
+}
+
+bool ClusterLink::sendEvents(uint32_t now) {
+    if (nodeId == 0) return false;  // Not enumerated yet
+
+    uint8_t count = pendingHead - pendingTail;
+    if (count == 0 && now - lastSendUs < CLUSTER_KEEPALIVE_US) return false;
+    if (count > FRAME_EVENTS_MAX) count = FRAME_EVENTS_MAX;
+
+    uint8_t payload[2 + FRAME_EVENTS_MAX * EVENT_BYTES];
+    for (uint8_t i = 0; i < count; i++) {
+        const ClusterEvent& event = pending[(pendingTail + i) & (CLUSTER_NODE_EVENTS - 1)];
+        uint8_t* p = payload + 2 + i * EVENT_BYTES;
+        putU16(p, now - event.time);
+        p[2] = event.type;
+        p[3] = event.index;
+        p[4] = event.value;
+    }
+    if (!writeFrame(*portA.serial, capacityA, FRAME_EVENTS, nodeId, payload,
+                    2 + count * EVENT_BYTES, 0, true)) {
+        return false;  // Link busy: the events wait (and age) for the next period
+    }
+    pendingTail += count;
+    lastSendUs = now;
+    framesSent++;
+    eventsSent += count;
+    return pendingHead != pendingTail;
+}
+
+void ClusterLink::forwardCue(const PortalMessage& message) {
+    uint8_t payload[PORTAL_MSG_MIN_SIZE];
+    message.toBytes(payload);
+    if (writeFrame(*portA.serial, capacityA, FRAME_CUE, 0, payload, sizeof(payload), 0, false)) {
+        framesSent++;
+        cuesForwarded++;
+    }
+}
+
+void ClusterLink::onCue(const PortalMessage& message, void* context) {
+    static_cast<ClusterLink*>(context)->forwardCue(message);
+}
+
+// ===== RECEIVE =====
+
+void ClusterLink::receive(HardwareSerial& serial, ClusterFrameParser& parser, bool fromA) {
+    uint32_t& lastPoll = fromA ? lastPollA : lastPollB;
+
+    // Bounded per poll; the rest stays in the receive buffer
+    for (uint16_t n = 1; n <= CLUSTER_UART_BUFFER && serial.available() > 0; n++) {
+        if (!parser.receive(serial.read())) continue;
+
+        // The frame ended before whatever arrived after it, and after the
+        // n bytes read so far had arrived since the last poll
+        const uint32_t latest = micros() - wireUs(serial.available());
+        const uint32_t earliest = lastPoll + wireUs(n);
+        const uint32_t arrival = before(earliest, latest) ? earliest + (latest - earliest) / 2 : latest;
+        framesReceived++;
+        handleFrame(parser.frame(), arrival, fromA);
+    }
+    lastPoll = micros() - wireUs(serial.available());
+}
+
+void ClusterLink::handleFrame(const ClusterFrameParser::Frame& frame, uint32_t arrival, bool fromA) {
+    if (role == CLUSTER_PRIMARY) {
+        if (frame.type == FRAME_EVENTS && frame.length >= 2) mergeFrame(frame, arrival);
+        return;
+    }
+
+    // Secondary
+    ClusterFrameParser::Frame copy = frame;
+    if (fromA) {
+        // From the primary's side: apply, then pass on down
+        if (frame.type == FRAME_ENUMERATE) {
+            if (frame.node != nodeId) {
+                LOG_EVENT(LOG_CLUSTER_ENUMERATED, frame.node, nodeId);
+                nodeId = frame.node;
+            }
+            copy.node = frame.node + 1;
+            if (copy.node >= CLUSTER_MAX_NODES) return;
+        } else if (frame.type == FRAME_CUE && frame.length == PORTAL_MSG_MIN_SIZE) {
+            cues.receiveMessage(PortalMessage::fromBytes(frame.payload), discardOutput);
+        }
+        if (writeFrame(*portB.serial, capacityB, copy.type, copy.node, copy.payload, copy.length, 0, false)) {
+            framesForwarded++;
+        }
+    } else if (frame.type == FRAME_EVENTS && frame.length >= 2) {
+        // From further down: on toward the primary, with the time it spent here
+        const uint32_t transit = getU16(frame.payload) + (micros() - arrival);
+        if (writeFrame(*portA.serial, capacityA, copy.type, copy.node, copy.payload, copy.length,
+                       transit, false)) {
+            framesForwarded++;
+        }
+    }
+}
+
+void ClusterLink::mergeFrame(const ClusterFrameParser::Frame& frame, uint32_t arrival) {
+    const uint8_t node = frame.node;
+    if (node == 0 || node >= CLUSTER_MAX_NODES) return;
+
+    // When the sender wrote the frame, on this board's clock
+    const uint32_t written = arrival - getU16(frame.payload);
+    lastFrameMs[node] = millis();
+    if (!merger.isActive(node)) {
+        merger.setActive(node, true);
+        activeNodes |= 1 << node;
+        LOG_EVENT(LOG_CLUSTER_NODE_JOINED, node);
+    }
+
+    const uint8_t count = (frame.length - 2) / EVENT_BYTES;
+    for (uint8_t i = 0; i < count; i++) {
+        const uint8_t* p = frame.payload + 2 + i * EVENT_BYTES;
+        const ClusterEvent event = {written - getU16(p), node, p[2], p[3], p[4]};
+        const uint32_t transit = micros() - event.time;
+        if (transit > maxTransitUs) maxTransitUs = transit;
+        merger.push(event);
+    }
+    merger.advance(node, written);
+}
+
+// ===== PRIMARY =====
+
+void ClusterLink::checkNodes(uint32_t nowMs) {
+    for (uint8_t n = 1; n < CLUSTER_MAX_NODES; n++) {
+        if (!(activeNodes & (1 << n)) || nowMs - lastFrameMs[n] <= CLUSTER_NODE_TIMEOUT_MS) continue;
+
+        // Gone: stop waiting for it and let go of its notes
+        activeNodes &= ~(1 << n);
+        merger.setActive(n, false);
+        mapper.releaseChannel(MIDI_CHANNEL + n);
+        LOG_EVENT(LOG_CLUSTER_NODE_LOST, n, min(nowMs - lastFrameMs[n], (uint32_t)0xFFFF));
+    }
+}
+
+void ClusterLink::onRelease(const ClusterEvent& event, void* context) {
+    static_cast<ClusterLink*>(context)->play(event);
+}
+
+FASTRUN void ClusterLink::play(const ClusterEvent& event) {
+    const uint8_t channel = MIDI_CHANNEL + event.node;
+    eventsMerged++;
+
+    if (events && event.node != 0) {
+        events->recordAt(event.time, FLIGHT_REMOTE, event.node << 4 | event.type,
+                         event.index | event.value << 8);
+    }
+
+    switch (event.type) {
+        case CLUSTER_BUTTON:   mapper.sendButton(event.index, event.value, channel); break;
+        case CLUSTER_POT:      mapper.sendPot(event.index, event.value, channel); break;
+        case CLUSTER_JOYSTICK: mapper.sendJoystick(event.index, channel); break;
+        case CLUSTER_SWITCH:   mapper.sendSwitch(event.index, event.value, channel); break;
+    }
+}
+
+// ===== TASK =====
+
+bool ClusterLink::poll() {
+    if (!started) return false;
+    const uint32_t now = micros();
+
+    if (role == CLUSTER_PRIMARY) {
+        receive(*portA.serial, parserA, true);
+
+        const uint32_t nowMs = millis();
+        if (nowMs - lastEnumerateMs >= CLUSTER_ENUMERATE_MS) {
+            lastEnumerateMs = nowMs;
+            if (writeFrame(*portA.serial, capacityA, FRAME_ENUMERATE, 1, nullptr, 0, 0, false)) {
+                framesSent++;
+            }
+        }
+        checkNodes(nowMs);
+        merger.release(micros(), CLUSTER_MERGE_WINDOW_US, onRelease, this);
+        mapper.flushSwitchBanks(nowMs);
+        return false;
+    }
+
+    receive(*portA.serial, parserA, true);
+    receive(*portB.serial, parserB, false);
+    return sendEvents(now);
+}
+
+FLASHMEM void ClusterLink::printStats(Print& out) const {
+    if (role == CLUSTER_PRIMARY) {
+        out.printf("=== CLUSTER PRIMARY: boards 0x%02X ===\n", activeNodes);
+        out.printf("Frames: %lu in, %lu out, %lu CRC errors; events merged %lu, worst transit %lu us\n",
+                   (unsigned long)framesReceived, (unsigned long)framesSent, (unsigned long)getCrcErrors(),
+                   (unsigned long)eventsMerged, (unsigned long)maxTransitUs);
+        out.printf("Cues: %lu passed down\n", (unsigned long)cuesForwarded);
+        out.printf("Merge: worst delay %lu us, %lu by window, %lu out of order, %lu dropped, queue peak %u/%u\n",
+                   (unsigned long)merger.getMaxDelayUs(), (unsigned long)merger.getLate(),
+                   (unsigned long)merger.getOutOfOrder(), (unsigned long)merger.getDropped(),
+                   merger.getMaxDepth(), CLUSTER_NODE_EVENTS);
+    } else {
+        out.printf("=== CLUSTER SECONDARY: board %u ===\n", nodeId);
+        out.printf("Frames: %lu in, %lu out, %lu forwarded, %lu forward drops, %lu CRC errors\n",
+                   (unsigned long)framesReceived, (unsigned long)framesSent, (unsigned long)framesForwarded,
+                   (unsigned long)forwardDrops, (unsigned long)getCrcErrors());
+        out.printf("Events: %lu sent, %lu dropped, queue peak %u/%u\n", (unsigned long)eventsSent,
+                   (unsigned long)eventsDropped, pendingPeak, CLUSTER_NODE_EVENTS);
+    }
+}
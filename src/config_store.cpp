@@ -0,0 +1,278 @@
+#include "config_store.h"
+#include "memory_placement.h"
+
+#ifdef __IMXRT1062__
+#include <EEPROM.h>
+#endif
+
+static_assert(sizeof(RuntimeConfig) <= CONFIG_MAX_PAYLOAD, "RuntimeConfig exceeds CONFIG_MAX_PAYLOAD");
+
+ConfigStore configStore;
+
+// Indexed by ConfigParam
+static const ConfigStore::ParamInfo PARAM_INFO[CONFIG_PARAM_COUNT] = {
+    {"debounce_ms",        0,     50,      1},
+    {"pot_deadband",       0,     16,      1},
+    {"pot_rate_limit_ms",  0,     255,     1},
+    {"idle_timeout_ms",    1000,  1800000, 1000},
+    {"joystick_rearm_ms",  0,     1000,    4},
+    {"led_brightness_max", 1,     255,     1},
+    {"switch_snapshot",    0,     2,       1},
+    {"led_power_budget",   0,     25000,   100}
+};
+
+ConfigStore::ConfigStore()
+    : active(defaults())
+    , pending(defaults())
+    , pendingChanged(false)
+    , saveRequested(false)
+    , loaded(false)
+    , saveCount(0)
+{
+}
+
+RuntimeConfig ConfigStore::defaults() {
+    RuntimeConfig config = {};
+    config.idleTimeoutMs = IDLE_TIMEOUT_MS;
+    config.joystickRearmMs = JOYSTICK_REARM_MS;
+    config.debounceMs = DEBOUNCE_MS;
+    config.potDeadband = POT_DEADBAND;
+    config.potRateLimitMs = POT_RATE_LIMIT_MS;
+    config.ledBrightnessMax = LED_BRIGHTNESS_MAX;
+    config.switchSnapshot = SWITCH_SNAPSHOT;
+    config.ledPowerBudgetMa = LED_POWER_BUDGET_MA;
+    return config;
+}
+
+const ConfigStore::ParamInfo& ConfigStore::getParamInfo(ConfigParam param) {
+    return PARAM_INFO[param < CONFIG_PARAM_COUNT ? param : 0];
+}
+
+FLASHMEM bool ConfigStore::begin() {
+    uint8_t block[HEADER_SIZE + CONFIG_MAX_PAYLOAD + 4];
+    #ifdef __IMXRT1062__
+    for (size_t i = 0; i < sizeof(block); i++) {
+        block[i] = EEPROM.read(CONFIG_EEPROM_ADDRESS + i);
+    }
+    #else
+    memset(block, 0xFF, sizeof(block));  // Host builds: erased EEPROM
+    #endif
+
+    loaded = decode(block, sizeof(block));
+
+    #if DEBUG >= 1
+    Serial.println(loaded ? "Config: loaded from EEPROM" : "Config: no valid EEPROM block, using defaults");
+    print(Serial);
+    #endif
+    return loaded;
+}
+
+bool ConfigStore::setValue(ConfigParam param, uint32_t value) {
+    if (param >= CONFIG_PARAM_COUNT) return false;
+    const ParamInfo& info = PARAM_INFO[param];
+    if (value < info.minValue || value > info.maxValue) return false;
+
+    writeField(pending, param, value);
+    pendingChanged = true;
+    return true;
+}
+
+uint32_t ConfigStore::getValue(ConfigParam param) const {
+    if (param >= CONFIG_PARAM_COUNT) return 0;
+    return readField(pending, param);
+}
+
+void ConfigStore::restoreDefaults() {
+    pending = defaults();
+    pendingChanged = true;
+}
+
+bool ConfigStore::applyPending() {
+    if (!pendingChanged) return false;
+    pendingChanged = false;
+
+    bool changed = memcmp(&active, &pending, sizeof(RuntimeConfig)) != 0;
+    active = pending;
+    return changed;
+}
+
+bool ConfigStore::saveIfRequested() {
+    if (!saveRequested) return false;
+    saveRequested = false;
+
+    uint8_t block[BLOCK_SIZE];
+    encode(block);
+    #ifdef __IMXRT1062__
+    // EEPROM.update() skips unchanged bytes, so repeated saves cost no flash wear
+    for (size_t i = 0; i < sizeof(block); i++) {
+        EEPROM.update(CONFIG_EEPROM_ADDRESS + i, block[i]);
+    }
+    #endif
+    saveCount++;
+
+    #if DEBUG >= 1
+    Serial.println("Config: saved to EEPROM");
+    #endif
+    return true;
+}
+
+uint32_t ConfigStore::fromWire(ConfigParam param, uint8_t value) {
+    return (uint32_t)value * getParamInfo(param).wireUnit;
+}
+
+uint8_t ConfigStore::toWire(ConfigParam param, uint32_t value) {
+    uint32_t wire = value / getParamInfo(param).wireUnit;
+    return wire < 255 ? (uint8_t)wire : 255;
+}
+
+void ConfigStore::encode(uint8_t* out) const {
+    const uint32_t magic = MAGIC;
+    memcpy(out, &magic, 4);
+    out[4] = VERSION;
+    out[5] = sizeof(RuntimeConfig);
+    out[6] = 0;
+    out[7] = 0;
+    memcpy(out + HEADER_SIZE, &active, sizeof(RuntimeConfig));
+
+    uint32_t sum = checksum(out, HEADER_SIZE + sizeof(RuntimeConfig));
+    memcpy(out + HEADER_SIZE + sizeof(RuntimeConfig), &sum, 4);
+}
+
+bool ConfigStore::decode(const uint8_t* block, size_t length) {
+    RuntimeConfig config = defaults();
+    bool valid = false;
+
+    uint32_t magic;
+    memcpy(&magic, block, 4);
+    const uint8_t payloadSize = block[5];
+    if (magic == MAGIC && block[4] >= 1 && payloadSize <= CONFIG_MAX_PAYLOAD &&
+        (size_t)HEADER_SIZE + payloadSize + 4 <= length) {
+        uint32_t stored;
+        memcpy(&stored, block + HEADER_SIZE + payloadSize, 4);
+        valid = stored == checksum(block, HEADER_SIZE + payloadSize);
+    }
+
+    if (valid) {
+        // Older blocks are shorter: their fields over the defaults
+        RuntimeConfig stored = config;
+        size_t n = payloadSize < sizeof(RuntimeConfig) ? payloadSize : sizeof(RuntimeConfig);
+        memcpy(&stored, block + HEADER_SIZE, n);
+
+        for (uint8_t i = 0; i < CONFIG_PARAM_COUNT; i++) {
+            ConfigParam param = static_cast<ConfigParam>(i);
+            uint32_t value = readField(stored, param);
+            if (value >= PARAM_INFO[i].minValue && value <= PARAM_INFO[i].maxValue) {
+                writeField(config, param, value);
+            }
+        }
+    }
+
+    active = config;
+    pending = config;
+    pendingChanged = false;
+    return valid;
+}
+
+size_t ConfigStore::handleSysEx(const uint8_t* data, size_t length, uint8_t* reply) {
+    if (length < 5 || data[0] != 0xF0 || data[length - 1] != 0xF7 ||
+        data[1] != SYSEX_MANUFACTURER || data[2] != SYSEX_DEVICE) {
+        return 0;
+    }
+
+    const uint8_t type = data[3];
+    const uint8_t* body = data + 4;
+    const size_t bodyLength = length - 5;
+
+    switch (type) {
+        case SYSEX_SET:
+        case SYSEX_GET: {
+            if (bodyLength != (type == SYSEX_SET ? 4u : 1u)) break;
+            ConfigParam param = static_cast<ConfigParam>(body[0]);
+            if (param >= CONFIG_PARAM_COUNT) break;
+            if (type == SYSEX_SET) {
+                uint32_t value = ((uint32_t)body[1] << 14) | ((uint32_t)body[2] << 7) | body[3];
+                if (!setValue(param, value)) break;
+            }
+            uint32_t value = getValue(param);
+            uint8_t payload[4] = {
+                (uint8_t)param,
+                (uint8_t)((value >> 14) & 0x7F),
+                (uint8_t)((value >> 7) & 0x7F),
+                (uint8_t)(value & 0x7F)
+            };
+            return sysExReply(reply, SYSEX_VALUE, payload, sizeof(payload));
+        }
+
+        case SYSEX_SAVE:
+            if (bodyLength != 0) break;
+            requestSave();
+            return sysExReply(reply, SYSEX_OK, nullptr, 0);
+
+        case SYSEX_DEFAULTS:
+            if (bodyLength != 0) break;
+            restoreDefaults();
+            return sysExReply(reply, SYSEX_OK, nullptr, 0);
+
+        default:
+            break;
+    }
+    return sysExReply(reply, SYSEX_ERROR, nullptr, 0);
+}
+
+FLASHMEM void ConfigStore::print(Print& out) const {
+    for (uint8_t i = 0; i < CONFIG_PARAM_COUNT; i++) {
+        out.printf("  %-18s %lu\n", PARAM_INFO[i].name,
+                   (unsigned long)readField(active, static_cast<ConfigParam>(i)));
+    }
+}
+
+uint32_t ConfigStore::readField(const RuntimeConfig& config, ConfigParam param) {
+    switch (param) {
+        case CONFIG_DEBOUNCE_MS: return config.debounceMs;
+        case CONFIG_POT_DEADBAND: return config.potDeadband;
+        case CONFIG_POT_RATE_LIMIT_MS: return config.potRateLimitMs;
+        case CONFIG_IDLE_TIMEOUT_MS: return config.idleTimeoutMs;
+        case CONFIG_JOYSTICK_REARM_MS: return config.joystickRearmMs;
+        case CONFIG_LED_BRIGHTNESS_MAX: return config.ledBrightnessMax;
+        case CONFIG_SWITCH_SNAPSHOT: return config.switchSnapshot;
+        case CONFIG_LED_POWER_BUDGET_MA: return config.ledPowerBudgetMa;
+        default: return 0;
+    }
+}
+
+void ConfigStore::writeField(RuntimeConfig& config, ConfigParam param, uint32_t value) {
+    // Callers range-check against PARAM_INFO, which fits every field
+    switch (param) {
+        case CONFIG_DEBOUNCE_MS: config.debounceMs = (uint8_t)value; break;
+        case CONFIG_POT_DEADBAND: config.potDeadband = (uint8_t)value; break;
+        case CONFIG_POT_RATE_LIMIT_MS: config.potRateLimitMs = (uint8_t)value; break;
+        case CONFIG_IDLE_TIMEOUT_MS: config.idleTimeoutMs = value; break;
+        case CONFIG_JOYSTICK_REARM_MS: config.joystickRearmMs = (uint16_t)value; break;
+        case CONFIG_LED_BRIGHTNESS_MAX: config.ledBrightnessMax = (uint8_t)value; break;
+        case CONFIG_SWITCH_SNAPSHOT: config.switchSnapshot = (uint8_t)value; break;
+        case CONFIG_LED_POWER_BUDGET_MA: config.ledPowerBudgetMa = (uint16_t)value; break;
+        default: break;
+    }
+}
+
+uint32_t ConfigStore::checksum(const uint8_t* data, size_t length) {
+    // FNV-1a
+    uint32_t hash = 2166136261UL;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ data[i]) * 16777619UL;
+    }
+    return hash;
+}
+
+size_t ConfigStore::sysExReply(uint8_t* reply, uint8_t type, const uint8_t* payload, size_t length) {
+    size_t n = 0;
+    reply[n++] = 0xF0;
+    reply[n++] = SYSEX_MANUFACTURER;
+    reply[n++] = SYSEX_DEVICE;
+    reply[n++] = type;
+    for (size_t i = 0; i < length; i++) {
+        reply[n++] = payload[i];
+    }
+    reply[n++] = 0xF7;
+    return n;
+}
@@ -1,4 +1,5 @@
 #include "debouncer.h"
+#include "memory_placement.h"
 
 Debouncer::Debouncer(uint8_t debounceMs) 
     : debounceMs(debounceMs)
@@ -9,7 +10,7 @@ Debouncer::Debouncer(uint8_t debounceMs)
 {
 }
 
-bool Debouncer::update(bool currentState, uint32_t timestampMs) {
+FASTRUN bool Debouncer::update(bool currentState, uint32_t timestampMs) {
     stateChanged = false;
     
     // Check if raw state has changed
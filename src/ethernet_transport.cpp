@@ -0,0 +1,301 @@
+#include "ethernet_transport.h"
+#include "memory_placement.h"
+
+static_assert((ETHERNET_TX_PACKETS & (ETHERNET_TX_PACKETS - 1)) == 0,
+              "ETHERNET_TX_PACKETS must be a power of two");
+
+#if ETHERNET_OSC > 0
+extern PortalCueHandler portalCueHandler;
+extern PortalController portalController;
+
+// Read by the CPU when the stack copies a packet out, so cached OCRAM is fine
+DMAMEM static EthernetTransport::Packet ethernetPackets[ETHERNET_TX_PACKETS];
+#if FLIGHT_RECORDER > 0
+EthernetTransport ethernetTransport(portalCueHandler, portalController, &flightRecorder, ethernetPackets);
+#else
+EthernetTransport ethernetTransport(portalCueHandler, portalController, nullptr, ethernetPackets);
+#endif
+#endif
+
+namespace {
+
+// Cue commands by OSC address; the argument (if any) is the protocol value
+struct OscCue {
+    const char* address;
+    PortalSerialCommand command;
+};
+
+const OscCue OSC_CUES[] = {
+    {"/portal/program", PortalSerialCommand::SET_PROGRAM},
+    {"/portal/bpm", PortalSerialCommand::SET_BPM},
+    {"/portal/intensity", PortalSerialCommand::SET_INTENSITY},
+    {"/portal/hue", PortalSerialCommand::SET_HUE},
+    {"/portal/brightness", PortalSerialCommand::SET_BRIGHTNESS},
+    {"/portal/flash", PortalSerialCommand::TRIGGER_FLASH},
+    {"/portal/ripple", PortalSerialCommand::TRIGGER_RIPPLE},
+    {"/ping", PortalSerialCommand::PING},
+};
+
+// Flight recorder entries forwarded as events, by FlightEventType
+const char* const EVENT_ADDRESSES[] = {
+    nullptr,             // 0
+    nullptr,             // FLIGHT_BOOT
+    "/input/button",
+    "/input/joystick",
+    "/input/switch",
+    "/input/pot",
+    "/midi/note_on",
+    "/midi/note_off",
+    "/midi/cc",
+    nullptr,             // FLIGHT_FRAME_RX
+    nullptr,             // FLIGHT_FRAME_BAD
+    nullptr,             // FLIGHT_FRAME_TX
+    nullptr,             // FLIGHT_TICK
+    nullptr,             // FLIGHT_GAP
+    nullptr,             // FLIGHT_REMOTE
+    "/input/health",
+};
+
+} // namespace
+
+EthernetTransport::EthernetTransport(PortalCueHandler& cues, PortalController& portal,
+                                     FlightRecorder* events, Packet* packets)
+    : cues(cues)
+    , portal(portal)
+    , events(events)
+    , packets(packets)
+    , replies(*this)
+    , udp(ETHERNET_RX_QUEUE)
+    , started(false)
+    , peerPort(0)
+    , peerActive(false)
+    , lastReceiveMs(0)
+    , lastTelemetryMs(0)
+    , writer(nullptr, 0)
+    , packetOpen(false)
+    , txHead(0)
+    , txTail(0)
+    , readSequence(0)
+    , maxTickUs(0)
+    , rxPackets(0)
+    , rxMessages(0)
+    , rxMalformed(0)
+    , rxUnknown(0)
+    , txPackets(0)
+    , txBytes(0)
+    , txRetries(0)
+    , eventsDropped(0)
+    , maxQueued(0)
+{
+}
+
+FLASHMEM bool EthernetTransport::begin() {
+    using qindesign::network::Ethernet;
+
+    const bool dhcp = ETHERNET_IP[0] == 0 && ETHERNET_IP[1] == 0 && ETHERNET_IP[2] == 0 && ETHERNET_IP[3] == 0;
+    const bool ok = dhcp ? Ethernet.begin()
+                         : Ethernet.begin(IPAddress(ETHERNET_IP), IPAddress(ETHERNET_NETMASK),
+                                          IPAddress(ETHERNET_GATEWAY));
+    if (!ok || !udp.begin(ETHERNET_OSC_PORT)) {
+        Serial.println("Ethernet OSC: interface not available");
+        return false;
+    }
+    started = true;
+    if (dhcp) {
+        Serial.printf("Ethernet OSC: DHCP, UDP port %u\n", ETHERNET_OSC_PORT);
+    } else {
+        Serial.printf("Ethernet OSC: %u.%u.%u.%u UDP port %u\n", ETHERNET_IP[0], ETHERNET_IP[1],
+                      ETHERNET_IP[2], ETHERNET_IP[3], ETHERNET_OSC_PORT);
+    }
+    return true;
+}
+
+// ===== RECEIVE =====
+
+size_t EthernetTransport::ReplyOutput::write(uint8_t b) {
+    frame[length++] = b;
+    if (length == sizeof(frame)) {
+        const int32_t args[2] = {frame[1], frame[2]};
+        transport.queueMessage("/portal/reply", args, 2);
+        length = 0;
+    }
+    return 1;
+}
+
+void EthernetTransport::onMessage(const OscMessage& message, void* context) {
+    static_cast<EthernetTransport*>(context)->handleMessage(message);
+}
+
+void EthernetTransport::dispatch(uint8_t command, int32_t value) {
+    const uint8_t byte = value < 0 ? 0 : value > 255 ? 255 : (uint8_t)value;
+    PortalMessage message(static_cast<PortalSerialCommand>(command), byte);
+    cues.receiveMessage(message, replies);
+}
+
+void EthernetTransport::handleMessage(const OscMessage& message) {
+    rxMessages++;
+
+    int32_t command, value;
+    if (message.is("/portal/cmd")) {
+        if (message.getInt(0, command) && message.getInt(1, value)) {
+            dispatch((uint8_t)command, value);
+            return;
+        }
+    } else if (message.is("/portal/frame")) {
+        const uint8_t* data;
+        uint32_t length;
+        if (message.getBlob(0, data, length)) {
+            for (uint32_t i = 0; i + PORTAL_MSG_MIN_SIZE <= length; i += PORTAL_MSG_MIN_SIZE) {
+                cues.receiveMessage(PortalMessage::fromBytes(data + i), replies);
+            }
+            return;
+        }
+    } else {
+        for (const OscCue& cue : OSC_CUES) {
+            if (message.is(cue.address)) {
+                dispatch(static_cast<uint8_t>(cue.command), message.getInt(0, value) ? value : 0);
+                return;
+            }
+        }
+    }
+    rxUnknown++;
+}
+
+// ===== TRANSMIT =====
+
+bool EthernetTransport::openPacket() {
+    if (packetOpen) return true;
+    if (txHead - txTail >= ETHERNET_TX_PACKETS) return false;
+
+    Packet& packet = packets[txHead & (ETHERNET_TX_PACKETS - 1)];
+    writer = OscWriter(packet.data, sizeof(packet.data));
+    writer.beginBundle();
+    packetOpen = true;
+    return true;
+}
+
+void EthernetTransport::closePacket() {
+    if (!packetOpen) return;
+    packetOpen = false;
+    if (writer.getMessageCount() == 0) return;
+
+    packets[txHead & (ETHERNET_TX_PACKETS - 1)].length = writer.getLength();
+    txHead++;
+    if (txHead - txTail > maxQueued) maxQueued = txHead - txTail;
+}
+
+bool EthernetTransport::queueMessage(const char* address, const int32_t* args, uint8_t count) {
+    if (!peerActive) return false;
+
+    static const char INT_TAGS[] = "iiiiiiii";
+    const char* types = INT_TAGS + sizeof(INT_TAGS) - 1 - count;
+    for (uint8_t attempt = 0; attempt < 2; attempt++) {
+        if (!openPacket()) break;
+        writer.beginMessage(address, types);
+        for (uint8_t i = 0; i < count; i++) writer.addInt(args[i]);
+        if (writer.endMessage()) return true;
+        closePacket();  // Full: the message goes in the next packet
+    }
+    eventsDropped++;
+    return false;
+}
+
+bool EthernetTransport::sendQueued() {
+    while (txTail != txHead) {
+        const Packet& packet = packets[txTail & (ETHERNET_TX_PACKETS - 1)];
+        if (!udp.send(peerIP, peerPort, packet.data, packet.length)) {
+            // No link, ARP pending or no buffers yet: try again next poll
+            txRetries++;
+            return true;
+        }
+        txPackets++;
+        txBytes += packet.length;
+        txTail++;
+    }
+    return false;
+}
+
+void EthernetTransport::collectEvents() {
+    const uint32_t head = events->getHead();
+    if (!peerActive) {
+        readSequence = head;
+        return;
+    }
+    if (head - readSequence > FLIGHT_RECORDER_ENTRIES) {
+        eventsDropped += head - readSequence - FLIGHT_RECORDER_ENTRIES;
+        readSequence = head - FLIGHT_RECORDER_ENTRIES;
+    }
+
+    for (; readSequence != head; readSequence++) {
+        const FlightRecorder::Entry& entry = events->getEntryAt(readSequence);
+        if (entry.type == FLIGHT_TICK) {
+            if (entry.b > maxTickUs) maxTickUs = entry.b;
+            continue;
+        }
+        if (entry.type >= sizeof(EVENT_ADDRESSES) / sizeof(EVENT_ADDRESSES[0]) || !EVENT_ADDRESSES[entry.type]) {
+            continue;
+        }
+
+        int32_t args[4] = {(int32_t)entry.timestamp, entry.a, entry.b, 0};
+        uint8_t count = 3;
+        if (entry.type >= FLIGHT_NOTE_ON && entry.type <= FLIGHT_CC) {
+            // MIDI: b = data2 | channel << 8
+            args[1] = entry.b >> 8;
+            args[2] = entry.a;
+            args[3] = entry.b & 0xFF;
+            count = 4;
+        }
+        queueMessage(EVENT_ADDRESSES[entry.type], args, count);
+    }
+}
+
+bool EthernetTransport::poll() {
+    if (!started) return false;
+    qindesign::network::Ethernet.loop();
+
+    const uint32_t now = millis();
+    for (uint8_t i = 0; i < ETHERNET_RX_QUEUE; i++) {
+        const int size = udp.parsePacket();
+        if (size <= 0) break;
+
+        rxPackets++;
+        lastReceiveMs = now;
+        if (!peerActive || !(udp.remoteIP() == peerIP) || udp.remotePort() != peerPort) {
+            // A new peer gets events from now on, not the backlog
+            peerIP = udp.remoteIP();
+            peerPort = udp.remotePort();
+            peerActive = true;
+            if (events) readSequence = events->getHead();
+        }
+        if (!OscReader::parse(udp.data(), size, onMessage, this)) rxMalformed++;
+    }
+
+    if (peerActive && now - lastReceiveMs > ETHERNET_PEER_TIMEOUT_MS) {
+        peerActive = false;
+        txTail = txHead;  // Nobody to send the backlog to
+        packetOpen = false;
+    }
+
+    if (events) collectEvents();
+
+    if (peerActive && now - lastTelemetryMs >= ETHERNET_TELEMETRY_MS) {
+        lastTelemetryMs = now;
+        const int32_t telemetry[5] = {(int32_t)now, portal.getCurrentProgram(), maxTickUs,
+                                      (int32_t)eventsDropped, (int32_t)rxPackets};
+        queueMessage("/telemetry", telemetry, 5);
+        maxTickUs = 0;
+    }
+
+    closePacket();
+    return sendQueued();
+}
+
+FLASHMEM void EthernetTransport::printStats(Print& out) const {
+    out.printf("=== ETHERNET OSC: %s ===\n", peerActive ? "peer active" : "no peer");
+    out.printf("RX: %lu packets, %lu messages, %lu malformed, %lu unknown\n",
+               (unsigned long)rxPackets, (unsigned long)rxMessages,
+               (unsigned long)rxMalformed, (unsigned long)rxUnknown);
+    out.printf("TX: %lu packets, %lu bytes, %lu retries, queue peak %u/%u, %lu events dropped\n",
+               (unsigned long)txPackets, (unsigned long)txBytes, (unsigned long)txRetries,
+               maxQueued, ETHERNET_TX_PACKETS, (unsigned long)eventsDropped);
+}
@@ -0,0 +1,183 @@
+#include "event_log.h"
+#include "serial_portal_protocol.h"
+#include "config_store.h"
+#include "portal_cue_handler.h"
+#include "midi_looper.h"
+#include "input_health.h"
+
+static_assert((EVENT_LOG_ENTRIES & (EVENT_LOG_ENTRIES - 1)) == 0,
+              "EVENT_LOG_ENTRIES must be a power of two");
+static_assert(sizeof(EventLog::Record) == 12, "Event log records are 12 bytes");
+static_assert(sizeof(LOG_META) / sizeof(LOG_META[0]) == LOG_ID_COUNT, "One LogMeta per LogId");
+
+#if EVENT_LOG > 0
+EventLog eventLog;
+#endif
+
+static const char* const LOG_FORMATS[] = {
+    #define EVENT_LOG_FORMAT(id, level, category, args, names, format) format,
+    EVENT_LOG_MESSAGES(EVENT_LOG_FORMAT)
+    #undef EVENT_LOG_FORMAT
+};
+
+static const char* logName(uint8_t names, uint16_t value) {
+    static const char* const DIRECTIONS[] = {"UP", "DOWN", "LEFT", "RIGHT"};
+    switch (names) {
+        case LOG_NAMES_PROGRAM:
+            return value < PORTAL_PROGRAM_COUNT ? PORTAL_PROGRAM_NAMES[value] : "?";
+        case LOG_NAMES_COMMAND:
+            return SerialPortalProtocol::getCommandName(static_cast<PortalSerialCommand>(value));
+        case LOG_NAMES_CONFIG:
+            return value < CONFIG_PARAM_COUNT ? ConfigStore::getParamInfo(static_cast<ConfigParam>(value)).name : "?";
+        case LOG_NAMES_DIRECTION:
+            return value < 4 ? DIRECTIONS[value] : "?";
+        case LOG_NAMES_PRESSED:
+            return value ? "PRESSED" : "RELEASED";
+        case LOG_NAMES_ON_OFF:
+            return value ? "ON" : "OFF";
+        case LOG_NAMES_LOOPER:
+            return MidiLooper::stateName(value);
+        case LOG_NAMES_HEALTH:
+            return InputHealthMonitor::faultName(value);
+        default:
+            return "?";
+    }
+}
+
+EventLog::EventLog()
+    : head(0)
+    , tail(0)
+    , dropped(0)
+    , droppedReported(0)
+    , level(EVENT_LOG_LEVEL)
+    , categories(LOG_CAT_ALL)
+    , textOutput(EVENT_LOG_TEXT)
+    , dumping(false)
+    , dumpHeaderSent(false)
+    , dumpNext(0)
+    , dumpRemaining(0)
+{
+}
+
+void EventLog::clear() {
+    head = 0;
+    tail = 0;
+    dropped = 0;
+    droppedReported = 0;
+    dumping = false;
+}
+
+void EventLog::setTextOutput(bool enabled) {
+    if (enabled && !textOutput) {
+        // Start from what the ring still holds; older records are not news
+        if (head - tail > EVENT_LOG_ENTRIES) tail = head - EVENT_LOG_ENTRIES;
+        droppedReported = dropped;
+    }
+    textOutput = enabled;
+}
+
+size_t EventLog::format(const Record& record, char* buffer, size_t size) {
+    if (size == 0) return 0;
+
+    int n = snprintf(buffer, size, "[%lu.%03lu] ", (unsigned long)(record.timestamp / 1000000),
+                     (unsigned long)(record.timestamp / 1000 % 1000));
+    if (n < 0 || (size_t)n >= size) return size - 1;
+
+    char* out = buffer + n;
+    const size_t room = size - n;
+    int m;
+    if (record.id >= LOG_ID_COUNT) {
+        m = snprintf(out, room, "Log: unknown id %u (%u, %u, %u)", record.id, record.a, record.b, record.c);
+    } else {
+        const LogMeta& meta = LOG_META[record.id];
+        const char* fmt = LOG_FORMATS[record.id];
+        switch (meta.args) {
+            case LOG_ARGS_NAME_A:
+                m = snprintf(out, room, fmt, logName(meta.names, record.a), record.b, record.c);
+                break;
+            case LOG_ARGS_NAME_B:
+                m = snprintf(out, room, fmt, record.a, logName(meta.names, record.b), record.c);
+                break;
+            case LOG_ARGS_NAME_A_WIDE:
+                m = snprintf(out, room, fmt, logName(meta.names, record.a),
+                             (unsigned long)record.b | ((unsigned long)record.c << 16));
+                break;
+            default:
+                m = snprintf(out, room, fmt, record.a, record.b, record.c);
+                break;
+        }
+    }
+    if (m < 0) m = 0;
+    return (size_t)m >= room ? size - 1 : n + m;
+}
+
+bool EventLog::drainText(Print& out) {
+    if (!textOutput || dumping) return false;
+
+    // Overrun: the oldest unread records were overwritten
+    if (head - tail > EVENT_LOG_ENTRIES) {
+        dropped += head - tail - EVENT_LOG_ENTRIES;
+        tail = head - EVENT_LOG_ENTRIES;
+    }
+
+    char line[128];
+    if (dropped != droppedReported) {
+        uint32_t lost = dropped - droppedReported;
+        Record notice = {micros(), LOG_LOG_DROPPED, (uint16_t)(lost < 0xFFFF ? lost : 0xFFFF), 0, 0};
+        droppedReported = dropped;
+        format(notice, line, sizeof(line));
+        out.println(line);
+    }
+
+    for (uint8_t i = 0; i < EVENT_LOG_DRAIN_SLICE && tail != head; i++) {
+        format(records[tail & INDEX_MASK], line, sizeof(line));
+        tail++;
+        out.println(line);
+    }
+    return tail != head;
+}
+
+bool EventLog::beginDump() {
+    if (dumping) return false;
+
+    dumping = true;
+    dumpHeaderSent = false;
+    dumpRemaining = getCount();
+    dumpNext = (head - dumpRemaining) & INDEX_MASK;
+    return true;
+}
+
+bool EventLog::dumpSlice(Print& out) {
+    if (!dumping) return false;
+
+    if (!dumpHeaderSent) {
+        uint8_t header[HEADER_SIZE];
+        uint16_t droppedCount = dropped < 0xFFFF ? dropped : 0xFFFF;
+        uint32_t count = dumpRemaining;
+        uint32_t now = micros();
+        memcpy(header, "ELOG", 4);
+        header[4] = FORMAT_VERSION;
+        header[5] = sizeof(Record);
+        memcpy(&header[6], &droppedCount, 2);
+        memcpy(&header[8], &count, 4);
+        memcpy(&header[12], &now, 4);
+        out.write(header, HEADER_SIZE);
+        dumpHeaderSent = true;
+        return true;
+    }
+
+    // Contiguous run up to the slice size or the end of the ring
+    uint32_t n = dumpRemaining < EVENT_LOG_DUMP_SLICE_RECORDS ? dumpRemaining : EVENT_LOG_DUMP_SLICE_RECORDS;
+    if (n > EVENT_LOG_ENTRIES - dumpNext) n = EVENT_LOG_ENTRIES - dumpNext;
+    if (n > 0) {
+        out.write(reinterpret_cast<const uint8_t*>(&records[dumpNext]), n * sizeof(Record));
+    }
+    dumpNext = (dumpNext + n) & INDEX_MASK;
+    dumpRemaining -= n;
+
+    if (dumpRemaining == 0) {
+        dumping = false;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,105 @@
+#include "flight_recorder.h"
+#include "memory_placement.h"
+#include <stddef.h>
+
+static_assert((FLIGHT_RECORDER_ENTRIES & (FLIGHT_RECORDER_ENTRIES - 1)) == 0,
+              "FLIGHT_RECORDER_ENTRIES must be a power of two");
+static_assert(sizeof(FlightRecorder::Entry) == 8, "Flight recorder entries are 8 bytes");
+
+#if FLIGHT_RECORDER > 0
+// DMAMEM (OCRAM) is not cleared by the startup code, so the ring survives resets
+DMAMEM CACHE_ALIGNED static FlightRecorder::Storage flightStorage;
+FlightRecorder flightRecorder(&flightStorage);
+#endif
+
+FlightRecorder::FlightRecorder(Storage* storage)
+    : storage(storage)
+    , flushedHead(0)
+    , dumping(false)
+    , dumpHeaderSent(false)
+    , dumpNext(0)
+    , dumpRemaining(0)
+{
+}
+
+FLASHMEM void FlightRecorder::begin() {
+    // Anything inconsistent means cold power-up garbage: start a new ring
+    if (storage->magic != MAGIC || storage->count > FLIGHT_RECORDER_ENTRIES) {
+        memset(storage, 0, sizeof(Storage));
+        storage->magic = MAGIC;
+    }
+    storage->bootCount++;
+    flushedHead = storage->head;
+
+    uint8_t resetCause = 0;
+    #ifdef __IMXRT1062__
+    resetCause = SRC_SRSR & 0xFF;
+    #endif
+    record(FLIGHT_BOOT, resetCause, (uint16_t)storage->bootCount);
+}
+
+void FlightRecorder::flushToMemory() {
+    uint32_t head = storage->head;
+    uint32_t pending = head - flushedHead;
+    if (pending == 0) return;
+
+    if (pending >= FLIGHT_RECORDER_ENTRIES) {
+        flushDataCache(storage->entries, sizeof(storage->entries));
+    } else {
+        uint32_t start = flushedHead & INDEX_MASK;
+        uint32_t end = head & INDEX_MASK;
+        if (start < end) {
+            flushDataCache(&storage->entries[start], (end - start) * sizeof(Entry));
+        } else {
+            flushDataCache(&storage->entries[start], (FLIGHT_RECORDER_ENTRIES - start) * sizeof(Entry));
+            flushDataCache(&storage->entries[0], end * sizeof(Entry));
+        }
+    }
+    flushDataCache(storage, offsetof(Storage, entries));
+    flushedHead = head;
+}
+
+bool FlightRecorder::beginDump() {
+    if (dumping) return false;
+
+    dumping = true;
+    dumpHeaderSent = false;
+    dumpRemaining = storage->count;
+    dumpNext = (storage->head - storage->count) & INDEX_MASK;
+    return true;
+}
+
+bool FlightRecorder::dumpSlice(Print& out) {
+    if (!dumping) return false;
+
+    if (!dumpHeaderSent) {
+        uint8_t header[HEADER_SIZE];
+        uint16_t bootCount = (uint16_t)storage->bootCount;
+        uint32_t count = dumpRemaining;
+        uint32_t now = micros();
+        memcpy(header, "FLTR", 4);
+        header[4] = FORMAT_VERSION;
+        header[5] = sizeof(Entry);
+        memcpy(&header[6], &bootCount, 2);
+        memcpy(&header[8], &count, 4);
+        memcpy(&header[12], &now, 4);
+        out.write(header, HEADER_SIZE);
+        dumpHeaderSent = true;
+        return true;
+    }
+
+    // Contiguous run up to the slice size or the end of the ring
+    uint32_t n = dumpRemaining < FLIGHT_DUMP_SLICE_ENTRIES ? dumpRemaining : FLIGHT_DUMP_SLICE_ENTRIES;
+    if (n > FLIGHT_RECORDER_ENTRIES - dumpNext) n = FLIGHT_RECORDER_ENTRIES - dumpNext;
+    if (n > 0) {
+        out.write(reinterpret_cast<const uint8_t*>(&storage->entries[dumpNext]), n * sizeof(Entry));
+    }
+    dumpNext = (dumpNext + n) & INDEX_MASK;
+    dumpRemaining -= n;
+
+    if (dumpRemaining == 0) {
+        dumping = false;
+        return false;
+    }
+    return true;
+}
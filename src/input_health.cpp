@@ -0,0 +1,128 @@
+#include "input_health.h"
+#include "memory_placement.h"
+#include "flight_recorder.h"
+#include "event_log.h"
+
+InputHealthMonitor::InputHealthMonitor()
+    : quarantineCount(0)
+    , suppressed(0)
+{
+    reset(0);
+}
+
+const char* InputHealthMonitor::faultName(uint8_t fault) {
+    static const char* const NAMES[] = {"OK", "CHATTER", "STUCK", "NOISE"};
+    return fault < 4 ? NAMES[fault] : "?";
+}
+
+void InputHealthMonitor::reset(uint32_t nowMs) {
+    quarantined = 0;
+    rawActive = 0;
+    windowStart = nowMs;
+    memset(activeSince, 0, sizeof(activeSince));
+    memset(releaseAt, 0, sizeof(releaseAt));
+    memset(edges, 0, sizeof(edges));
+    memset(fault, HEALTH_OK, sizeof(fault));
+    memset(lastPotValue, 0, sizeof(lastPotValue));
+    memset(lastPotDirection, 0, sizeof(lastPotDirection));
+}
+
+FASTRUN uint32_t InputHealthMonitor::recordEdges(uint32_t channels, uint32_t nowMs) {
+    if (INPUT_HEALTH == 0) return channels;
+
+    for (uint32_t pending = channels; pending; pending &= pending - 1) {
+        const uint8_t channel = __builtin_ctz(pending);
+        if (edges[channel] < 255) edges[channel]++;
+        const uint8_t limit = channel >= SWITCH_CHANNEL ? INPUT_HEALTH_MAX_SWITCH_EDGES : INPUT_HEALTH_MAX_EDGES;
+        if (edges[channel] > limit) flag(channel, HEALTH_CHATTER, nowMs);
+    }
+
+    suppressed += __builtin_popcount(channels & quarantined);
+    return channels & ~quarantined;
+}
+
+FASTRUN bool InputHealthMonitor::recordPot(uint8_t pot, uint8_t value, uint32_t nowMs) {
+    if (INPUT_HEALTH == 0 || pot >= POT_COUNT) return true;
+    const uint8_t channel = POT_CHANNEL + pot;
+
+    // A hand turns one way for a while; noise turns back on every send
+    const int8_t direction = value > lastPotValue[pot] ? 1 : (value < lastPotValue[pot] ? -1 : 0);
+    if (direction != 0 && direction == -lastPotDirection[pot]) {
+        if (edges[channel] < 255) edges[channel]++;
+        if (edges[channel] > INPUT_HEALTH_MAX_POT_REVERSALS) flag(channel, HEALTH_NOISE, nowMs);
+    }
+    if (direction != 0) lastPotDirection[pot] = direction;
+    lastPotValue[pot] = value;
+
+    if (!isQuarantined(channel)) return true;
+    suppressed++;
+    return false;
+}
+
+FASTRUN void InputHealthMonitor::update(uint32_t active, uint32_t nowMs) {
+    if (INPUT_HEALTH == 0) return;
+
+    // Only momentary inputs can be stuck
+    active &= (1UL << SWITCH_CHANNEL) - 1;
+    for (uint32_t rising = active & ~rawActive; rising; rising &= rising - 1) {
+        activeSince[__builtin_ctz(rising)] = nowMs;
+    }
+    rawActive = active;
+
+    if (nowMs - windowStart >= INPUT_HEALTH_WINDOW_MS) closeWindow(nowMs);
+}
+
+void InputHealthMonitor::closeWindow(uint32_t nowMs) {
+    windowStart = nowMs;
+    memset(edges, 0, sizeof(edges));
+
+    for (uint32_t held = rawActive; held; held &= held - 1) {
+        const uint8_t channel = __builtin_ctz(held);
+        if (nowMs - activeSince[channel] >= INPUT_HEALTH_STUCK_MS) flag(channel, HEALTH_STUCK, nowMs);
+    }
+
+    for (uint32_t pending = quarantined; pending; pending &= pending - 1) {
+        const uint8_t channel = __builtin_ctz(pending);
+        if ((int32_t)(nowMs - releaseAt[channel]) < 0) continue;
+        quarantined &= ~(1UL << channel);
+        fault[channel] = HEALTH_OK;
+        LOG_EVENT(LOG_INPUT_RECOVERED, channel);
+        FLIGHT_RECORD(FLIGHT_HEALTH, channel, HEALTH_OK);
+    }
+}
+
+void InputHealthMonitor::flag(uint8_t channel, uint8_t newFault, uint32_t nowMs) {
+    // Every sighting pushes recovery back
+    releaseAt[channel] = nowMs + INPUT_HEALTH_RECOVERY_MS;
+    if (isQuarantined(channel)) return;
+
+    quarantined |= 1UL << channel;
+    fault[channel] = newFault;
+    quarantineCount++;
+    LOG_EVENT(LOG_INPUT_QUARANTINED, channel, newFault);
+    FLIGHT_RECORD(FLIGHT_HEALTH, channel, newFault);
+}
+
+FLASHMEM void InputHealthMonitor::printStats(Print& out) const {
+    out.printf("=== INPUT HEALTH: %u quarantined, %lu quarantines, %lu events held back ===\n",
+               __builtin_popcount(quarantined), (unsigned long)quarantineCount, (unsigned long)suppressed);
+    const uint32_t now = millis();
+    for (uint32_t pending = quarantined; pending; pending &= pending - 1) {
+        const uint8_t channel = __builtin_ctz(pending);
+        const char* kind = "pot";
+        uint8_t index = channel - POT_CHANNEL;
+        if (channel < JOYSTICK_CHANNEL) {
+            kind = "button";
+            index = channel - BUTTON_CHANNEL;
+        } else if (channel < SWITCH_CHANNEL) {
+            kind = "joystick";
+            index = channel - JOYSTICK_CHANNEL;
+        } else if (channel < POT_CHANNEL) {
+            kind = "switch";
+            index = channel - SWITCH_CHANNEL;
+        }
+        const int32_t leftMs = (int32_t)(releaseAt[channel] - now);
+        out.printf("  %s %u: %s, back in %ld ms if it stays clear\n", kind, index, faultName(fault[channel]),
+                   (long)(leftMs > 0 ? leftMs : 0));
+    }
+}
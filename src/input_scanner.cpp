@@ -60,7 +60,51 @@ void InputScanner::begin() {
 }
 
 void InputScanner::scan() {
-    // Save last states
+    saveLastStates();
+    
+    // Scan all inputs
+    scanButtons();
+    scanJoystick();
+    scanSwitches();
+    scanPots();
+}
+
+void InputScanner::scanFrame(const RawInputFrame& frame) {
+    saveLastStates();
+    
+    for (int i = 0; i < BUTTON_COUNT; i++) {
+        buttonStates[i] = (frame.buttons >> i) & 1;
+    }
+    for (int i = 0; i < 4; i++) {
+        joystickStates[i] = (frame.joystick >> i) & 1;
+    }
+    for (int i = 0; i < SWITCH_COUNT; i++) {
+        switchStates[i] = (frame.switches >> i) & 1;
+    }
+    for (int i = 0; i < POT_COUNT; i++) {
+        potValues[i] = frame.pots[i];
+    }
+}
+
+void InputScanner::getRawFrame(RawInputFrame& frame) const {
+    frame.buttons = 0;
+    for (int i = 0; i < BUTTON_COUNT; i++) {
+        if (buttonStates[i]) frame.buttons |= 1 << i;
+    }
+    frame.joystick = 0;
+    for (int i = 0; i < 4; i++) {
+        if (joystickStates[i]) frame.joystick |= 1 << i;
+    }
+    frame.switches = 0;
+    for (int i = 0; i < SWITCH_COUNT; i++) {
+        if (switchStates[i]) frame.switches |= 1 << i;
+    }
+    for (int i = 0; i < POT_COUNT; i++) {
+        frame.pots[i] = potValues[i];
+    }
+}
+
+void InputScanner::saveLastStates() {
     for (int i = 0; i < BUTTON_COUNT; i++) {
         lastButtonStates[i] = buttonStates[i];
     }
@@ -73,12 +117,6 @@ void InputScanner::scan() {
     for (int i = 0; i < POT_COUNT; i++) {
         lastPotValues[i] = potValues[i];
     }
-    
-    // Scan all inputs
-    scanButtons();
-    scanJoystick();
-    scanSwitches();
-    scanPots();
 }
 
 void InputScanner::scanButtons() {
@@ -126,6 +164,11 @@ bool InputScanner::getButtonReleased(uint8_t buttonIndex) const {
 }
 
 // Joystick state access
+bool InputScanner::getJoystickState(uint8_t direction) const {
+    if (direction >= 4) return false;
+    return joystickStates[direction];
+}
+
 bool InputScanner::getJoystickPressed(uint8_t direction) const {
     if (direction >= 4) return false;
     return joystickStates[direction] && !lastJoystickStates[direction];
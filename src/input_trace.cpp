@@ -0,0 +1,268 @@
+#include "input_trace.h"
+#include "memory_placement.h"
+
+#if INPUT_TRACE > 0
+// OCRAM: large, and only touched once per scan tick while capturing
+DMAMEM CACHE_ALIGNED static uint8_t traceBuffer[INPUT_TRACE_BYTES];
+InputTrace inputTrace(traceBuffer, sizeof(traceBuffer));
+#endif
+
+static void putU16(uint8_t* p, uint16_t value) {
+    p[0] = value & 0xFF;
+    p[1] = value >> 8;
+}
+
+static void putU32(uint8_t* p, uint32_t value) {
+    putU16(p, value & 0xFFFF);
+    putU16(p + 2, value >> 16);
+}
+
+static uint16_t getU16(const uint8_t* p) {
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t getU32(const uint8_t* p) {
+    return getU16(p) | ((uint32_t)getU16(p + 2) << 16);
+}
+
+// ===== RECORDER =====
+
+InputTraceRecorder::InputTraceRecorder(uint8_t* buffer, size_t capacity)
+    : buffer(buffer)
+    , capacity(capacity)
+    , capturing(false)
+    , startUs(0)
+    , tickUs(SCAN_PERIOD_US)
+    , recordBytes(0)
+    , lastTick(0)
+    , durationTicks(0)
+    , last{}
+{
+}
+
+void InputTraceRecorder::begin(uint32_t timeUs, uint16_t newTickUs) {
+    startUs = timeUs;
+    tickUs = newTickUs ? newTickUs : 1;
+    recordBytes = 0;
+    lastTick = 0;
+    durationTicks = 0;
+    capturing = capacity >= HEADER_SIZE;
+    if (capturing) writeHeader();
+}
+
+FASTRUN bool InputTraceRecorder::capture(const RawInputFrame& frame, uint32_t timeUs) {
+    if (!capturing) return false;
+
+    // The first frame fixes tick 0 and stores every source
+    const bool initial = recordBytes == 0;
+    if (initial) startUs = timeUs;
+    uint32_t tick = (timeUs - startUs + tickUs / 2) / tickUs;
+    if (tick < lastTick) tick = lastTick;
+
+    bool ok = true;
+    if (initial || frame.buttons != last.buttons) ok = ok && put(TRACE_BUTTONS, tick, frame.buttons);
+    if (initial || frame.joystick != last.joystick) ok = ok && put(TRACE_JOYSTICK, tick, frame.joystick);
+    if (initial || frame.switches != last.switches) ok = ok && put(TRACE_SWITCHES, tick, frame.switches);
+    for (uint8_t i = 0; i < POT_COUNT; i++) {
+        if (initial || frame.pots[i] != last.pots[i]) ok = ok && put(TRACE_POT + i, tick, frame.pots[i]);
+    }
+
+    if (!ok) {
+        // Full: keep what fits, the trace stays valid up to the last whole tick
+        capturing = false;
+        writeHeader();
+        return false;
+    }
+
+    last = frame;
+    durationTicks = tick + 1;
+    writeHeader();
+    return true;
+}
+
+void InputTraceRecorder::end(uint32_t timeUs) {
+    if (!capturing) return;
+    if (recordBytes > 0) {
+        uint32_t tick = (timeUs - startUs + tickUs / 2) / tickUs;
+        if (tick > durationTicks) durationTicks = tick;
+    }
+    capturing = false;
+    writeHeader();
+}
+
+bool InputTraceRecorder::put(uint8_t source, uint32_t tick, uint16_t value) {
+    uint32_t delta = tick - lastTick;
+
+    // Room for the wait records and the record itself
+    uint32_t waits = delta > MAX_TAG_TICKS ? (delta + 0xFFFE) / 0xFFFF : 0;
+    if (HEADER_SIZE + recordBytes + (waits + 1) * RECORD_SIZE > capacity) return false;
+
+    uint8_t* p = buffer + HEADER_SIZE + recordBytes;
+    while (delta > MAX_TAG_TICKS) {
+        uint16_t wait = delta > 0xFFFF ? 0xFFFF : delta;
+        p[0] = TRACE_WAIT;
+        putU16(p + 1, wait);
+        p += RECORD_SIZE;
+        delta -= wait;
+    }
+    p[0] = source | (delta << 3);
+    putU16(p + 1, value);
+    p += RECORD_SIZE;
+
+    recordBytes = p - (buffer + HEADER_SIZE);
+    lastTick = tick;
+    return true;
+}
+
+void InputTraceRecorder::writeHeader() {
+    putU32(buffer, MAGIC);
+    buffer[4] = FORMAT_VERSION;
+    buffer[5] = BUTTON_COUNT;
+    buffer[6] = SWITCH_COUNT;
+    buffer[7] = POT_COUNT;
+    putU16(buffer + 8, tickUs);
+    putU16(buffer + 10, 0);
+    putU32(buffer + 12, recordBytes);
+    putU32(buffer + 16, durationTicks);
+}
+
+// ===== PLAYER =====
+
+InputTracePlayer::InputTracePlayer()
+    : records(nullptr)
+    , recordsEnd(nullptr)
+    , next(nullptr)
+    , tickUs(SCAN_PERIOD_US)
+    , durationTicks(0)
+    , nextTick(0)
+    , current{}
+    , initial{}
+{
+}
+
+bool InputTracePlayer::begin(const uint8_t* trace, size_t length) {
+    records = nullptr;
+    if (!trace || length < InputTraceRecorder::HEADER_SIZE) return false;
+    if (getU32(trace) != InputTraceRecorder::MAGIC ||
+        trace[4] != InputTraceRecorder::FORMAT_VERSION ||
+        trace[5] != BUTTON_COUNT || trace[6] != SWITCH_COUNT || trace[7] != POT_COUNT) {
+        return false;
+    }
+    const uint32_t recordBytes = getU32(trace + 12);
+    if (recordBytes % InputTraceRecorder::RECORD_SIZE != 0 ||
+        recordBytes > length - InputTraceRecorder::HEADER_SIZE) {
+        return false;
+    }
+
+    tickUs = getU16(trace + 8) ? getU16(trace + 8) : 1;
+    durationTicks = getU32(trace + 16);
+    records = trace + InputTraceRecorder::HEADER_SIZE;
+    recordsEnd = records + recordBytes;
+    next = records;
+    memset(&current, 0, sizeof(current));
+
+    // Tick 0 holds the complete starting frame
+    loadNextTick(0);
+    while (next < recordsEnd && nextTick == 0) {
+        apply();
+    }
+    initial = current;
+    return true;
+}
+
+FASTRUN bool InputTracePlayer::advance(uint32_t elapsedUs, RawInputFrame& frame) {
+    if (!records) return false;
+
+    const uint32_t tick = elapsedUs / tickUs;
+    while (next < recordsEnd && nextTick <= tick) {
+        apply();
+    }
+    frame = current;
+    return tick < durationTicks;
+}
+
+void InputTracePlayer::apply() {
+    const uint8_t source = next[0] & 7;
+    const uint16_t value = getU16(next + 1);
+    next += InputTraceRecorder::RECORD_SIZE;
+
+    switch (source) {
+        case TRACE_BUTTONS: current.buttons = value; break;
+        case TRACE_JOYSTICK: current.joystick = value; break;
+        case TRACE_SWITCHES: current.switches = value; break;
+        default:
+            if (source - TRACE_POT < POT_COUNT) current.pots[source - TRACE_POT] = value;
+            break;
+    }
+    loadNextTick(nextTick);
+}
+
+void InputTracePlayer::loadNextTick(uint32_t fromTick) {
+    uint32_t tick = fromTick;
+    while (next < recordsEnd) {
+        tick += next[0] >> 3;
+        if ((next[0] & 7) != TRACE_WAIT) break;
+        tick += getU16(next + 1);
+        next += InputTraceRecorder::RECORD_SIZE;
+    }
+    nextTick = tick;
+}
+
+// ===== FIRMWARE TRACE =====
+
+#if INPUT_TRACE > 0
+InputTrace::InputTrace(uint8_t* buffer, size_t capacity)
+    : recorder(buffer, capacity)
+    , replaying(false)
+    , replayStartUs(0)
+    , dumping(false)
+    , dumpOffset(0)
+{
+}
+
+bool InputTrace::startCapture() {
+    // The buffer is in use while it is replayed or streamed
+    if (replaying || dumping) return false;
+    recorder.begin(micros());
+    return true;
+}
+
+bool InputTrace::startReplay() {
+    if (replaying || recorder.isCapturing() || recorder.getRecordCount() == 0) return false;
+    if (!player.begin(recorder.data(), recorder.size())) return false;
+    replaying = true;
+    replayStartUs = micros();
+    return true;
+}
+
+FASTRUN bool InputTrace::nextFrame(RawInputFrame& frame) {
+    if (!replaying) return false;
+    if (!player.advance(micros() - replayStartUs, frame)) {
+        replaying = false;
+        return false;
+    }
+    return true;
+}
+
+bool InputTrace::beginDump() {
+    if (dumping || recorder.isCapturing()) return false;
+    dumping = true;
+    dumpOffset = 0;
+    return true;
+}
+
+bool InputTrace::dumpSlice(Print& out) {
+    if (!dumping) return false;
+
+    size_t n = recorder.size() - dumpOffset;
+    if (n > INPUT_TRACE_DUMP_SLICE_BYTES) n = INPUT_TRACE_DUMP_SLICE_BYTES;
+    out.write(recorder.data() + dumpOffset, n);
+    dumpOffset += n;
+
+    if (dumpOffset >= recorder.size()) {
+        dumping = false;
+        return false;
+    }
+    return true;
+}
+#endif
@@ -0,0 +1,122 @@
+#include "led_power.h"
+#include "memory_placement.h"
+#include "event_log.h"
+
+#if defined(__ARM_FEATURE_SIMD32)
+#include <arm_acle.h>
+#endif
+
+static_assert(sizeof(CRGB) == 3, "the channel sum reads the frame as packed RGB bytes");
+
+// Bytes 0 and 2 of word added into the two 16-bit lanes of acc
+static inline uint32_t addBytePairs(uint32_t acc, uint32_t word) {
+    #if defined(__ARM_FEATURE_SIMD32)
+    return __uxtab16(acc, word);
+    #else
+    return acc + (word & 0x00FF00FF);
+    #endif
+}
+
+LedPowerLimiter::LedPowerLimiter()
+    : brightness(LED_BRIGHTNESS_MAX)
+    , budgetMa(LED_POWER_BUDGET_MA)
+    , limit(255)
+    , lastMa(0)
+    , peakMa(0)
+    , limitedFrames(0)
+{
+}
+
+void LedPowerLimiter::configure(uint8_t newBrightness, uint16_t newBudgetMa) {
+    brightness = newBrightness;
+    budgetMa = newBudgetMa;
+}
+
+FASTRUN void LedPowerLimiter::sumChannels(const CRGB* leds, uint16_t count, uint32_t sums[3]) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(leds);
+    sums[0] = sums[1] = sums[2] = 0;
+
+    // Four LEDs are three words: R G B R | G B R G | B R G B (little-endian).
+    // Each word feeds two lanes with bytes 0/2 and two with bytes 1/3, so a
+    // lane always holds one channel of one LED slot.
+    uint16_t groups = count / 4;
+    while (groups > 0) {
+        // A lane takes one byte per group: flush before it can overflow
+        const uint16_t chunk = groups < 256 ? groups : 256;
+        uint32_t lane0 = 0, lane1 = 0, lane2 = 0, lane3 = 0, lane4 = 0, lane5 = 0;
+        for (uint16_t g = 0; g < chunk; g++, bytes += 12) {
+            uint32_t w0, w1, w2;
+            memcpy(&w0, bytes, 4);
+            memcpy(&w1, bytes + 4, 4);
+            memcpy(&w2, bytes + 8, 4);
+            lane0 = addBytePairs(lane0, w0);        // R0, B0
+            lane1 = addBytePairs(lane1, w0 >> 8);   // G0, R1
+            lane2 = addBytePairs(lane2, w1);        // G1, R2
+            lane3 = addBytePairs(lane3, w1 >> 8);   // B1, G2
+            lane4 = addBytePairs(lane4, w2);        // B2, G3
+            lane5 = addBytePairs(lane5, w2 >> 8);   // R3, B3
+        }
+        sums[0] += (lane0 & 0xFFFF) + (lane1 >> 16) + (lane2 >> 16) + (lane5 & 0xFFFF);
+        sums[1] += (lane1 & 0xFFFF) + (lane2 & 0xFFFF) + (lane3 >> 16) + (lane4 >> 16);
+        sums[2] += (lane0 >> 16) + (lane3 & 0xFFFF) + (lane4 & 0xFFFF) + (lane5 >> 16);
+        groups -= chunk;
+    }
+
+    for (uint16_t i = count & ~3; i < count; i++) {
+        sums[0] += leds[i].r;
+        sums[1] += leds[i].g;
+        sums[2] += leds[i].b;
+    }
+}
+
+// Channel draw at full brightness, without the dark current
+static uint32_t fullScaleMa(const uint32_t sums[3]) {
+    return (sums[0] * LED_POWER_MA_RED + sums[1] * LED_POWER_MA_GREEN + sums[2] * LED_POWER_MA_BLUE) / 255;
+}
+
+uint32_t LedPowerLimiter::estimateMa(const CRGB* leds, uint16_t count, uint8_t brightness) {
+    uint32_t sums[3];
+    sumChannels(leds, count, sums);
+    return (uint32_t)count * LED_POWER_MA_DARK + fullScaleMa(sums) * brightness / 255;
+}
+
+FASTRUN uint8_t LedPowerLimiter::update(const CRGB* leds, uint16_t count) {
+    uint32_t sums[3];
+    sumChannels(leds, count, sums);
+    const uint32_t fullMa = fullScaleMa(sums);
+    const uint32_t darkMa = (uint32_t)count * LED_POWER_MA_DARK;
+
+    const uint32_t renderedMa = darkMa + fullMa * brightness / 255;
+    if (renderedMa > peakMa) peakMa = renderedMa;
+
+    // Highest brightness this frame can have within the budget
+    uint8_t target = 255;
+    if (budgetMa > 0 && renderedMa > budgetMa) {
+        const uint32_t fits = budgetMa > darkMa ? (budgetMa - darkMa) * 255 / fullMa : 0;
+        target = fits < 255 ? fits : 255;
+    }
+
+    const bool wasLimited = limit < brightness;
+    if (target < limit) {
+        limit = target;
+    } else {
+        const uint16_t raised = limit + LED_POWER_RELEASE_STEP;
+        limit = raised < target ? raised : target;
+    }
+
+    const uint8_t shown = brightness < limit ? brightness : limit;
+    if (shown < brightness) {
+        limitedFrames++;
+        if (!wasLimited) {
+            LOG_EVENT(LOG_LED_POWER_LIMITED, renderedMa < 0xFFFF ? renderedMa : 0xFFFF, budgetMa, shown);
+        }
+    }
+    lastMa = darkMa + fullMa * shown / 255;
+    return shown;
+}
+
+FLASHMEM void LedPowerLimiter::printStats(Print& out) const {
+    out.printf("=== LED POWER: budget %u mA%s, last frame %lu mA, peak %lu mA as rendered ===\n", budgetMa,
+               budgetMa ? "" : " (off)", (unsigned long)lastMa, (unsigned long)peakMa);
+    out.printf("Brightness %u, limit %u, %lu frames limited\n", brightness, limit, (unsigned long)limitedFrames);
+}
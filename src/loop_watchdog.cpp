@@ -0,0 +1,194 @@
+#include "loop_watchdog.h"
+#include "memory_placement.h"
+#include "perf_monitor.h"
+#include "task_scheduler.h"
+#include "flight_recorder.h"
+#include <stddef.h>
+
+#if WATCHDOG > 0
+LoopWatchdog loopWatchdog;
+#endif
+
+static_assert(WATCHDOG_TIMEOUT_MS % 500 == 0 && WATCHDOG_TIMEOUT_MS >= 500 && WATCHDOG_TIMEOUT_MS <= 128000,
+              "WDOG1 timeout is set in 500 ms steps (0.5-128 s)");
+static_assert(WATCHDOG_WARNING_MS % 500 == 0 && WATCHDOG_WARNING_MS < WATCHDOG_TIMEOUT_MS,
+              "WDOG1 early warning is set in 500 ms steps and must come before the timeout");
+
+// DMAMEM (OCRAM) is not cleared by the startup code, so the record written
+// just before a watchdog reset is still there on the next boot
+DMAMEM CACHE_ALIGNED static LoopWatchdog::StallRecord stallRecord;
+
+static constexpr uint32_t STALL_RECORD_MAGIC = 0x57444F47;  // "WDOG"
+
+#if WATCHDOG > 0 && defined(__IMXRT1062__)
+static LoopWatchdog* activeWatchdog = nullptr;
+
+FASTRUN static void watchdogWarningIsr() {
+    if (activeWatchdog) {
+        activeWatchdog->onWarning();
+    }
+}
+#endif
+
+LoopWatchdog::LoopWatchdog()
+    : perfMonitor(nullptr)
+    , scheduler(nullptr)
+    , running(false)
+    , requiredMask(0)
+    , checkedInMask(0)
+    , currentTask(NO_TASK)
+    , feedCount(0)
+    , eventHead(0)
+    , eventCount(0)
+    , stallReported(false)
+{
+    memset(events, 0, sizeof(events));
+    memset(&lastStall, 0, sizeof(lastStall));
+}
+
+FLASHMEM bool LoopWatchdog::checkBootReport() {
+    stallReported = stallRecord.magic == STALL_RECORD_MAGIC &&
+                    stallRecord.checksum == checksum(stallRecord);
+    if (stallReported) {
+        lastStall = stallRecord;
+    }
+
+    // Consume the record so a later non-watchdog reset does not report it again
+    stallRecord.magic = 0;
+    flushDataCache(&stallRecord, sizeof(stallRecord));
+
+    return stallReported;
+}
+
+void LoopWatchdog::watchTask(uint8_t id) {
+    if (id < 32) {
+        requiredMask |= 1UL << id;
+    }
+}
+
+FLASHMEM void LoopWatchdog::begin(const TaskScheduler* taskScheduler) {
+    scheduler = taskScheduler;
+
+    #if WATCHDOG > 0 && defined(__IMXRT1062__)
+    activeWatchdog = this;
+
+    CCM_CCGR3 |= CCM_CCGR3_WDOG1(CCM_CCGR_ON);
+    WDOG1_WMCR = 0;  // Power-down counter would otherwise reset us after 16 s
+
+    attachInterruptVector(IRQ_WDOG1, watchdogWarningIsr);
+    NVIC_SET_PRIORITY(IRQ_WDOG1, 0);  // Must preempt whatever is stuck
+    NVIC_ENABLE_IRQ(IRQ_WDOG1);
+
+    // Both registers are write-once after reset
+    WDOG1_WICR = WDOG_WICR_WIE | WDOG_WICR_WTIS | WDOG_WICR_WICT(WATCHDOG_WARNING_MS / 500);
+    WDOG1_WCR = WDOG_WCR_WDZST | WDOG_WCR_WDBG | WDOG_WCR_SRS | WDOG_WCR_WDA |
+                WDOG_WCR_WT(WATCHDOG_TIMEOUT_MS / 500 - 1) | WDOG_WCR_WDE;
+
+    running = true;
+    feed();
+    #endif
+}
+
+FASTRUN void LoopWatchdog::checkIn(uint8_t id) {
+    recordEvent(EVENT_TASK_DONE, id);
+
+    uint32_t mask = checkedInMask | (1UL << id);
+    if (running && (mask & requiredMask) == requiredMask) {
+        feed();
+        mask = 0;
+    }
+    checkedInMask = mask;
+}
+
+FASTRUN void LoopWatchdog::feed() {
+    #if WATCHDOG > 0 && defined(__IMXRT1062__)
+    WDOG1_WSR = 0x5555;
+    WDOG1_WSR = 0xAAAA;
+    #endif
+    feedCount++;
+    recordEvent(EVENT_FEED, 0);
+}
+
+FASTRUN void LoopWatchdog::onWarning() {
+    #if WATCHDOG > 0 && defined(__IMXRT1062__)
+    if (running) {
+        WDOG1_WICR |= WDOG_WICR_WTIS;  // Acknowledge; the reset still follows
+    }
+    #endif
+
+    StallRecord& record = stallRecord;
+    record.cycles = cycles();
+    record.uptimeMs = millis();
+    record.checkedIn = checkedInMask;
+    record.required = requiredMask;
+    record.task = currentTask;
+    record.stage = perfMonitor ? perfMonitor->getCurrentStage() : PERF_STAGE_COUNT;
+    record.eventHead = eventHead;
+    record.eventCount = eventCount;
+    memcpy(record.events, events, sizeof(events));
+    record.magic = STALL_RECORD_MAGIC;
+    record.checksum = checksum(record);
+
+    // OCRAM is write-back cached: push the record (and the flight recorder's
+    // newest entries) out before the reset
+    flushDataCache(&record, sizeof(record));
+    #if FLIGHT_RECORDER > 0
+    flightRecorder.flushToMemory();
+    #endif
+}
+
+FLASHMEM void LoopWatchdog::printStallReport(Print& out) const {
+    if (!stallReported) {
+        out.println("Watchdog: no stall recorded before last reset");
+        return;
+    }
+
+    const StallRecord& record = lastStall;
+    const uint8_t taskCount = scheduler ? scheduler->getTaskCount() : 0;
+
+    out.println("=== WATCHDOG STALL REPORT ===");
+    out.printf("Stalled at uptime %lu ms, cycle %lu\n",
+               (unsigned long)record.uptimeMs, (unsigned long)record.cycles);
+    if (record.task < taskCount) {
+        out.printf("Running task: %s\n", scheduler->getTaskName(record.task));
+    } else if (record.task == NO_TASK) {
+        out.println("Running task: none (stalled outside the scheduler)");
+    } else {
+        out.printf("Running task: #%d\n", record.task);
+    }
+    if (record.stage < PERF_STAGE_COUNT) {
+        out.printf("Running stage: %s\n", PERF_STAGE_LABELS[record.stage]);
+    }
+    out.printf("Checked in: 0x%08lX of required 0x%08lX\n",
+               (unsigned long)record.checkedIn, (unsigned long)record.required);
+
+    // Oldest event first; cycle deltas relative to the warning
+    out.println("Last events (cycles before warning):");
+    uint8_t count = record.eventCount < STALL_EVENT_COUNT ? record.eventCount : STALL_EVENT_COUNT;
+    uint8_t index = (record.eventHead + STALL_EVENT_COUNT - count) % STALL_EVENT_COUNT;
+    for (uint8_t i = 0; i < count; i++) {
+        const Event& event = record.events[index];
+        const char* type = event.type == EVENT_TASK_ENTER ? "enter" :
+                           event.type == EVENT_TASK_DONE ? "done " : "feed ";
+        if (event.type == EVENT_FEED) {
+            out.printf("  %10lu %s\n", (unsigned long)(record.cycles - event.cycles), type);
+        } else if (event.id < taskCount) {
+            out.printf("  %10lu %s %s\n", (unsigned long)(record.cycles - event.cycles), type,
+                       scheduler->getTaskName(event.id));
+        } else {
+            out.printf("  %10lu %s #%d\n", (unsigned long)(record.cycles - event.cycles), type, event.id);
+        }
+        index = (index + 1) % STALL_EVENT_COUNT;
+    }
+    out.println("=============================");
+}
+
+uint32_t LoopWatchdog::checksum(const StallRecord& record) {
+    // FNV-1a over everything before the checksum field
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&record);
+    uint32_t hash = 2166136261UL;
+    for (size_t i = 0; i < offsetof(StallRecord, checksum); i++) {
+        hash = (hash ^ bytes[i]) * 16777619UL;
+    }
+    return hash;
+}
@@ -2,71 +2,129 @@
 #include <FastLED.h>
 #include "pins.h"
 #include "config.h"
-#include "robust_input_processor.h"
+#include "static_input_pipeline.h"
 #include "midi_out.h"
 #include "robust_midi_mapper.h"
 #include "oled_display.h"
 #include "portal_controller.h"
 #include "portal_cue_handler.h"
 #include "serial_portal_protocol.h"
+#include "perf_monitor.h"
+#include "task_scheduler.h"
+#include "stage_profiler.h"
+#include "loop_watchdog.h"
+#include "flight_recorder.h"
+#include "session_recorder.h"
+#include "input_trace.h"
+#include "event_log.h"
+#include "serial_mux.h"
+#include "ethernet_transport.h"
+#include "cluster_link.h"
+#include "midi_looper.h"
+#include "rule_engine.h"
+#include "led_power.h"
+#include "memory_placement.h"
+#include "config_store.h"
 
 // Forward declarations
-void portalStartupSequence();
+void endStartupShow();
 void updateOledInputData();
 void handlePortalInteractions();
+void registerTasks();
+bool scanTask();
+bool portalTask();
+bool oledTask();
+bool heartbeatTask();
+bool testDumpTask();
+bool bootTask();
+bool flightTask();
+bool sessionTask();
+bool traceTask();
+bool logTask();
+bool muxTask();
+bool ethernetTask();
+bool clusterTask();
+bool configTask();
+void applyRuntimeConfig(const RuntimeConfig& config);
 
 // ===== GLOBAL VARIABLES =====
 CRGB leds[LED_COUNT];
-elapsedMicros mainLoopTimer;
-elapsedMicros portalFrameTimer;
-elapsedMillis blinkTimer;
-elapsedMillis testDumpTimer;
-elapsedMillis oledUpdateTimer;
 bool builtinLedState = false;
 
+// Cooperative scheduler driving everything in loop()
+TaskScheduler scheduler;
+uint8_t scanTaskId = TaskScheduler::INVALID_TASK;
+uint8_t portalTaskId = TaskScheduler::INVALID_TASK;
+uint8_t oledTaskId = TaskScheduler::INVALID_TASK;
+uint8_t bootTaskId = TaskScheduler::INVALID_TASK;
+
+// Boot timing (micros() since reset)
+uint32_t setupStartUs = 0;
+uint32_t firstScanUs = 0;
+bool startupShowRunning = false;
+uint32_t startupShowStart = 0;
+
 // Phase 2: Robust input system modules
-RobustInputProcessor inputProcessor;
+InputProcessor inputProcessor;
 MidiOut midiOut;
 RobustMidiMapper inputMapper(inputProcessor, midiOut);
+#if MIDI_LOOPER > 0
+MidiLooper midiLooper(midiOut);
+#endif
 
 // OLED Display
 OledDisplay oledDisplay;
 
+// Loop timing and per-stage budgets (OLED PERF mode)
+PerfMonitor perfMonitor;
+
 // Phase 3: Portal Animation System
 PortalController portalController;
 PortalCueHandler portalCueHandler;
+LedPowerLimiter ledPower;
 
 // ===== SETUP FUNCTION =====
-void setup() {
-    // Initialize Serial for debugging and Pi communication
+// Fast boot: only what the 1 kHz scan and MIDI need runs here. OLED init and
+// the portal startup show run later from bootTask() inside the main loop.
+FLASHMEM void setup() {
+    setupStartUs = micros();
+    
+    #if WATCHDOG > 0
+    // Pick up the stall record if the last reset came from the watchdog
+    loopWatchdog.checkBootReport();
+    #endif
+    
+    #if FLIGHT_RECORDER > 0
+    // Keep the event history from before a soft reset and mark this boot
+    flightRecorder.begin();
+    #endif
+    
+    #if SESSION_RECORDER > 0
+    // Record the whole session to the SD card if one is in the slot
+    sessionRecorder.begin();
+    #endif
+    
+    // Initialize Serial for debugging and Pi communication (no wait: output
+    // before the host opens the port is simply dropped)
     Serial.begin(PORTAL_SERIAL_BAUD);
-    delay(1000);  // Give time for serial to initialize
     
     Serial.println("=== Mystery Melody Machine Teensy Firmware ===");
     Serial.println("Phase 3: Portal Animation System + Serial Protocol");
     Serial.printf("Firmware compiled: %s %s\n", __DATE__, __TIME__);
-    Serial.printf("Serial Protocol: %lu baud for Pi communication\n", PORTAL_SERIAL_BAUD);
+    Serial.printf("Serial Protocol: %lu baud for Pi communication\n", (unsigned long)PORTAL_SERIAL_BAUD);
     #ifdef USB_MIDI
     Serial.println("USB Type: MIDI + Serial");
     #else
     Serial.println("USB Type: Serial (Debug Mode)");
     #endif
     
+    // Runtime tuning from EEPROM (compile-time defaults if none saved)
+    configStore.begin();
+    
     // Initialize built-in LED for blink test
     pinMode(BUILTIN_LED_PIN, OUTPUT);
     digitalWrite(BUILTIN_LED_PIN, LOW);
     
-    // Initialize OLED display first
-    Serial.println("Initializing OLED display...");
-    if (oledDisplay.begin()) {
-        Serial.printf("OLED initialized successfully at I2C address 0x%02X\n", OLED_I2C_ADDRESS);
-    } else {
-        Serial.println("Warning: OLED initialization failed - continuing without display");
-    }
-    
-    // Wait a moment for the OLED startup message to be visible
-    delay(1500);
-    
     // Initialize Phase 2 robust input system
     Serial.println("Initializing robust input processor...");
     inputProcessor.begin();
@@ -74,16 +132,20 @@ void setup() {
     Serial.println("Initializing MIDI output...");
     midiOut.begin();
     
-    // Connect MIDI output to OLED for logging
+    // Connect MIDI output to OLED for logging (entries are kept until the
+    // display comes up)
     midiOut.setOledDisplay(&oledDisplay);
     
+    // Connect loop timing to the OLED performance dashboard
+    oledDisplay.setPerfMonitor(&perfMonitor);
+    
     Serial.printf("Input mapping: %d buttons, %d pots, %d switches, 4-way joystick\n", 
                   BUTTON_COUNT, POT_COUNT, SWITCH_COUNT);
     Serial.println("Features: debouncing, analog smoothing, change compression, OLED logging");
     
     // Initialize FastLED for portal
     FastLED.addLeds<WS2812B, LED_DATA_PIN, GRB>(leds, LED_COUNT);
-    FastLED.setBrightness(LED_BRIGHTNESS_MAX);
+    FastLED.setBrightness(configStore.get().ledBrightnessMax);
     FastLED.clear();
     FastLED.show();
     Serial.printf("FastLED initialized: %d LEDs on pin %d\n", LED_COUNT, LED_DATA_PIN);
@@ -92,6 +154,10 @@ void setup() {
     Serial.println("Initializing portal controller...");
     portalController.begin(leds);
     portalCueHandler.begin(&portalController);
+    portalCueHandler.setConfigStore(&configStore);
+    
+    // Input reactions: the default rule table until the Pi uploads its own
+    ruleEngine.begin(&portalController, &midiOut, &configStore);
     
     // Set initial portal program and parameters
     portalController.setProgram(PORTAL_AMBIENT);  // Start with ambient
@@ -100,20 +166,21 @@ void setup() {
     portalController.setBaseHue(0.6);  // Nice blue-purple base
     Serial.println("Portal system ready with 10 animation programs");
     
-    // Test MIDI functionality (only if MIDI is available)
-    Serial.println("Testing MIDI enumeration...");
-    #ifdef USB_MIDI
-    midiOut.sendNoteOn(60, 64, MIDI_CHANNEL);  // Test note
-    delay(100);
-    midiOut.sendNoteOff(60, 0, MIDI_CHANNEL);
-    Serial.println("MIDI test note sent (C4)");
-    #else
-    Serial.println("MIDI not available - debug mode active");
+    #if ETHERNET_OSC > 0
+    // OSC/UDP link to the Pi next to USB serial; the link comes up on its own
+    ethernetTransport.begin();
+    #endif
+    
+    #if CLUSTER_ROLE != CLUSTER_STANDALONE
+    // UART chain to the other boards; the primary plays everyone's inputs
+    clusterLink.begin();
     #endif
     
-    // Portal startup sequence
-    Serial.println("Starting portal initialization sequence...");
-    portalStartupSequence();
+    applyRuntimeConfig(configStore.get());
+    
+    #ifndef USB_MIDI
+    Serial.println("MIDI not available - debug mode active");
+    #endif
     
     // Enable test mode for debugging (can be disabled by setting DEBUG to 0)
     #if DEBUG >= 1
@@ -121,6 +188,38 @@ void setup() {
     Serial.println("Test mode enabled - will dump input values every 5 seconds");
     #endif
     
+    #if PROFILE > 0
+    // Start the DWT cycle counter for the stage profiler
+    stageProfiler.begin();
+    #endif
+    
+    // Register main loop tasks and align their first releases to now
+    registerTasks();
+    
+    #if WATCHDOG > 0
+    // Feed the hardware watchdog only when scan, portal and OLED all check in
+    loopWatchdog.watchTask(scanTaskId);
+    loopWatchdog.watchTask(portalTaskId);
+    loopWatchdog.watchTask(oledTaskId);
+    loopWatchdog.setPerfMonitor(&perfMonitor);
+    scheduler.setWatchdog(&loopWatchdog);
+    #endif
+    
+    scheduler.begin();
+    
+    #if WATCHDOG > 0
+    loopWatchdog.begin(&scheduler);
+    #endif
+    
+    #if DEBUG >= 1 && defined(__IMXRT1062__)
+    // Placement self-test (see memory_placement.h): scan path in ITCM, its
+    // state in DTCM
+    if (!isInItcm(reinterpret_cast<const void*>(&scanTask)) ||
+        !isInDtcm(&inputProcessor) || !isInDtcm(&scheduler) || !isInDtcm(leds)) {
+        Serial.println("WARNING: hot path not in tightly-coupled memory");
+    }
+    #endif
+    
     Serial.println("=== Setup Complete ===");
     Serial.printf("Main loop target: %d Hz\n", SCAN_HZ);
     Serial.printf("Portal target: %d Hz\n", PORTAL_FPS);
@@ -130,39 +229,100 @@ void setup() {
     Serial.println("Entering main loop...");
 }
 
-// ===== PORTAL STARTUP SEQUENCE =====
-void portalStartupSequence() {
-    Serial.println("Starting Portal Animation Showcase...");
-    
-    // Showcase each animation program briefly
-    uint8_t demoPrograms[] = {PORTAL_SPIRAL, PORTAL_PULSE, PORTAL_RAINBOW, PORTAL_WAVE, PORTAL_PLASMA};
-    
-    for (int p = 0; p < 5; p++) {
-        portalController.setProgram(demoPrograms[p]);
-        portalController.setIntensity(0.8);
-        portalController.setBpm(140);  // Energetic startup tempo
-        
-        Serial.printf("Demo: %d\n", demoPrograms[p]);
-        
-        // Run each program for 1 second
-        for (int frame = 0; frame < 60; frame++) {  // 60 frames at 60Hz = 1 second
-            portalController.update();
-            FastLED.show();
-            delay(16);  // ~60 FPS
-        }
+// ===== BOOT SEQUENCE =====
+// Runs as a low-priority task after the first scans: OLED init, then the
+// portal showcase on a timeline instead of blocking delays. Any input
+// activity ends the showcase early.
+enum BootStep : uint8_t {
+    BOOT_OLED_INIT,
+    BOOT_SHOWCASE,
+    BOOT_FLASHES,
+    BOOT_DONE
+};
+
+const uint8_t BOOT_DEMO_PROGRAMS[] = {PORTAL_SPIRAL, PORTAL_PULSE, PORTAL_RAINBOW, PORTAL_WAVE, PORTAL_PLASMA};
+constexpr uint8_t BOOT_DEMO_COUNT = sizeof(BOOT_DEMO_PROGRAMS);
+constexpr uint16_t BOOT_DEMO_MS = 1000;        // Per showcase program
+constexpr uint8_t BOOT_FLASH_COUNT = 3;
+constexpr uint16_t BOOT_FLASH_INTERVAL_MS = 360;
+constexpr uint16_t BOOT_SETTLE_MS = 250;       // Ignore power-up input changes
+
+uint8_t bootStep = BOOT_OLED_INIT;
+uint8_t bootStepCount = 0;
+uint32_t bootStepStart = 0;
+
+bool bootTask() {
+    uint32_t now = millis();
+    
+    switch (bootStep) {
+        case BOOT_OLED_INIT:
+            #if DEBUG >= 1
+            Serial.printf("Time to first scan: %lu us since reset (%lu us after setup start)\n",
+                          (unsigned long)firstScanUs, (unsigned long)(firstScanUs - setupStartUs));
+            #endif
+            oledDisplay.setBootTime(firstScanUs);
+            
+            #if WATCHDOG > 0
+            if (loopWatchdog.hasStallReport()) {
+                loopWatchdog.printStallReport(serialChannel(MUX_BULK));
+            }
+            #endif
+            
+            Serial.println("Initializing OLED display...");
+            if (oledDisplay.begin()) {
+                Serial.printf("OLED initialized successfully at I2C address 0x%02X\n", OLED_I2C_ADDRESS);
+            } else {
+                Serial.println("Warning: OLED initialization failed - continuing without display");
+            }
+            
+            Serial.println("Starting Portal Animation Showcase...");
+            startupShowRunning = true;
+            startupShowStart = now;
+            bootStep = BOOT_SHOWCASE;
+            bootStepCount = 0;
+            bootStepStart = now;
+            portalController.setProgram(BOOT_DEMO_PROGRAMS[0]);
+            portalController.setIntensity(0.8);
+            portalController.setBpm(140);  // Energetic startup tempo
+            break;
+            
+        case BOOT_SHOWCASE:
+            if (now - bootStepStart < BOOT_DEMO_MS) break;
+            bootStepStart += BOOT_DEMO_MS;
+            
+            if (++bootStepCount < BOOT_DEMO_COUNT) {
+                portalController.setProgram(BOOT_DEMO_PROGRAMS[bootStepCount]);
+                Serial.printf("Demo: %d\n", BOOT_DEMO_PROGRAMS[bootStepCount]);
+            } else {
+                Serial.println("Startup flash sequence...");
+                bootStep = BOOT_FLASHES;
+                bootStepCount = 0;
+                bootStepStart = now - BOOT_FLASH_INTERVAL_MS;  // First flash now
+            }
+            break;
+            
+        case BOOT_FLASHES:
+            if (now - bootStepStart < BOOT_FLASH_INTERVAL_MS) break;
+            bootStepStart += BOOT_FLASH_INTERVAL_MS;
+            
+            if (bootStepCount++ < BOOT_FLASH_COUNT) {
+                portalController.triggerFlash();
+            } else {
+                endStartupShow();
+            }
+            break;
+            
+        default:
+            break;
     }
     
-    // Final flash sequence
-    Serial.println("Startup flash sequence...");
-    for (int i = 0; i < 3; i++) {
-        portalController.triggerFlash();
-        for (int frame = 0; frame < 10; frame++) {
-            portalController.update();
-            FastLED.show();
-            delay(16);
-        }
-        delay(200);
-    }
+    return false;
+}
+
+void endStartupShow() {
+    startupShowRunning = false;
+    bootStep = BOOT_DONE;
+    scheduler.setEnabled(bootTaskId, false);
     
     // Fade to ambient mode
     Serial.println("Transitioning to ambient mode...");
@@ -175,204 +335,389 @@ void portalStartupSequence() {
 }
 
 // ===== PORTAL INTERACTION HANDLING =====
-void handlePortalInteractions() {
-    // Track input activity for idle detection
-    bool hasActivity = false;
-    
-    // Button press feedback - trigger flash on any button press
-    for (int i = 0; i < BUTTON_COUNT; i++) {
-        static bool lastButtonStates[10] = {false};
-        bool currentState = inputProcessor.getButtonState(i);
-        
-        if (currentState && !lastButtonStates[i]) {
-            // Button just pressed - trigger flash and color change
-            portalController.triggerFlash();
-            
-            // Shift hue slightly on each button press
-            float currentHue = (i * 0.1); // Different hue per button
-            portalController.setBaseHue(currentHue);
-            
-            hasActivity = true;
-            
-            #if DEBUG >= 2
-            Serial.printf("Button %d pressed - portal flash + hue shift\n", i);
-            #endif
-        }
-        lastButtonStates[i] = currentState;
-    }
+FASTRUN void handlePortalInteractions() {
+    // Input reactions come from the rule table (rule_engine.h); any input
+    // event but a release counts as activity for idle detection
+    const bool hasActivity = ruleEngine.processInputs(inputProcessor);
     
-    // Pot activity feedback - hue rotation based on pot movement
-    float totalPotActivity = 0.0;
-    for (int i = 0; i < POT_COUNT; i++) {
-        if (inputProcessor.getPotChanged(i)) {
-            hasActivity = true;
-            
-            // Get normalized pot value (0.0-1.0)
-            float potValue = inputProcessor.getPotMidiValue(i) / 127.0;
-            totalPotActivity += potValue;
-            
-            // Trigger ripple effect at position based on pot
-            uint8_t ripplePos = (uint8_t)(potValue * (LED_COUNT - 1));
-            portalController.triggerRipple(ripplePos);
-        }
+    // Update portal cue handler with activity status
+    portalCueHandler.setInputActivity(hasActivity);
+    
+    // Player took over during the startup show
+    if (hasActivity && startupShowRunning && millis() - startupShowStart >= BOOT_SETTLE_MS) {
+        endStartupShow();
     }
+}
+
+// ===== MAIN LOOP =====
+void loop() {
+    // Track main loop timing for performance monitoring
+    perfMonitor.markLoop();
     
-    // Apply pot-based hue rotation
-    if (totalPotActivity > 0.0) {
-        float hueShift = fmod(totalPotActivity * 0.2, 1.0);  // Smooth hue changes
-        float currentHue = fmod(millis() * 0.0001 + hueShift, 1.0);  // Slow drift + pot influence
-        portalController.setBaseHue(currentHue);
-        
-        // Set activity level for animation intensity
-        portalController.setActivityLevel(min(1.0f, totalPotActivity / POT_COUNT));
+    // Run at most one task slice per pass
+    scheduler.run();
+}
+
+// ===== TASKS =====
+FLASHMEM void registerTasks() {
+    // 1 kHz input scan must finish within its own period
+    scanTaskId = scheduler.addTask("scan", scanTask, SCAN_PERIOD_US, TASK_PRIORITY_CRITICAL);
+    
+    // Portal render and LED show run as two slices so a scan tick can go between
+    portalTaskId = scheduler.addTask("portal", portalTask, PORTAL_FRAME_INTERVAL_US, TASK_PRIORITY_HIGH);
+    
+    // OLED: render, then transfer the frame in small I2C slices
+    oledTaskId = scheduler.addTask("oled", oledTask, 1000000UL / OLED_UPDATE_HZ, TASK_PRIORITY_NORMAL);
+    
+    // Built-in LED blink every second to show we're alive
+    scheduler.addTask("heartbeat", heartbeatTask, 1000000UL, TASK_PRIORITY_LOW);
+    
+    // Deferred OLED init and startup show; disabled once finished
+    bootTaskId = scheduler.addTask("boot", bootTask, 10000UL, TASK_PRIORITY_LOW);
+    
+    #if FLIGHT_RECORDER > 0
+    // Flight recorder cache flush and on-demand dump streaming
+    scheduler.addTask("flight", flightTask, FLIGHT_TASK_PERIOD_US, TASK_PRIORITY_LOW);
+    #endif
+    
+    #if SESSION_RECORDER > 0
+    // Flight recorder entries to the SD card, only while the card is idle
+    scheduler.addTask("session", sessionTask, SESSION_TASK_PERIOD_US, TASK_PRIORITY_LOW);
+    #endif
+    
+    #if INPUT_TRACE > 0
+    // Input trace dump streaming
+    scheduler.addTask("trace", traceTask, INPUT_TRACE_TASK_PERIOD_US, TASK_PRIORITY_LOW);
+    #endif
+    
+    #if EVENT_LOG > 0
+    // Event log text drain and on-demand dump streaming
+    scheduler.addTask("log", logTask, EVENT_LOG_TASK_PERIOD_US, TASK_PRIORITY_LOW);
+    #endif
+    
+    #if SERIAL_MUX > 0
+    // Frames queued channel output onto USB serial ahead of the producers
+    scheduler.addTask("mux", muxTask, SERIAL_MUX_TASK_PERIOD_US, TASK_PRIORITY_NORMAL);
+    #endif
+    
+    #if ETHERNET_OSC > 0
+    // Network poll: received cues, outgoing events and telemetry
+    scheduler.addTask("ethernet", ethernetTask, ETHERNET_TASK_PERIOD_US, TASK_PRIORITY_NORMAL);
+    #endif
+    
+    #if CLUSTER_ROLE != CLUSTER_STANDALONE
+    // Chain frames in and out; its delay adds straight to remote input latency
+    scheduler.addTask("cluster", clusterTask, CLUSTER_TASK_PERIOD_US, TASK_PRIORITY_HIGH);
+    #endif
+    
+    // Deferred EEPROM write for CONFIG_SAVE
+    scheduler.addTask("config", configTask, CONFIG_TASK_PERIOD_US, TASK_PRIORITY_LOW);
+    
+    #if DEBUG >= 1
+    // Test mode: dump input values every 5 seconds
+    scheduler.addTask("testdump", testDumpTask, 5000000UL, TASK_PRIORITY_LOW);
+    #endif
+}
+
+FASTRUN bool scanTask() {
+    const uint32_t tickStart = micros();
+    if (firstScanUs == 0) {
+        firstScanUs = tickStart;
     }
     
-    // Joystick interactions - trigger directional ripples
-    for (int dir = 0; dir < 4; dir++) {
-        static bool lastJoyStates[4] = {false};
-        bool currentState = inputProcessor.getJoystickPressed(dir);
-        
-        if (currentState && !lastJoyStates[dir]) {
-            // Calculate ripple position based on direction
-            uint8_t positions[] = {0, LED_COUNT/2, LED_COUNT/4, 3*LED_COUNT/4}; // Up, Down, Left, Right
-            portalController.triggerRipple(positions[dir]);
-            hasActivity = true;
-            
-            #if DEBUG >= 2
-            Serial.printf("Joystick %s - portal ripple at %d\n", 
-                         dir == 0 ? "UP" : dir == 1 ? "DOWN" : dir == 2 ? "LEFT" : "RIGHT",
-                         positions[dir]);
-            #endif
-        }
-        lastJoyStates[dir] = currentState;
+    // Tuning edits staged during the previous tick take effect here, so a
+    // tick never runs with a half-applied set
+    if (configStore.applyPending()) {
+        applyRuntimeConfig(configStore.get());
     }
     
-    // Switch changes - program switching (optional)
-    if (SWITCH_COUNT > 0) {
-        static bool lastSwitchState = false;
-        bool currentSwitchState = inputProcessor.getSwitchState(0);  // Use first switch
-        
-        if (currentSwitchState != lastSwitchState) {
-            if (currentSwitchState) {
-                // Switch turned on - cycle to next program
-                uint8_t nextProgram = (portalController.getCurrentProgram() + 1) % PORTAL_PROGRAM_COUNT;
-                portalController.setProgram(nextProgram);
-                hasActivity = true;
-                
-                #if DEBUG >= 1
-                Serial.printf("Switch activated - portal program: %d\n", nextProgram);
-                #endif
+    // Phase 2: Robust input processing with debouncing and smoothing
+    {
+        STAGE_SCOPE(perfMonitor, PERF_STAGE_SCAN);
+        #if INPUT_TRACE > 0
+        // TRACE_REPLAY: the captured trace stands in for the pins until it ends
+        static bool replaying = false;
+        RawInputFrame frame;
+        if (inputTrace.nextFrame(frame)) {
+            if (!replaying) {
+                // Start from the trace's first frame with nothing held
+                inputMapper.sendAllNotesOff();
+                inputMapper.reset();
+                inputProcessor.restart(inputTrace.getInitialFrame());
+                replaying = true;
             }
+            inputProcessor.update(frame);
+        } else {
+            replaying = false;
+            inputProcessor.update();
         }
-        lastSwitchState = currentSwitchState;
+        inputProcessor.getRawFrame(frame);
+        inputTrace.capture(frame);
+        #else
+        inputProcessor.update();
+        #endif
     }
     
-    // Update portal cue handler with activity status
-    portalCueHandler.setInputActivity(hasActivity);
-}
-
-// ===== MAIN LOOP =====
-void loop() {
-    // Track main loop timing for performance monitoring
-    static uint32_t loopStartTime = 0;
-    loopStartTime = micros();
-    
-    // Main scan loop at ~1kHz
-    if (mainLoopTimer >= (1000000 / SCAN_HZ)) {
-        mainLoopTimer -= (1000000 / SCAN_HZ);
-        
-        // Phase 2: Robust input processing with debouncing and smoothing
-        inputProcessor.update();
+    {
+        STAGE_SCOPE(perfMonitor, PERF_STAGE_MAPPER);
+        #if CLUSTER_ROLE != CLUSTER_STANDALONE
+        clusterLink.captureInputs(inputProcessor, tickStart);
+        #else
         inputMapper.processInputs();
-        
-        // Handle OLED mode switching with buttons 0 and 1
-        static bool button0WasPressed = false;
-        static bool button1WasPressed = false;
-        
-        bool button0IsPressed = inputProcessor.getButtonState(0);
-        bool button1IsPressed = inputProcessor.getButtonState(1);
-        
-        // Button 0: Next mode (on press, not hold)
-        if (button0IsPressed && !button0WasPressed) {
-            oledDisplay.nextMode();
-        }
-        button0WasPressed = button0IsPressed;
-        
-        // Button 1: Previous mode (on press, not hold)
-        if (button1IsPressed && !button1WasPressed) {
-            oledDisplay.prevMode();
-        }
-        button1WasPressed = button1IsPressed;
-        
-        // Update OLED with current input data
-        updateOledInputData();
-        
-        // Phase 3: Handle portal interactions (button presses, pot changes)
-        handlePortalInteractions();
-        
-        // Handle incoming serial messages for portal cues
+        #endif
+        #if MIDI_LOOPER > 0
+        midiLooper.update(tickStart, portalController.getBpm());
+        midiLooper.captureInputs(inputProcessor);
+        #endif
+    }
+    
+    // Handle OLED mode switching with buttons 0 and 1
+    static bool button0WasPressed = false;
+    static bool button1WasPressed = false;
+    
+    bool button0IsPressed = inputProcessor.getButtonState(0);
+    bool button1IsPressed = inputProcessor.getButtonState(1);
+    
+    // Button 0: Next mode (on press, not hold)
+    if (button0IsPressed && !button0WasPressed) {
+        oledDisplay.nextMode();
+    }
+    button0WasPressed = button0IsPressed;
+    
+    // Button 1: Previous mode (on press, not hold)
+    if (button1IsPressed && !button1WasPressed) {
+        oledDisplay.prevMode();
+    }
+    button1WasPressed = button1IsPressed;
+    
+    // Update OLED with current input data
+    updateOledInputData();
+    
+    // Phase 3: Handle portal interactions (button presses, pot changes)
+    handlePortalInteractions();
+    
+    // Handle incoming serial messages for portal cues
+    {
+        STAGE_SCOPE(perfMonitor, PERF_STAGE_SERIAL);
         portalCueHandler.processSerialInput();
-        
+    
         // Handle any incoming MIDI (legacy support)
         #ifdef USB_MIDI
         while (usbMIDI.read()) {
             // Check if it's a portal control CC (legacy MIDI support)
             if (usbMIDI.getType() == usbMIDI.ControlChange) {
                 portalCueHandler.handleMidiCC(usbMIDI.getData1(), usbMIDI.getData2());
+            } else if (usbMIDI.getType() == usbMIDI.SystemExclusive) {
+                // Rule table uploads and runtime tuning over SysEx (see rule_engine.h, config_store.h)
+                uint8_t reply[ConfigStore::SYSEX_MAX_SIZE];
+                size_t replyLength = ruleEngine.handleSysEx(usbMIDI.getSysExArray(),
+                                                            usbMIDI.getSysExArrayLength(), reply);
+                if (replyLength == 0) {
+                    replyLength = configStore.handleSysEx(usbMIDI.getSysExArray(),
+                                                          usbMIDI.getSysExArrayLength(), reply);
+                }
+                if (replyLength > 0) {
+                    usbMIDI.sendSysEx(replyLength, reply, true);
+                }
             }
         }
         #endif
-        
-        // Update portal cue handler (for idle detection, auto-switching)
-        portalCueHandler.update();
     }
     
-    // OLED display update at ~20Hz (every 50ms)
-    if (oledUpdateTimer >= 50) {
-        oledUpdateTimer -= 50;
-        
-        // Update system info for OLED
-        uint32_t currentLoopTime = micros() - loopStartTime;
-        oledDisplay.updateSystemInfo(currentLoopTime, inputProcessor.isIdle(), millis());
-        
-        // Update display
-        oledDisplay.update();
-    }
+    // Update portal cue handler (for idle detection, auto-switching)
+    portalCueHandler.update();
     
-    // Portal animation at ~60Hz
-    if (portalFrameTimer >= PORTAL_FRAME_INTERVAL_US) {
-        portalFrameTimer -= PORTAL_FRAME_INTERVAL_US;
-        
-        // Phase 3: Update portal controller (handles all animations)
+    #if FLIGHT_RECORDER > 0
+    const uint32_t tickUs = micros() - tickStart;
+    flightRecorder.recordAt(tickStart, FLIGHT_TICK, 0, tickUs < 0xFFFF ? tickUs : 0xFFFF);
+    #endif
+    
+    return false;
+}
+
+FASTRUN bool portalTask() {
+    static bool frameRendered = false;
+    
+    if (!frameRendered) {
+        // Slice 1: Phase 3 portal controller renders the frame (all animations)
+        STAGE_SCOPE(perfMonitor, PERF_STAGE_PORTAL);
         portalController.update();
-        FastLED.show();
+        FastLED.setBrightness(ledPower.update(leds, LED_COUNT));
+        frameRendered = true;
+        return true;
     }
     
-    // Built-in LED blink every second to show we're alive
-    if (blinkTimer >= 1000) {
-        blinkTimer -= 1000;
-        builtinLedState = !builtinLedState;
-        digitalWrite(BUILTIN_LED_PIN, builtinLedState);
+    // Slice 2: push the frame to the LED strip
+    STAGE_SCOPE(perfMonitor, PERF_STAGE_LED_SHOW);
+    FastLED.show();
+    frameRendered = false;
+    return false;
+}
+
+bool oledTask() {
+    static bool transferring = false;
+    
+    STAGE_SCOPE(perfMonitor, PERF_STAGE_OLED);
+    bool more;
+    if (!transferring) {
+        // Slice 1: update system info and render the frame into the buffer
+        const TaskScheduler::TaskStats& scanStats = scheduler.getStats(scanTaskId);
+        const TaskScheduler::TaskStats& portalStats = scheduler.getStats(portalTaskId);
+        perfMonitor.setDeadlineMisses(scanStats.missedReleases, portalStats.missedReleases);
+        oledDisplay.updateSystemInfo(perfMonitor.getLoopMaxUs(), inputProcessor.isIdle(), millis());
         
-        #if DEBUG >= 1
-        // Check for idle state
-        if (inputProcessor.isIdle()) {
-            Serial.printf("Heartbeat - IDLE mode (no activity for %lums)\n", 
-                         inputProcessor.getTimeSinceLastActivity());
-        } else {
-            Serial.printf("Heartbeat - ACTIVE (last activity %lums ago)\n",
-                         inputProcessor.getTimeSinceLastActivity());
-        }
-        #endif
+        transferring = oledDisplay.beginFrame();
+        more = transferring;
+    } else {
+        // Following slices: send the frame a few bytes at a time
+        more = oledDisplay.transferSlice();
+        transferring = more;
     }
+    return more;
+}
+
+bool heartbeatTask() {
+    builtinLedState = !builtinLedState;
+    digitalWrite(BUILTIN_LED_PIN, builtinLedState);
+    
+    #if FLIGHT_RECORDER > 0
+    // Keep text out of a binary flight recorder dump
+    if (flightRecorder.isDumping()) return false;
+    #endif
+    #if INPUT_TRACE > 0
+    if (inputTrace.isDumping()) return false;
+    #endif
+    #if EVENT_LOG > 0
+    if (eventLog.isDumping()) return false;
+    #endif
     
-    // Test mode: dump input values every 5 seconds
     #if DEBUG >= 1
-    if (testDumpTimer >= 5000) {
-        testDumpTimer -= 5000;
-        inputProcessor.dumpTestValues();
+    // Check for idle state
+    Print& out = serialChannel(MUX_TELEMETRY);
+    if (inputProcessor.isIdle()) {
+        out.printf("Heartbeat - IDLE mode (no activity for %lums)\n", 
+                   (unsigned long)inputProcessor.getTimeSinceLastActivity());
+    } else {
+        out.printf("Heartbeat - ACTIVE (last activity %lums ago)\n",
+                   (unsigned long)inputProcessor.getTimeSinceLastActivity());
+    }
+    #endif
+    
+    return false;
+}
+
+#if FLIGHT_RECORDER > 0
+bool flightTask() {
+    flightRecorder.dumpSlice(serialChannel(MUX_BULK));
+    flightRecorder.flushToMemory();
+    return false;
+}
+#endif
+
+#if SESSION_RECORDER > 0
+bool sessionTask() {
+    sessionRecorder.update();
+    return false;
+}
+#endif
+
+#if INPUT_TRACE > 0
+bool traceTask() {
+    inputTrace.dumpSlice(serialChannel(MUX_BULK));
+    return false;
+}
+#endif
+
+#if EVENT_LOG > 0
+bool logTask() {
+    if (eventLog.isDumping()) {
+        eventLog.dumpSlice(serialChannel(MUX_BULK));
+        return false;
+    }
+    
+    // Text would corrupt another binary dump in progress
+    #if FLIGHT_RECORDER > 0
+    if (flightRecorder.isDumping()) return false;
+    #endif
+    #if INPUT_TRACE > 0
+    if (inputTrace.isDumping()) return false;
+    #endif
+    eventLog.drainText(serialChannel(MUX_LOG));
+    return false;
+}
+#endif
+
+#if SERIAL_MUX > 0
+bool muxTask() {
+    serialMux.pump();
+    return false;
+}
+#endif
+
+#if ETHERNET_OSC > 0
+bool ethernetTask() {
+    ethernetTransport.poll();
+    return false;
+}
+#endif
+
+#if CLUSTER_ROLE != CLUSTER_STANDALONE
+bool clusterTask() {
+    return clusterLink.poll();
+}
+#endif
+
+bool configTask() {
+    configStore.saveIfRequested();
+    return false;
+}
+
+bool testDumpTask() {
+    #if FLIGHT_RECORDER > 0
+    if (flightRecorder.isDumping()) return false;
+    #endif
+    #if INPUT_TRACE > 0
+    if (inputTrace.isDumping()) return false;
+    #endif
+    #if EVENT_LOG > 0
+    if (eventLog.isDumping()) return false;
+    #endif
+    
+    Print& out = serialChannel(MUX_TELEMETRY);
+    inputProcessor.dumpTestValues(out);
+    scheduler.printStats(out);
+    #if SERIAL_MUX > 0
+    serialMux.printStats(out);
+    #endif
+    #if ETHERNET_OSC > 0
+    ethernetTransport.printStats(out);
+    #endif
+    #if CLUSTER_ROLE != CLUSTER_STANDALONE
+    clusterLink.printStats(out);
+    #endif
+    #if MIDI_LOOPER > 0
+    midiLooper.printStats(out);
+    #endif
+    ruleEngine.printStats(out);
+    inputProcessor.getHealth().printStats(out);
+    ledPower.printStats(out);
+    if (inputMapper.getSwitchSnapshotMode() != RobustMidiMapper::SWITCH_SNAPSHOT_OFF) {
+        out.printf("Switch snapshots: %lu sent for %lu switch changes\n",
+                   (unsigned long)inputMapper.getSnapshotsSent(), (unsigned long)inputMapper.getSnapshotChanges());
     }
+    #if SESSION_RECORDER > 0
+    if (sessionRecorder.getState() != SessionRecorder::SESSION_OFF) sessionRecorder.printStats(out);
     #endif
+    return false;
+}
+
+// ===== RUNTIME CONFIG =====
+void applyRuntimeConfig(const RuntimeConfig& config) {
+    inputProcessor.applyConfig(config);
+    portalCueHandler.setIdleTimeoutMs(config.idleTimeoutMs);
+    inputMapper.setSwitchSnapshotMode(config.switchSnapshot);
+    portalController.setMaxBrightness(config.ledBrightnessMax);
+    ledPower.configure(config.ledBrightnessMax, config.ledPowerBudgetMa);
 }
 
 // ===== OLED INPUT DATA UPDATE =====
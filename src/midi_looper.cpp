@@ -0,0 +1,274 @@
+#include "midi_looper.h"
+#include "memory_placement.h"
+#include "event_log.h"
+
+static_assert(BUTTON_COUNT <= 16, "button masks are 16 bits");
+static_assert((uint32_t)LOOPER_MAX_BEATS * LOOPER_TICKS_PER_BEAT <= 0xFFFF, "loop ticks are 16 bits");
+
+MidiLooper::MidiLooper(MidiOut& midi)
+    : midi(midi)
+    , count(0)
+    , cursor(0)
+    , state(LOOPER_EMPTY)
+    , enabled(false)
+    , quantizeSteps(LOOPER_QUANTIZE_STEPS)
+    , lastUpdate(0)
+    , bpmMilli(0)
+    , remainder(0)
+    , position(0)
+    , length(0)
+    , lastButtons(0)
+    , recording(0)
+    , sounding(0)
+    , played(0)
+    , dropped(0)
+    , maxLateUs(0)
+{
+    memset(shift, 0, sizeof(shift));
+    memset(onTick, 0, sizeof(onTick));
+}
+
+const char* MidiLooper::stateName(uint8_t state) {
+    static const char* const NAMES[] = {"EMPTY", "RECORDING", "PLAYING", "OVERDUBBING"};
+    return state < 4 ? NAMES[state] : "?";
+}
+
+// ===== GESTURES =====
+
+FASTRUN void MidiLooper::captureInputs(const InputProcessor& inputs) {
+    const bool armed = inputs.getSwitchState(LOOPER_SWITCH);
+    if (armed != enabled) setEnabled(armed);
+    if (enabled) {
+        if (inputs.getJoystickPressed(LOOPER_CLEAR_DIRECTION)) clear();
+        if (inputs.getJoystickPressed(LOOPER_RECORD_DIRECTION)) pressRecord();
+    }
+
+    for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+        const uint16_t bit = 1 << i;
+        const bool pressed = inputs.getButtonState(i);
+        if (pressed == ((lastButtons & bit) != 0)) continue;
+        lastButtons ^= bit;
+        if (enabled) noteEdge(i, pressed);
+    }
+}
+
+void MidiLooper::setEnabled(bool armed) {
+    if (!armed) {
+        if (state == LOOPER_RECORDING) {
+            clear();
+        } else {
+            // Close the notes being recorded here, then stop overdubbing
+            for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+                if (recording & (1 << i)) noteEdge(i, false);
+            }
+            if (state == LOOPER_OVERDUBBING) setState(LOOPER_PLAYING);
+            silence();
+        }
+    }
+    enabled = armed;
+}
+
+void MidiLooper::pressRecord() {
+    switch (state) {
+        case LOOPER_EMPTY:
+            // The loop starts on this tick
+            count = 0;
+            cursor = 0;
+            position = 0;
+            remainder = 0;
+            length = 0;
+            recording = 0;
+            setState(LOOPER_RECORDING);
+            break;
+        case LOOPER_RECORDING:
+            closeLoop();
+            setState(LOOPER_PLAYING);
+            break;
+        case LOOPER_PLAYING:
+            setState(LOOPER_OVERDUBBING);
+            break;
+        default:
+            setState(LOOPER_PLAYING);
+            break;
+    }
+}
+
+void MidiLooper::clear() {
+    silence();
+    count = 0;
+    cursor = 0;
+    position = 0;
+    length = 0;
+    recording = 0;
+    setState(LOOPER_EMPTY);
+}
+
+void MidiLooper::setState(uint8_t newState) {
+    state = newState;
+    LOG_EVENT(LOG_LOOPER_STATE, state, length / LOOPER_TICKS_PER_BEAT, count);
+}
+
+// ===== RECORDING =====
+
+uint16_t MidiLooper::snap(uint32_t tick) const {
+    if (quantizeSteps == 0) return tick;
+    const uint32_t grid = quantizeSteps < LOOPER_TICKS_PER_BEAT ? LOOPER_TICKS_PER_BEAT / quantizeSteps : 1;
+    return (tick + grid / 2) / grid * grid;
+}
+
+FASTRUN void MidiLooper::noteEdge(uint8_t button, bool on) {
+    if (button >= BUTTON_COUNT) return;
+    const uint16_t bit = 1 << button;
+
+    if (on) {
+        if ((state != LOOPER_RECORDING && state != LOOPER_OVERDUBBING) || (recording & bit)) return;
+        // Room for this note-on and the note-off of every note still held
+        if (count + 2 + __builtin_popcount(recording) > LOOPER_MAX_EVENTS) {
+            dropped++;
+            LOG_EVENT(LOG_LOOPER_FULL, button);
+            return;
+        }
+        uint32_t tick = snap(position);
+        shift[button] = (int32_t)tick - (int32_t)position;
+        const uint8_t flags = EVENT_ON | (shift[button] > 0 ? EVENT_FRESH : 0);
+        if (length > 0 && tick >= length) tick -= length;
+        onTick[button] = tick;
+        insert(tick, button, flags);
+        recording |= bit;
+        return;
+    }
+
+    // Off, for a note whose on was recorded (even after overdub ended)
+    if (!(recording & bit)) return;
+    recording &= ~bit;
+    int32_t tick = (int32_t)position + shift[button];
+    if (tick < 0) tick += length;
+    if (length > 0 && tick >= length) tick -= length;
+    if ((uint16_t)tick == onTick[button]) {
+        // Never on and off on the same tick
+        tick = length > 0 && tick + 1 >= length ? 0 : tick + 1;
+    }
+    insert(tick, button, shift[button] > 0 ? EVENT_FRESH : 0);
+}
+
+void MidiLooper::insert(uint16_t tick, uint8_t button, uint8_t flags) {
+    // After any events on the same tick
+    uint16_t index = count;
+    while (index > 0 && events[index - 1].tick > tick) index--;
+    memmove(&events[index + 1], &events[index], (count - index) * sizeof(Event));
+    events[index] = {tick, button, flags};
+    count++;
+    // Already behind the clock on this pass: plays next time round
+    if (length > 0 && tick <= position) cursor++;
+}
+
+void MidiLooper::closeLoop() {
+    uint32_t beats = (position + LOOPER_TICKS_PER_BEAT / 2) / LOOPER_TICKS_PER_BEAT;
+    if (beats < 1) beats = 1;
+    if (beats > LOOPER_MAX_BEATS) beats = LOOPER_MAX_BEATS;
+    length = beats * LOOPER_TICKS_PER_BEAT;
+
+    // Fold the pass past the end back onto the loop, keeping tick order
+    for (uint16_t i = 0; i < count; i++) {
+        Event& event = events[i];
+        if ((event.flags & EVENT_FRESH) && event.tick <= position) event.flags &= ~EVENT_FRESH;
+        event.tick %= length;
+    }
+    for (uint16_t i = 1; i < count; i++) {
+        const Event event = events[i];
+        uint16_t j = i;
+        for (; j > 0 && events[j - 1].tick > event.tick; j--) events[j] = events[j - 1];
+        events[j] = event;
+    }
+    for (uint8_t i = 0; i < BUTTON_COUNT; i++) onTick[i] %= length;
+
+    position %= length;
+    cursor = 0;
+    while (cursor < count && events[cursor].tick <= position) cursor++;
+}
+
+// ===== PLAYBACK =====
+
+FASTRUN void MidiLooper::update(uint32_t now, float bpm) {
+    const uint32_t elapsed = now - lastUpdate;
+    lastUpdate = now;
+    bpmMilli = bpm > 0 ? (uint32_t)(bpm * 1000.0f + 0.5f) : 0;
+    if (state == LOOPER_EMPTY) return;
+
+    remainder += (uint64_t)elapsed * bpmMilli * LOOPER_TICKS_PER_BEAT;
+    const uint32_t ticks = remainder / TICK_UNITS;
+    remainder %= TICK_UNITS;
+    if (ticks == 0) return;
+
+    if (state == LOOPER_RECORDING) {
+        position += ticks;
+        if (position >= MAX_TICKS) {
+            // Longest loop reached: it plays from here
+            position = MAX_TICKS;
+            closeLoop();
+            setState(LOOPER_PLAYING);
+        }
+        return;
+    }
+
+    if (ticks >= length) {
+        // Stalled for a whole pass or more: pick up in time rather than
+        // replaying what was missed
+        silence();
+        for (uint16_t i = 0; i < count; i++) events[i].flags &= ~EVENT_FRESH;
+        position = (position + ticks) % length;
+        cursor = 0;
+        while (cursor < count && events[cursor].tick <= position) cursor++;
+        return;
+    }
+
+    uint32_t target = position + ticks;
+    for (;;) {
+        const uint32_t limit = target < length ? target : length - 1;
+        while (cursor < count && events[cursor].tick <= limit) {
+            Event& event = events[cursor++];
+            if (event.flags & EVENT_FRESH) {
+                event.flags &= ~EVENT_FRESH;
+                continue;
+            }
+            if (!enabled) continue;
+            play(event);
+            const uint64_t lateUnits = (uint64_t)(target - event.tick) * TICK_UNITS + remainder;
+            const uint32_t lateUs = bpmMilli ? lateUnits / ((uint64_t)bpmMilli * LOOPER_TICKS_PER_BEAT) : 0;
+            if (lateUs > maxLateUs) maxLateUs = lateUs;
+        }
+        if (target < length) break;
+        target -= length;
+        cursor = 0;
+    }
+    position = target;
+}
+
+void MidiLooper::play(const Event& event) {
+    const uint16_t bit = 1 << event.button;
+    const uint8_t note = BUTTON_NOTES[event.button];
+    if (event.flags & EVENT_ON) {
+        if (sounding & bit) midi.sendNoteOff(note, 0, LOOPER_MIDI_CHANNEL);
+        midi.sendNoteOn(note, MIDI_VELOCITY, LOOPER_MIDI_CHANNEL);
+        sounding |= bit;
+        played++;
+    } else if (sounding & bit) {
+        midi.sendNoteOff(note, 0, LOOPER_MIDI_CHANNEL);
+        sounding &= ~bit;
+    }
+}
+
+void MidiLooper::silence() {
+    for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+        if (sounding & (1 << i)) midi.sendNoteOff(BUTTON_NOTES[i], 0, LOOPER_MIDI_CHANNEL);
+    }
+    sounding = 0;
+}
+
+FLASHMEM void MidiLooper::printStats(Print& out) const {
+    out.printf("=== LOOPER: %s%s, %u beats at %lu.%lu BPM, %u/%u events ===\n", stateName(state),
+               enabled ? "" : " (off)", length / LOOPER_TICKS_PER_BEAT, (unsigned long)(bpmMilli / 1000),
+               (unsigned long)(bpmMilli % 1000 / 100), count, LOOPER_MAX_EVENTS);
+    out.printf("Played %lu notes, worst lateness %lu us, %lu not recorded (buffer full)\n",
+               (unsigned long)played, (unsigned long)maxLateUs, (unsigned long)dropped);
+}
@@ -1,16 +1,19 @@
 #include "midi_out.h"
+#include "memory_placement.h"
 #include "oled_display.h"
+#include "flight_recorder.h"
+#include "event_log.h"
 
 MidiOut::MidiOut() : oledDisplay(nullptr) {
     // Constructor
 }
 
-void MidiOut::begin() {
+FLASHMEM void MidiOut::begin() {
 #ifdef USB_MIDI
     // USB MIDI is automatically initialized when USB_MIDI is defined
     // No explicit initialization needed for Teensy USB MIDI
 #else
-    // In debug mode, just initialize serial for debug output
+    // In debug mode MIDI goes to the event log (text output drains it to Serial)
     // Serial is already initialized in main.cpp
 #endif
 }
@@ -20,11 +23,13 @@ void MidiOut::setOledDisplay(OledDisplay* display) {
 }
 
 void MidiOut::sendNoteOn(uint8_t note, uint8_t velocity, uint8_t channel) {
+    FLIGHT_RECORD(FLIGHT_NOTE_ON, note, velocity | (channel << 8));
+    
 #ifdef USB_MIDI
     usbMIDI.sendNoteOn(note, velocity, channel);
     usbMIDI.send_now();  // Force immediate send
 #else
-    debugMidi("NoteOn", note, velocity, channel);
+    LOG_EVENT(LOG_MIDI_OUT_NOTE_ON, channel, note, velocity);
 #endif
     
     // Log to OLED if available
@@ -34,11 +39,13 @@ void MidiOut::sendNoteOn(uint8_t note, uint8_t velocity, uint8_t channel) {
 }
 
 void MidiOut::sendNoteOff(uint8_t note, uint8_t velocity, uint8_t channel) {
+    FLIGHT_RECORD(FLIGHT_NOTE_OFF, note, velocity | (channel << 8));
+    
 #ifdef USB_MIDI
     usbMIDI.sendNoteOff(note, velocity, channel);
     usbMIDI.send_now();  // Force immediate send
 #else
-    debugMidi("NoteOff", note, velocity, channel);
+    LOG_EVENT(LOG_MIDI_OUT_NOTE_OFF, channel, note, velocity);
 #endif
     
     // Log to OLED if available
@@ -48,11 +55,13 @@ void MidiOut::sendNoteOff(uint8_t note, uint8_t velocity, uint8_t channel) {
 }
 
 void MidiOut::sendControlChange(uint8_t controller, uint8_t value, uint8_t channel) {
+    FLIGHT_RECORD(FLIGHT_CC, controller, value | (channel << 8));
+    
 #ifdef USB_MIDI
     usbMIDI.sendControlChange(controller, value, channel);
     usbMIDI.send_now();  // Force immediate send
 #else
-    debugMidi("CC", controller, value, channel);
+    LOG_EVENT(LOG_MIDI_OUT_CC, channel, controller, value);
 #endif
     
     // Log to OLED if available
@@ -61,15 +70,11 @@ void MidiOut::sendControlChange(uint8_t controller, uint8_t value, uint8_t chann
     }
 }
 
-void MidiOut::debugMidi(const char* type, uint8_t param1, uint8_t param2, uint8_t channel) {
-#ifndef USB_MIDI
-    Serial.print("MIDI ");
-    Serial.print(type);
-    Serial.print(" Ch:");
-    Serial.print(channel);
-    Serial.print(" P1:");
-    Serial.print(param1);
-    Serial.print(" P2:");
-    Serial.println(param2);
+void MidiOut::sendSysEx(const uint8_t* data, uint8_t length) {
+#ifdef USB_MIDI
+    usbMIDI.sendSysEx(length, data, true);
+    usbMIDI.send_now();  // Force immediate send
+#else
+    LOG_EVENT(LOG_MIDI_OUT_SYSEX, length, length > 3 ? data[3] : 0);
 #endif
 }
@@ -1,4 +1,6 @@
 #include "oled_display.h"
+#include "memory_placement.h"
+#include "perf_monitor.h"
 
 // Note names for MIDI display
 const char* OledDisplay::NOTE_NAMES[12] = {
@@ -6,18 +8,23 @@ const char* OledDisplay::NOTE_NAMES[12] = {
 };
 
 OledDisplay::OledDisplay() : 
-    display(OLED_WIDTH, OLED_HEIGHT, &Wire, -1),
+    display(OLED_WIDTH, OLED_HEIGHT, &Wire, -1, OLED_I2C_CLOCK_HZ, OLED_I2C_CLOCK_HZ),
+    text(nullptr, OLED_WIDTH, OLED_HEIGHT),
     initialized(false),
     currentMode(MIDI_LOG),
+    transferOffset(0),
     lastUpdate(0),
     modeDisplayTime(0),
+    initTime(0),
     midiLogIndex(0),
     buttonActivity(0),
     potActivity(0),
     switchActivity(0),
     loopTimeUs(0),
     isIdle(false),
-    uptime(0)
+    uptime(0),
+    bootTimeUs(0),
+    perfMonitor(nullptr)
 {
     // Initialize MIDI log
     for (int i = 0; i < MIDI_LOG_SIZE; i++) {
@@ -33,7 +40,7 @@ OledDisplay::OledDisplay() :
     for (int i = 0; i < 4; i++) joystickStates[i] = false;
 }
 
-bool OledDisplay::begin() {
+FLASHMEM bool OledDisplay::begin() {
     // Initialize I2C
     Wire.begin();
     
@@ -45,6 +52,9 @@ bool OledDisplay::begin() {
         return false;
     }
     
+    // Page buffer is allocated by begin(); hand it to the glyph blitter
+    text.setBuffer(display.getBuffer());
+    
     // Initial display setup
     display.clearDisplay();
     display.setTextSize(1);
@@ -56,10 +66,11 @@ bool OledDisplay::begin() {
     display.println("Machine");
     display.println("");
     display.println("OLED Initialized");
-    display.display();
     
     initialized = true;
     modeDisplayTime = millis();
+    initTime = modeDisplayTime;
+    transferOffset = 0;
     
     #if DEBUG >= 1
     Serial.printf("OLED: Initialized %dx%d display at 0x%02X\n", 
@@ -77,6 +88,53 @@ void OledDisplay::update() {
     if (now - lastUpdate < 50) return;
     lastUpdate = now;
     
+    renderCurrentMode();
+    display.display();
+}
+
+bool OledDisplay::beginFrame() {
+    if (!initialized) return false;
+    
+    renderCurrentMode();
+    transferOffset = 0;
+    return true;
+}
+
+bool OledDisplay::transferSlice() {
+    if (!initialized) return false;
+    
+    const uint16_t frameBytes = OLED_WIDTH * OLED_HEIGHT / 8;
+    
+    if (transferOffset == 0) {
+        // Address the full screen; the controller auto-increments from here
+        display.ssd1306_command(SSD1306_PAGEADDR);
+        display.ssd1306_command(0);
+        display.ssd1306_command(OLED_HEIGHT / 8 - 1);
+        display.ssd1306_command(SSD1306_COLUMNADDR);
+        display.ssd1306_command(0);
+        display.ssd1306_command(OLED_WIDTH - 1);
+    }
+    
+    uint16_t count = min((uint16_t)OLED_TRANSFER_SLICE_BYTES, (uint16_t)(frameBytes - transferOffset));
+    const uint8_t* data = display.getBuffer() + transferOffset;
+    
+    Wire.beginTransmission(OLED_I2C_ADDRESS);
+    Wire.write((uint8_t)0x40);  // Co = 0, D/C = 1: data stream follows
+    Wire.write(data, count);
+    Wire.endTransmission();
+    
+    transferOffset += count;
+    if (transferOffset >= frameBytes) {
+        transferOffset = 0;
+        return false;
+    }
+    return true;
+}
+
+void OledDisplay::renderCurrentMode() {
+    // Keep the startup message in the buffer until it has been up long enough
+    if (millis() - initTime < OLED_SPLASH_MS) return;
+    
     display.clearDisplay();
     
     // Draw current mode content
@@ -93,6 +151,9 @@ void OledDisplay::update() {
         case INFO:
             drawInfo();
             break;
+        case PERF:
+            drawPerf();
+            break;
         case MODE_COUNT:
         default:
             // Invalid mode, reset to default
@@ -100,8 +161,6 @@ void OledDisplay::update() {
             drawMidiLog();
             break;
     }
-    
-    display.display();
 }
 
 void OledDisplay::nextMode() {
@@ -130,31 +189,26 @@ void OledDisplay::setMode(DisplayMode mode) {
 }
 
 void OledDisplay::logMidiNoteOn(uint8_t note, uint8_t velocity, uint8_t channel) {
-    const char* noteName = getNoteNameFromMidi(note);
-    int octave = (note / 12) - 1;
-    
     char message[32];
-    snprintf(message, sizeof(message), "NoteOn %s%d V%d Ch%d", 
-             noteName, octave, velocity, channel);
-    
+    formatNoteMessage(message, sizeof(message), "NoteOn ", note, velocity, channel);
     addMidiLogEntry(message);
 }
 
 void OledDisplay::logMidiNoteOff(uint8_t note, uint8_t velocity, uint8_t channel) {
-    const char* noteName = getNoteNameFromMidi(note);
-    int octave = (note / 12) - 1;
-    
     char message[32];
-    snprintf(message, sizeof(message), "NoteOff %s%d V%d Ch%d", 
-             noteName, octave, velocity, channel);
-    
+    formatNoteMessage(message, sizeof(message), "NoteOff ", note, velocity, channel);
     addMidiLogEntry(message);
 }
 
 void OledDisplay::logMidiCC(uint8_t controller, uint8_t value, uint8_t channel) {
-    char message[32];
-    snprintf(message, sizeof(message), "CC%d=%d Ch%d", 
-             controller, value, channel);
+    // "CC<n>=<v> Ch<c>" built without snprintf (called from the scan tick)
+    char message[32] = {};
+    char* p = OledText::appendString(message, "CC", message + sizeof(message) - 1);
+    p = OledText::formatUInt(p, controller);
+    *p++ = '=';
+    p = OledText::formatUInt(p, value);
+    p = OledText::appendString(p, " Ch", message + sizeof(message) - 1);
+    OledText::formatUInt(p, channel);
     
     addMidiLogEntry(message);
 }
@@ -209,15 +263,15 @@ void OledDisplay::drawMidiLog() {
         int index = (midiLogIndex - 1 - i + MIDI_LOG_SIZE) % MIDI_LOG_SIZE;
         
         if (midiLog[index].valid) {
-            display.setCursor(0, y);
+            int16_t x = 0;
             
             // Show relative timestamp
             uint32_t age = millis() - midiLog[index].timestamp;
             if (age < 10000) {
-                display.printf("%ds %s", age / 1000, midiLog[index].text);
-            } else {
-                display.print(midiLog[index].text);
+                x = text.drawUInt(x, y, age / 1000);
+                x = text.drawString(x, y, "s ");
             }
+            text.drawString(x, y, midiLog[index].text);
             
             y += 8;
             displayed++;
@@ -226,49 +280,41 @@ void OledDisplay::drawMidiLog() {
     
     // Show message if no MIDI activity
     if (displayed == 0) {
-        display.setCursor(0, 28);
-        display.println("No MIDI activity");
-        display.println("yet...");
+        text.drawString(0, 28, "No MIDI activity");
+        text.drawString(0, 36, "yet...");
     }
 }
 
 void OledDisplay::drawStatus() {
     drawHeader();
     
-    // Show button states
-    display.setCursor(0, 16);
-    display.print("Btns:");
+    // Show button states (5 per row)
+    int16_t x = text.drawString(0, 16, "Btns:");
     for (int i = 0; i < 10; i++) {
-        if (i == 5) {
-            display.setCursor(0, 24);
-            display.print("     ");
-        }
-        display.print(buttonStates[i] ? "1" : "0");
+        int y = (i < 5) ? 16 : 24;
+        text.drawChar(x + (i % 5) * OledTextRenderer::CELL_WIDTH, y, buttonStates[i] ? '1' : '0');
     }
     
     // Show pot values
-    display.setCursor(0, 32);
-    display.printf("Pots: %d %d %d %d", 
-                   potValues[0], potValues[1], potValues[2], potValues[3]);
-    
-    // Show switch states
-    display.setCursor(0, 40);
-    display.print("Switches:");
-    display.setCursor(0, 48);
+    x = text.drawString(0, 32, "Pots:");
+    for (int i = 0; i < 4; i++) {
+        x = text.drawChar(x, 32, ' ');
+        x = text.drawUInt(x, 32, potValues[i]);
+    }
+    
+    // Show switch states (8 on the first row, 4 on the second)
+    text.drawString(0, 40, "Switches:");
     for (int i = 0; i < 12; i++) {
-        display.print(switchStates[i] ? "1" : "0");
-        if (i == 7) {
-            display.setCursor(0, 56);
-        }
+        int y = (i < 8) ? 48 : 56;
+        text.drawChar((i % 8) * OledTextRenderer::CELL_WIDTH, y, switchStates[i] ? '1' : '0');
     }
     
     // Show joystick
-    display.setCursor(80, 48);
-    display.printf("Joy:%s%s%s%s", 
-                   joystickStates[0] ? "U" : "",
-                   joystickStates[1] ? "D" : "",
-                   joystickStates[2] ? "L" : "",
-                   joystickStates[3] ? "R" : "");
+    x = text.drawString(80, 48, "Joy:");
+    if (joystickStates[0]) x = text.drawChar(x, 48, 'U');
+    if (joystickStates[1]) x = text.drawChar(x, 48, 'D');
+    if (joystickStates[2]) x = text.drawChar(x, 48, 'L');
+    if (joystickStates[3]) x = text.drawChar(x, 48, 'R');
 }
 
 void OledDisplay::drawActivity() {
@@ -278,8 +324,7 @@ void OledDisplay::drawActivity() {
     int y = 20;
     
     // Button activity bars
-    display.setCursor(0, y);
-    display.print("Buttons:");
+    text.drawString(0, y, "Buttons:");
     y += 10;
     
     for (int i = 0; i < 10; i++) {
@@ -290,8 +335,7 @@ void OledDisplay::drawActivity() {
     y += 12;
     
     // Pot activity bars
-    display.setCursor(0, y);
-    display.print("Pots:");
+    text.drawString(0, y, "Pots:");
     y += 10;
     
     for (int i = 0; i < 4; i++) {
@@ -310,36 +354,97 @@ void OledDisplay::drawInfo() {
     drawHeader();
     
     // System information
-    display.setCursor(0, 16);
-    display.printf("Loop: %luus", loopTimeUs);
+    int16_t x = text.drawString(0, 16, "Loop max: ");
+    x = text.drawUInt(x, 16, loopTimeUs);
+    text.drawString(x, 16, "us");
     
-    display.setCursor(0, 24);
-    display.printf("State: %s", isIdle ? "IDLE" : "ACTIVE");
+    x = text.drawString(0, 24, "State: ");
+    text.drawString(x, 24, isIdle ? "IDLE" : "ACTIVE");
     
-    display.setCursor(0, 32);
     uint32_t uptimeSeconds = uptime / 1000;
     uint32_t minutes = uptimeSeconds / 60;
     uint32_t seconds = uptimeSeconds % 60;
-    display.printf("Uptime: %lum%lus", minutes, seconds);
+    x = text.drawString(0, 32, "Uptime: ");
+    x = text.drawUInt(x, 32, minutes);
+    x = text.drawChar(x, 32, 'm');
+    x = text.drawUInt(x, 32, seconds);
+    text.drawChar(x, 32, 's');
     
-    display.setCursor(0, 40);
-    display.printf("Mode: %d/%d", currentMode + 1, MODE_COUNT);
+    x = text.drawString(0, 40, "Mode: ");
+    x = text.drawUInt(x, 40, currentMode + 1);
+    x = text.drawChar(x, 40, '/');
+    text.drawUInt(x, 40, MODE_COUNT);
     
-    display.setCursor(0, 48);
-    display.print("MIDI Log Mode");
+    x = text.drawString(0, 48, "1st scan: ");
+    x = text.drawUInt(x, 48, bootTimeUs / 1000);
+    text.drawString(x, 48, "ms");
     
     #ifdef USB_MIDI
-    display.setCursor(0, 56);
-    display.print("USB: MIDI");
+    text.drawString(0, 56, "USB: MIDI");
     #else
-    display.setCursor(0, 56);
-    display.print("USB: Serial");
+    text.drawString(0, 56, "USB: Serial");
     #endif
 }
 
+void OledDisplay::drawPerf() {
+    drawHeader();
+    
+    if (!perfMonitor) {
+        text.drawString(0, 28, "No perf data");
+        return;
+    }
+    
+    // Left half: one row per stage. Bar fill = average call time, tick = worst
+    // call, both relative to the stage budget (full bar = at/over budget)
+    const int barX = 20;
+    const uint32_t barWidth = 40;
+    for (uint8_t stage = 0; stage < PERF_STAGE_COUNT; stage++) {
+        int y = 16 + stage * 8;
+        const PerfMonitor::StageStats& stats = perfMonitor->getStageStats(stage);
+        uint32_t budget = PERF_STAGE_BUDGET_US[stage];
+        
+        text.drawString(0, y, PERF_STAGE_LABELS[stage]);
+        display.drawRect(barX, y + 1, barWidth, 6, SSD1306_WHITE);
+        
+        uint32_t avgWidth = min(barWidth, (stats.avgUs() * barWidth + budget - 1) / budget);
+        if (avgWidth > 0) {
+            display.fillRect(barX, y + 1, avgWidth, 6, SSD1306_WHITE);
+        }
+        if (stats.calls > 0) {
+            uint32_t maxX = min(barWidth - 1, (stats.maxUs * (barWidth - 1)) / budget);
+            display.drawFastVLine(barX + maxX, y, 8, SSD1306_WHITE);
+        }
+    }
+    
+    // Right half, top: loop pass histogram, one 3px column per power-of-two
+    // bin from 1us to 65ms; column height is log2 of the bin count
+    const LogHistogram& histogram = perfMonitor->getLoopHistogram();
+    const int histX = 64;
+    const int histBottom = 31;
+    for (uint8_t bin = 1; bin <= 16; bin++) {
+        uint32_t count = histogram.bins[bin];
+        if (count == 0) continue;
+        int height = min(16, 32 - __builtin_clz(count));
+        display.fillRect(histX + (bin - 1) * 4, histBottom - height + 1, 3, height, SSD1306_WHITE);
+    }
+    
+    // Right half, bottom: loop p99/max (us) and deadline misses since boot
+    int16_t x = text.drawString(histX, 32, "p99 ");
+    text.drawUInt(x, 32, perfMonitor->getLoopP99Us());
+    x = text.drawString(histX, 40, "max ");
+    text.drawUInt(x, 40, perfMonitor->getLoopMaxUs());
+    x = text.drawString(histX, 48, "miss ");
+    text.drawUInt(x, 48, perfMonitor->getMissedScanTicks());
+    x = text.drawString(histX, 56, "drop ");
+    text.drawUInt(x, 56, perfMonitor->getDroppedFrames());
+}
+
 void OledDisplay::addMidiLogEntry(const char* message) {
-    strncpy(midiLog[midiLogIndex].text, message, sizeof(midiLog[midiLogIndex].text) - 1);
-    midiLog[midiLogIndex].text[sizeof(midiLog[midiLogIndex].text) - 1] = '\0';
+    // Clamped copy rather than snprintf: this runs from the scan tick
+    char* text = midiLog[midiLogIndex].text;
+    size_t length = strnlen(message, sizeof(midiLog[midiLogIndex].text) - 1);
+    memcpy(text, message, length);
+    text[length] = '\0';
     midiLog[midiLogIndex].timestamp = millis();
     midiLog[midiLogIndex].valid = true;
     
@@ -348,15 +453,17 @@ void OledDisplay::addMidiLogEntry(const char* message) {
 
 void OledDisplay::drawHeader() {
     // Mode indicator at top
-    const char* modeNames[] = {"MIDI LOG", "STATUS", "ACTIVITY", "INFO"};
+    const char* modeNames[] = {"MIDI LOG", "STATUS", "ACTIVITY", "INFO", "PERF"};
     
-    display.setCursor(0, 0);
-    display.print(modeNames[currentMode]);
+    text.drawString(0, 0, modeNames[currentMode]);
     
     // Show mode switch indicator if recently changed
     if (millis() - modeDisplayTime < 2000) {
-        display.setCursor(80, 0);
-        display.printf("(%d/%d)", currentMode + 1, MODE_COUNT);
+        int16_t x = text.drawChar(80, 0, '(');
+        x = text.drawUInt(x, 0, currentMode + 1);
+        x = text.drawChar(x, 0, '/');
+        x = text.drawUInt(x, 0, MODE_COUNT);
+        text.drawChar(x, 0, ')');
     }
     
     // Draw horizontal line
@@ -366,3 +473,16 @@ void OledDisplay::drawHeader() {
 const char* OledDisplay::getNoteNameFromMidi(uint8_t note) {
     return NOTE_NAMES[note % 12];
 }
+
+void OledDisplay::formatNoteMessage(char* out, size_t size, const char* type,
+                                    uint8_t note, uint8_t velocity, uint8_t channel) {
+    // "<type><name><octave> V<vel> Ch<ch>" built without snprintf
+    char* end = out + size - 1;
+    char* p = OledText::appendString(out, type, end);
+    p = OledText::appendString(p, getNoteNameFromMidi(note), end);
+    p = OledText::formatInt(p, (note / 12) - 1);
+    p = OledText::appendString(p, " V", end);
+    p = OledText::formatUInt(p, velocity);
+    p = OledText::appendString(p, " Ch", end);
+    OledText::formatUInt(p, channel);
+}
@@ -0,0 +1,209 @@
+#include "oled_text.h"
+
+// Classic 5x7 LCD font, printable ASCII 0x20-0x7E.
+// Column-major, LSB = top row, same bit order as the SSD1306 pages.
+const uint8_t OLED_FONT_5X7[] = {
+    0x00, 0x00, 0x00, 0x00, 0x00,  // ' '
+    0x00, 0x00, 0x5F, 0x00, 0x00,  // '!'
+    0x00, 0x07, 0x00, 0x07, 0x00,  // '"'
+    0x14, 0x7F, 0x14, 0x7F, 0x14,  // '#'
+    0x24, 0x2A, 0x7F, 0x2A, 0x12,  // '$'
+    0x23, 0x13, 0x08, 0x64, 0x62,  // '%'
+    0x36, 0x49, 0x55, 0x22, 0x50,  // '&'
+    0x00, 0x05, 0x03, 0x00, 0x00,  // '''
+    0x00, 0x1C, 0x22, 0x41, 0x00,  // '('
+    0x00, 0x41, 0x22, 0x1C, 0x00,  // ')'
+    0x14, 0x08, 0x3E, 0x08, 0x14,  // '*'
+    0x08, 0x08, 0x3E, 0x08, 0x08,  // '+'
+    0x00, 0x50, 0x30, 0x00, 0x00,  // ','
+    0x08, 0x08, 0x08, 0x08, 0x08,  // '-'
+    0x00, 0x60, 0x60, 0x00, 0x00,  // '.'
+    0x20, 0x10, 0x08, 0x04, 0x02,  // '/'
+    0x3E, 0x51, 0x49, 0x45, 0x3E,  // '0'
+    0x00, 0x42, 0x7F, 0x40, 0x00,  // '1'
+    0x42, 0x61, 0x51, 0x49, 0x46,  // '2'
+    0x21, 0x41, 0x45, 0x4B, 0x31,  // '3'
+    0x18, 0x14, 0x12, 0x7F, 0x10,  // '4'
+    0x27, 0x45, 0x45, 0x45, 0x39,  // '5'
+    0x3C, 0x4A, 0x49, 0x49, 0x30,  // '6'
+    0x01, 0x71, 0x09, 0x05, 0x03,  // '7'
+    0x36, 0x49, 0x49, 0x49, 0x36,  // '8'
+    0x06, 0x49, 0x49, 0x29, 0x1E,  // '9'
+    0x00, 0x36, 0x36, 0x00, 0x00,  // ':'
+    0x00, 0x56, 0x36, 0x00, 0x00,  // ';'
+    0x08, 0x14, 0x22, 0x41, 0x00,  // '<'
+    0x14, 0x14, 0x14, 0x14, 0x14,  // '='
+    0x00, 0x41, 0x22, 0x14, 0x08,  // '>'
+    0x02, 0x01, 0x51, 0x09, 0x06,  // '?'
+    0x32, 0x49, 0x79, 0x41, 0x3E,  // '@'
+    0x7E, 0x11, 0x11, 0x11, 0x7E,  // 'A'
+    0x7F, 0x49, 0x49, 0x49, 0x36,  // 'B'
+    0x3E, 0x41, 0x41, 0x41, 0x22,  // 'C'
+    0x7F, 0x41, 0x41, 0x22, 0x1C,  // 'D'
+    0x7F, 0x49, 0x49, 0x49, 0x41,  // 'E'
+    0x7F, 0x09, 0x09, 0x09, 0x01,  // 'F'
+    0x3E, 0x41, 0x49, 0x49, 0x7A,  // 'G'
+    0x7F, 0x08, 0x08, 0x08, 0x7F,  // 'H'
+    0x00, 0x41, 0x7F, 0x41, 0x00,  // 'I'
+    0x20, 0x40, 0x41, 0x3F, 0x01,  // 'J'
+    0x7F, 0x08, 0x14, 0x22, 0x41,  // 'K'
+    0x7F, 0x40, 0x40, 0x40, 0x40,  // 'L'
+    0x7F, 0x02, 0x0C, 0x02, 0x7F,  // 'M'
+    0x7F, 0x04, 0x08, 0x10, 0x7F,  // 'N'
+    0x3E, 0x41, 0x41, 0x41, 0x3E,  // 'O'
+    0x7F, 0x09, 0x09, 0x09, 0x06,  // 'P'
+    0x3E, 0x41, 0x51, 0x21, 0x5E,  // 'Q'
+    0x7F, 0x09, 0x19, 0x29, 0x46,  // 'R'
+    0x46, 0x49, 0x49, 0x49, 0x31,  // 'S'
+    0x01, 0x01, 0x7F, 0x01, 0x01,  // 'T'
+    0x3F, 0x40, 0x40, 0x40, 0x3F,  // 'U'
+    0x1F, 0x20, 0x40, 0x20, 0x1F,  // 'V'
+    0x3F, 0x40, 0x38, 0x40, 0x3F,  // 'W'
+    0x63, 0x14, 0x08, 0x14, 0x63,  // 'X'
+    0x07, 0x08, 0x70, 0x08, 0x07,  // 'Y'
+    0x61, 0x51, 0x49, 0x45, 0x43,  // 'Z'
+    0x00, 0x7F, 0x41, 0x41, 0x00,  // '['
+    0x02, 0x04, 0x08, 0x10, 0x20,  // '\'
+    0x00, 0x41, 0x41, 0x7F, 0x00,  // ']'
+    0x04, 0x02, 0x01, 0x02, 0x04,  // '^'
+    0x40, 0x40, 0x40, 0x40, 0x40,  // '_'
+    0x00, 0x01, 0x02, 0x04, 0x00,  // '`'
+    0x20, 0x54, 0x54, 0x54, 0x78,  // 'a'
+    0x7F, 0x48, 0x44, 0x44, 0x38,  // 'b'
+    0x38, 0x44, 0x44, 0x44, 0x20,  // 'c'
+    0x38, 0x44, 0x44, 0x48, 0x7F,  // 'd'
+    0x38, 0x54, 0x54, 0x54, 0x18,  // 'e'
+    0x08, 0x7E, 0x09, 0x01, 0x02,  // 'f'
+    0x0C, 0x52, 0x52, 0x52, 0x3E,  // 'g'
+    0x7F, 0x08, 0x04, 0x04, 0x78,  // 'h'
+    0x00, 0x44, 0x7D, 0x40, 0x00,  // 'i'
+    0x20, 0x40, 0x44, 0x3D, 0x00,  // 'j'
+    0x7F, 0x10, 0x28, 0x44, 0x00,  // 'k'
+    0x00, 0x41, 0x7F, 0x40, 0x00,  // 'l'
+    0x7C, 0x04, 0x18, 0x04, 0x78,  // 'm'
+    0x7C, 0x08, 0x04, 0x04, 0x78,  // 'n'
+    0x38, 0x44, 0x44, 0x44, 0x38,  // 'o'
+    0x7C, 0x14, 0x14, 0x14, 0x08,  // 'p'
+    0x08, 0x14, 0x14, 0x18, 0x7C,  // 'q'
+    0x7C, 0x08, 0x04, 0x04, 0x08,  // 'r'
+    0x48, 0x54, 0x54, 0x54, 0x20,  // 's'
+    0x04, 0x3F, 0x44, 0x40, 0x20,  // 't'
+    0x3C, 0x40, 0x40, 0x20, 0x7C,  // 'u'
+    0x1C, 0x20, 0x40, 0x20, 0x1C,  // 'v'
+    0x3C, 0x40, 0x30, 0x40, 0x3C,  // 'w'
+    0x44, 0x28, 0x10, 0x28, 0x44,  // 'x'
+    0x0C, 0x50, 0x50, 0x50, 0x3C,  // 'y'
+    0x44, 0x64, 0x54, 0x4C, 0x44,  // 'z'
+    0x00, 0x08, 0x36, 0x41, 0x00,  // '{'
+    0x00, 0x00, 0x7F, 0x00, 0x00,  // '|'
+    0x00, 0x41, 0x36, 0x08, 0x00,  // '}'
+    0x08, 0x04, 0x08, 0x10, 0x08   // '~'
+};
+
+OledTextRenderer::OledTextRenderer(uint8_t* buffer, uint8_t width, uint8_t height)
+    : buffer(buffer)
+    , width(width)
+    , pages(height / CELL_HEIGHT)
+{
+}
+
+int16_t OledTextRenderer::drawChar(int16_t x, int16_t y, char c) {
+    if (!buffer || x >= width || x + GLYPH_WIDTH <= 0) {
+        return x + CELL_WIDTH;
+    }
+
+    if (c < FIRST_CHAR || c > LAST_CHAR) c = '?';
+    const uint8_t* glyph = &OLED_FONT_5X7[(c - FIRST_CHAR) * GLYPH_WIDTH];
+
+    // Clip glyph columns to the visible area
+    uint8_t firstCol = (x < 0) ? -x : 0;
+    uint8_t lastCol = (x + GLYPH_WIDTH > width) ? width - x : GLYPH_WIDTH;
+
+    int16_t page = y >> 3;
+    uint8_t shift = y & 7;
+
+    if (shift == 0) {
+        // Page-aligned fast path: one OR per glyph column
+        if (page < 0 || page >= pages) return x + CELL_WIDTH;
+        uint8_t* dst = buffer + page * width + x;
+        for (uint8_t col = firstCol; col < lastCol; col++) {
+            dst[col] |= glyph[col];
+        }
+    } else {
+        // Straddles two pages: split each column byte
+        uint8_t* upper = (page >= 0 && page < pages) ? buffer + page * width + x : nullptr;
+        uint8_t* lower = (page + 1 >= 0 && page + 1 < pages) ? buffer + (page + 1) * width + x : nullptr;
+        for (uint8_t col = firstCol; col < lastCol; col++) {
+            if (upper) upper[col] |= glyph[col] << shift;
+            if (lower) lower[col] |= glyph[col] >> (8 - shift);
+        }
+    }
+
+    return x + CELL_WIDTH;
+}
+
+int16_t OledTextRenderer::drawString(int16_t x, int16_t y, const char* text) {
+    while (*text && x < width) {
+        x = drawChar(x, y, *text++);
+    }
+    return x;
+}
+
+int16_t OledTextRenderer::drawUInt(int16_t x, int16_t y, uint32_t value) {
+    char digits[11];
+    OledText::formatUInt(digits, value);
+    return drawString(x, y, digits);
+}
+
+int16_t OledTextRenderer::drawInt(int16_t x, int16_t y, int32_t value) {
+    char digits[12];
+    OledText::formatInt(digits, value);
+    return drawString(x, y, digits);
+}
+
+// ===== FORMATTING HELPERS =====
+
+namespace OledText {
+
+char* formatUInt(char* out, uint32_t value) {
+    // Build digits in reverse, then copy forward
+    char reversed[10];
+    uint8_t count = 0;
+    do {
+        reversed[count++] = '0' + (value % 10);
+        value /= 10;
+    } while (value > 0);
+
+    while (count > 0) {
+        *out++ = reversed[--count];
+    }
+    *out = '\0';
+    return out;
+}
+
+char* formatInt(char* out, int32_t value) {
+    if (value < 0) {
+        *out++ = '-';
+        // Negate in unsigned space so INT32_MIN is handled
+        return formatUInt(out, 0u - (uint32_t)value);
+    }
+    return formatUInt(out, (uint32_t)value);
+}
+
+char* formatHex2(char* out, uint8_t value) {
+    static const char HEX_DIGITS[] = "0123456789ABCDEF";
+    out[0] = HEX_DIGITS[value >> 4];
+    out[1] = HEX_DIGITS[value & 0x0F];
+    out[2] = '\0';
+    return out + 2;
+}
+
+char* appendString(char* out, const char* text, char* end) {
+    while (*text && out < end) {
+        *out++ = *text++;
+    }
+    *out = '\0';
+    return out;
+}
+
+}  // namespace OledText
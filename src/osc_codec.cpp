@@ -0,0 +1,221 @@
+#include "osc_codec.h"
+#include <string.h>
+
+static constexpr uint8_t MAX_BUNDLE_DEPTH = 4;
+
+static size_t padded(size_t size) {
+    return (size + 3) & ~(size_t)3;
+}
+
+// Length of a padded, null-terminated OSC string at p, or 0 if it runs past end
+static size_t stringLength(const uint8_t* p, const uint8_t* end) {
+    const uint8_t* terminator = static_cast<const uint8_t*>(memchr(p, 0, end - p));
+    if (!terminator) return 0;
+    size_t size = padded(terminator - p + 1);
+    return size <= (size_t)(end - p) ? size : 0;
+}
+
+// ===== WRITER =====
+
+OscWriter::OscWriter(uint8_t* buffer, size_t capacity)
+    : buffer(buffer)
+    , capacity(capacity)
+{
+    reset();
+}
+
+void OscWriter::reset() {
+    length = 0;
+    messageStart = 0;
+    bundle = false;
+    overflow = false;
+    messages = 0;
+}
+
+bool OscWriter::put(const void* data, size_t size) {
+    if (overflow || size > capacity - length) {
+        overflow = true;
+        return false;
+    }
+    memcpy(buffer + length, data, size);
+    length += size;
+    return true;
+}
+
+bool OscWriter::putPadded(const void* data, size_t size) {
+    static const uint8_t zeros[4] = {0, 0, 0, 0};
+    return put(data, size) && put(zeros, padded(size) - size);
+}
+
+bool OscWriter::putWord(uint32_t word) {
+    const uint8_t bytes[4] = {(uint8_t)(word >> 24), (uint8_t)(word >> 16), (uint8_t)(word >> 8), (uint8_t)word};
+    return put(bytes, 4);
+}
+
+bool OscWriter::beginBundle() {
+    reset();
+    bundle = true;
+    return putPadded("#bundle", 8) && putWord(0) && putWord(1);
+}
+
+bool OscWriter::beginMessage(const char* address, const char* types) {
+    overflow = false;
+    messageStart = length;
+    if (bundle) putWord(0);  // Element size, filled in by endMessage()
+
+    char tags[16];
+    size_t count = strlen(types);
+    if (count + 2 > sizeof(tags)) {
+        overflow = true;
+        return false;
+    }
+    tags[0] = ',';
+    memcpy(tags + 1, types, count + 1);
+    return putPadded(address, strlen(address) + 1) && putPadded(tags, count + 2);
+}
+
+bool OscWriter::addInt(int32_t value) {
+    return putWord((uint32_t)value);
+}
+
+bool OscWriter::addFloat(float value) {
+    uint32_t word;
+    memcpy(&word, &value, 4);
+    return putWord(word);
+}
+
+bool OscWriter::addBlob(const uint8_t* data, uint32_t size) {
+    return putWord(size) && putPadded(data, size);
+}
+
+bool OscWriter::endMessage() {
+    if (overflow) {
+        length = messageStart;
+        overflow = false;
+        return false;
+    }
+    if (bundle) {
+        const uint32_t size = length - messageStart - 4;
+        const uint8_t bytes[4] = {(uint8_t)(size >> 24), (uint8_t)(size >> 16), (uint8_t)(size >> 8), (uint8_t)size};
+        memcpy(buffer + messageStart, bytes, 4);
+    }
+    messages++;
+    return true;
+}
+
+// ===== MESSAGE =====
+
+bool OscMessage::is(const char* pattern) const {
+    return strcmp(address, pattern) == 0;
+}
+
+uint8_t OscMessage::getArgCount() const {
+    return (uint8_t)strlen(types);
+}
+
+const uint8_t* OscMessage::argAt(uint8_t index, char& type) const {
+    const uint8_t* p = args;
+    for (uint8_t i = 0; types[i]; i++) {
+        size_t size;
+        switch (types[i]) {
+            case 'i':
+            case 'f':
+                size = 4;
+                break;
+            case 'b':
+                if (end - p < 4) return nullptr;
+                size = 4 + padded(OscReader::readWord(p));
+                break;
+            default:
+                return nullptr;  // Other types are not used here
+        }
+        if ((size_t)(end - p) < size) return nullptr;
+        if (i == index) {
+            type = types[i];
+            return p;
+        }
+        p += size;
+    }
+    return nullptr;
+}
+
+bool OscMessage::getInt(uint8_t index, int32_t& value) const {
+    char type;
+    const uint8_t* p = argAt(index, type);
+    if (!p || type == 'b') return false;
+    const uint32_t word = OscReader::readWord(p);
+    if (type == 'i') {
+        value = (int32_t)word;
+    } else {
+        float f;
+        memcpy(&f, &word, 4);
+        value = (int32_t)f;
+    }
+    return true;
+}
+
+bool OscMessage::getFloat(uint8_t index, float& value) const {
+    char type;
+    const uint8_t* p = argAt(index, type);
+    if (!p || type == 'b') return false;
+    const uint32_t word = OscReader::readWord(p);
+    if (type == 'f') {
+        memcpy(&value, &word, 4);
+    } else {
+        value = (float)(int32_t)word;
+    }
+    return true;
+}
+
+bool OscMessage::getBlob(uint8_t index, const uint8_t*& data, uint32_t& size) const {
+    char type;
+    const uint8_t* p = argAt(index, type);
+    if (!p || type != 'b') return false;
+    size = OscReader::readWord(p);
+    data = p + 4;
+    return true;
+}
+
+// ===== READER =====
+
+bool OscReader::parseMessage(const uint8_t* data, size_t size, OscMessage& message) {
+    const uint8_t* end = data + size;
+    size_t addressLength = stringLength(data, end);
+    if (addressLength == 0 || data[0] != '/') return false;
+    const uint8_t* tags = data + addressLength;
+    size_t tagsLength = tags < end ? stringLength(tags, end) : 0;
+    if (tagsLength == 0 || tags[0] != ',') return false;
+
+    message.address = reinterpret_cast<const char*>(data);
+    message.types = reinterpret_cast<const char*>(tags + 1);
+    message.args = tags + tagsLength;
+    message.end = end;
+    return true;
+}
+
+bool OscReader::parseElement(const uint8_t* data, size_t size, Handler handler, void* context, uint8_t depth) {
+    if (size < 8 || (size & 3) != 0) return false;
+
+    if (memcmp(data, "#bundle", 8) != 0) {
+        OscMessage message;
+        if (!parseMessage(data, size, message)) return false;
+        handler(message, context);
+        return true;
+    }
+
+    if (depth >= MAX_BUNDLE_DEPTH || size < 16) return false;
+    size_t offset = 16;  // "#bundle" + time tag
+    while (offset < size) {
+        if (size - offset < 4) return false;
+        const uint32_t elementSize = readWord(data + offset);
+        offset += 4;
+        if (elementSize > size - offset) return false;
+        if (!parseElement(data + offset, elementSize, handler, context, depth + 1)) return false;
+        offset += elementSize;
+    }
+    return true;
+}
+
+bool OscReader::parse(const uint8_t* data, size_t size, Handler handler, void* context) {
+    return parseElement(data, size, handler, context, 0);
+}
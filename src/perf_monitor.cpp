@@ -0,0 +1,47 @@
+#include "perf_monitor.h"
+#include "memory_placement.h"
+
+PerfMonitor::PerfMonitor()
+    : windowStart(0)
+    , lastLoopStart(0)
+    , currentStage(PERF_STAGE_COUNT)
+    , missedScanTicks(0)
+    , droppedFrames(0)
+{
+    memset(stages, 0, sizeof(stages));
+    memset(publishedStages, 0, sizeof(publishedStages));
+}
+
+FASTRUN void PerfMonitor::markLoop() {
+    uint32_t now = micros();
+
+    // Time between consecutive passes covers everything loop() and the
+    // core (yield, USB servicing) did since the last mark
+    if (lastLoopStart != 0) {
+        loopHistogram.add(now - lastLoopStart);
+    } else {
+        windowStart = now;
+    }
+    lastLoopStart = now;
+
+    if (now - windowStart >= PERF_WINDOW_MS * 1000UL) {
+        publishWindow(now);
+    }
+}
+
+FASTRUN void PerfMonitor::endStage(PerfStage stage, uint32_t elapsed) {
+    currentStage = PERF_STAGE_COUNT;
+    StageStats& stats = stages[stage];
+    stats.calls++;
+    stats.totalUs += elapsed;
+    if (elapsed > stats.maxUs) stats.maxUs = elapsed;
+}
+
+void PerfMonitor::publishWindow(uint32_t now) {
+    memcpy(publishedStages, stages, sizeof(stages));
+    publishedLoop = loopHistogram;
+
+    memset(stages, 0, sizeof(stages));
+    loopHistogram.reset();
+    windowStart = now;
+}
@@ -1,5 +1,7 @@
 #include "portal_controller.h"
+#include "memory_placement.h"
 #include "pins.h"
+#include "event_log.h"
 #include <FastLED.h>
 
 PortalController::PortalController() : 
@@ -9,6 +11,7 @@ PortalController::PortalController() :
     intensity(0.7),
     baseHue(0.0),
     globalBrightness(LED_BRIGHTNESS_MAX),
+    maxBrightness(LED_BRIGHTNESS_MAX),
     activityLevel(0.0),
     frameCount(0),
     lastUpdateTime(0),
@@ -27,7 +30,7 @@ PortalController::PortalController() :
     }
 }
 
-void PortalController::begin(CRGB* ledArray) {
+FLASHMEM void PortalController::begin(CRGB* ledArray) {
     leds = ledArray;
     frameCount = 0;
     lastUpdateTime = millis();
@@ -37,7 +40,7 @@ void PortalController::begin(CRGB* ledArray) {
         currentProgram == PORTAL_AMBIENT ? "AMBIENT" : "UNKNOWN");
 }
 
-void PortalController::update() {
+FASTRUN void PortalController::update() {
     if (!leds) return;
     
     frameCount++;
@@ -45,13 +48,19 @@ void PortalController::update() {
     float deltaTime = (currentTime - lastUpdateTime) / 1000.0;
     lastUpdateTime = currentTime;
     
-    // Update animation phase based on time
+    // Update animation phase based on time; wrapped so small steps still register
     animationPhase += deltaTime;
+    if (animationPhase >= PORTAL_ANIMATION_PHASE_WRAP) {
+        animationPhase = fmodf(animationPhase, PORTAL_ANIMATION_PHASE_WRAP);
+    }
     
     // Update BPM phase
     if (bpm > 0) {
         float bpmDelta = (currentTime - lastBpmUpdate) / 1000.0;
         bpmPhase += bpmDelta * (bpm / 60.0);
+        if (bpmPhase >= PORTAL_BPM_PHASE_WRAP) {
+            bpmPhase = fmodf(bpmPhase, PORTAL_BPM_PHASE_WRAP);
+        }
         lastBpmUpdate = currentTime;
     }
     
@@ -88,7 +97,7 @@ void PortalController::setProgram(uint8_t programId) {
         wavePhase = 0.0;
         chaosTimer = 0;
         
-        Serial.printf("Portal program changed to: %d\n", programId);
+        LOG_EVENT(LOG_PORTAL_PROGRAM, programId, programId);
     }
 }
 
@@ -107,7 +116,14 @@ void PortalController::setBaseHue(float hue) {
 }
 
 void PortalController::setBrightness(uint8_t brightness) {
-    globalBrightness = brightness;
+    globalBrightness = brightness < maxBrightness ? brightness : maxBrightness;
+}
+
+void PortalController::setMaxBrightness(uint8_t brightness) {
+    maxBrightness = brightness;
+    if (globalBrightness > maxBrightness) {
+        globalBrightness = maxBrightness;
+    }
 }
 
 void PortalController::triggerFlash() {
@@ -156,7 +172,7 @@ void PortalController::handlePortalCue(uint8_t cueType, uint8_t value) {
             break;
             
         case PORTAL_CUE_BRIGHTNESS:
-            setBrightness((uint8_t)mapFloat(value, 0, 127, 0, LED_BRIGHTNESS_MAX));
+            setBrightness((uint8_t)mapFloat(value, 0, 127, 0, maxBrightness));
             break;
             
         case PORTAL_CUE_FLASH:
@@ -173,7 +189,7 @@ void PortalController::handlePortalCue(uint8_t cueType, uint8_t value) {
 
 // ===== ANIMATION IMPLEMENTATIONS =====
 
-void PortalController::updateSpiral() {
+FASTRUN void PortalController::updateSpiral() {
     spiralPhase += 0.02 * intensity;
     
     float bpmSpeed = sin(bpmPhase * 2 * PI) * 0.5 + 1.0;  // BPM sync
@@ -189,7 +205,7 @@ void PortalController::updateSpiral() {
     }
 }
 
-void PortalController::updatePulse() {
+FASTRUN void PortalController::updatePulse() {
     // Create pulses that emanate from center, synced to BPM
     float pulse = sin(bpmPhase * 2 * PI);
     pulse = max(0.0f, pulse);  // Only positive pulses
@@ -211,7 +227,7 @@ void PortalController::updatePulse() {
     }
 }
 
-void PortalController::updateWave() {
+FASTRUN void PortalController::updateWave() {
     wavePhase += 0.05 * intensity;
     
     // Multiple wave frequencies for complexity
@@ -231,7 +247,7 @@ void PortalController::updateWave() {
     }
 }
 
-void PortalController::updateChaos() {
+FASTRUN void PortalController::updateChaos() {
     chaosTimer++;
     
     // Random mutations based on BPM and activity
@@ -253,7 +269,7 @@ void PortalController::updateChaos() {
     }
 }
 
-void PortalController::updateAmbient() {
+FASTRUN void PortalController::updateAmbient() {
     // Slow, peaceful color cycling
     for (int i = 0; i < LED_COUNT; i++) {
         float slowPhase = animationPhase * 0.1;
@@ -268,7 +284,7 @@ void PortalController::updateAmbient() {
     }
 }
 
-void PortalController::updateIdle() {
+FASTRUN void PortalController::updateIdle() {
     // Very minimal, low brightness ambient mode
     uint8_t idleBrightness = (globalBrightness * IDLE_BRIGHTNESS_CAP_PCT) / 100;
     
@@ -283,7 +299,7 @@ void PortalController::updateIdle() {
     }
 }
 
-void PortalController::updateRipple() {
+FASTRUN void PortalController::updateRipple() {
     // Primary ripple animation (can be combined with ripple effects)
     updateAmbient();  // Base ambient pattern
     
@@ -293,7 +309,7 @@ void PortalController::updateRipple() {
     }
 }
 
-void PortalController::updateRainbow() {
+FASTRUN void PortalController::updateRainbow() {
     // Smooth rainbow that rotates around the circle
     float rainbowSpeed = 0.01 + (bpm / 1200.0);  // BPM affects speed
     
@@ -305,7 +321,7 @@ void PortalController::updateRainbow() {
     }
 }
 
-void PortalController::updatePlasma() {
+FASTRUN void PortalController::updatePlasma() {
     // Plasma-like flowing colors using multiple sine waves
     for (int i = 0; i < LED_COUNT; i++) {
         float x = (float)i / LED_COUNT;
@@ -324,7 +340,7 @@ void PortalController::updatePlasma() {
     }
 }
 
-void PortalController::updateBreathe() {
+FASTRUN void PortalController::updateBreathe() {
     // Gentle breathing effect synchronized to BPM
     float breathe = sin(bpmPhase * PI) * 0.5 + 0.5;  // 0-1 breathing cycle
     breathe = smoothstep(0.0, 1.0, breathe);  // Smooth curve
@@ -339,13 +355,13 @@ void PortalController::updateBreathe() {
 
 // ===== HELPER FUNCTIONS =====
 
-void PortalController::clearLeds() {
+FASTRUN void PortalController::clearLeds() {
     for (int i = 0; i < LED_COUNT; i++) {
         leds[i] = CRGB::Black;
     }
 }
 
-void PortalController::applyInteractionEffects() {
+FASTRUN void PortalController::applyInteractionEffects() {
     // Apply flash effect
     if (flashActive) {
         if (flashTimer < 200) {  // 200ms flash duration
@@ -385,21 +401,21 @@ void PortalController::applyInteractionEffects() {
 
 // ===== UTILITY FUNCTIONS =====
 
-uint8_t PortalController::wrapAround(int16_t position) const {
+FASTRUN uint8_t PortalController::wrapAround(int16_t position) const {
     while (position < 0) position += LED_COUNT;
     return position % LED_COUNT;
 }
 
-float PortalController::mapFloat(float x, float in_min, float in_max, float out_min, float out_max) {
+FASTRUN float PortalController::mapFloat(float x, float in_min, float in_max, float out_min, float out_max) {
     return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
 }
 
-float PortalController::smoothstep(float edge0, float edge1, float x) {
+FASTRUN float PortalController::smoothstep(float edge0, float edge1, float x) {
     float t = constrain((x - edge0) / (edge1 - edge0), 0.0, 1.0);
     return t * t * (3.0 - 2.0 * t);
 }
 
-uint8_t PortalController::noise8(uint8_t x, uint8_t y) {
+FASTRUN uint8_t PortalController::noise8(uint8_t x, uint8_t y) {
     // Simple pseudo-noise function
     uint16_t n = x + y * 57;
     n = (n << 13) ^ n;
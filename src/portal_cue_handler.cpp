@@ -1,6 +1,14 @@
 #include "portal_cue_handler.h"
+#include "memory_placement.h"
 #include "config.h"
 #include "pins.h"
+#include "stage_profiler.h"
+#include "loop_watchdog.h"
+#include "flight_recorder.h"
+#include "input_trace.h"
+#include "config_store.h"
+#include "event_log.h"
+#include "serial_mux.h"
 
 // Program names for debugging and display
 const char* PORTAL_PROGRAM_NAMES[] = {
@@ -10,25 +18,32 @@ const char* PORTAL_PROGRAM_NAMES[] = {
 
 PortalCueHandler::PortalCueHandler() :
     portalController(nullptr),
+    configStore(nullptr),
     timeSinceLastActivity(0),
     wasIdle(false),
     lastActiveProgram(PORTAL_AMBIENT),
+    idleTimeoutMs(IDLE_TIMEOUT_MS),
     autoSwitchTimer(0),
     bufferIndex(0),
     lastMessageTime(0),
+    selectedConfigParam(CONFIG_PARAM_COUNT),
+    replyOut(nullptr),
+    frameAcked(false),
+    cueListener(nullptr),
+    cueListenerContext(nullptr),
     messagesReceived(0),
     messagesValid(0),
     messagesInvalid(0)
 {
 }
 
-void PortalCueHandler::begin(PortalController* controller) {
+FLASHMEM void PortalCueHandler::begin(PortalController* controller) {
     portalController = controller;
     timeSinceLastActivity = 0;
     resetSerialBuffer();
     
     Serial.println("Portal Cue Handler initialized with Serial Protocol");
-    Serial.printf("Serial baud rate: %lu\n", PORTAL_SERIAL_BAUD);
+    Serial.printf("Serial baud rate: %lu\n", (unsigned long)PORTAL_SERIAL_BAUD);
     Serial.println("Serial Commands:");
     Serial.println("  0x01: SET_PROGRAM (0-9)");
     Serial.println("  0x02: SET_BPM (0-255 -> 60-180 BPM)");
@@ -44,9 +59,7 @@ void PortalCueHandler::begin(PortalController* controller) {
 void PortalCueHandler::handleMidiCC(uint8_t cc, uint8_t value) {
     if (!portalController) return;
     
-    #if DEBUG >= 1
-    Serial.printf("Portal MIDI CC: %d = %d\n", cc, value);
-    #endif
+    LOG_EVENT(LOG_PORTAL_MIDI_CC, cc, value);
     
     switch (cc) {
         case PORTAL_PROGRAM_CC:
@@ -54,11 +67,6 @@ void PortalCueHandler::handleMidiCC(uint8_t cc, uint8_t value) {
                 portalController->setProgram(value);
                 lastActiveProgram = value;
                 
-                #if DEBUG >= 1
-                Serial.printf("Portal program changed to: %s (%d)\n", 
-                             PORTAL_PROGRAM_NAMES[value], value);
-                #endif
-                
                 // Reset idle timer when program is manually changed
                 timeSinceLastActivity = 0;
                 wasIdle = false;
@@ -70,9 +78,7 @@ void PortalCueHandler::handleMidiCC(uint8_t cc, uint8_t value) {
                 float bpm = map(value, 0, 127, 60, 180);
                 portalController->setBpm(bpm);
                 
-                #if DEBUG >= 1
-                Serial.printf("Portal BPM set to: %.1f\n", bpm);
-                #endif
+                LOG_EVENT(LOG_PORTAL_BPM, (uint16_t)bpm, (uint16_t)(bpm * 10) % 10);
             }
             break;
             
@@ -81,9 +87,7 @@ void PortalCueHandler::handleMidiCC(uint8_t cc, uint8_t value) {
                 float intensity = value / 127.0;
                 portalController->setIntensity(intensity);
                 
-                #if DEBUG >= 1
-                Serial.printf("Portal intensity set to: %.2f\n", intensity);
-                #endif
+                LOG_EVENT(LOG_PORTAL_INTENSITY, (uint16_t)(intensity * 100 + 0.5f));
             }
             break;
             
@@ -92,20 +96,16 @@ void PortalCueHandler::handleMidiCC(uint8_t cc, uint8_t value) {
                 float hue = value / 127.0;
                 portalController->setBaseHue(hue);
                 
-                #if DEBUG >= 1
-                Serial.printf("Portal base hue set to: %.2f\n", hue);
-                #endif
+                LOG_EVENT(LOG_PORTAL_HUE, (uint16_t)(hue * 100 + 0.5f));
             }
             break;
             
         case PORTAL_BRIGHTNESS_CC:
             {
-                uint8_t brightness = map(value, 0, 127, 0, LED_BRIGHTNESS_MAX);
+                uint8_t brightness = map(value, 0, 127, 0, portalController->getMaxBrightness());
                 portalController->setBrightness(brightness);
                 
-                #if DEBUG >= 1
-                Serial.printf("Portal brightness set to: %d\n", brightness);
-                #endif
+                LOG_EVENT(LOG_PORTAL_BRIGHTNESS, brightness);
             }
             break;
             
@@ -113,9 +113,7 @@ void PortalCueHandler::handleMidiCC(uint8_t cc, uint8_t value) {
             if (value >= 64) {  // Trigger on high values
                 portalController->triggerFlash();
                 
-                #if DEBUG >= 1
-                Serial.println("Portal flash triggered");
-                #endif
+                LOG_EVENT(LOG_PORTAL_FLASH);
             }
             break;
             
@@ -124,9 +122,7 @@ void PortalCueHandler::handleMidiCC(uint8_t cc, uint8_t value) {
                 uint8_t position = map(value, 0, 127, 0, LED_COUNT - 1);
                 portalController->triggerRipple(position);
                 
-                #if DEBUG >= 1
-                Serial.printf("Portal ripple triggered at position: %d\n", position);
-                #endif
+                LOG_EVENT(LOG_PORTAL_RIPPLE, position);
             }
             break;
             
@@ -201,16 +197,13 @@ void PortalCueHandler::setInputActivity(bool hasActivity) {
             portalController->setProgram(lastActiveProgram);
             wasIdle = false;
             
-            #if DEBUG >= 1
-            Serial.printf("Activity detected - switching from IDLE to %s\n", 
-                         PORTAL_PROGRAM_NAMES[lastActiveProgram]);
-            #endif
+            LOG_EVENT(LOG_PORTAL_IDLE_EXIT, lastActiveProgram);
         }
     }
 }
 
 void PortalCueHandler::checkIdleState() {
-    bool isCurrentlyIdle = (timeSinceLastActivity > IDLE_TIMEOUT_MS);
+    bool isCurrentlyIdle = (timeSinceLastActivity > idleTimeoutMs);
     
     // Transition from active to idle
     if (isCurrentlyIdle && !wasIdle) {
@@ -219,11 +212,7 @@ void PortalCueHandler::checkIdleState() {
         wasIdle = true;
         autoSwitchTimer = 0;
         
-        #if DEBUG >= 1
-        Serial.printf("No activity for %ds - switching to IDLE mode (was %s)\n", 
-                     IDLE_TIMEOUT_MS / 1000, 
-                     PORTAL_PROGRAM_NAMES[lastActiveProgram]);
-        #endif
+        LOG_EVENT(LOG_PORTAL_IDLE_ENTER, (uint16_t)(idleTimeoutMs / 1000), lastActiveProgram);
     }
     
     // Auto-switch between programs when idle (for demo/ambient purposes)
@@ -236,42 +225,38 @@ void PortalCueHandler::checkIdleState() {
         
         portalController->setProgram(nextProgram);
         
-        #if DEBUG >= 1
-        Serial.printf("Auto-switching to %s for ambient display\n", 
-                     PORTAL_PROGRAM_NAMES[nextProgram]);
-        #endif
+        LOG_EVENT(LOG_PORTAL_AUTO_SWITCH, nextProgram);
     }
 }
 
-void PortalCueHandler::printStatus() {
+FLASHMEM void PortalCueHandler::printStatus() {
     if (!portalController) return;
     
     Serial.println("=== Portal Status ===");
     Serial.printf("Current Program: %s (%d)\n", 
                  PORTAL_PROGRAM_NAMES[portalController->getCurrentProgram()],
                  portalController->getCurrentProgram());
-    Serial.printf("Frame Count: %lu\n", portalController->getFrameCount());
-    Serial.printf("Time Since Activity: %lu ms\n", (uint32_t)timeSinceLastActivity);
+    Serial.printf("Frame Count: %lu\n", (unsigned long)portalController->getFrameCount());
+    Serial.printf("Time Since Activity: %lu ms\n", (unsigned long)timeSinceLastActivity);
     Serial.printf("Idle State: %s\n", wasIdle ? "YES" : "NO");
     if (wasIdle) {
         Serial.printf("Last Active Program: %s (%d)\n", 
                      PORTAL_PROGRAM_NAMES[lastActiveProgram], lastActiveProgram);
     }
     Serial.printf("Serial Messages - RX: %lu, Valid: %lu, Invalid: %lu\n", 
-                 messagesReceived, messagesValid, messagesInvalid);
+                 (unsigned long)messagesReceived, (unsigned long)messagesValid,
+                 (unsigned long)messagesInvalid);
     Serial.println("====================");
 }
 
 // ===== NEW SERIAL PROTOCOL METHODS =====
 
-void PortalCueHandler::handleSerialMessage(const PortalMessage& message) {
-    if (!portalController) return;
+bool PortalCueHandler::handleSerialMessage(const PortalMessage& message) {
+    if (!portalController) return false;
+    frameAcked = false;
     
-    #if DEBUG >= 1
-    Serial.printf("Portal Serial: %s (0x%02X) = %d\n", 
-                 SerialPortalProtocol::getCommandName(message.command),
-                 static_cast<uint8_t>(message.command), message.value);
-    #endif
+    LOG_EVENT(LOG_PROTOCOL_FRAME, static_cast<uint8_t>(message.command),
+              static_cast<uint8_t>(message.command), message.value);
     
     switch (message.command) {
         case PortalSerialCommand::SET_PROGRAM:
@@ -279,11 +264,6 @@ void PortalCueHandler::handleSerialMessage(const PortalMessage& message) {
                 portalController->setProgram(message.value);
                 lastActiveProgram = message.value;
                 
-                #if DEBUG >= 1
-                Serial.printf("Portal program changed to: %s (%d)\n", 
-                             PORTAL_PROGRAM_NAMES[message.value], message.value);
-                #endif
-                
                 // Reset idle timer when program is manually changed
                 timeSinceLastActivity = 0;
                 wasIdle = false;
@@ -298,9 +278,7 @@ void PortalCueHandler::handleSerialMessage(const PortalMessage& message) {
                 float bpm = SerialPortalProtocol::mapToBpm(message.value);
                 portalController->setBpm(bpm);
                 
-                #if DEBUG >= 1
-                Serial.printf("Portal BPM set to: %.1f\n", bpm);
-                #endif
+                LOG_EVENT(LOG_PORTAL_BPM, (uint16_t)bpm, (uint16_t)(bpm * 10) % 10);
                 sendAck();
             }
             break;
@@ -310,9 +288,7 @@ void PortalCueHandler::handleSerialMessage(const PortalMessage& message) {
                 float intensity = SerialPortalProtocol::mapToNormalized(message.value);
                 portalController->setIntensity(intensity);
                 
-                #if DEBUG >= 1
-                Serial.printf("Portal intensity set to: %.2f\n", intensity);
-                #endif
+                LOG_EVENT(LOG_PORTAL_INTENSITY, (uint16_t)(intensity * 100 + 0.5f));
                 sendAck();
             }
             break;
@@ -322,9 +298,7 @@ void PortalCueHandler::handleSerialMessage(const PortalMessage& message) {
                 float hue = SerialPortalProtocol::mapToNormalized(message.value);
                 portalController->setBaseHue(hue);
                 
-                #if DEBUG >= 1
-                Serial.printf("Portal base hue set to: %.2f\n", hue);
-                #endif
+                LOG_EVENT(LOG_PORTAL_HUE, (uint16_t)(hue * 100 + 0.5f));
                 sendAck();
             }
             break;
@@ -333,9 +307,7 @@ void PortalCueHandler::handleSerialMessage(const PortalMessage& message) {
             {
                 portalController->setBrightness(message.value);
                 
-                #if DEBUG >= 1
-                Serial.printf("Portal brightness set to: %d\n", message.value);
-                #endif
+                LOG_EVENT(LOG_PORTAL_BRIGHTNESS, message.value);
                 sendAck();
             }
             break;
@@ -343,9 +315,7 @@ void PortalCueHandler::handleSerialMessage(const PortalMessage& message) {
         case PortalSerialCommand::TRIGGER_FLASH:
             portalController->triggerFlash();
             
-            #if DEBUG >= 1
-            Serial.println("Portal flash triggered");
-            #endif
+            LOG_EVENT(LOG_PORTAL_FLASH);
             sendAck();
             break;
             
@@ -354,9 +324,7 @@ void PortalCueHandler::handleSerialMessage(const PortalMessage& message) {
                 uint8_t position = SerialPortalProtocol::mapToLedPosition(message.value, LED_COUNT);
                 portalController->triggerRipple(position);
                 
-                #if DEBUG >= 1
-                Serial.printf("Portal ripple triggered at position: %d\n", position);
-                #endif
+                LOG_EVENT(LOG_PORTAL_RIPPLE, position);
                 sendAck();
             }
             break;
@@ -371,56 +339,248 @@ void PortalCueHandler::handleSerialMessage(const PortalMessage& message) {
             portalController->setBpm(120.0);
             portalController->setIntensity(0.7);
             portalController->setBaseHue(0.6);
-            portalController->setBrightness(LED_BRIGHTNESS_MAX);
+            portalController->setBrightness(portalController->getMaxBrightness());
+            
+            LOG_EVENT(LOG_PORTAL_RESET);
+            sendAck();
+            break;
+            
+        #if PROFILE > 0
+        case PortalSerialCommand::PROFILE_DUMP:
+            // ACK first so the Pi can tell the text dump apart from frames
+            sendAck();
+            stageProfiler.dump(serialChannel(MUX_BULK));
+            break;
+            
+        case PortalSerialCommand::PROFILE_RESET:
+            stageProfiler.reset();
+            sendAck();
+            break;
+        #endif
             
-            #if DEBUG >= 1
-            Serial.println("Portal reset to default state");
+        #if FLIGHT_RECORDER > 0
+        case PortalSerialCommand::FLIGHT_DUMP:
+            // ACK now; the binary dump is streamed by the background flight task
+            #if INPUT_TRACE > 0
+            if (inputTrace.isDumping()) {
+                sendNak();
+                break;
+            }
+            #endif
+            #if EVENT_LOG > 0
+            if (eventLog.isDumping()) {
+                sendNak();
+                break;
+            }
             #endif
+            if (flightRecorder.beginDump()) {
+                sendAck();
+            } else {
+                sendNak();
+            }
+            break;
+        #endif
+            
+        #if WATCHDOG > 0
+        case PortalSerialCommand::STALL_REPORT:
+            sendAck();
+            loopWatchdog.printStallReport(serialChannel(MUX_BULK));
+            break;
+        #endif
+            
+        case PortalSerialCommand::CONFIG_SELECT:
+            if (configStore && message.value < CONFIG_PARAM_COUNT) {
+                selectedConfigParam = message.value;
+                sendAck();
+            } else {
+                sendNak();
+            }
+            break;
+            
+        case PortalSerialCommand::CONFIG_SET:
+            {
+                // Staged; takes effect at the start of the next scan tick
+                ConfigParam param = static_cast<ConfigParam>(selectedConfigParam);
+                if (configStore && param < CONFIG_PARAM_COUNT &&
+                    configStore->setValue(param, ConfigStore::fromWire(param, message.value))) {
+                    LOG_EVENT(LOG_CONFIG_SET, param, configStore->getValue(param) & 0xFFFF,
+                              configStore->getValue(param) >> 16);
+                    sendAck();
+                } else {
+                    sendNak();
+                }
+            }
+            break;
+            
+        case PortalSerialCommand::CONFIG_GET:
+            if (configStore && message.value < CONFIG_PARAM_COUNT) {
+                ConfigParam param = static_cast<ConfigParam>(message.value);
+                sendMessage(PortalMessage(PortalSerialCommand::CONFIG_VALUE,
+                                          ConfigStore::toWire(param, configStore->getValue(param))));
+            } else {
+                sendNak();
+            }
+            break;
+            
+        case PortalSerialCommand::CONFIG_SAVE:
+            // Written to EEPROM by the background config task
+            if (configStore) {
+                configStore->requestSave();
+                sendAck();
+            } else {
+                sendNak();
+            }
+            break;
+            
+        case PortalSerialCommand::CONFIG_DEFAULTS:
+            if (configStore) {
+                configStore->restoreDefaults();
+                sendAck();
+            } else {
+                sendNak();
+            }
+            break;
+            
+        #if INPUT_TRACE > 0
+        case PortalSerialCommand::TRACE_CAPTURE:
+            if (message.value == 0) {
+                inputTrace.stopCapture();
+                LOG_EVENT(LOG_TRACE_STOPPED, inputTrace.getRecordCount());
+                sendAck();
+            } else if (inputTrace.startCapture()) {
+                sendAck();
+            } else {
+                sendNak();
+            }
+            break;
+            
+        case PortalSerialCommand::TRACE_DUMP:
+            {
+                // ACK now; the binary dump is streamed by the background trace task
+                bool busy = false;
+                #if FLIGHT_RECORDER > 0
+                busy = flightRecorder.isDumping();
+                #endif
+                #if EVENT_LOG > 0
+                busy = busy || eventLog.isDumping();
+                #endif
+                if (!busy && inputTrace.beginDump()) {
+                    sendAck();
+                } else {
+                    sendNak();
+                }
+            }
+            break;
+            
+        case PortalSerialCommand::TRACE_REPLAY:
+            // Takes over from the pins at the next scan tick
+            if (inputTrace.startReplay()) {
+                sendAck();
+            } else {
+                sendNak();
+            }
+            break;
+        #endif
+            
+        #if EVENT_LOG > 0
+        case PortalSerialCommand::LOG_LEVEL:
+            if ((message.value & 0x07) <= LOG_DEBUG) {
+                eventLog.setLevel(static_cast<LogLevel>(message.value & 0x07));
+                eventLog.setTextOutput(message.value & 0x80);
+                sendAck();
+            } else {
+                sendNak();
+            }
+            break;
+            
+        case PortalSerialCommand::LOG_CATEGORIES:
+            eventLog.setCategories(message.value);
             sendAck();
             break;
             
+        case PortalSerialCommand::LOG_DUMP:
+            {
+                // ACK now; the binary dump is streamed by the background log task
+                bool busy = false;
+                #if FLIGHT_RECORDER > 0
+                busy = flightRecorder.isDumping();
+                #endif
+                #if INPUT_TRACE > 0
+                busy = busy || inputTrace.isDumping();
+                #endif
+                if (!busy && eventLog.beginDump()) {
+                    sendAck();
+                } else {
+                    sendNak();
+                }
+            }
+            break;
+        #endif
+            
         default:
-            #if DEBUG >= 1
-            Serial.printf("Unknown serial command: 0x%02X\n", static_cast<uint8_t>(message.command));
-            #endif
+            LOG_EVENT(LOG_PROTOCOL_UNKNOWN, static_cast<uint8_t>(message.command));
             sendNak();
             break;
     }
+    return frameAcked;
 }
 
 void PortalCueHandler::processSerialInput() {
     while (Serial.available()) {
-        uint8_t byte = Serial.read();
-        
-        // Handle buffer overflow
-        if (bufferIndex >= PORTAL_SERIAL_BUFFER_SIZE) {
-            #if DEBUG >= 2
-            Serial.println("Serial buffer overflow - resetting");
-            #endif
-            resetSerialBuffer();
-        }
-        
-        serialBuffer[bufferIndex++] = byte;
-        lastMessageTime = 0;
-        
-        // Try to parse message if we have minimum bytes
-        if (bufferIndex >= PORTAL_MSG_MIN_SIZE) {
-            if (parseSerialMessage()) {
-                resetSerialBuffer();
-            }
-        }
+        PortalMessage message;
+        if (!receiveByte(Serial.read(), message)) continue;
+        receiveMessage(message, serialChannel(MUX_CONTROL));
     }
     
     // Timeout incomplete messages
     if (bufferIndex > 0 && lastMessageTime > PORTAL_SERIAL_TIMEOUT_MS) {
-        #if DEBUG >= 2
-        Serial.println("Serial message timeout - resetting buffer");
-        #endif
+        LOG_EVENT(LOG_PROTOCOL_TIMEOUT);
         resetSerialBuffer();
     }
 }
 
-bool PortalCueHandler::parseSerialMessage() {
+void PortalCueHandler::receiveMessage(const PortalMessage& message, Print& reply) {
+    replyOut = &reply;
+    messagesReceived++;
+    
+    if (message.isValid()) {
+        messagesValid++;
+        FLIGHT_RECORD(FLIGHT_FRAME_RX, static_cast<uint8_t>(message.command), message.value);
+        const bool acked = handleSerialMessage(message);
+        
+        // Only cues this board accepted are passed on
+        const uint8_t command = static_cast<uint8_t>(message.command);
+        if (acked && cueListener && ((command >= static_cast<uint8_t>(PortalSerialCommand::SET_PROGRAM) &&
+                                      command <= static_cast<uint8_t>(PortalSerialCommand::TRIGGER_RIPPLE)) ||
+                                     message.command == PortalSerialCommand::RESET)) {
+            cueListener(message, cueListenerContext);
+        }
+    } else {
+        messagesInvalid++;
+        FLIGHT_RECORD(FLIGHT_FRAME_BAD, static_cast<uint8_t>(message.command), message.value);
+        LOG_EVENT(LOG_PROTOCOL_CHECKSUM, message.checksum,
+                  PortalMessage::calculateChecksum(message.command, message.value));
+        sendNak();
+    }
+    replyOut = nullptr;
+}
+
+bool PortalCueHandler::receiveByte(uint8_t byte, PortalMessage& message) {
+    // Handle buffer overflow
+    if (bufferIndex >= PORTAL_SERIAL_BUFFER_SIZE) {
+        LOG_EVENT(LOG_PROTOCOL_OVERFLOW);
+        resetSerialBuffer();
+    }
+    
+    serialBuffer[bufferIndex++] = byte;
+    lastMessageTime = 0;
+    
+    // Try to parse message if we have minimum bytes
+    if (bufferIndex < PORTAL_MSG_MIN_SIZE) return false;
+    return parseSerialMessage(message);
+}
+
+bool PortalCueHandler::parseSerialMessage(PortalMessage& message) {
     // Look for start byte
     int startIndex = -1;
     for (int i = 0; i < bufferIndex; i++) {
@@ -448,23 +608,12 @@ bool PortalCueHandler::parseSerialMessage() {
     if (bufferIndex >= PORTAL_MSG_MIN_SIZE && 
         serialBuffer[PORTAL_MSG_MIN_SIZE - 1] == PORTAL_MSG_END_BYTE) {
         
-        // Parse the message
-        PortalMessage message = PortalMessage::fromBytes(serialBuffer);
-        messagesReceived++;
-        
+        // Parse the message; a frame with a bad checksum stays buffered
+        message = PortalMessage::fromBytes(serialBuffer);
         if (message.isValid()) {
-            messagesValid++;
-            handleSerialMessage(message);
-            return true;
-        } else {
-            messagesInvalid++;
-            #if DEBUG >= 2
-            Serial.printf("Invalid message checksum: got 0x%02X, expected 0x%02X\n",
-                         message.checksum, 
-                         PortalMessage::calculateChecksum(message.command, message.value));
-            #endif
-            sendNak();
+            resetSerialBuffer();
         }
+        return true;
     }
     
     return false;
@@ -476,13 +625,19 @@ void PortalCueHandler::resetSerialBuffer() {
 }
 
 void PortalCueHandler::sendMessage(const PortalMessage& message) {
+    FLIGHT_RECORD(FLIGHT_FRAME_TX, static_cast<uint8_t>(message.command), message.value);
+    
+    // Back over the transport the command came from; serial control channel
+    // otherwise, flushed ahead of any queued telemetry, log or bulk output
     uint8_t buffer[5];
     message.toBytes(buffer);
-    Serial.write(buffer, 5);
-    Serial.flush();
+    Print& out = replyOut ? *replyOut : serialChannel(MUX_CONTROL);
+    out.write(buffer, 5);
+    out.flush();
 }
 
 void PortalCueHandler::sendAck() {
+    frameAcked = true;
     PortalMessage ack(PortalSerialCommand::ACK, 0);
     sendMessage(ack);
 }
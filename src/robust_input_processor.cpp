@@ -1,7 +1,13 @@
 #include "robust_input_processor.h"
+#include "memory_placement.h"
+#include "flight_recorder.h"
+#include "event_log.h"
+#include "config_store.h"
 
 RobustInputProcessor::RobustInputProcessor()
-    : lastActivityTime(0)
+    : joystickRearmMs(JOYSTICK_REARM_MS)
+    , lastActivityTime(0)
+    , idleTimeoutMs(IDLE_TIMEOUT_MS)
     , testModeEnabled(false)
 {
     // Initialize joystick rearm times
@@ -10,7 +16,7 @@ RobustInputProcessor::RobustInputProcessor()
     }
 }
 
-void RobustInputProcessor::begin() {
+FLASHMEM void RobustInputProcessor::begin() {
     // Initialize the raw scanner
     scanner.begin();
     
@@ -36,6 +42,7 @@ void RobustInputProcessor::begin() {
     }
     
     lastActivityTime = millis();
+    health.reset(lastActivityTime);
     
     #if DEBUG
     Serial.println("RobustInputProcessor: Initialized with debouncing and smoothing");
@@ -45,35 +52,91 @@ void RobustInputProcessor::begin() {
     #endif
 }
 
-void RobustInputProcessor::update() {
+void RobustInputProcessor::applyConfig(const RuntimeConfig& config) {
+    for (int i = 0; i < BUTTON_COUNT; i++) {
+        buttonDebouncers[i].setDebounceMs(config.debounceMs);
+    }
+    for (int i = 0; i < 4; i++) {
+        joystickDebouncers[i].setDebounceMs(config.debounceMs);
+    }
+    for (int i = 0; i < SWITCH_COUNT; i++) {
+        switchDebouncers[i].setDebounceMs(config.debounceMs);
+    }
+    for (int i = 0; i < POT_COUNT; i++) {
+        potSmoothers[i].setLimits(config.potDeadband, config.potRateLimitMs);
+    }
+    joystickRearmMs = config.joystickRearmMs;
+    idleTimeoutMs = config.idleTimeoutMs;
+}
+
+FASTRUN void RobustInputProcessor::update() {
     // Scan raw inputs first
     scanner.scan();
+    processAll();
+}
+
+FASTRUN void RobustInputProcessor::update(const RawInputFrame& frame) {
+    scanner.scanFrame(frame);
+    processAll();
+}
+
+void RobustInputProcessor::restart(const RawInputFrame& frame) {
+    scanner.scanFrame(frame);
+    
+    for (int i = 0; i < BUTTON_COUNT; i++) {
+        buttonDebouncers[i].reset();
+    }
+    for (int i = 0; i < 4; i++) {
+        joystickDebouncers[i].reset();
+        joystickRearmTime[i] = 0;
+    }
+    for (int i = 0; i < SWITCH_COUNT; i++) {
+        switchDebouncers[i].reset();
+    }
+    for (int i = 0; i < POT_COUNT; i++) {
+        potSmoothers[i].reset(frame.pots[i]);
+    }
     
+    lastActivityTime = millis();
+    health.reset(lastActivityTime);
+}
+
+FASTRUN void RobustInputProcessor::processAll() {
     // Process all input types with robust filtering
     processButtons();
     processJoystick();
     processSwitches();
     processPotentiometers();
+    
+    // Raw levels for stuck buttons; joystick directions ignore the rearm window
+    uint32_t rawActive = 0;
+    for (int i = 0; i < BUTTON_COUNT; i++) {
+        if (scanner.getButtonState(i)) rawActive |= 1UL << (InputHealthMonitor::BUTTON_CHANNEL + i);
+    }
+    for (int i = 0; i < 4; i++) {
+        if (scanner.getJoystickState(i)) rawActive |= 1UL << (InputHealthMonitor::JOYSTICK_CHANNEL + i);
+    }
+    health.update(rawActive, millis());
 }
 
-void RobustInputProcessor::processButtons() {
+FASTRUN void RobustInputProcessor::processButtons() {
     uint32_t currentTime = millis();
     
     for (int i = 0; i < BUTTON_COUNT; i++) {
         bool rawState = scanner.getButtonState(i);
         if (buttonDebouncers[i].update(rawState, currentTime)) {
             // State changed after debouncing
-            updateActivity();
+            if (health.recordEdges(1UL << (InputHealthMonitor::BUTTON_CHANNEL + i), currentTime)) {
+                updateActivity();
+            }
+            FLIGHT_RECORD(FLIGHT_BUTTON, i, buttonDebouncers[i].isPressed());
             
-            #if DEBUG >= 2
-            Serial.printf("Button %d: %s\n", i, 
-                         buttonDebouncers[i].isPressed() ? "PRESSED" : "RELEASED");
-            #endif
+            LOG_EVENT(LOG_INPUT_BUTTON, i, buttonDebouncers[i].isPressed());
         }
     }
 }
 
-void RobustInputProcessor::processJoystick() {
+FASTRUN void RobustInputProcessor::processJoystick() {
     uint32_t currentTime = millis();
     
     for (int i = 0; i < 4; i++) {
@@ -81,96 +144,95 @@ void RobustInputProcessor::processJoystick() {
         
         // Only read joystick if rearm time has passed
         if (currentTime >= joystickRearmTime[i]) {
-            switch (i) {
-                case 0: rawState = !digitalRead(JOYSTICK_UP); break;
-                case 1: rawState = !digitalRead(JOYSTICK_DOWN); break;
-                case 2: rawState = !digitalRead(JOYSTICK_LEFT); break;
-                case 3: rawState = !digitalRead(JOYSTICK_RIGHT); break;
-            }
+            rawState = scanner.getJoystickState(i);
         }
         
         if (joystickDebouncers[i].update(rawState, currentTime)) {
+            const bool healthy = health.recordEdges(1UL << (InputHealthMonitor::JOYSTICK_CHANNEL + i), currentTime);
             if (joystickDebouncers[i].justPressed()) {
                 // Set rearm time to prevent rapid repeat
-                joystickRearmTime[i] = currentTime + JOYSTICK_REARM_MS;
-                updateActivity();
+                joystickRearmTime[i] = currentTime + joystickRearmMs;
+                if (healthy) updateActivity();
+                FLIGHT_RECORD(FLIGHT_JOYSTICK, i, 1);
                 
-                #if DEBUG >= 2
-                const char* directions[] = {"UP", "DOWN", "LEFT", "RIGHT"};
-                Serial.printf("Joystick %s pressed (rearm: %dms)\n", 
-                             directions[i], JOYSTICK_REARM_MS);
-                #endif
+                LOG_EVENT(LOG_INPUT_JOYSTICK, i, joystickRearmMs);
             }
         }
     }
 }
 
-void RobustInputProcessor::processSwitches() {
+FASTRUN void RobustInputProcessor::processSwitches() {
     uint32_t currentTime = millis();
     
     for (int i = 0; i < SWITCH_COUNT; i++) {
         bool rawState = scanner.getSwitchState(i);
         if (switchDebouncers[i].update(rawState, currentTime)) {
             // State changed after debouncing
-            updateActivity();
+            if (health.recordEdges(1UL << (InputHealthMonitor::SWITCH_CHANNEL + i), currentTime)) {
+                updateActivity();
+            }
+            FLIGHT_RECORD(FLIGHT_SWITCH, i, switchDebouncers[i].isPressed());
             
-            #if DEBUG >= 2
-            Serial.printf("Switch %d: %s\n", i, 
-                         switchDebouncers[i].isPressed() ? "ON" : "OFF");
-            #endif
+            LOG_EVENT(LOG_INPUT_SWITCH, i, switchDebouncers[i].isPressed());
         }
     }
 }
 
-void RobustInputProcessor::processPotentiometers() {
+FASTRUN void RobustInputProcessor::processPotentiometers() {
     uint32_t currentTime = millis();
     
     for (int i = 0; i < POT_COUNT; i++) {
         uint16_t rawValue = scanner.getPotValue(i);
         if (potSmoothers[i].update(rawValue, currentTime)) {
             // Smoothed value changed significantly
-            updateActivity();
+            if (health.recordPot(i, potSmoothers[i].getMidiValue(), currentTime)) {
+                updateActivity();
+            }
+            FLIGHT_RECORD(FLIGHT_POT, i, potSmoothers[i].getRawFiltered());
             
-            #if DEBUG >= 2
-            Serial.printf("Pot %d: %d -> MIDI %d\n", i, rawValue, 
-                         potSmoothers[i].getMidiValue());
-            #endif
+            LOG_EVENT(LOG_INPUT_POT, i, rawValue, potSmoothers[i].getMidiValue());
         }
     }
 }
 
-void RobustInputProcessor::updateActivity() {
+FASTRUN void RobustInputProcessor::updateActivity() {
     lastActivityTime = millis();
 }
 
 // Public interface methods
 bool RobustInputProcessor::getButtonPressed(uint8_t buttonIndex) const {
     if (buttonIndex >= BUTTON_COUNT) return false;
+    if (health.isQuarantined(InputHealthMonitor::BUTTON_CHANNEL + buttonIndex)) return false;
     return buttonDebouncers[buttonIndex].justPressed();
 }
 
 bool RobustInputProcessor::getButtonReleased(uint8_t buttonIndex) const {
     if (buttonIndex >= BUTTON_COUNT) return false;
+    if (health.isQuarantined(InputHealthMonitor::BUTTON_CHANNEL + buttonIndex)) return false;
     return buttonDebouncers[buttonIndex].justReleased();
 }
 
 bool RobustInputProcessor::getButtonState(uint8_t buttonIndex) const {
     if (buttonIndex >= BUTTON_COUNT) return false;
+    if (health.isQuarantined(InputHealthMonitor::BUTTON_CHANNEL + buttonIndex)) return false;
     return buttonDebouncers[buttonIndex].isPressed();
 }
 
 bool RobustInputProcessor::getJoystickPressed(uint8_t direction) const {
     if (direction >= 4) return false;
+    if (health.isQuarantined(InputHealthMonitor::JOYSTICK_CHANNEL + direction)) return false;
     return joystickDebouncers[direction].justPressed();
 }
 
 bool RobustInputProcessor::getSwitchState(uint8_t switchIndex) const {
     if (switchIndex >= SWITCH_COUNT) return false;
+    if (health.isQuarantined(InputHealthMonitor::SWITCH_CHANNEL + switchIndex)) return false;
     return switchDebouncers[switchIndex].isPressed();
 }
 
 bool RobustInputProcessor::getSwitchChanged(uint8_t switchIndex) const {
     if (switchIndex >= SWITCH_COUNT) return false;
+    if (health.isQuarantined(InputHealthMonitor::SWITCH_CHANNEL + switchIndex)) return false;
     return switchDebouncers[switchIndex].justPressed() || 
            switchDebouncers[switchIndex].justReleased();
 }
@@ -182,6 +244,7 @@ uint8_t RobustInputProcessor::getPotMidiValue(uint8_t potIndex) const {
 
 bool RobustInputProcessor::getPotChanged(uint8_t potIndex) const {
     if (potIndex >= POT_COUNT) return false;
+    if (health.isQuarantined(InputHealthMonitor::POT_CHANNEL + potIndex)) return false;
     return potSmoothers[potIndex].hasSignificantChange();
 }
 
@@ -190,38 +253,38 @@ uint32_t RobustInputProcessor::getTimeSinceLastActivity() const {
 }
 
 bool RobustInputProcessor::isIdle() const {
-    return getTimeSinceLastActivity() >= IDLE_TIMEOUT_MS;
+    return getTimeSinceLastActivity() >= idleTimeoutMs;
 }
 
-void RobustInputProcessor::dumpTestValues() const {
+FLASHMEM void RobustInputProcessor::dumpTestValues(Print& out) const {
     if (!testModeEnabled) return;
     
-    Serial.println("=== INPUT STATE DUMP ===");
+    out.println("=== INPUT STATE DUMP ===");
     
     // Button states
-    Serial.print("Buttons: ");
+    out.print("Buttons: ");
     for (int i = 0; i < BUTTON_COUNT; i++) {
-        Serial.printf("%d:%s ", i, getButtonState(i) ? "ON" : "OFF");
+        out.printf("%d:%s ", i, getButtonState(i) ? "ON" : "OFF");
     }
-    Serial.println();
+    out.println();
     
     // Switch states
-    Serial.print("Switches: ");
+    out.print("Switches: ");
     for (int i = 0; i < SWITCH_COUNT; i++) {
-        Serial.printf("%d:%s ", i, getSwitchState(i) ? "ON" : "OFF");
+        out.printf("%d:%s ", i, getSwitchState(i) ? "ON" : "OFF");
     }
-    Serial.println();
+    out.println();
     
     // Potentiometer values
-    Serial.print("Pots: ");
+    out.print("Pots: ");
     for (int i = 0; i < POT_COUNT; i++) {
-        Serial.printf("%d:MIDI_%d ", i, getPotMidiValue(i));
+        out.printf("%d:MIDI_%d ", i, getPotMidiValue(i));
     }
-    Serial.println();
+    out.println();
     
     // Activity status
-    Serial.printf("Activity: %lums ago, Idle: %s\n", 
-                  getTimeSinceLastActivity(), isIdle() ? "YES" : "NO");
+    out.printf("Activity: %lums ago, Idle: %s\n", 
+                  (unsigned long)getTimeSinceLastActivity(), isIdle() ? "YES" : "NO");
     
-    Serial.println("========================");
+    out.println("========================");
 }
@@ -1,172 +1,262 @@
 #include "robust_midi_mapper.h"
+#include "memory_placement.h"
+#include "event_log.h"
+#include "config_store.h"
 
-RobustMidiMapper::RobustMidiMapper(RobustInputProcessor& processor, MidiOut& midiOut)
+RobustMidiMapper::RobustMidiMapper(InputProcessor& processor, MidiOut& midiOut)
     : processor_(processor)
     , midiOut_(midiOut)
-    , lastBinaryValue(0)
+    , snapshotMode(SWITCH_SNAPSHOT)
+    , snapshotsSent(0)
+    , snapshotChanges(0)
 {
-    // Initialize state tracking arrays
-    for (int i = 0; i < BUTTON_COUNT; i++) {
-        lastButtonStates[i] = false;
-    }
-    
-    for (int i = 0; i < SWITCH_COUNT; i++) {
-        lastSwitchStates[i] = false;
-    }
+    static_assert(SWITCH_COUNT <= 14, "switch snapshots carry 14 bits");
+    reset();
+}
+
+void RobustMidiMapper::reset() {
+    memset(channels, 0, sizeof(channels));
+    memset(lastPotValues, 0, sizeof(lastPotValues));
     
-    for (int i = 0; i < POT_COUNT; i++) {
-        lastPotValues[i] = 0;
-    }
+    // This board's own channel is always in play
+    channels[0].used = true;
+}
+
+RobustMidiMapper::ChannelState* RobustMidiMapper::channelState(uint8_t channel) {
+    const uint8_t index = channel - MIDI_CHANNEL;
+    if (index >= CHANNEL_COUNT) return nullptr;
+    channels[index].used = true;
+    return &channels[index];
 }
 
-void RobustMidiMapper::processInputs() {
+FASTRUN void RobustMidiMapper::processInputs() {
     // Process all input types in order
     processButtons();
     processPots();
     processJoystick();
     processSwitches();
+    flushSwitchBanks(millis());
 }
 
-void RobustMidiMapper::processButtons() {
+FASTRUN void RobustMidiMapper::processButtons() {
+    const uint16_t held = channels[0].heldButtons;
     for (int i = 0; i < BUTTON_COUNT; i++) {
         bool currentState = processor_.getButtonState(i);
         
         // Check for state changes
-        if (currentState != lastButtonStates[i]) {
-            if (currentState) {
-                // Button pressed - send Note On
-                midiOut_.sendNoteOn(BUTTON_NOTES[i], MIDI_VELOCITY, MIDI_CHANNEL);
-                
-                #if DEBUG >= 1
-                Serial.printf("MIDI: Button %d pressed -> Note %d ON\n", i, BUTTON_NOTES[i]);
-                #endif
-            } else {
-                // Button released - send Note Off
-                midiOut_.sendNoteOff(BUTTON_NOTES[i], 0, MIDI_CHANNEL);
-                
-                #if DEBUG >= 1
-                Serial.printf("MIDI: Button %d released -> Note %d OFF\n", i, BUTTON_NOTES[i]);
-                #endif
-            }
-            
-            lastButtonStates[i] = currentState;
+        if (currentState != ((held >> i) & 1)) {
+            sendButton(i, currentState, MIDI_CHANNEL);
         }
     }
 }
 
-void RobustMidiMapper::processPots() {
+FASTRUN void RobustMidiMapper::processPots() {
     for (int i = 0; i < POT_COUNT; i++) {
         uint8_t currentValue = processor_.getPotMidiValue(i);
         
         // Check if potentiometer value changed significantly
         if (processor_.getPotChanged(i) && currentValue != lastPotValues[i]) {
-            // Send CC message
-            midiOut_.sendControlChange(POT_CCS[i], currentValue, MIDI_CHANNEL);
-            
-            #if DEBUG >= 1
-            Serial.printf("MIDI: Pot %d changed -> CC %d = %d\n", i, POT_CCS[i], currentValue);
-            #endif
-            
+            sendPot(i, currentValue, MIDI_CHANNEL);
             lastPotValues[i] = currentValue;
         }
     }
 }
 
-void RobustMidiMapper::processJoystick() {
-    // Joystick directions send single pulse CC messages (127 on press, no release)
-    if (processor_.getJoystickPressed(0)) {  // Up
-        midiOut_.sendControlChange(JOY_UP_CC, 127, MIDI_CHANNEL);
-        
-        #if DEBUG >= 1
-        Serial.printf("MIDI: Joystick UP -> CC %d = 127\n", JOY_UP_CC);
-        #endif
+FASTRUN void RobustMidiMapper::processJoystick() {
+    // Up, Down, Left, Right
+    for (int i = 0; i < 4; i++) {
+        if (processor_.getJoystickPressed(i)) {
+            sendJoystick(i, MIDI_CHANNEL);
+        }
     }
+}
+
+FASTRUN void RobustMidiMapper::processSwitches() {
+    uint16_t bits = 0;
+    for (int i = 0; i < SWITCH_COUNT; i++) {
+        if (processor_.getSwitchState(i)) bits |= 1 << i;
+    }
+    sendSwitches(bits, MIDI_CHANNEL);
+}
+
+FASTRUN void RobustMidiMapper::sendButton(uint8_t index, bool pressed, uint8_t channel) {
+    ChannelState* state = channelState(channel);
+    if (!state || index >= BUTTON_COUNT) return;
     
-    if (processor_.getJoystickPressed(1)) {  // Down
-        midiOut_.sendControlChange(JOY_DOWN_CC, 127, MIDI_CHANNEL);
+    if (pressed) {
+        // Button pressed - send Note On
+        midiOut_.sendNoteOn(BUTTON_NOTES[index], MIDI_VELOCITY, channel);
+        state->heldButtons |= 1 << index;
+        
+        LOG_EVENT(LOG_MIDI_NOTE_ON, index, BUTTON_NOTES[index]);
+    } else {
+        // Button released - send Note Off
+        midiOut_.sendNoteOff(BUTTON_NOTES[index], 0, channel);
+        state->heldButtons &= ~(1 << index);
         
-        #if DEBUG >= 1
-        Serial.printf("MIDI: Joystick DOWN -> CC %d = 127\n", JOY_DOWN_CC);
-        #endif
+        LOG_EVENT(LOG_MIDI_NOTE_OFF, index, BUTTON_NOTES[index]);
+    }
+}
+
+FASTRUN void RobustMidiMapper::sendPot(uint8_t index, uint8_t value, uint8_t channel) {
+    if (!channelState(channel) || index >= POT_COUNT) return;
+    
+    midiOut_.sendControlChange(POT_CCS[index], value, channel);
+    
+    LOG_EVENT(LOG_MIDI_POT_CC, index, POT_CCS[index], value);
+}
+
+FASTRUN void RobustMidiMapper::sendJoystick(uint8_t direction, uint8_t channel) {
+    static const uint8_t JOYSTICK_CCS[4] = {JOY_UP_CC, JOY_DOWN_CC, JOY_LEFT_CC, JOY_RIGHT_CC};
+    if (!channelState(channel) || direction >= 4) return;
+    
+    midiOut_.sendControlChange(JOYSTICK_CCS[direction], 127, channel);
+    
+    LOG_EVENT(LOG_MIDI_JOYSTICK_CC, direction, JOYSTICK_CCS[direction]);
+}
+
+FASTRUN void RobustMidiMapper::sendSwitch(uint8_t index, bool on, uint8_t channel) {
+    ChannelState* state = channelState(channel);
+    if (!state || index >= SWITCH_COUNT) return;
+    sendSwitches(on ? state->switchBits | (1 << index) : state->switchBits & ~(1 << index), channel);
+}
+
+FASTRUN void RobustMidiMapper::sendSwitches(uint16_t bits, uint8_t channel) {
+    ChannelState* state = channelState(channel);
+    if (!state) return;
+    const uint16_t changed = bits ^ state->switchBits;
+    if (!changed) return;
+    state->switchBits = bits;
+    
+    if (snapshotMode != SWITCH_SNAPSHOT_OFF) {
+        // Gathered until the bank settles (flushSwitchBanks()); the binary
+        // CC is kept in step so a return to per-switch CCs sends only later changes
+        const uint32_t now = millis();
+        if (!state->bankPending) {
+            state->bankPending = true;
+            state->burstStartMs = now;
+        }
+        state->bankChanges += __builtin_popcount(changed);
+        state->lastChangeMs = now;
+        state->binaryValue = bits & 0xFF;
+        return;
     }
     
-    if (processor_.getJoystickPressed(2)) {  // Left
-        midiOut_.sendControlChange(JOY_LEFT_CC, 127, MIDI_CHANNEL);
+    for (int i = 0; i < SWITCH_COUNT; i++) {
+        if (!(changed & (1 << i))) continue;
+        uint8_t midiValue = (bits >> i) & 1 ? 127 : 0;
         
-        #if DEBUG >= 1
-        Serial.printf("MIDI: Joystick LEFT -> CC %d = 127\n", JOY_LEFT_CC);
-        #endif
+        // Send CC message for individual switch state
+        midiOut_.sendControlChange(SWITCH_CCS[i], midiValue, channel);
+        
+        LOG_EVENT(LOG_MIDI_SWITCH_CC, i, SWITCH_CCS[i], midiValue);
     }
     
-    if (processor_.getJoystickPressed(3)) {  // Right
-        midiOut_.sendControlChange(JOY_RIGHT_CC, 127, MIDI_CHANNEL);
+    // Binary representation of the first 8 switches, if it changed
+    const uint8_t binaryValue = bits & 0xFF;
+    if ((changed & 0xFF) && binaryValue != state->binaryValue) {
+        midiOut_.sendControlChange(SWITCH_BINARY_CC, binaryValue, channel);
+        
+        LOG_EVENT(LOG_MIDI_SWITCH_BINARY, SWITCH_BINARY_CC, binaryValue);
         
-        #if DEBUG >= 1
-        Serial.printf("MIDI: Joystick RIGHT -> CC %d = 127\n", JOY_RIGHT_CC);
-        #endif
+        state->binaryValue = binaryValue;
     }
 }
 
-void RobustMidiMapper::processSwitches() {
-    bool binaryStateChanged = false;
+void RobustMidiMapper::setSwitchSnapshotMode(uint8_t mode) {
+    if (mode > SWITCH_SNAPSHOT_SYSEX || mode == snapshotMode) return;
     
-    for (int i = 0; i < SWITCH_COUNT; i++) {
-        bool currentState = processor_.getSwitchState(i);
-        
-        // Check for state changes
-        if (currentState != lastSwitchStates[i]) {
-            uint8_t midiValue = currentState ? 127 : 0;
-            
-            // Send CC message for individual switch state
-            midiOut_.sendControlChange(SWITCH_CCS[i], midiValue, MIDI_CHANNEL);
-            
-            #if DEBUG >= 1
-            Serial.printf("MIDI: Switch %d %s -> CC %d = %d\n", 
-                         i, currentState ? "ON" : "OFF", SWITCH_CCS[i], midiValue);
-            #endif
-            
-            lastSwitchStates[i] = currentState;
-            
-            // Mark that binary state may have changed (for first 8 switches)
-            if (i < 8) {
-                binaryStateChanged = true;
+    if (mode == SWITCH_SNAPSHOT_OFF) {
+        // A burst still being gathered goes out now, as the receiver expects it
+        for (uint8_t n = 0; n < CHANNEL_COUNT; n++) {
+            ChannelState& state = channels[n];
+            if (!state.bankPending) continue;
+            state.bankPending = false;
+            if (!state.bankSent || state.switchBits != state.sentBits) {
+                sendSwitchSnapshot(state, MIDI_CHANNEL + n);
             }
         }
+        snapshotMode = mode;
+        return;
     }
+    snapshotMode = mode;
     
-    // Process binary representation of first 8 switches
-    if (binaryStateChanged) {
-        uint8_t binaryValue = 0;
+    // The receiver gets the whole bank once, then changes
+    const uint32_t now = millis();
+    for (uint8_t n = 0; n < CHANNEL_COUNT; n++) {
+        ChannelState& state = channels[n];
+        if (!state.used) continue;
+        state.bankSent = false;
+        state.bankPending = true;
+        state.bankChanges = 0;
+        state.burstStartMs = state.lastChangeMs = now;
+    }
+}
+
+FASTRUN void RobustMidiMapper::flushSwitchBanks(uint32_t nowMs) {
+    if (snapshotMode == SWITCH_SNAPSHOT_OFF) return;
+    
+    for (uint8_t n = 0; n < CHANNEL_COUNT; n++) {
+        ChannelState& state = channels[n];
         
-        // Calculate binary representation from first 8 switches
-        for (int i = 0; i < 8 && i < SWITCH_COUNT; i++) {
-            if (processor_.getSwitchState(i)) {
-                binaryValue |= (1 << i);  // Set bit i if switch i is on
-            }
-        }
+        // Wait for the burst to end, but not forever on a slow sweep
+        if (!state.bankPending) continue;
+        if (nowMs - state.lastChangeMs < SWITCH_SNAPSHOT_SETTLE_MS &&
+            nowMs - state.burstStartMs < SWITCH_SNAPSHOT_MAX_HOLD_MS) continue;
+        state.bankPending = false;
         
-        // Send binary CC if value changed
-        if (binaryValue != lastBinaryValue) {
-            midiOut_.sendControlChange(SWITCH_BINARY_CC, binaryValue, MIDI_CHANNEL);
-            
-            #if DEBUG >= 1
-            Serial.printf("MIDI: Switch binary representation -> CC %d = %d (0b%08b)\n", 
-                         SWITCH_BINARY_CC, binaryValue, binaryValue);
-            #endif
-            
-            lastBinaryValue = binaryValue;
+        // Flipped and back within the burst: the receiver is already right
+        if (state.bankSent && state.switchBits == state.sentBits) {
+            state.bankChanges = 0;
+            continue;
         }
+        sendSwitchSnapshot(state, MIDI_CHANNEL + n);
+    }
+}
+
+void RobustMidiMapper::sendSwitchSnapshot(ChannelState& state, uint8_t channel) {
+    const uint16_t bits = state.switchBits;
+    const uint8_t high = (bits >> 7) & 0x7F;
+    const uint8_t low = bits & 0x7F;
+    
+    if (snapshotMode == SWITCH_SNAPSHOT_NRPN) {
+        midiOut_.sendControlChange(99, (SWITCH_SNAPSHOT_NRPN_PARAM >> 7) & 0x7F, channel);
+        midiOut_.sendControlChange(98, SWITCH_SNAPSHOT_NRPN_PARAM & 0x7F, channel);
+        midiOut_.sendControlChange(6, high, channel);
+        midiOut_.sendControlChange(38, low, channel);
+    } else {
+        // SysEx has no channel: a cluster board's snapshot carries its node in the device ID
+        const uint8_t message[SYSEX_SNAPSHOT_SIZE] = {
+            0xF0, ConfigStore::SYSEX_MANUFACTURER, (uint8_t)(ConfigStore::SYSEX_DEVICE + (channel - MIDI_CHANNEL)),
+            SYSEX_SWITCH_SNAPSHOT, high, low, 0xF7
+        };
+        midiOut_.sendSysEx(message, sizeof(message));
+    }
+    
+    LOG_EVENT(LOG_MIDI_SWITCH_SNAPSHOT, snapshotMode, bits, state.bankChanges);
+    
+    snapshotsSent++;
+    snapshotChanges += state.bankChanges;
+    state.bankChanges = 0;
+    state.sentBits = bits;
+    state.bankSent = true;
+}
+
+void RobustMidiMapper::releaseChannel(uint8_t channel) {
+    ChannelState* state = channelState(channel);
+    if (!state) return;
+    for (int i = 0; i < BUTTON_COUNT; i++) {
+        if (state->heldButtons & (1 << i)) midiOut_.sendNoteOff(BUTTON_NOTES[i], 0, channel);
     }
+    state->heldButtons = 0;
 }
 
 void RobustMidiMapper::sendAllNotesOff() {
     // Send Note Off for all possible button notes
     for (int i = 0; i < BUTTON_COUNT; i++) {
         midiOut_.sendNoteOff(BUTTON_NOTES[i], 0, MIDI_CHANNEL);
-        lastButtonStates[i] = false;  // Reset state tracking
     }
+    channels[0].heldButtons = 0;  // Reset state tracking
     
-    #if DEBUG >= 1
-    Serial.println("MIDI: All notes OFF (panic)");
-    #endif
+    LOG_EVENT(LOG_MIDI_PANIC);
 }
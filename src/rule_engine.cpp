@@ -0,0 +1,392 @@
+#include "rule_engine.h"
+#include "memory_placement.h"
+#include "event_log.h"
+#include "serial_portal_protocol.h"
+
+static_assert(RULES_MAX <= 0x3FFF, "rule counts are two 7-bit bytes in SysEx replies");
+static_assert(BUTTON_COUNT <= 16 && SWITCH_COUNT <= 16 && POT_COUNT <= 16, "rule groups hold 16 inputs per source");
+static_assert(RuleEngine::SYSEX_REPLY_SIZE <= ConfigStore::SYSEX_MAX_SIZE, "rule replies use the config SysEx reply buffer");
+
+// SysEx uploads are assembled here and swapped in on commit
+DMAMEM static Rule ruleStaging[RULES_MAX];
+
+RuleEngine ruleEngine;
+
+// The reactions handlePortalInteractions() used to hard-code
+const Rule RuleEngine::DEFAULT_RULES[] = {
+    // Buttons: flash, and a hue per button (index x 0.1)
+    {RULE_SRC_BUTTON, RULE_ANY_INDEX, RULE_ON_PRESS, RULE_OPERAND_CONST, RULE_IF_ALWAYS, 0, RULE_DO_FLASH, 0, 0},
+    {RULE_SRC_BUTTON, RULE_ANY_INDEX, RULE_ON_PRESS, RULE_OPERAND_INDEX, RULE_IF_ALWAYS, 0, RULE_DO_HUE, 0, 26},
+
+    // Pots: ripple at the pot position, hue drift + 0.2 x pot, activity = pot / POT_COUNT
+    {RULE_SRC_POT, RULE_ANY_INDEX, RULE_ON_CHANGE, RULE_OPERAND_EVENT, RULE_IF_ALWAYS, 0, RULE_DO_RIPPLE, 0, 256},
+    {RULE_SRC_POT, RULE_ANY_INDEX, RULE_ON_CHANGE, RULE_OPERAND_EVENT, RULE_IF_ALWAYS, 0, RULE_DO_HUE_DRIFT, 0, 51},
+    {RULE_SRC_POT, RULE_ANY_INDEX, RULE_ON_CHANGE, RULE_OPERAND_EVENT, RULE_IF_ALWAYS, 0, RULE_DO_ACTIVITY, 0, 256 / POT_COUNT},
+
+    // Joystick: ripple from the top, bottom, left or right of the ring
+    {RULE_SRC_JOYSTICK, 0, RULE_ON_PRESS, RULE_OPERAND_CONST, RULE_IF_ALWAYS, 0, RULE_DO_RIPPLE, 0, 0},
+    {RULE_SRC_JOYSTICK, 1, RULE_ON_PRESS, RULE_OPERAND_CONST, RULE_IF_ALWAYS, 0, RULE_DO_RIPPLE, 0, 128},
+    {RULE_SRC_JOYSTICK, 2, RULE_ON_PRESS, RULE_OPERAND_CONST, RULE_IF_ALWAYS, 0, RULE_DO_RIPPLE, 0, 64},
+    {RULE_SRC_JOYSTICK, 3, RULE_ON_PRESS, RULE_OPERAND_CONST, RULE_IF_ALWAYS, 0, RULE_DO_RIPPLE, 0, 192},
+
+    // Switch 0 on: next program
+    {RULE_SRC_SWITCH, 0, RULE_ON_PRESS, RULE_OPERAND_CONST, RULE_IF_ALWAYS, 0, RULE_DO_NEXT_PROGRAM, 0, 0},
+};
+
+const uint16_t RuleEngine::DEFAULT_RULE_COUNT = sizeof(DEFAULT_RULES) / sizeof(DEFAULT_RULES[0]);
+
+RuleEngine::RuleEngine()
+    : portal(nullptr)
+    , midi(nullptr)
+    , config(nullptr)
+    , inputs(nullptr)
+    , count(0)
+    , largestGroup(0)
+    , stagingCount(0)
+    , uploading(false)
+    , events(0)
+    , fired(0)
+    , capped(0)
+    , maxExamined(0)
+{
+    memset(groupStart, 0, sizeof(groupStart));
+}
+
+void RuleEngine::begin(PortalController* portalController, MidiOut* midiOut, ConfigStore* configStore) {
+    portal = portalController;
+    midi = midiOut;
+    config = configStore;
+    loadDefaults();
+}
+
+// ===== TABLE =====
+
+uint8_t RuleEngine::groupOf(uint8_t source, uint8_t index) {
+    return source * GROUPS_PER_SOURCE + (index == RULE_ANY_INDEX ? INDEX_SLOTS : index);
+}
+
+bool RuleEngine::isValid(const Rule& rule) {
+    if (rule.source >= RULE_SOURCE_COUNT) return false;
+    if (rule.index != RULE_ANY_INDEX && rule.index >= INDEX_SLOTS) return false;
+    if (rule.trigger >= RULE_TRIGGER_COUNT || rule.condition >= RULE_CONDITION_COUNT) return false;
+    if ((rule.flags & ~(RULE_OPERAND_MASK | RULE_STOP)) != 0 || (rule.flags & RULE_OPERAND_MASK) > RULE_OPERAND_INDEX) {
+        return false;
+    }
+    switch (rule.action) {
+        case RULE_DO_PROGRAM: case RULE_DO_BPM: case RULE_DO_INTENSITY: case RULE_DO_HUE:
+        case RULE_DO_BRIGHTNESS: case RULE_DO_FLASH: case RULE_DO_RIPPLE: case RULE_DO_NEXT_PROGRAM:
+        case RULE_DO_HUE_DRIFT: case RULE_DO_ACTIVITY:
+            return true;
+        case RULE_DO_NOTE:
+        case RULE_DO_CC:
+            return rule.target < 128;
+        case RULE_DO_CONFIG:
+            return rule.target < CONFIG_PARAM_COUNT;
+        default:
+            return false;
+    }
+}
+
+bool RuleEngine::load(const Rule* table, uint16_t tableCount) {
+    if (tableCount > RULES_MAX) {
+        LOG_EVENT(LOG_RULES_REJECTED, RULES_MAX);
+        return false;
+    }
+
+    // Counting sort by group, keeping load order within each group
+    uint16_t sizes[GROUP_COUNT] = {};
+    for (uint16_t i = 0; i < tableCount; i++) {
+        const Rule& rule = table[i];
+        if (!isValid(rule)) {
+            LOG_EVENT(LOG_RULES_REJECTED, i);
+            return false;
+        }
+        if (++sizes[groupOf(rule.source, rule.index)] > RULES_MAX_PER_INPUT) {
+            LOG_EVENT(LOG_RULES_REJECTED, i);
+            return false;
+        }
+    }
+
+    largestGroup = 0;
+    groupStart[0] = 0;
+    for (uint8_t g = 0; g < GROUP_COUNT; g++) {
+        groupStart[g + 1] = groupStart[g] + sizes[g];
+        if (sizes[g] > largestGroup) largestGroup = sizes[g];
+        sizes[g] = groupStart[g];
+    }
+    for (uint16_t i = 0; i < tableCount; i++) {
+        rules[sizes[groupOf(table[i].source, table[i].index)]++] = table[i];
+    }
+    count = tableCount;
+
+    LOG_EVENT(LOG_RULES_LOADED, count, largestGroup);
+    return true;
+}
+
+// ===== EVALUATION =====
+
+FASTRUN bool RuleEngine::processInputs(const InputProcessor& source) {
+    inputs = &source;
+    bool activity = false;
+
+    for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+        if (source.getButtonPressed(i)) {
+            handleEvent({RULE_SRC_BUTTON, i, 127, true});
+            activity = true;
+        }
+        if (source.getButtonReleased(i)) handleEvent({RULE_SRC_BUTTON, i, 0, false});
+    }
+    for (uint8_t i = 0; i < POT_COUNT; i++) {
+        if (source.getPotChanged(i)) {
+            handleEvent({RULE_SRC_POT, i, source.getPotMidiValue(i), true});
+            activity = true;
+        }
+    }
+    for (uint8_t dir = 0; dir < 4; dir++) {
+        if (source.getJoystickPressed(dir)) {
+            handleEvent({RULE_SRC_JOYSTICK, dir, 127, true});
+            activity = true;
+        }
+    }
+    for (uint8_t i = 0; i < SWITCH_COUNT; i++) {
+        if (source.getSwitchChanged(i)) {
+            const bool on = source.getSwitchState(i);
+            handleEvent({RULE_SRC_SWITCH, i, (uint8_t)(on ? 127 : 0), on});
+            activity = true;
+        }
+    }
+    return activity;
+}
+
+FASTRUN uint8_t RuleEngine::handleEvent(const RuleEvent& event) {
+    events++;
+    if (event.source >= RULE_SOURCE_COUNT || event.index >= INDEX_SLOTS) return 0;
+
+    // The input's own rules first, then its source's "any index" rules
+    uint8_t examined = 0;
+    bool stop = false;
+    uint8_t done = runGroup(groupOf(event.source, event.index), event, 0, examined, stop);
+    if (!stop) done = runGroup(groupOf(event.source, RULE_ANY_INDEX), event, done, examined, stop);
+
+    if (examined > maxExamined) maxExamined = examined;
+    return done;
+}
+
+FASTRUN uint8_t RuleEngine::runGroup(uint8_t group, const RuleEvent& event, uint8_t firedSoFar, uint8_t& examined,
+                                     bool& stop) {
+    for (uint16_t i = groupStart[group]; i < groupStart[group + 1]; i++) {
+        const Rule& rule = rules[i];
+        examined++;
+        if (rule.trigger != RULE_ON_CHANGE && (rule.trigger == RULE_ON_PRESS) != event.on) continue;
+        if (!conditionHolds(rule, event)) continue;
+        if (firedSoFar >= RULES_MAX_ACTIONS_PER_EVENT) {
+            capped++;
+            continue;
+        }
+
+        run(rule, operand(rule, event));
+        firedSoFar++;
+        fired++;
+        LOG_EVENT(LOG_RULE_FIRED, event.source, event.index, rule.action);
+        if (rule.flags & RULE_STOP) {
+            stop = true;
+            break;
+        }
+    }
+    return firedSoFar;
+}
+
+bool RuleEngine::conditionHolds(const Rule& rule, const RuleEvent& event) const {
+    switch (rule.condition) {
+        case RULE_IF_ALWAYS:
+            return true;
+        case RULE_IF_PROGRAM:
+            return portal && portal->getCurrentProgram() == rule.conditionArg;
+        case RULE_IF_SWITCH_ON:
+            return inputs && rule.conditionArg < SWITCH_COUNT && inputs->getSwitchState(rule.conditionArg);
+        case RULE_IF_SWITCH_OFF:
+            return inputs && rule.conditionArg < SWITCH_COUNT && !inputs->getSwitchState(rule.conditionArg);
+        case RULE_IF_BUTTON_HELD:
+            return inputs && rule.conditionArg < BUTTON_COUNT && inputs->getButtonState(rule.conditionArg);
+        case RULE_IF_VALUE_ABOVE:
+            return event.value >= rule.conditionArg;
+        case RULE_IF_VALUE_BELOW:
+            return event.value < rule.conditionArg;
+        default:
+            return false;
+    }
+}
+
+uint16_t RuleEngine::operand(const Rule& rule, const RuleEvent& event) const {
+    uint32_t value;
+    switch (rule.flags & RULE_OPERAND_MASK) {
+        case RULE_OPERAND_EVENT: {
+            // 0-127 to the protocol's 0-255, then the gain (256 = 1.0)
+            const uint32_t wire = event.value * 2 + (event.value >> 6);
+            value = wire * rule.value / 256;
+            break;
+        }
+        case RULE_OPERAND_INDEX:
+            value = (uint32_t)event.index * rule.value;
+            break;
+        default:
+            value = rule.value;
+            break;
+    }
+    return value > 0xFFFF ? 0xFFFF : value;
+}
+
+FASTRUN void RuleEngine::run(const Rule& rule, uint16_t value) {
+    const uint8_t wire = value > 255 ? 255 : value;
+    const uint8_t midiValue = value > 127 ? 127 : value;
+
+    if (rule.action < RULE_DO_NOTE && !portal) return;
+    switch (rule.action) {
+        case RULE_DO_PROGRAM:
+            if (wire < PORTAL_PROGRAM_COUNT) portal->setProgram(wire);
+            break;
+        case RULE_DO_BPM:
+            portal->setBpm(SerialPortalProtocol::mapToBpm(wire));
+            break;
+        case RULE_DO_INTENSITY:
+            portal->setIntensity(SerialPortalProtocol::mapToNormalized(wire));
+            break;
+        case RULE_DO_HUE:
+            portal->setBaseHue(SerialPortalProtocol::mapToNormalized(wire));
+            break;
+        case RULE_DO_BRIGHTNESS:
+            portal->setBrightness(wire);
+            break;
+        case RULE_DO_FLASH:
+            portal->triggerFlash();
+            break;
+        case RULE_DO_RIPPLE:
+            portal->triggerRipple(SerialPortalProtocol::mapToLedPosition(wire, LED_COUNT));
+            break;
+        case RULE_DO_NEXT_PROGRAM:
+            portal->setProgram((portal->getCurrentProgram() + 1) % PORTAL_PROGRAM_COUNT);
+            break;
+        case RULE_DO_HUE_DRIFT:
+            portal->setBaseHue(fmodf(millis() * 0.0001f + SerialPortalProtocol::mapToNormalized(wire), 1.0f));
+            break;
+        case RULE_DO_ACTIVITY:
+            portal->setActivityLevel(SerialPortalProtocol::mapToNormalized(wire));
+            break;
+        case RULE_DO_NOTE:
+            if (!midi) break;
+            if (midiValue > 0) {
+                midi->sendNoteOn(rule.target, midiValue, RULES_MIDI_CHANNEL);
+            } else {
+                midi->sendNoteOff(rule.target, 0, RULES_MIDI_CHANNEL);
+            }
+            break;
+        case RULE_DO_CC:
+            if (midi) midi->sendControlChange(rule.target, midiValue, RULES_MIDI_CHANNEL);
+            break;
+        case RULE_DO_CONFIG:
+            if (config) {
+                const ConfigParam param = static_cast<ConfigParam>(rule.target);
+                config->setValue(param, ConfigStore::fromWire(param, wire));
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// ===== SYSEX UPLOAD =====
+
+void RuleEngine::encodeRule(const Rule& rule, uint8_t* out) {
+    out[0] = rule.source;
+    out[1] = rule.index;
+    out[2] = rule.trigger;
+    out[3] = rule.flags;
+    out[4] = rule.condition;
+    out[5] = rule.conditionArg;
+    out[6] = rule.action;
+    out[7] = rule.target;
+    out[8] = (rule.value >> 7) & 0x7F;
+    out[9] = rule.value & 0x7F;
+}
+
+bool RuleEngine::decodeRule(const uint8_t* in, Rule& rule) {
+    for (uint8_t i = 0; i < RULE_WIRE_SIZE; i++) {
+        if (in[i] & 0x80) return false;
+    }
+    rule = {in[0], in[1], in[2], in[3], in[4], in[5], in[6], in[7], (uint16_t)((in[8] << 7) | in[9])};
+    return true;
+}
+
+size_t RuleEngine::handleSysEx(const uint8_t* data, size_t length, uint8_t* reply) {
+    if (length < 5 || data[0] != 0xF0 || data[length - 1] != 0xF7 ||
+        data[1] != ConfigStore::SYSEX_MANUFACTURER || data[2] != ConfigStore::SYSEX_DEVICE) {
+        return 0;
+    }
+
+    const uint8_t type = data[3];
+    const uint8_t* body = data + 4;
+    const size_t bodyLength = length - 5;
+    bool ok = false;
+    uint16_t replyCount = 0;
+
+    switch (type) {
+        case SYSEX_RULES_BEGIN:
+            ok = bodyLength == 0;
+            if (ok) {
+                uploading = true;
+                stagingCount = 0;
+            }
+            break;
+
+        case SYSEX_RULES_ADD: {
+            const size_t rulesIn = bodyLength / RULE_WIRE_SIZE;
+            ok = uploading && bodyLength % RULE_WIRE_SIZE == 0 && rulesIn >= 1 &&
+                 rulesIn <= SYSEX_RULES_PER_MESSAGE && stagingCount + rulesIn <= RULES_MAX;
+            for (size_t i = 0; ok && i < rulesIn; i++) {
+                ok = decodeRule(body + i * RULE_WIRE_SIZE, ruleStaging[stagingCount + i]);
+            }
+            if (ok) {
+                stagingCount += rulesIn;
+            } else {
+                uploading = false;    // Start again from BEGIN
+            }
+            replyCount = stagingCount;
+            break;
+        }
+
+        case SYSEX_RULES_COMMIT:
+            ok = uploading && bodyLength == 0 && load(ruleStaging, stagingCount);
+            uploading = false;
+            break;
+
+        case SYSEX_RULES_DEFAULTS:
+            ok = bodyLength == 0;
+            if (ok) loadDefaults();
+            uploading = false;
+            break;
+
+        default:
+            return 0;    // Not a rule message (ConfigStore's)
+    }
+
+    reply[0] = 0xF0;
+    reply[1] = ConfigStore::SYSEX_MANUFACTURER;
+    reply[2] = ConfigStore::SYSEX_DEVICE;
+    if (!ok) {
+        reply[3] = ConfigStore::SYSEX_ERROR;
+        reply[4] = 0xF7;
+        return 5;
+    }
+    if (type != SYSEX_RULES_ADD) replyCount = type == SYSEX_RULES_BEGIN ? 0 : count;
+    reply[3] = ConfigStore::SYSEX_OK;
+    reply[4] = (replyCount >> 7) & 0x7F;
+    reply[5] = replyCount & 0x7F;
+    reply[6] = 0xF7;
+    return SYSEX_REPLY_SIZE;
+}
+
+FLASHMEM void RuleEngine::printStats(Print& out) const {
+    out.printf("=== RULES: %u loaded, largest input group %u/%u ===\n", count, largestGroup, RULES_MAX_PER_INPUT);
+    out.printf("Events %lu, actions fired %lu, capped %lu, most rules examined for one event %u\n",
+               (unsigned long)events, (unsigned long)fired, (unsigned long)capped, maxExamined);
+}
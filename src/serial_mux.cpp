@@ -0,0 +1,138 @@
+#include "serial_mux.h"
+#include "memory_placement.h"
+
+static_assert((SERIAL_MUX_CONTROL_QUEUE & (SERIAL_MUX_CONTROL_QUEUE - 1)) == 0 &&
+              (SERIAL_MUX_TELEMETRY_QUEUE & (SERIAL_MUX_TELEMETRY_QUEUE - 1)) == 0 &&
+              (SERIAL_MUX_LOG_QUEUE & (SERIAL_MUX_LOG_QUEUE - 1)) == 0 &&
+              (SERIAL_MUX_BULK_QUEUE & (SERIAL_MUX_BULK_QUEUE - 1)) == 0,
+              "Serial mux queues must be powers of two");
+static_assert(SERIAL_MUX_CONTROL_QUEUE >= PORTAL_MSG_MAX_SIZE,
+              "Control queue must hold a protocol frame");
+
+#if SERIAL_MUX > 0
+SerialMux serialMux(Serial);
+#endif
+
+static const char* const CHANNEL_NAMES[MUX_CHANNEL_COUNT] = {
+    "control", "telemetry", "log", "bulk"
+};
+
+SerialMux::SerialMux(Print& link)
+    : link(link)
+    , framesSent(0)
+{
+    uint8_t* const queues[MUX_CHANNEL_COUNT] = {controlQueue, telemetryQueue, logQueue, bulkQueue};
+    const uint32_t sizes[MUX_CHANNEL_COUNT] = {
+        SERIAL_MUX_CONTROL_QUEUE, SERIAL_MUX_TELEMETRY_QUEUE, SERIAL_MUX_LOG_QUEUE, SERIAL_MUX_BULK_QUEUE
+    };
+    const MuxOverflow overflow[MUX_CHANNEL_COUNT] = {MUX_BLOCK, MUX_DROP, MUX_DROP, MUX_BLOCK};
+
+    for (uint8_t i = 0; i < MUX_CHANNEL_COUNT; i++) {
+        channels[i].mux = this;
+        channels[i].buffer = queues[i];
+        channels[i].capacity = sizes[i];
+        channels[i].id = i;
+        channels[i].overflow = overflow[i];
+    }
+}
+
+size_t SerialMux::Channel::write(const uint8_t* data, size_t size) {
+    if (overflow == MUX_DROP && size > capacity - (head - tail)) {
+        dropped += size;
+        dropPending = true;
+        return 0;
+    }
+
+    const uint32_t mask = capacity - 1;
+    size_t written = 0;
+    while (written < size) {
+        uint32_t space = capacity - (head - tail);
+        if (space == 0) {
+            mux->makeRoom(*this);
+            continue;
+        }
+        uint32_t n = size - written < space ? size - written : space;
+        for (uint32_t i = 0; i < n; i++) {
+            buffer[(head + i) & mask] = data[written + i];
+        }
+        head += n;
+        written += n;
+        if (head - tail > peak) peak = head - tail;
+    }
+    return size;
+}
+
+void SerialMux::Channel::flush() {
+    while (head != tail) {
+        mux->makeRoom(*this);
+    }
+    mux->link.flush();
+}
+
+void SerialMux::makeRoom(Channel& channel) {
+    for (uint8_t i = 0; i < channel.id; i++) {
+        while (channels[i].getQueued() > 0) sendFrame(channels[i]);
+    }
+    sendFrame(channel);
+}
+
+void SerialMux::sendFrame(Channel& channel) {
+    uint8_t frame[FRAME_OVERHEAD + SERIAL_MUX_MAX_PAYLOAD];
+    const uint32_t mask = channel.capacity - 1;
+    const uint8_t length = channel.getQueued() < SERIAL_MUX_MAX_PAYLOAD ? channel.getQueued() : SERIAL_MUX_MAX_PAYLOAD;
+
+    frame[0] = START_BYTE;
+    frame[1] = channel.id | (channel.dropPending ? FLAG_DROPPED : 0);
+    frame[2] = length;
+    for (uint8_t i = 0; i < length; i++) {
+        frame[3 + i] = channel.buffer[(channel.tail + i) & mask];
+    }
+    frame[3 + length] = crc8(&frame[1], length + 2);
+
+    channel.tail += length;
+    channel.dropPending = false;
+    link.write(frame, length + FRAME_OVERHEAD);
+    framesSent++;
+}
+
+bool SerialMux::pump(uint16_t budget) {
+    for (;;) {
+        Channel* next = nullptr;
+        for (uint8_t i = 0; i < MUX_CHANNEL_COUNT; i++) {
+            if (channels[i].getQueued() > 0) {
+                next = &channels[i];
+                break;
+            }
+        }
+        if (!next) return false;
+
+        uint32_t length = next->getQueued() < SERIAL_MUX_MAX_PAYLOAD ? next->getQueued() : SERIAL_MUX_MAX_PAYLOAD;
+        if (length > budget || link.availableForWrite() < (int)(length + FRAME_OVERHEAD)) return true;
+
+        sendFrame(*next);
+        budget -= length;
+    }
+}
+
+uint8_t SerialMux::crc8(const uint8_t* data, size_t length) {
+    // CRC-8/ATM: polynomial 0x07, init 0
+    uint8_t crc = 0;
+    while (length--) {
+        crc ^= *data++;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+FLASHMEM void SerialMux::printStats(Print& out) const {
+    out.printf("=== SERIAL MUX (%lu frames) ===\n", (unsigned long)framesSent);
+    out.println("Channel   Queued  Peak   Size Dropped");
+    for (uint8_t i = 0; i < MUX_CHANNEL_COUNT; i++) {
+        const Channel& channel = channels[i];
+        out.printf("%-9s %6lu %5lu %6lu %7lu\n", CHANNEL_NAMES[i],
+                   (unsigned long)channel.getQueued(), (unsigned long)channel.peak,
+                   (unsigned long)channel.capacity, (unsigned long)channel.dropped);
+    }
+}
@@ -0,0 +1,295 @@
+#include "session_recorder.h"
+#include "serial_mux.h"
+#include "memory_placement.h"
+
+static_assert(SESSION_BUFFER_BYTES % SessionRecorder::SECTOR_SIZE == 0,
+              "SESSION_BUFFER_BYTES must be a multiple of the sector size");
+static_assert(SESSION_FILE_BYTES % SessionRecorder::SECTOR_SIZE == 0,
+              "SESSION_FILE_BYTES must be a multiple of the sector size");
+static_assert(SessionRecorder::SECTOR_SIZE % sizeof(FlightRecorder::Entry) == 0,
+              "Sectors must hold whole entries");
+
+#if SESSION_RECORDER > 0
+// The card is read by the CPU (SDIO FIFO mode), so cached OCRAM is fine
+DMAMEM CACHE_ALIGNED static uint8_t sessionBuffers[2 * SESSION_BUFFER_BYTES];
+SessionRecorder sessionRecorder(flightRecorder, sessionBuffers);
+#endif
+
+static constexpr uint32_t ENTRY_SIZE = sizeof(FlightRecorder::Entry);
+
+// "SESS0042.BIN" -> 42
+static bool parseSequence(const char* name, uint32_t& sequence) {
+    if (strncmp(name, "SESS", 4) != 0 || strcmp(name + 8, ".BIN") != 0) return false;
+    sequence = 0;
+    for (uint8_t i = 4; i < 8; i++) {
+        if (name[i] < '0' || name[i] > '9') return false;
+        sequence = sequence * 10 + (name[i] - '0');
+    }
+    return true;
+}
+
+SessionRecorder::SessionRecorder(FlightRecorder& source, uint8_t* buffers)
+    : source(source)
+    , buffers{buffers, buffers + SESSION_BUFFER_BYTES}
+    , state(SESSION_OFF)
+    , readSequence(0)
+    , pendingLost(0)
+    , dumpPaused(false)
+    , fillIndex(0)
+    , fillLength(0)
+    , writeData(nullptr)
+    , writeLength(0)
+    , writeOffset(0)
+    , lastSwapMs(0)
+    , lastSyncMs(0)
+    , syncPending(false)
+    , fileSequence(0)
+    , oldestSequence(0)
+    , fileCount(0)
+    , fileBytes(0)
+    , mountMs(0)
+    , bytesWritten(0)
+    , writeUs(0)
+    , maxWriteUs(0)
+    , maxRotateUs(0)
+    , busySkips(0)
+    , entriesLost(0)
+    , peakFill(0)
+    , errors(0)
+{
+}
+
+void SessionRecorder::fileName(uint32_t sequence, char* name) {
+    snprintf(name, 13, "SESS%04lu.BIN", (unsigned long)(sequence % 10000));
+}
+
+FLASHMEM bool SessionRecorder::begin() {
+    // Start at this boot's FLIGHT_BOOT marker
+    readSequence = source.getHead() - (source.getCount() > 0 ? 1 : 0);
+
+    if (!sd.begin(SdioConfig(FIFO_SDIO))) {
+        Serial.println("Session recorder: no SD card");
+        return false;
+    }
+
+    // Number on from the newest session file already on the card
+    FsFile root = sd.open("/");
+    FsFile entry;
+    char name[16];
+    uint32_t newest = 0;
+    oldestSequence = UINT32_MAX;
+    fileCount = 0;
+    while (entry.openNext(&root, O_RDONLY)) {
+        uint32_t sequence;
+        if (!entry.isDir() && entry.getName(name, sizeof(name)) && parseSequence(name, sequence)) {
+            fileCount++;
+            if (sequence > newest) newest = sequence;
+            if (sequence < oldestSequence) oldestSequence = sequence;
+        }
+        entry.close();
+    }
+    root.close();
+    if (fileCount == 0) oldestSequence = 1;
+    fileSequence = newest;
+
+    mountMs = millis();
+    lastSwapMs = mountMs;
+    lastSyncMs = mountMs;
+    if (!openNext()) return false;
+
+    state = SESSION_RECORDING;
+    fileName(fileSequence, name);
+    Serial.printf("Session recorder: recording to %s\n", name);
+    return true;
+}
+
+FLASHMEM void SessionRecorder::prune() {
+    char name[16];
+    while (fileCount >= SESSION_MAX_FILES && oldestSequence < fileSequence) {
+        fileName(oldestSequence, name);
+        if (sd.exists(name) && sd.remove(name)) fileCount--;
+        oldestSequence++;
+    }
+}
+
+FLASHMEM bool SessionRecorder::openNext() {
+    fileSequence++;
+    prune();
+
+    char name[16];
+    fileName(fileSequence, name);
+    file = sd.open(name, O_WRONLY | O_CREAT | O_TRUNC);
+    if (!file || !file.preAllocate(SESSION_FILE_BYTES)) {
+        fail();
+        return false;
+    }
+    fileCount++;
+    fileBytes = 0;
+
+    uint8_t header[SECTOR_SIZE];
+    memset(header, 0, sizeof(header));
+    const uint16_t bootCount = source.getBootCount();
+    const uint32_t now = micros();
+    memcpy(header, "SESS", 4);
+    header[4] = FORMAT_VERSION;
+    header[5] = ENTRY_SIZE;
+    memcpy(&header[6], &bootCount, 2);
+    memcpy(&header[8], &fileSequence, 4);
+    memcpy(&header[12], &now, 4);
+    return writeSector(header);
+}
+
+void SessionRecorder::fail() {
+    errors++;
+    file.close();
+    state = SESSION_FAILED;
+    serialChannel(MUX_LOG).println("Session recorder: SD card error, recording stopped");
+}
+
+bool SessionRecorder::writeSector(const uint8_t* data) {
+    // Rotation is the one step that may wait on the card
+    if (fileBytes + SECTOR_SIZE > SESSION_FILE_BYTES) {
+        const uint32_t start = micros();
+        file.truncate();
+        file.close();
+        if (!openNext()) return false;
+        const uint32_t us = micros() - start;
+        if (us > maxRotateUs) maxRotateUs = us;
+    }
+
+    const uint32_t start = micros();
+    if (file.write(data, SECTOR_SIZE) != SECTOR_SIZE) {
+        fail();
+        return false;
+    }
+    const uint32_t us = micros() - start;
+    writeUs += us;
+    if (us > maxWriteUs) maxWriteUs = us;
+    fileBytes += SECTOR_SIZE;
+    bytesWritten += SECTOR_SIZE;
+    syncPending = true;
+    return true;
+}
+
+void SessionRecorder::collect() {
+    // A flight dump pauses recording; note where the hole is
+    if (source.isDumping()) {
+        dumpPaused = true;
+    }
+
+    const uint32_t head = source.getHead();
+    if (head - readSequence > FLIGHT_RECORDER_ENTRIES) {
+        // Both halves stayed full for longer than the ring holds
+        pendingLost += head - readSequence - FLIGHT_RECORDER_ENTRIES;
+        readSequence = head - FLIGHT_RECORDER_ENTRIES;
+    }
+
+    uint8_t* fill = buffers[fillIndex];
+    while (fillLength + ENTRY_SIZE <= SESSION_BUFFER_BYTES) {
+        if (pendingLost > 0 || (dumpPaused && !source.isDumping())) {
+            FlightRecorder::Entry gap = {micros(), FLIGHT_GAP, (uint8_t)(pendingLost > 0 ? 0 : 1),
+                                         (uint16_t)(pendingLost < 0xFFFF ? pendingLost : 0xFFFF)};
+            entriesLost += pendingLost;
+            pendingLost = 0;
+            dumpPaused = false;
+            memcpy(fill + fillLength, &gap, ENTRY_SIZE);
+        } else if (readSequence != head) {
+            memcpy(fill + fillLength, &source.getEntryAt(readSequence++), ENTRY_SIZE);
+        } else {
+            break;
+        }
+        fillLength += ENTRY_SIZE;
+    }
+    if (fillLength > peakFill) peakFill = fillLength;
+}
+
+bool SessionRecorder::update() {
+    if (state != SESSION_RECORDING) return false;
+
+    collect();
+    const uint32_t now = millis();
+
+    // Swap once the write half is done: when the fill half is full, or on
+    // the sync interval with the whole sectors it holds (the partial one
+    // carries over)
+    if (writeOffset == writeLength) {
+        const uint32_t whole = fillLength & ~(uint32_t)(SECTOR_SIZE - 1);
+        if (fillLength == SESSION_BUFFER_BYTES || (whole > 0 && now - lastSwapMs >= SESSION_SYNC_MS)) {
+            uint8_t* full = buffers[fillIndex];
+            fillIndex ^= 1;
+            fillLength -= whole;
+            memcpy(buffers[fillIndex], full + whole, fillLength);
+            writeData = full;
+            writeLength = whole;
+            writeOffset = 0;
+            lastSwapMs = now;
+        }
+    }
+
+    for (uint8_t i = 0; i < SESSION_SECTORS_PER_SLICE && writeOffset < writeLength; i++) {
+        if (file.isBusy()) {
+            busySkips++;
+            break;
+        }
+        if (!writeSector(writeData + writeOffset)) return false;
+        writeOffset += SECTOR_SIZE;
+    }
+
+    if (syncPending && writeOffset == writeLength && now - lastSyncMs >= SESSION_SYNC_MS && !file.isBusy()) {
+        if (!file.sync()) {
+            fail();
+            return false;
+        }
+        syncPending = false;
+        lastSyncMs = now;
+    }
+    return writeOffset < writeLength;
+}
+
+FLASHMEM void SessionRecorder::close() {
+    if (state != SESSION_RECORDING) return;
+
+    collect();
+    while (writeOffset < writeLength) {
+        if (!writeSector(writeData + writeOffset)) return;
+        writeOffset += SECTOR_SIZE;
+    }
+
+    // Pad the last sector with type 0 entries
+    uint8_t* fill = buffers[fillIndex];
+    const uint32_t padded = (fillLength + SECTOR_SIZE - 1) & ~(uint32_t)(SECTOR_SIZE - 1);
+    memset(fill + fillLength, 0, padded - fillLength);
+    for (uint32_t offset = 0; offset < padded; offset += SECTOR_SIZE) {
+        if (!writeSector(fill + offset)) return;
+    }
+    fillLength = 0;
+
+    file.truncate();
+    file.close();
+    state = SESSION_OFF;
+}
+
+uint32_t SessionRecorder::getWriteRate() const {
+    return writeUs > 0 ? (uint32_t)(bytesWritten * 1000000ULL / writeUs) : 0;
+}
+
+uint32_t SessionRecorder::getSustainedRate() const {
+    const uint32_t elapsedMs = millis() - mountMs;
+    return elapsedMs > 0 ? (uint32_t)(bytesWritten * 1000ULL / elapsedMs) : 0;
+}
+
+FLASHMEM void SessionRecorder::printStats(Print& out) const {
+    static const char* const STATE_NAMES[] = {"off", "recording", "failed"};
+    char name[16];
+    fileName(fileSequence, name);
+    out.printf("=== SESSION RECORDER: %s %s (%lu KB) ===\n", STATE_NAMES[state], name,
+               (unsigned long)(fileBytes / 1024));
+    out.printf("Written: %lu KB, %lu B/s sustained, %lu KB/s while writing\n",
+               (unsigned long)(bytesWritten / 1024), (unsigned long)getSustainedRate(),
+               (unsigned long)(getWriteRate() / 1024));
+    out.printf("Latency: sector max %lu us, rotate max %lu us, %lu busy skips\n",
+               (unsigned long)maxWriteUs, (unsigned long)maxRotateUs, (unsigned long)busySkips);
+    out.printf("Buffer: peak %lu/%lu bytes, %lu entries lost, %u errors\n",
+               (unsigned long)peakFill, (unsigned long)SESSION_BUFFER_BYTES,
+               (unsigned long)entriesLost, errors);
+}
@@ -0,0 +1,59 @@
+#include "stage_profiler.h"
+#include "memory_placement.h"
+
+#if PROFILE > 0
+StageProfiler stageProfiler;
+#endif
+
+StageProfiler::StageProfiler() {
+    reset();
+}
+
+FLASHMEM void StageProfiler::begin() {
+    #ifdef ARM_DWT_CYCCNT
+    ARM_DEMCR |= ARM_DEMCR_TRCENA;
+    ARM_DWT_CTRL |= ARM_DWT_CTRL_CYCCNTENA;
+    #endif
+}
+
+void StageProfiler::reset() {
+    for (uint8_t i = 0; i < PERF_STAGE_COUNT; i++) {
+        stages[i].histogram.reset();
+        stages[i].minCycles = 0xFFFFFFFF;
+        stages[i].totalCycles = 0;
+    }
+}
+
+FLASHMEM void StageProfiler::dump(Print& out) const {
+    out.printf("=== STAGE PROFILE (cycles @ %lu Hz) ===\n", (unsigned long)F_CPU);
+    out.println("Stage      Calls      Min      Avg      Max      P50      P99");
+
+    for (uint8_t i = 0; i < PERF_STAGE_COUNT; i++) {
+        const StageProfile& profile = stages[i];
+        const LogHistogram& histogram = profile.histogram;
+        if (histogram.count == 0) {
+            out.printf("%-5s %10d\n", PERF_STAGE_LABELS[i], 0);
+            continue;
+        }
+
+        out.printf("%-5s %10lu %8lu %8lu %8lu %8lu %8lu\n",
+                   PERF_STAGE_LABELS[i],
+                   (unsigned long)histogram.count,
+                   (unsigned long)profile.minCycles,
+                   (unsigned long)(profile.totalCycles / histogram.count),
+                   (unsigned long)histogram.maxValue,
+                   (unsigned long)histogram.percentile(50),
+                   (unsigned long)histogram.percentile(99));
+
+        // Non-empty bins as upperBound:count pairs
+        out.print("  bins");
+        for (uint8_t bin = 0; bin < LogHistogram::BIN_COUNT; bin++) {
+            if (histogram.bins[bin]) {
+                out.printf(" %lu:%lu", (unsigned long)LogHistogram::binUpperBound(bin),
+                           (unsigned long)histogram.bins[bin]);
+            }
+        }
+        out.println();
+    }
+    out.println("===================================");
+}
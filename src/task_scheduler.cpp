@@ -0,0 +1,177 @@
+#include "task_scheduler.h"
+#include "memory_placement.h"
+#include "loop_watchdog.h"
+
+TaskScheduler::TaskScheduler()
+    : taskCount(0)
+    , watchdog(nullptr)
+{
+    memset(tasks, 0, sizeof(tasks));
+}
+
+uint8_t TaskScheduler::addTask(const char* name, TaskFunction function, uint32_t periodUs,
+                               TaskPriority priority, uint32_t deadlineUs) {
+    if (taskCount >= MAX_TASKS || !function || periodUs == 0) {
+        return INVALID_TASK;
+    }
+
+    Task& task = tasks[taskCount];
+    task.name = name;
+    task.function = function;
+    task.periodUs = periodUs;
+    task.deadlineUs = deadlineUs ? deadlineUs : periodUs;
+    task.priority = priority;
+    task.enabled = true;
+    task.nextRelease = micros();
+    task.jobRelease = task.nextRelease;
+    task.jobActive = false;
+    task.estimateUs = 0;
+    memset(&task.stats, 0, sizeof(task.stats));
+
+    return taskCount++;
+}
+
+FLASHMEM void TaskScheduler::begin() {
+    uint32_t now = micros();
+    for (uint8_t i = 0; i < taskCount; i++) {
+        tasks[i].nextRelease = now;
+        tasks[i].jobActive = false;
+    }
+}
+
+FASTRUN bool TaskScheduler::run() {
+    uint32_t now = micros();
+    Task* best = nullptr;
+    uint32_t bestDeadline = 0;
+
+    for (uint8_t i = 0; i < taskCount; i++) {
+        Task& task = tasks[i];
+        if (!isReady(task, now)) continue;
+
+        uint32_t release = task.jobActive ? task.jobRelease : task.nextRelease;
+        uint32_t deadline = release + task.deadlineUs;
+
+        // Hold back slices that would push a higher-priority task past its
+        // deadline, unless this task is itself already overdue
+        if (!reached(now, deadline) && !fitsBeforeHigherDeadlines(task, now)) {
+            task.stats.deferrals++;
+            continue;
+        }
+
+        // Highest priority first; earliest deadline breaks ties
+        if (!best || task.priority > best->priority ||
+            (task.priority == best->priority && !reached(deadline, bestDeadline))) {
+            best = &task;
+            bestDeadline = deadline;
+        }
+    }
+
+    if (!best) return false;
+
+    runSlice(*best);
+    return true;
+}
+
+void TaskScheduler::setEnabled(uint8_t id, bool enabled) {
+    if (id >= taskCount) return;
+
+    Task& task = tasks[id];
+    if (enabled && !task.enabled) {
+        task.nextRelease = micros();
+        task.jobActive = false;
+    }
+    task.enabled = enabled;
+}
+
+FASTRUN bool TaskScheduler::isReady(Task& task, uint32_t now) {
+    if (!task.enabled) return false;
+    if (task.jobActive) return true;
+    if (!reached(now, task.nextRelease)) return false;
+
+    // Releases that passed entirely while the loop was stalled (or while the
+    // previous job was still running) are skipped rather than replayed
+    uint32_t skipped = (now - task.nextRelease) / task.periodUs;
+    if (skipped > 0) {
+        task.stats.missedReleases += skipped;
+        task.nextRelease += skipped * task.periodUs;
+    }
+    return true;
+}
+
+FASTRUN bool TaskScheduler::fitsBeforeHigherDeadlines(const Task& task, uint32_t now) const {
+    uint32_t finish = now + task.estimateUs;
+
+    for (uint8_t i = 0; i < taskCount; i++) {
+        const Task& other = tasks[i];
+        if (!other.enabled || other.priority <= task.priority) continue;
+
+        // Latest time the higher-priority task can start and still make it
+        uint32_t latestStart = other.nextRelease + other.deadlineUs - other.estimateUs;
+        if (!reached(latestStart, finish)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+FASTRUN void TaskScheduler::runSlice(Task& task) {
+    if (!task.jobActive) {
+        task.jobActive = true;
+        task.jobRelease = task.nextRelease;
+        task.nextRelease += task.periodUs;
+    }
+
+    const uint8_t id = &task - tasks;
+    if (watchdog) watchdog->enterTask(id);
+
+    uint32_t start = micros();
+    bool more = task.function();
+    uint32_t end = micros();
+    uint32_t elapsed = end - start;
+
+    if (watchdog) {
+        if (!more) watchdog->checkIn(id);
+        watchdog->leaveTask();
+    }
+
+    TaskStats& stats = task.stats;
+    stats.slices++;
+    stats.totalUs += elapsed;
+    if (elapsed > stats.maxSliceUs) stats.maxSliceUs = elapsed;
+    if (elapsed > task.estimateUs) task.estimateUs = elapsed;
+
+    if (!more) {
+        task.jobActive = false;
+        stats.jobs++;
+
+        uint32_t jobUs = end - task.jobRelease;
+        if (jobUs > stats.maxJobUs) stats.maxJobUs = jobUs;
+        if (jobUs > task.deadlineUs) stats.overruns++;
+
+        // Let the admission estimate recover slowly from one-off spikes
+        task.estimateUs -= task.estimateUs >> 4;
+    }
+}
+
+void TaskScheduler::resetStats() {
+    for (uint8_t i = 0; i < taskCount; i++) {
+        memset(&tasks[i].stats, 0, sizeof(tasks[i].stats));
+    }
+}
+
+FLASHMEM void TaskScheduler::printStats(Print& out) const {
+    out.println("=== TASK SCHEDULER ===");
+    out.println("Task      Prio Period(us)  Jobs    AvgUs MaxSlice MaxJob Overrun Missed Defer");
+    for (uint8_t i = 0; i < taskCount; i++) {
+        const Task& task = tasks[i];
+        const TaskStats& stats = task.stats;
+        out.printf("%-9s %4d %10lu %7lu %6lu %8lu %6lu %7lu %6lu %5lu\n",
+                      task.name, task.priority, (unsigned long)task.periodUs,
+                      (unsigned long)stats.jobs,
+                      (unsigned long)(stats.jobs ? stats.totalUs / stats.jobs : 0),
+                      (unsigned long)stats.maxSliceUs, (unsigned long)stats.maxJobUs,
+                      (unsigned long)stats.overruns, (unsigned long)stats.missedReleases,
+                      (unsigned long)stats.deferrals);
+    }
+    out.println("======================");
+}
@@ -0,0 +1,161 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "cluster_link.h"
+
+// Events the merger released, in order
+struct Released {
+    ClusterEvent events[16];
+    uint8_t count;
+};
+
+static void collect(const ClusterEvent& event, void* context) {
+    Released* released = static_cast<Released*>(context);
+    if (released->count < 16) released->events[released->count++] = event;
+}
+
+static ClusterMerger merger;
+static Released released;
+
+static ClusterEvent event(uint32_t time, uint8_t node, uint8_t index) {
+    return {time, node, CLUSTER_BUTTON, index, 1};
+}
+
+void test_cluster_frame_round_trip() {
+    const uint8_t payload[] = {0x10, 0x00, CLUSTER_SWITCH, 4, 1};
+    uint8_t bytes[64];
+    const size_t length = ClusterFrameParser::encode(1, 3, payload, sizeof(payload), bytes);
+    TEST_ASSERT_EQUAL(sizeof(payload) + ClusterFrameParser::OVERHEAD, length);
+
+    // Line noise before the frame is skipped
+    ClusterFrameParser parser;
+    parser.receive(0x00);
+    parser.receive(0x42);
+    bool complete = false;
+    for (size_t i = 0; i < length; i++) {
+        complete = parser.receive(bytes[i]);
+        if (i + 1 < length) TEST_ASSERT_FALSE(complete);
+    }
+    TEST_ASSERT_TRUE(complete);
+    TEST_ASSERT_EQUAL(1, parser.frame().type);
+    TEST_ASSERT_EQUAL(3, parser.frame().node);
+    TEST_ASSERT_EQUAL(sizeof(payload), parser.frame().length);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(payload, parser.frame().payload, sizeof(payload));
+
+    // Empty payload
+    const size_t empty = ClusterFrameParser::encode(2, 1, nullptr, 0, bytes);
+    for (size_t i = 0; i < empty; i++) complete = parser.receive(bytes[i]);
+    TEST_ASSERT_TRUE(complete);
+    TEST_ASSERT_EQUAL(2, parser.frame().type);
+    TEST_ASSERT_EQUAL(0, parser.frame().length);
+}
+
+void test_cluster_frame_rejects_bad_crc() {
+    const uint8_t payload[] = {1, 2, 3};
+    uint8_t bytes[16];
+    const size_t length = ClusterFrameParser::encode(1, 2, payload, sizeof(payload), bytes);
+    bytes[5] ^= 0x01;
+
+    ClusterFrameParser parser;
+    bool complete = false;
+    for (size_t i = 0; i < length; i++) complete |= parser.receive(bytes[i]);
+    TEST_ASSERT_FALSE(complete);
+    TEST_ASSERT_EQUAL_UINT32(1, parser.getCrcErrors());
+
+    // The next good frame still decodes
+    ClusterFrameParser::encode(1, 2, payload, sizeof(payload), bytes);
+    for (size_t i = 0; i < length; i++) complete = parser.receive(bytes[i]);
+    TEST_ASSERT_TRUE(complete);
+}
+
+void test_cluster_merge_in_time_order() {
+    merger.setActive(0, true);
+    merger.setActive(1, true);
+    merger.push(event(1000, 0, 0));
+    merger.push(event(3000, 0, 1));
+    merger.push(event(2000, 1, 2));
+    merger.advance(0, 3000);
+    merger.advance(1, 2500);
+
+    // Board 1 has reported up to 2500, so 3000 must wait
+    TEST_ASSERT_EQUAL(2, merger.release(3100, 5000, collect, &released));
+    TEST_ASSERT_EQUAL_UINT32(1000, released.events[0].time);
+    TEST_ASSERT_EQUAL_UINT32(2000, released.events[1].time);
+    TEST_ASSERT_EQUAL(1, released.events[1].node);
+
+    merger.advance(1, 3500);
+    TEST_ASSERT_EQUAL(1, merger.release(3600, 5000, collect, &released));
+    TEST_ASSERT_EQUAL_UINT32(3000, released.events[2].time);
+    TEST_ASSERT_EQUAL_UINT32(0, merger.getLate());
+    TEST_ASSERT_EQUAL_UINT32(0, merger.getOutOfOrder());
+}
+
+void test_cluster_merge_window_and_inactive_boards() {
+    merger.setActive(0, true);
+    merger.setActive(1, true);
+    merger.setActive(2, false);
+    merger.push(event(1000, 0, 0));
+    merger.advance(0, 1000);
+
+    // Board 1 is silent: held until the window runs out
+    TEST_ASSERT_EQUAL(0, merger.release(4000, 5000, collect, &released));
+    TEST_ASSERT_EQUAL(1, merger.release(6000, 5000, collect, &released));
+    TEST_ASSERT_EQUAL_UINT32(1, merger.getLate());
+
+    // Dropped boards are not waited for
+    merger.setActive(1, false);
+    merger.push(event(7000, 0, 1));
+    TEST_ASSERT_EQUAL(1, merger.release(7000, 5000, collect, &released));
+    TEST_ASSERT_EQUAL_UINT32(1, merger.getLate());
+}
+
+void test_cluster_merge_across_clock_wrap() {
+    merger.setActive(0, true);
+    merger.setActive(1, true);
+    merger.push(event(0xFFFFFF00, 1, 0));
+    merger.push(event(0x00000100, 0, 1));
+    merger.advance(0, 0x200);
+    merger.advance(1, 0x200);
+
+    TEST_ASSERT_EQUAL(2, merger.release(0x300, 5000, collect, &released));
+    TEST_ASSERT_EQUAL(1, released.events[0].node);
+    TEST_ASSERT_EQUAL(0, released.events[1].node);
+    TEST_ASSERT_EQUAL_UINT32(0, merger.getOutOfOrder());
+}
+
+void test_cluster_merge_queue_full() {
+    merger.setActive(1, true);
+    for (uint16_t i = 0; i < CLUSTER_NODE_EVENTS; i++) {
+        TEST_ASSERT_TRUE(merger.push(event(i, 1, 0)));
+    }
+    TEST_ASSERT_FALSE(merger.push(event(CLUSTER_NODE_EVENTS, 1, 0)));
+    TEST_ASSERT_EQUAL_UINT32(1, merger.getDropped());
+    TEST_ASSERT_EQUAL(CLUSTER_NODE_EVENTS, merger.getMaxDepth());
+}
+
+void setUp(void) {
+    merger.reset();
+    released.count = 0;
+}
+
+void tearDown(void) {
+    // Clean up code if needed
+}
+
+void setup() {
+    delay(2000); // Wait for serial
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_cluster_frame_round_trip);
+    RUN_TEST(test_cluster_frame_rejects_bad_crc);
+    RUN_TEST(test_cluster_merge_in_time_order);
+    RUN_TEST(test_cluster_merge_window_and_inactive_boards);
+    RUN_TEST(test_cluster_merge_across_clock_wrap);
+    RUN_TEST(test_cluster_merge_queue_full);
+
+    UNITY_END();
+}
+
+void loop() {
+    // Empty
+}
@@ -0,0 +1,143 @@
+#include <unity.h>
+#include "config_store.h"
+
+void test_config_defaults_without_block() {
+    ConfigStore store;
+    uint8_t erased[ConfigStore::BLOCK_SIZE];
+    memset(erased, 0xFF, sizeof(erased));
+
+    TEST_ASSERT_FALSE(store.decode(erased, sizeof(erased)));
+    TEST_ASSERT_EQUAL_UINT8(DEBOUNCE_MS, store.get().debounceMs);
+    TEST_ASSERT_EQUAL_UINT32(IDLE_TIMEOUT_MS, store.get().idleTimeoutMs);
+    TEST_ASSERT_EQUAL_UINT8(LED_BRIGHTNESS_MAX, store.get().ledBrightnessMax);
+}
+
+void test_config_edits_apply_at_tick_boundary() {
+    ConfigStore store;
+
+    TEST_ASSERT_TRUE(store.setValue(CONFIG_DEBOUNCE_MS, 12));
+    TEST_ASSERT_FALSE(store.setValue(CONFIG_DEBOUNCE_MS, 200));      // Out of range
+    TEST_ASSERT_FALSE(store.setValue(CONFIG_SWITCH_SNAPSHOT, 3));
+    TEST_ASSERT_FALSE(store.setValue(CONFIG_LED_POWER_BUDGET_MA, 25001));
+    TEST_ASSERT_FALSE(store.setValue(CONFIG_PARAM_COUNT, 1));
+
+    // Staged, not live yet
+    TEST_ASSERT_EQUAL_UINT32(12, store.getValue(CONFIG_DEBOUNCE_MS));
+    TEST_ASSERT_EQUAL_UINT8(DEBOUNCE_MS, store.get().debounceMs);
+
+    TEST_ASSERT_TRUE(store.applyPending());
+    TEST_ASSERT_EQUAL_UINT8(12, store.get().debounceMs);
+    TEST_ASSERT_FALSE(store.applyPending());
+}
+
+void test_config_block_round_trip() {
+    ConfigStore store;
+    store.setValue(CONFIG_POT_RATE_LIMIT_MS, 30);
+    store.setValue(CONFIG_IDLE_TIMEOUT_MS, 90000);
+    store.applyPending();
+
+    uint8_t block[ConfigStore::BLOCK_SIZE];
+    store.encode(block);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY("MMCF", block, 4);
+
+    ConfigStore loaded;
+    TEST_ASSERT_TRUE(loaded.decode(block, sizeof(block)));
+    TEST_ASSERT_EQUAL_UINT8(30, loaded.get().potRateLimitMs);
+    TEST_ASSERT_EQUAL_UINT32(90000, loaded.get().idleTimeoutMs);
+
+    // Any corruption falls back to the defaults
+    block[ConfigStore::HEADER_SIZE] ^= 0x01;
+    TEST_ASSERT_FALSE(loaded.decode(block, sizeof(block)));
+    TEST_ASSERT_EQUAL_UINT32(IDLE_TIMEOUT_MS, loaded.get().idleTimeoutMs);
+}
+
+void test_config_short_block_keeps_stored_fields() {
+    // Block from firmware that only knew idleTimeoutMs and joystickRearmMs
+    ConfigStore store;
+    store.setValue(CONFIG_IDLE_TIMEOUT_MS, 60000);
+    store.setValue(CONFIG_JOYSTICK_REARM_MS, 200);
+    store.setValue(CONFIG_DEBOUNCE_MS, 20);
+    store.applyPending();
+
+    uint8_t full[ConfigStore::BLOCK_SIZE];
+    store.encode(full);
+
+    const uint8_t payload = 6;
+    uint8_t block[ConfigStore::HEADER_SIZE + payload + 4];
+    memcpy(block, full, ConfigStore::HEADER_SIZE + payload);
+    block[5] = payload;
+    uint32_t hash = 2166136261UL;
+    for (size_t i = 0; i < ConfigStore::HEADER_SIZE + payload; i++) {
+        hash = (hash ^ block[i]) * 16777619UL;
+    }
+    memcpy(block + ConfigStore::HEADER_SIZE + payload, &hash, 4);
+
+    ConfigStore loaded;
+    TEST_ASSERT_TRUE(loaded.decode(block, sizeof(block)));
+    TEST_ASSERT_EQUAL_UINT32(60000, loaded.get().idleTimeoutMs);
+    TEST_ASSERT_EQUAL_UINT16(200, loaded.get().joystickRearmMs);
+    TEST_ASSERT_EQUAL_UINT8(DEBOUNCE_MS, loaded.get().debounceMs);  // Not in the block
+    TEST_ASSERT_EQUAL_UINT8(SWITCH_SNAPSHOT, loaded.get().switchSnapshot);
+    TEST_ASSERT_EQUAL_UINT16(LED_POWER_BUDGET_MA, loaded.get().ledPowerBudgetMa);
+}
+
+void test_config_sysex_set_and_get() {
+    ConfigStore store;
+    uint8_t reply[ConfigStore::SYSEX_MAX_SIZE];
+
+    // Set idle timeout to 120000 ms = 7 << 14 | 41 << 7 | 64
+    const uint8_t set[] = {0xF0, 0x7D, 0x4D, 0x01, CONFIG_IDLE_TIMEOUT_MS, 7, 41, 64, 0xF7};
+    size_t length = store.handleSysEx(set, sizeof(set), reply);
+    TEST_ASSERT_EQUAL(9, length);
+    TEST_ASSERT_EQUAL_UINT8(ConfigStore::SYSEX_VALUE, reply[3]);
+    TEST_ASSERT_EQUAL_UINT32(120000, store.getValue(CONFIG_IDLE_TIMEOUT_MS));
+
+    const uint8_t get[] = {0xF0, 0x7D, 0x4D, 0x02, CONFIG_IDLE_TIMEOUT_MS, 0xF7};
+    length = store.handleSysEx(get, sizeof(get), reply);
+    TEST_ASSERT_EQUAL(9, length);
+    TEST_ASSERT_EQUAL_UINT8(7, reply[5]);
+    TEST_ASSERT_EQUAL_UINT8(41, reply[6]);
+    TEST_ASSERT_EQUAL_UINT8(64, reply[7]);
+
+    // Out of range value is an error; other manufacturers are ignored
+    const uint8_t bad[] = {0xF0, 0x7D, 0x4D, 0x01, CONFIG_LED_BRIGHTNESS_MAX, 0, 0, 0, 0xF7};
+    length = store.handleSysEx(bad, sizeof(bad), reply);
+    TEST_ASSERT_EQUAL(5, length);
+    TEST_ASSERT_EQUAL_UINT8(ConfigStore::SYSEX_ERROR, reply[3]);
+
+    const uint8_t other[] = {0xF0, 0x43, 0x10, 0x01, 0xF7};
+    TEST_ASSERT_EQUAL(0, store.handleSysEx(other, sizeof(other), reply));
+}
+
+void test_config_wire_units() {
+    TEST_ASSERT_EQUAL_UINT32(30000, ConfigStore::fromWire(CONFIG_IDLE_TIMEOUT_MS, 30));
+    TEST_ASSERT_EQUAL_UINT8(30, ConfigStore::toWire(CONFIG_JOYSTICK_REARM_MS, 120));
+    TEST_ASSERT_EQUAL_UINT8(255, ConfigStore::toWire(CONFIG_IDLE_TIMEOUT_MS, 1800000));
+}
+
+void setUp(void) {
+    // Set up code if needed
+}
+
+void tearDown(void) {
+    // Clean up code if needed
+}
+
+void setup() {
+    delay(2000); // Wait for serial
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_config_defaults_without_block);
+    RUN_TEST(test_config_edits_apply_at_tick_boundary);
+    RUN_TEST(test_config_block_round_trip);
+    RUN_TEST(test_config_short_block_keeps_stored_fields);
+    RUN_TEST(test_config_sysex_set_and_get);
+    RUN_TEST(test_config_wire_units);
+
+    UNITY_END();
+}
+
+void loop() {
+    // Empty
+}
@@ -0,0 +1,148 @@
+#include <unity.h>
+#include "event_log.h"
+
+// Collects drained text and dump output
+class CapturePrint : public Print {
+public:
+    uint8_t data[512];
+    size_t length = 0;
+    size_t overflow = 0;
+
+    size_t write(uint8_t b) override {
+        if (length < sizeof(data)) {
+            data[length++] = b;
+        } else {
+            overflow++;
+        }
+        return 1;
+    }
+    using Print::write;
+
+    bool contains(const char* text) const {
+        size_t n = strlen(text);
+        for (size_t i = 0; i + n <= length; i++) {
+            if (memcmp(data + i, text, n) == 0) return true;
+        }
+        return false;
+    }
+};
+
+static EventLog testLog;
+
+void test_log_level_and_category_filter() {
+    testLog.setLevel(LOG_INFO);
+    testLog.setCategories(LOG_CAT_ALL);
+
+    testLog.write(LOG_MIDI_NOTE_ON, 0, 36);      // INFO: kept
+    testLog.write(LOG_INPUT_BUTTON, 0, 1);       // DEBUG: above level
+    testLog.write(LOG_PROTOCOL_UNKNOWN, 0x42);   // WARN: kept
+    TEST_ASSERT_EQUAL_UINT32(2, testLog.getCount());
+
+    testLog.setCategories(LOG_CAT_ALL & ~LOG_CAT_MIDI);
+    testLog.write(LOG_MIDI_NOTE_OFF, 0, 36);
+    TEST_ASSERT_EQUAL_UINT32(2, testLog.getCount());
+
+    testLog.setLevel(LOG_OFF);
+    testLog.write(LOG_LOG_DROPPED, 1);
+    TEST_ASSERT_EQUAL_UINT32(2, testLog.getCount());
+
+    TEST_ASSERT_EQUAL_UINT16(LOG_MIDI_NOTE_ON, testLog.getRecord(0).id);
+    TEST_ASSERT_EQUAL_UINT16(36, testLog.getRecord(0).b);
+    TEST_ASSERT_EQUAL_UINT16(LOG_PROTOCOL_UNKNOWN, testLog.getRecord(1).id);
+}
+
+void test_log_format_names_and_numbers() {
+    char line[128];
+
+    EventLog::Record pot = {1234567, LOG_MIDI_POT_CC, 3, 23, 64};
+    EventLog::format(pot, line, sizeof(line));
+    TEST_ASSERT_EQUAL_STRING("[1.234] MIDI: Pot 3 changed -> CC 23 = 64", line);
+
+    EventLog::Record joystick = {0, LOG_MIDI_JOYSTICK_CC, 2, 30, 0};
+    EventLog::format(joystick, line, sizeof(line));
+    TEST_ASSERT_EQUAL_STRING("[0.000] MIDI: Joystick LEFT -> CC 30 = 127", line);
+
+    EventLog::Record program = {0, LOG_PORTAL_PROGRAM, 4, 4, 0};
+    EventLog::format(program, line, sizeof(line));
+    TEST_ASSERT_EQUAL_STRING("[0.000] Portal program changed to: AMBIENT (4)", line);
+
+    // Truncation keeps the string terminated
+    TEST_ASSERT_EQUAL(15, EventLog::format(program, line, 16));
+    TEST_ASSERT_EQUAL(15, strlen(line));
+}
+
+void test_log_text_drain_reports_overrun() {
+    testLog.setLevel(LOG_INFO);
+    testLog.setCategories(LOG_CAT_ALL);
+    testLog.setTextOutput(true);
+
+    for (uint32_t i = 0; i < EVENT_LOG_ENTRIES + 5; i++) {
+        testLog.write(LOG_MIDI_NOTE_ON, i & 15, 36);
+    }
+
+    CapturePrint out;
+    testLog.drainText(out);
+    TEST_ASSERT_EQUAL_UINT32(5, testLog.getDropped());
+    TEST_ASSERT_TRUE(out.contains("Log: 5 records dropped"));
+    TEST_ASSERT_TRUE(out.contains("MIDI: Button 5 pressed -> Note 36 ON"));
+}
+
+void test_log_dump_header_and_records() {
+    testLog.setLevel(LOG_INFO);
+    testLog.setCategories(LOG_CAT_ALL);
+    testLog.write(LOG_PORTAL_RIPPLE, 17);
+    testLog.write(LOG_PORTAL_FLASH);
+    testLog.write(LOG_PORTAL_RESET);
+
+    TEST_ASSERT_TRUE(testLog.beginDump());
+    TEST_ASSERT_FALSE(testLog.beginDump());
+
+    // Records are dropped while the dump runs
+    testLog.write(LOG_PORTAL_FLASH);
+    TEST_ASSERT_EQUAL_UINT32(1, testLog.getDropped());
+
+    CapturePrint out;
+    while (testLog.dumpSlice(out)) {}
+    TEST_ASSERT_FALSE(testLog.isDumping());
+    TEST_ASSERT_EQUAL(EventLog::HEADER_SIZE + 3 * sizeof(EventLog::Record), out.length);
+
+    TEST_ASSERT_EQUAL_UINT8_ARRAY("ELOG", out.data, 4);
+    TEST_ASSERT_EQUAL_UINT8(EventLog::FORMAT_VERSION, out.data[4]);
+    TEST_ASSERT_EQUAL_UINT8(12, out.data[5]);
+    TEST_ASSERT_EQUAL_UINT8(1, out.data[6]);  // Dropped (LE)
+    TEST_ASSERT_EQUAL_UINT8(3, out.data[8]);  // Record count (LE)
+
+    // First record: ripple at 17
+    const uint8_t* record = out.data + EventLog::HEADER_SIZE;
+    uint16_t id, a;
+    memcpy(&id, record + 4, 2);
+    memcpy(&a, record + 6, 2);
+    TEST_ASSERT_EQUAL_UINT16(LOG_PORTAL_RIPPLE, id);
+    TEST_ASSERT_EQUAL_UINT16(17, a);
+}
+
+void setUp(void) {
+    testLog.clear();
+    testLog.setTextOutput(false);
+}
+
+void tearDown(void) {
+    // Clean up code if needed
+}
+
+void setup() {
+    delay(2000); // Wait for serial
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_log_level_and_category_filter);
+    RUN_TEST(test_log_format_names_and_numbers);
+    RUN_TEST(test_log_text_drain_reports_overrun);
+    RUN_TEST(test_log_dump_header_and_records);
+
+    UNITY_END();
+}
+
+void loop() {
+    // Empty
+}
@@ -0,0 +1,130 @@
+#include <unity.h>
+#include "flight_recorder.h"
+
+// Collects dump output
+class CapturePrint : public Print {
+public:
+    uint8_t data[FlightRecorder::HEADER_SIZE + 3 * sizeof(FlightRecorder::Entry)];
+    size_t length = 0;
+    size_t overflow = 0;
+
+    size_t write(uint8_t b) override {
+        if (length < sizeof(data)) {
+            data[length++] = b;
+        } else {
+            overflow++;
+        }
+        return 1;
+    }
+    using Print::write;
+};
+
+static FlightRecorder::Storage storage;
+
+void test_recorder_cold_start_and_boot_marker() {
+    memset(&storage, 0xA5, sizeof(storage));  // Power-up garbage
+    FlightRecorder recorder(&storage);
+    recorder.begin();
+
+    TEST_ASSERT_EQUAL_UINT32(1, recorder.getCount());
+    TEST_ASSERT_EQUAL_UINT32(1, recorder.getBootCount());
+    TEST_ASSERT_EQUAL_UINT8(FLIGHT_BOOT, recorder.getEntry(0).type);
+    TEST_ASSERT_EQUAL_UINT16(1, recorder.getEntry(0).b);
+}
+
+void test_recorder_survives_reset() {
+    memset(&storage, 0, sizeof(storage));
+    {
+        FlightRecorder recorder(&storage);
+        recorder.begin();
+        recorder.recordAt(100, FLIGHT_BUTTON, 3, 1);
+    }
+
+    // Soft reset: a new instance over the same storage keeps the history
+    FlightRecorder recorder(&storage);
+    recorder.begin();
+    TEST_ASSERT_EQUAL_UINT32(3, recorder.getCount());
+    TEST_ASSERT_EQUAL_UINT8(FLIGHT_BUTTON, recorder.getEntry(1).type);
+    TEST_ASSERT_EQUAL_UINT8(3, recorder.getEntry(1).a);
+    TEST_ASSERT_EQUAL_UINT8(FLIGHT_BOOT, recorder.getEntry(2).type);
+    TEST_ASSERT_EQUAL_UINT16(2, recorder.getEntry(2).b);
+}
+
+void test_recorder_ring_keeps_newest() {
+    memset(&storage, 0, sizeof(storage));
+    FlightRecorder recorder(&storage);
+    recorder.begin();
+
+    for (uint32_t i = 0; i < FLIGHT_RECORDER_ENTRIES + 10; i++) {
+        recorder.recordAt(i, FLIGHT_TICK, 0, (uint16_t)i);
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(FLIGHT_RECORDER_ENTRIES, recorder.getCount());
+    TEST_ASSERT_EQUAL_UINT32(10, recorder.getEntry(0).timestamp);  // Boot marker + 10 ticks dropped
+    TEST_ASSERT_EQUAL_UINT32(FLIGHT_RECORDER_ENTRIES + 9,
+                             recorder.getEntry(FLIGHT_RECORDER_ENTRIES - 1).timestamp);
+}
+
+void test_recorder_dump_format() {
+    memset(&storage, 0, sizeof(storage));
+    FlightRecorder recorder(&storage);
+    recorder.begin();
+    recorder.recordAt(1000, FLIGHT_NOTE_ON, 60, 100 | (1 << 8));
+    recorder.recordAt(2000, FLIGHT_FRAME_RX, 0x01, 5);
+
+    TEST_ASSERT_TRUE(recorder.beginDump());
+    TEST_ASSERT_FALSE(recorder.beginDump());
+
+    // Recording pauses while the dump runs
+    recorder.recordAt(3000, FLIGHT_CC, 1, 2);
+
+    CapturePrint out;
+    while (recorder.dumpSlice(out)) {}
+    TEST_ASSERT_FALSE(recorder.isDumping());
+    TEST_ASSERT_EQUAL(sizeof(out.data), out.length);
+    TEST_ASSERT_EQUAL(0, out.overflow);
+
+    TEST_ASSERT_EQUAL_UINT8_ARRAY("FLTR", out.data, 4);
+    TEST_ASSERT_EQUAL_UINT8(FlightRecorder::FORMAT_VERSION, out.data[4]);
+    TEST_ASSERT_EQUAL_UINT8(8, out.data[5]);
+    TEST_ASSERT_EQUAL_UINT8(3, out.data[8]);  // Entry count (LE)
+
+    // Second entry: NoteOn 60, velocity 100, channel 1
+    const uint8_t* entry = out.data + FlightRecorder::HEADER_SIZE + 8;
+    uint32_t timestamp;
+    memcpy(&timestamp, entry, 4);
+    TEST_ASSERT_EQUAL_UINT32(1000, timestamp);
+    TEST_ASSERT_EQUAL_UINT8(FLIGHT_NOTE_ON, entry[4]);
+    TEST_ASSERT_EQUAL_UINT8(60, entry[5]);
+    TEST_ASSERT_EQUAL_UINT8(100, entry[6]);
+    TEST_ASSERT_EQUAL_UINT8(1, entry[7]);
+
+    // Recording resumes after the dump
+    recorder.recordAt(4000, FLIGHT_CC, 1, 2);
+    TEST_ASSERT_EQUAL_UINT32(4, recorder.getCount());
+}
+
+void setUp(void) {
+    // Set up code if needed
+}
+
+void tearDown(void) {
+    // Clean up code if needed
+}
+
+void setup() {
+    delay(2000); // Wait for serial
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_recorder_cold_start_and_boot_marker);
+    RUN_TEST(test_recorder_survives_reset);
+    RUN_TEST(test_recorder_ring_keeps_newest);
+    RUN_TEST(test_recorder_dump_format);
+
+    UNITY_END();
+}
+
+void loop() {
+    // Empty
+}
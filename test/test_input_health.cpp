@@ -0,0 +1,145 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "static_input_pipeline.h"
+#include "input_trace.h"
+
+static InputProcessor processor;
+static RawInputFrame frame;
+
+// One 1 ms scan tick per ms, as the scan task runs them
+static void runMs(uint32_t ms) {
+    for (uint32_t i = 0; i < ms; i++) {
+        delay(1);
+        processor.update(frame);
+    }
+}
+
+// Button 0 bouncing every 8 ms, past debouncing: ~125 edges a second
+static void chatter(uint32_t ms) {
+    for (uint32_t t = 0; t < ms; t += 8) {
+        frame.buttons ^= 1;
+        runMs(8);
+    }
+}
+
+void test_health_chatter_quarantined() {
+    const InputHealthMonitor& health = processor.getHealth();
+    chatter(INPUT_HEALTH_WINDOW_MS / 2);
+    TEST_ASSERT_TRUE(health.isQuarantined(InputHealthMonitor::BUTTON_CHANNEL));
+    TEST_ASSERT_EQUAL(InputHealthMonitor::HEALTH_CHATTER, health.getFault(InputHealthMonitor::BUTTON_CHANNEL));
+    TEST_ASSERT_EQUAL_UINT32(1, health.getQuarantineCount());
+
+    // Held back: reads released and is no longer activity
+    const uint32_t suppressed = health.getSuppressed();
+    frame.buttons |= 1;
+    runMs(DEBOUNCE_MS + 2);
+    TEST_ASSERT_FALSE(processor.getButtonState(0));
+    chatter(100);
+    TEST_ASSERT_GREATER_THAN(suppressed, health.getSuppressed());
+    TEST_ASSERT_GREATER_THAN(90, processor.getTimeSinceLastActivity());
+
+    // Other buttons are untouched
+    frame.buttons = 1 << 3;
+    runMs(DEBOUNCE_MS + 2);
+    TEST_ASSERT_TRUE(processor.getButtonState(3));
+}
+
+void test_health_recovers_once_clear() {
+    const InputHealthMonitor& health = processor.getHealth();
+    chatter(INPUT_HEALTH_WINDOW_MS / 2);
+    TEST_ASSERT_TRUE(health.isQuarantined(InputHealthMonitor::BUTTON_CHANNEL));
+
+    // Quiet for the recovery time, then the next window closes it
+    frame.buttons = 0;
+    runMs(INPUT_HEALTH_RECOVERY_MS - INPUT_HEALTH_WINDOW_MS);
+    TEST_ASSERT_TRUE(health.isQuarantined(InputHealthMonitor::BUTTON_CHANNEL));
+    runMs(2 * INPUT_HEALTH_WINDOW_MS);
+    TEST_ASSERT_FALSE(health.isQuarantined(InputHealthMonitor::BUTTON_CHANNEL));
+
+    frame.buttons = 1;
+    runMs(DEBOUNCE_MS + 2);
+    TEST_ASSERT_TRUE(processor.getButtonState(0));
+}
+
+void test_health_stuck_button_released() {
+    const InputHealthMonitor& health = processor.getHealth();
+    const uint8_t channel = InputHealthMonitor::BUTTON_CHANNEL + 2;
+    frame.buttons = 1 << 2;
+    runMs(INPUT_HEALTH_STUCK_MS - INPUT_HEALTH_WINDOW_MS);
+    TEST_ASSERT_TRUE(processor.getButtonState(2));
+    TEST_ASSERT_FALSE(health.isQuarantined(channel));
+
+    runMs(2 * INPUT_HEALTH_WINDOW_MS);
+    TEST_ASSERT_EQUAL(InputHealthMonitor::HEALTH_STUCK, health.getFault(channel));
+    TEST_ASSERT_FALSE(processor.getButtonState(2));
+
+    // Still held: stays out. Let go: back after the recovery time
+    runMs(INPUT_HEALTH_RECOVERY_MS + INPUT_HEALTH_WINDOW_MS);
+    TEST_ASSERT_TRUE(health.isQuarantined(channel));
+    frame.buttons = 0;
+    runMs(INPUT_HEALTH_RECOVERY_MS + INPUT_HEALTH_WINDOW_MS);
+    TEST_ASSERT_FALSE(health.isQuarantined(channel));
+}
+
+void test_health_switches_may_stay_on() {
+    frame.switches = 0x0F;
+    runMs(INPUT_HEALTH_STUCK_MS + INPUT_HEALTH_WINDOW_MS);
+    TEST_ASSERT_EQUAL_UINT32(0, processor.getHealth().getQuarantined());
+    TEST_ASSERT_TRUE(processor.getSwitchState(3));
+}
+
+void test_health_noisy_pot_silenced() {
+    const InputHealthMonitor& health = processor.getHealth();
+    const uint8_t channel = InputHealthMonitor::POT_CHANNEL + 1;
+
+    // A slow turn one way is fine
+    for (uint16_t raw = 0; raw < 1024; raw += 16) {
+        frame.pots[1] = raw;
+        runMs(20);
+    }
+    TEST_ASSERT_FALSE(health.isQuarantined(channel));
+
+    // Swinging back and forth on every send is not
+    for (uint8_t i = 0; i < 2 * INPUT_HEALTH_MAX_POT_REVERSALS; i++) {
+        frame.pots[1] = (i & 1) ? 1000 : 200;
+        runMs(POT_RATE_LIMIT_MS + 5);
+    }
+    TEST_ASSERT_EQUAL(InputHealthMonitor::HEALTH_NOISE, health.getFault(channel));
+
+    bool changed = false;
+    for (uint8_t i = 0; i < 10; i++) {
+        frame.pots[1] = (i & 1) ? 1000 : 200;
+        runMs(POT_RATE_LIMIT_MS + 5);
+        changed |= processor.getPotChanged(1);
+    }
+    TEST_ASSERT_FALSE(changed);
+}
+
+void setUp(void) {
+    memset(&frame, 0, sizeof(frame));
+    processor.restart(frame);
+}
+
+void tearDown(void) {
+    // Clean up code if needed
+}
+
+void setup() {
+    delay(2000); // Wait for serial
+
+    processor.begin();
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_health_chatter_quarantined);
+    RUN_TEST(test_health_recovers_once_clear);
+    RUN_TEST(test_health_stuck_button_released);
+    RUN_TEST(test_health_switches_may_stay_on);
+    RUN_TEST(test_health_noisy_pot_silenced);
+
+    UNITY_END();
+}
+
+void loop() {
+    // Empty
+}
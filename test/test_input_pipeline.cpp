@@ -0,0 +1,244 @@
+#include <unity.h>
+#include "static_input_pipeline.h"
+#include "debouncer.h"
+#include "analog_smoother.h"
+#include "stage_profiler.h"
+#include "input_trace.h"
+
+// Scripted pin levels instead of hardware reads
+struct TestInputPolicy {
+    static bool pressed[64];
+    static uint16_t analog[64];
+
+    static void configureDigital(uint8_t) {}
+
+    template <uint8_t Pin>
+    static bool readDigital() { return pressed[Pin]; }
+
+    template <uint8_t Pin>
+    static uint16_t readAnalog() { return analog[Pin]; }
+
+    static uint32_t nowMs() { return 0; }
+};
+
+bool TestInputPolicy::pressed[64];
+uint16_t TestInputPolicy::analog[64];
+
+using TestDigitalPins = PinList<2, 3, 4, 5>;
+using TestAnalogPins = PinList<14, 15>;
+
+// Deterministic bounce: pins toggle on a pseudo-random schedule
+static uint32_t lcgState;
+static uint32_t nextRandom() {
+    lcgState = lcgState * 1664525UL + 1013904223UL;
+    return lcgState >> 16;
+}
+
+void test_digital_bank_matches_debouncer() {
+    DigitalBank<TestDigitalPins, TestInputPolicy> bank;
+    Debouncer reference[TestDigitalPins::count];
+    memset(TestInputPolicy::pressed, 0, sizeof(TestInputPolicy::pressed));
+    lcgState = 1;
+
+    for (uint32_t now = 1; now < 2000; now++) {
+        for (uint8_t i = 0; i < TestDigitalPins::count; i++) {
+            if (nextRandom() % 7 == 0) {
+                TestInputPolicy::pressed[TestDigitalPins::pins[i]] ^= true;
+            }
+        }
+        bank.update(now);
+        for (uint8_t i = 0; i < TestDigitalPins::count; i++) {
+            bool changed = reference[i].update(TestInputPolicy::pressed[TestDigitalPins::pins[i]], now);
+            TEST_ASSERT_EQUAL(reference[i].isPressed(), bank.isPressed(i));
+            TEST_ASSERT_EQUAL(changed, bank.justChanged(i));
+            TEST_ASSERT_EQUAL(reference[i].justPressed(), bank.justPressed(i));
+            TEST_ASSERT_EQUAL(reference[i].justReleased(), bank.justReleased(i));
+        }
+    }
+}
+
+void test_digital_bank_disabled_inputs_read_released() {
+    DigitalBank<TestDigitalPins, TestInputPolicy> bank;
+    bank.setDebounceMs(2);
+    memset(TestInputPolicy::pressed, 1, sizeof(TestInputPolicy::pressed));
+
+    bank.update(1, 0x1);
+    bank.update(3, 0x1);
+    TEST_ASSERT_TRUE(bank.isPressed(0));
+    TEST_ASSERT_FALSE(bank.isPressed(1));
+    TEST_ASSERT_EQUAL_UINT32(0x1, bank.getStableMask());
+
+    // Indexes past the bank read false without a bounds check
+    TEST_ASSERT_FALSE(bank.isPressed(TestDigitalPins::count));
+    TEST_ASSERT_FALSE(bank.justChanged(31));
+}
+
+void test_analog_bank_matches_smoother() {
+    AnalogBank<TestAnalogPins, TestInputPolicy> bank;
+    AnalogSmoother reference[TestAnalogPins::count];
+    TestInputPolicy::analog[14] = 100;
+    TestInputPolicy::analog[15] = 900;
+    bank.begin();
+    reference[0].reset(100);
+    reference[1].reset(900);
+    lcgState = 7;
+
+    for (uint32_t now = 1; now < 3000; now++) {
+        // Slow ramp on one pot, jumps plus ADC noise on the other
+        TestInputPolicy::analog[14] = (now / 3) % 1024;
+        if (now % 500 == 0) TestInputPolicy::analog[15] = 2 + nextRandom() % 1020;
+        TestInputPolicy::analog[15] += (nextRandom() % 3) - 1;
+
+        uint32_t sent = bank.update(now);
+        for (uint8_t i = 0; i < TestAnalogPins::count; i++) {
+            bool send = reference[i].update(TestInputPolicy::analog[TestAnalogPins::pins[i]], now);
+            TEST_ASSERT_EQUAL(send, (sent >> i) & 1);
+            TEST_ASSERT_EQUAL_UINT8(reference[i].getMidiValue(), bank.getMidiValue(i));
+            TEST_ASSERT_EQUAL_UINT16(reference[i].getRawFiltered(), bank.getRawFiltered(i));
+            TEST_ASSERT_EQUAL(reference[i].hasSignificantChange(), bank.hasSignificantChange(i));
+        }
+    }
+}
+
+void test_frame_replay_matches_robust_processor() {
+    // Trace replay feeds both processors the same frames on the same clock
+    static RobustInputProcessor generic;
+    static StaticRobustInputProcessor specialized;
+    RawInputFrame frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.pots[0] = 300;
+    frame.pots[3] = 1000;
+    generic.restart(frame);
+    specialized.restart(frame);
+    lcgState = 11;
+
+    for (uint32_t tick = 0; tick < 3000; tick++) {
+        delay(1);
+        if (nextRandom() % 5 == 0) frame.buttons ^= 1 << (nextRandom() % BUTTON_COUNT);
+        if (nextRandom() % 9 == 0) frame.joystick ^= 1 << (nextRandom() % 4);
+        if (nextRandom() % 7 == 0) frame.switches ^= 1 << (nextRandom() % SWITCH_COUNT);
+        frame.pots[tick & 3] = (frame.pots[tick & 3] + nextRandom() % 41 - 20) & 0x3FF;
+        generic.update(frame);
+        specialized.update(frame);
+
+        for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+            TEST_ASSERT_EQUAL(generic.getButtonState(i), specialized.getButtonState(i));
+            TEST_ASSERT_EQUAL(generic.getButtonPressed(i), specialized.getButtonPressed(i));
+        }
+        for (uint8_t i = 0; i < 4; i++) {
+            TEST_ASSERT_EQUAL(generic.getJoystickPressed(i), specialized.getJoystickPressed(i));
+        }
+        for (uint8_t i = 0; i < SWITCH_COUNT; i++) {
+            TEST_ASSERT_EQUAL(generic.getSwitchState(i), specialized.getSwitchState(i));
+        }
+        for (uint8_t i = 0; i < POT_COUNT; i++) {
+            TEST_ASSERT_EQUAL_UINT8(generic.getPotMidiValue(i), specialized.getPotMidiValue(i));
+            TEST_ASSERT_EQUAL(generic.getPotChanged(i), specialized.getPotChanged(i));
+        }
+
+        // Captured frames match what went in
+        RawInputFrame captured;
+        specialized.getRawFrame(captured);
+        TEST_ASSERT_EQUAL_HEX16(frame.buttons, captured.buttons);
+        TEST_ASSERT_EQUAL_HEX8(frame.joystick, captured.joystick);
+        TEST_ASSERT_EQUAL_HEX16(frame.switches, captured.switches);
+        TEST_ASSERT_EQUAL_UINT16_ARRAY(frame.pots, captured.pots, POT_COUNT);
+    }
+}
+
+void test_pipeline_cycle_benchmark() {
+    // Same work both ways: 22 digital inputs and 4 pots per tick
+    constexpr uint32_t TICKS = 2000;
+    using BenchButtons = PinList<2, 3, 4, 5, 6, 7, 8, 9, 10, 11>;
+    using BenchSwitches = PinList<22, 23, 24, 25, 26, 27, 28, 29, 16, 17, 18, 21>;
+    using BenchPots = PinList<40, 41, 42, 43>;
+
+    static DigitalBank<BenchButtons, TestInputPolicy> buttons;
+    static DigitalBank<BenchSwitches, TestInputPolicy> switches;
+    static AnalogBank<BenchPots, TestInputPolicy> pots;
+    static Debouncer buttonRef[BenchButtons::count];
+    static Debouncer switchRef[BenchSwitches::count];
+    static AnalogSmoother potRef[BenchPots::count];
+    lcgState = 3;
+
+    uint32_t staticCycles = 0;
+    uint32_t genericCycles = 0;
+    uint32_t sink = 0;
+    for (uint32_t now = 1; now <= TICKS; now++) {
+        TestInputPolicy::pressed[nextRandom() % 32] ^= true;
+        TestInputPolicy::analog[40 + (now & 3)] = nextRandom() % 1024;
+
+        uint32_t start = StageProfiler::cycles();
+        sink += buttons.update(now);
+        sink += switches.update(now);
+        sink += pots.update(now);
+        staticCycles += StageProfiler::cycles() - start;
+
+        start = StageProfiler::cycles();
+        for (uint8_t i = 0; i < BenchButtons::count; i++) {
+            sink += buttonRef[i].update(TestInputPolicy::pressed[BenchButtons::pins[i]], now);
+        }
+        for (uint8_t i = 0; i < BenchSwitches::count; i++) {
+            sink += switchRef[i].update(TestInputPolicy::pressed[BenchSwitches::pins[i]], now);
+        }
+        for (uint8_t i = 0; i < BenchPots::count; i++) {
+            sink += potRef[i].update(TestInputPolicy::analog[BenchPots::pins[i]], now);
+        }
+        genericCycles += StageProfiler::cycles() - start;
+    }
+
+    #ifdef __IMXRT1062__
+    const char* unit = "cycles";
+    #else
+    const char* unit = "us";  // StageProfiler::cycles() is micros() on host builds
+    #endif
+    Serial.printf("Input pipeline, %lu ticks: static %lu %s, generic %lu %s (sink %lu)\n",
+                  (unsigned long)TICKS, (unsigned long)staticCycles, unit,
+                  (unsigned long)genericCycles, unit, (unsigned long)sink);
+
+    #ifdef __IMXRT1062__
+    // Full processors against the real pins (nothing connected: all idle)
+    static RobustInputProcessor generic;
+    static StaticRobustInputProcessor specialized;
+    generic.begin();
+    specialized.begin();
+
+    uint32_t start = StageProfiler::cycles();
+    for (uint32_t i = 0; i < TICKS; i++) generic.update();
+    uint32_t genericUpdate = (StageProfiler::cycles() - start) / TICKS;
+
+    start = StageProfiler::cycles();
+    for (uint32_t i = 0; i < TICKS; i++) specialized.update();
+    uint32_t staticUpdate = (StageProfiler::cycles() - start) / TICKS;
+
+    Serial.printf("update(): RobustInputProcessor %lu cycles, StaticRobustInputProcessor %lu cycles\n",
+                  (unsigned long)genericUpdate, (unsigned long)staticUpdate);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(genericUpdate, staticUpdate);
+    #endif
+}
+
+void setUp(void) {
+    // Set up code if needed
+}
+
+void tearDown(void) {
+    // Clean up code if needed
+}
+
+void setup() {
+    delay(2000); // Wait for serial
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_digital_bank_matches_debouncer);
+    RUN_TEST(test_digital_bank_disabled_inputs_read_released);
+    RUN_TEST(test_analog_bank_matches_smoother);
+    RUN_TEST(test_frame_replay_matches_robust_processor);
+    RUN_TEST(test_pipeline_cycle_benchmark);
+
+    UNITY_END();
+}
+
+void loop() {
+    // Empty
+}
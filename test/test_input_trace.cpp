@@ -0,0 +1,113 @@
+#include <unity.h>
+#include "input_trace.h"
+
+static uint8_t traceBuffer[1024];
+
+static RawInputFrame makeFrame(uint16_t buttons, uint16_t pot0) {
+    RawInputFrame frame = {};
+    frame.buttons = buttons;
+    frame.pots[0] = pot0;
+    return frame;
+}
+
+void test_trace_roundtrip() {
+    InputTraceRecorder recorder(traceBuffer, sizeof(traceBuffer));
+    recorder.begin(5000, 1000);
+
+    // Ticks 0-9: button 2 pressed at tick 3, pot 0 moves at tick 6
+    for (uint32_t tick = 0; tick < 10; tick++) {
+        RawInputFrame frame = makeFrame(tick >= 3 ? 0x0004 : 0, tick >= 6 ? 700 : 512);
+        TEST_ASSERT_TRUE(recorder.capture(frame, 5000 + tick * 1000));
+    }
+    recorder.end(15000);
+
+    // Initial frame (all sources) plus two changes
+    TEST_ASSERT_EQUAL_UINT32(3 + POT_COUNT + 2, recorder.getRecordCount());
+
+    InputTracePlayer player;
+    TEST_ASSERT_TRUE(player.begin(recorder.data(), recorder.size()));
+    TEST_ASSERT_EQUAL_UINT32(10, player.getDurationTicks());
+    TEST_ASSERT_EQUAL_UINT16(512, player.getInitialFrame().pots[0]);
+
+    RawInputFrame frame;
+    for (uint32_t tick = 0; tick < 10; tick++) {
+        TEST_ASSERT_TRUE(player.advance(tick * 1000, frame));
+        TEST_ASSERT_EQUAL_UINT16(tick >= 3 ? 0x0004 : 0, frame.buttons);
+        TEST_ASSERT_EQUAL_UINT16(tick >= 6 ? 700 : 512, frame.pots[0]);
+    }
+    TEST_ASSERT_FALSE(player.advance(10000, frame));
+}
+
+void test_trace_long_gap_uses_wait_records() {
+    InputTraceRecorder recorder(traceBuffer, sizeof(traceBuffer));
+    recorder.begin(0, 1000);
+    recorder.capture(makeFrame(0, 0), 0);
+    recorder.capture(makeFrame(1, 0), 100000000UL);  // 100000 ticks later
+    recorder.end(100001000UL);
+
+    InputTracePlayer player;
+    TEST_ASSERT_TRUE(player.begin(recorder.data(), recorder.size()));
+
+    RawInputFrame frame;
+    player.advance(99999000UL, frame);
+    TEST_ASSERT_EQUAL_UINT16(0, frame.buttons);
+    player.advance(100000000UL, frame);
+    TEST_ASSERT_EQUAL_UINT16(1, frame.buttons);
+}
+
+void test_trace_full_buffer_stops_capture() {
+    uint8_t small[InputTraceRecorder::HEADER_SIZE + 12 * InputTraceRecorder::RECORD_SIZE];
+    InputTraceRecorder recorder(small, sizeof(small));
+    recorder.begin(0, 1000);
+
+    uint32_t tick = 0;
+    while (recorder.capture(makeFrame(tick & 1, 0), tick * 1000)) {
+        tick++;
+    }
+    TEST_ASSERT_FALSE(recorder.isCapturing());
+    TEST_ASSERT_TRUE(recorder.size() <= sizeof(small));
+
+    // What fit is still a valid trace covering the captured ticks
+    InputTracePlayer player;
+    TEST_ASSERT_TRUE(player.begin(recorder.data(), recorder.size()));
+    TEST_ASSERT_EQUAL_UINT32(tick, player.getDurationTicks());
+}
+
+void test_trace_rejects_foreign_header() {
+    InputTraceRecorder recorder(traceBuffer, sizeof(traceBuffer));
+    recorder.begin(0, 1000);
+    recorder.capture(makeFrame(0, 0), 0);
+    recorder.end(1000);
+
+    InputTracePlayer player;
+    traceBuffer[7] = POT_COUNT + 1;  // Different pot count
+    TEST_ASSERT_FALSE(player.begin(traceBuffer, recorder.size()));
+    traceBuffer[7] = POT_COUNT;
+    TEST_ASSERT_FALSE(player.begin(traceBuffer, recorder.size() - 1));  // Truncated
+    TEST_ASSERT_TRUE(player.begin(traceBuffer, recorder.size()));
+}
+
+void setUp(void) {
+    // Set up code if needed
+}
+
+void tearDown(void) {
+    // Clean up code if needed
+}
+
+void setup() {
+    delay(2000); // Wait for serial
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_trace_roundtrip);
+    RUN_TEST(test_trace_long_gap_uses_wait_records);
+    RUN_TEST(test_trace_full_buffer_stops_capture);
+    RUN_TEST(test_trace_rejects_foreign_header);
+
+    UNITY_END();
+}
+
+void loop() {
+    // Empty
+}
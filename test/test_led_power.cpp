@@ -0,0 +1,122 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "led_power.h"
+#include "pins.h"
+
+static CRGB leds[LED_COUNT];
+static LedPowerLimiter limiter;
+
+// Whole strip at full scale, dark current included
+static constexpr uint32_t WHITE_MA = LED_COUNT * (LED_POWER_MA_RED + LED_POWER_MA_GREEN + LED_POWER_MA_BLUE +
+                                                  LED_POWER_MA_DARK);
+
+void test_power_channel_sums_match_scalar() {
+    // Longer than one lane flush, with a partial group at the end
+    static CRGB strip[1031];
+    uint32_t expected[3] = {0, 0, 0};
+    for (uint16_t i = 0; i < 1031; i++) {
+        strip[i] = CRGB(255 - (i & 0x7F), i * 7, (i & 1) ? 255 : 3);
+        expected[0] += strip[i].r;
+        expected[1] += strip[i].g;
+        expected[2] += strip[i].b;
+    }
+
+    uint32_t sums[3];
+    LedPowerLimiter::sumChannels(strip, 1031, sums);
+    TEST_ASSERT_EQUAL_UINT32_ARRAY(expected, sums, 3);
+
+    LedPowerLimiter::sumChannels(strip, 3, sums);
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)strip[0].r + strip[1].r + strip[2].r, sums[0]);
+}
+
+void test_power_estimate_per_channel() {
+    fill_solid(leds, LED_COUNT, CRGB::Black);
+    TEST_ASSERT_EQUAL_UINT32(LED_COUNT * LED_POWER_MA_DARK, LedPowerLimiter::estimateMa(leds, LED_COUNT, 255));
+
+    fill_solid(leds, LED_COUNT, CRGB(0, 255, 0));
+    TEST_ASSERT_EQUAL_UINT32(LED_COUNT * (LED_POWER_MA_GREEN + LED_POWER_MA_DARK),
+                             LedPowerLimiter::estimateMa(leds, LED_COUNT, 255));
+
+    // FastLED brightness scales the channels, not the dark current
+    fill_solid(leds, LED_COUNT, CRGB::White);
+    TEST_ASSERT_EQUAL_UINT32(WHITE_MA, LedPowerLimiter::estimateMa(leds, LED_COUNT, 255));
+    TEST_ASSERT_EQUAL_UINT32(LED_COUNT * LED_POWER_MA_DARK + (WHITE_MA - LED_COUNT * LED_POWER_MA_DARK) / 5,
+                             LedPowerLimiter::estimateMa(leds, LED_COUNT, 51));
+}
+
+void test_power_under_budget_untouched() {
+    limiter.configure(160, WHITE_MA);
+    fill_solid(leds, LED_COUNT, CRGB::White);
+    TEST_ASSERT_EQUAL(160, limiter.update(leds, LED_COUNT));
+    TEST_ASSERT_EQUAL_UINT32(0, limiter.getLimitedFrames());
+}
+
+void test_power_over_budget_limited_at_once() {
+    const uint16_t budget = WHITE_MA / 2;
+    limiter.configure(255, budget);
+    fill_solid(leds, LED_COUNT, CRGB::White);
+
+    const uint8_t shown = limiter.update(leds, LED_COUNT);
+    TEST_ASSERT_LESS_THAN(255, shown);
+    TEST_ASSERT_LESS_OR_EQUAL(budget, limiter.getLastMa());
+    TEST_ASSERT_LESS_OR_EQUAL(budget, LedPowerLimiter::estimateMa(leds, LED_COUNT, shown));
+    TEST_ASSERT_GREATER_THAN(budget - 20, LedPowerLimiter::estimateMa(leds, LED_COUNT, shown));
+    TEST_ASSERT_EQUAL_UINT32(WHITE_MA, limiter.getPeakMa());
+}
+
+void test_power_release_is_gradual() {
+    limiter.configure(200, WHITE_MA / 2);
+    fill_solid(leds, LED_COUNT, CRGB::White);
+    const uint8_t limited = limiter.update(leds, LED_COUNT);
+
+    // The flash is over: back up one step per frame
+    fill_solid(leds, LED_COUNT, CRGB(20, 0, 0));
+    uint8_t shown = limited;
+    uint8_t frames = 0;
+    while (shown < 200) {
+        const uint8_t next = limiter.update(leds, LED_COUNT);
+        TEST_ASSERT_LESS_OR_EQUAL(shown + LED_POWER_RELEASE_STEP, next);
+        shown = next;
+        frames++;
+    }
+    TEST_ASSERT_GREATER_THAN((200 - limited) / LED_POWER_RELEASE_STEP - 1, frames);
+    TEST_ASSERT_EQUAL_UINT32(frames, limiter.getLimitedFrames());
+
+    // Brightness changes under the limit apply at once
+    limiter.configure(90, WHITE_MA / 2);
+    TEST_ASSERT_EQUAL(90, limiter.update(leds, LED_COUNT));
+}
+
+void test_power_budget_zero_is_off() {
+    limiter.configure(255, 0);
+    fill_solid(leds, LED_COUNT, CRGB::White);
+    TEST_ASSERT_EQUAL(255, limiter.update(leds, LED_COUNT));
+    TEST_ASSERT_EQUAL_UINT32(WHITE_MA, limiter.getLastMa());
+}
+
+void setUp(void) {
+    limiter = LedPowerLimiter();
+}
+
+void tearDown(void) {
+    // Clean up code if needed
+}
+
+void setup() {
+    delay(2000); // Wait for serial
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_power_channel_sums_match_scalar);
+    RUN_TEST(test_power_estimate_per_channel);
+    RUN_TEST(test_power_under_budget_untouched);
+    RUN_TEST(test_power_over_budget_limited_at_once);
+    RUN_TEST(test_power_release_is_gradual);
+    RUN_TEST(test_power_budget_zero_is_off);
+
+    UNITY_END();
+}
+
+void loop() {
+    // Empty
+}
@@ -0,0 +1,86 @@
+#include <unity.h>
+#include "loop_watchdog.h"
+#include "perf_monitor.h"
+
+void test_watchdog_no_report_without_warning() {
+    LoopWatchdog dog;
+    dog.checkBootReport();  // Consume anything left from an earlier run
+    TEST_ASSERT_FALSE(dog.checkBootReport());
+    TEST_ASSERT_FALSE(dog.hasStallReport());
+}
+
+void test_watchdog_warning_record_survives_to_next_boot() {
+    PerfMonitor monitor;
+    LoopWatchdog dog;
+    dog.setPerfMonitor(&monitor);
+    dog.watchTask(0);
+    dog.watchTask(2);
+
+    // Task 0 completes, task 2 stalls inside the OLED stage
+    dog.enterTask(0);
+    dog.checkIn(0);
+    dog.leaveTask();
+    dog.enterTask(2);
+    monitor.beginStage(PERF_STAGE_OLED);
+    dog.onWarning();
+
+    // "Next boot": a fresh instance reads the no-init record
+    LoopWatchdog nextBoot;
+    TEST_ASSERT_TRUE(nextBoot.checkBootReport());
+    const LoopWatchdog::StallRecord& record = nextBoot.getStallReport();
+    TEST_ASSERT_EQUAL_UINT8(2, record.task);
+    TEST_ASSERT_EQUAL_UINT8(PERF_STAGE_OLED, record.stage);
+    TEST_ASSERT_EQUAL_UINT32(0x5, record.required);
+    TEST_ASSERT_EQUAL_UINT32(0x1, record.checkedIn);
+    TEST_ASSERT_EQUAL_UINT8(3, record.eventCount);
+
+    // Newest event is the stalled task's slice start
+    uint8_t newest = (record.eventHead + LoopWatchdog::STALL_EVENT_COUNT - 1) % LoopWatchdog::STALL_EVENT_COUNT;
+    TEST_ASSERT_EQUAL_UINT8(LoopWatchdog::EVENT_TASK_ENTER, record.events[newest].type);
+    TEST_ASSERT_EQUAL_UINT8(2, record.events[newest].id);
+
+    // The record is consumed on read
+    LoopWatchdog thirdBoot;
+    TEST_ASSERT_FALSE(thirdBoot.checkBootReport());
+}
+
+void test_watchdog_event_ring_wraps() {
+    LoopWatchdog dog;
+    for (uint8_t i = 0; i < LoopWatchdog::STALL_EVENT_COUNT + 5; i++) {
+        dog.enterTask(i);
+    }
+    dog.onWarning();
+
+    LoopWatchdog nextBoot;
+    TEST_ASSERT_TRUE(nextBoot.checkBootReport());
+    const LoopWatchdog::StallRecord& record = nextBoot.getStallReport();
+    TEST_ASSERT_EQUAL_UINT8(LoopWatchdog::STALL_EVENT_COUNT, record.eventCount);
+
+    // Oldest kept event is #5
+    uint8_t oldest = record.eventHead;
+    TEST_ASSERT_EQUAL_UINT8(5, record.events[oldest].id);
+}
+
+void setUp(void) {
+    // Set up code if needed
+}
+
+void tearDown(void) {
+    // Clean up code if needed
+}
+
+void setup() {
+    delay(2000); // Wait for serial
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_watchdog_no_report_without_warning);
+    RUN_TEST(test_watchdog_warning_record_survives_to_next_boot);
+    RUN_TEST(test_watchdog_event_ring_wraps);
+
+    UNITY_END();
+}
+
+void loop() {
+    // Empty
+}
@@ -0,0 +1,183 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <new>
+#include "midi_looper.h"
+
+// At 120 BPM a beat is 500 ms: 96 ticks, 15625/3 us each
+static const float BPM = 120.0f;
+
+static MidiOut midi;
+static MidiLooper looper(midi);
+static uint32_t now;
+
+static void advanceMs(uint32_t ms) {
+    for (uint32_t i = 0; i < ms; i++) {
+        now += 1000;
+        looper.update(now, BPM);
+    }
+}
+
+// Just past the start of the tick that many ticks on, in 1 ms scan steps
+static void advanceTicks(uint32_t ticks) {
+    const uint32_t target = now + (uint32_t)(((uint64_t)ticks * 15625 + 2) / 3);
+    while ((int32_t)(target - now) > 1000) advanceMs(1);
+    now = target;
+    looper.update(now, BPM);
+}
+
+// Record one note at tick on..off of the first pass, closing after beats
+static void recordNote(uint8_t button, uint32_t on, uint32_t off, uint32_t beats) {
+    looper.pressRecord();
+    advanceTicks(on);
+    looper.noteEdge(button, true);
+    advanceTicks(off - on);
+    looper.noteEdge(button, false);
+    advanceTicks(beats * LOOPER_TICKS_PER_BEAT - off);
+    looper.pressRecord();
+}
+
+void test_looper_clock_has_no_drift() {
+    looper.pressRecord();
+    // 1 ms steps: 0.192 ticks each, never rounded away
+    advanceMs(1000);
+    TEST_ASSERT_EQUAL(192, looper.getPosition());
+    advanceMs(9000);
+    TEST_ASSERT_EQUAL(1920, looper.getPosition());
+
+    // 140 BPM: 224 ticks per second
+    for (uint32_t i = 0; i < 1000; i++) looper.update(now += 1000, 140.0f);
+    TEST_ASSERT_EQUAL(2144, looper.getPosition());
+}
+
+void test_looper_length_rounds_to_whole_beats() {
+    looper.pressRecord();
+    advanceTicks(LOOPER_TICKS_PER_BEAT * 3 / 2 - 1);
+    looper.pressRecord();
+    TEST_ASSERT_EQUAL(MidiLooper::LOOPER_PLAYING, looper.getState());
+    TEST_ASSERT_EQUAL(LOOPER_TICKS_PER_BEAT, looper.getLengthTicks());
+    // The clock carries on from the rounded end
+    TEST_ASSERT_EQUAL(LOOPER_TICKS_PER_BEAT / 2 - 1, looper.getPosition());
+
+    looper.clear();
+    looper.pressRecord();
+    advanceTicks(LOOPER_TICKS_PER_BEAT * 3 / 2);
+    looper.pressRecord();
+    TEST_ASSERT_EQUAL(2 * LOOPER_TICKS_PER_BEAT, looper.getLengthTicks());
+
+    // Never shorter than a beat
+    looper.clear();
+    looper.pressRecord();
+    advanceTicks(5);
+    looper.pressRecord();
+    TEST_ASSERT_EQUAL(LOOPER_TICKS_PER_BEAT, looper.getLengthTicks());
+}
+
+void test_looper_plays_quantized_note_each_pass() {
+    // Played at tick 22, snaps to the 16th at 24
+    recordNote(2, 22, 41, 2);
+    TEST_ASSERT_EQUAL(2, looper.getEventCount());
+    TEST_ASSERT_EQUAL(0, looper.getPosition());
+
+    advanceTicks(23);
+    TEST_ASSERT_EQUAL_UINT32(0, looper.getPlayed());
+    advanceTicks(1);
+    TEST_ASSERT_EQUAL_UINT32(1, looper.getPlayed());
+
+    // Once per pass
+    advanceTicks(2 * LOOPER_TICKS_PER_BEAT);
+    TEST_ASSERT_EQUAL_UINT32(2, looper.getPlayed());
+    advanceMs(10000);
+    TEST_ASSERT_EQUAL_UINT32(12, looper.getPlayed());
+    // Played within a scan tick of due
+    TEST_ASSERT_LESS_OR_EQUAL(1000, looper.getMaxLateUs());
+}
+
+void test_looper_overdub_snapped_ahead_plays_next_pass() {
+    recordNote(0, 0, 10, 1);
+    advanceTicks(20);
+    looper.pressRecord();
+    TEST_ASSERT_EQUAL(MidiLooper::LOOPER_OVERDUBBING, looper.getState());
+    const uint32_t played = looper.getPlayed();
+
+    // 46 snaps ahead to 48: heard live, so not again on this pass
+    advanceTicks(26);
+    looper.noteEdge(1, true);
+    looper.noteEdge(1, false);
+    // 74 snaps back to 72: behind the clock, next pass too
+    advanceTicks(28);
+    looper.noteEdge(3, true);
+    looper.noteEdge(3, false);
+    advanceTicks(LOOPER_TICKS_PER_BEAT - 74 - 1);
+    TEST_ASSERT_EQUAL_UINT32(played, looper.getPlayed());
+
+    // Next pass: all three, once each
+    advanceTicks(LOOPER_TICKS_PER_BEAT);
+    TEST_ASSERT_EQUAL_UINT32(played + 3, looper.getPlayed());
+    TEST_ASSERT_EQUAL(6, looper.getEventCount());
+}
+
+void test_looper_drops_notes_when_full() {
+    looper.setQuantize(0);
+    looper.pressRecord();
+    for (uint16_t i = 0; i < LOOPER_MAX_EVENTS / 2; i++) {
+        looper.noteEdge(i % BUTTON_COUNT, true);
+        looper.noteEdge(i % BUTTON_COUNT, false);
+    }
+    TEST_ASSERT_EQUAL(LOOPER_MAX_EVENTS, looper.getEventCount());
+    looper.noteEdge(0, true);
+    looper.noteEdge(0, false);
+    TEST_ASSERT_EQUAL(LOOPER_MAX_EVENTS, looper.getEventCount());
+    TEST_ASSERT_EQUAL_UINT32(1, looper.getDropped());
+}
+
+void test_looper_switch_off_mutes_and_drops_recording() {
+    recordNote(4, 0, 10, 1);
+    looper.setEnabled(false);
+    advanceTicks(4 * LOOPER_TICKS_PER_BEAT);
+    TEST_ASSERT_EQUAL_UINT32(0, looper.getPlayed());
+    TEST_ASSERT_EQUAL(MidiLooper::LOOPER_PLAYING, looper.getState());
+
+    // Back in time on the next pass
+    looper.setEnabled(true);
+    advanceTicks(LOOPER_TICKS_PER_BEAT);
+    TEST_ASSERT_EQUAL_UINT32(1, looper.getPlayed());
+
+    // A first pass in progress is dropped
+    looper.clear();
+    looper.pressRecord();
+    looper.noteEdge(4, true);
+    looper.setEnabled(false);
+    TEST_ASSERT_EQUAL(MidiLooper::LOOPER_EMPTY, looper.getState());
+    TEST_ASSERT_EQUAL(0, looper.getEventCount());
+}
+
+void setUp(void) {
+    // A fresh, armed looper for every test
+    new (&looper) MidiLooper(midi);
+    now = 0;
+    looper.update(now, BPM);
+    looper.setEnabled(true);
+}
+
+void tearDown(void) {
+    // Clean up code if needed
+}
+
+void setup() {
+    delay(2000); // Wait for serial
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_looper_clock_has_no_drift);
+    RUN_TEST(test_looper_length_rounds_to_whole_beats);
+    RUN_TEST(test_looper_plays_quantized_note_each_pass);
+    RUN_TEST(test_looper_overdub_snapped_ahead_plays_next_pass);
+    RUN_TEST(test_looper_drops_notes_when_full);
+    RUN_TEST(test_looper_switch_off_mutes_and_drops_recording);
+
+    UNITY_END();
+}
+
+void loop() {
+    // Empty
+}
@@ -29,13 +29,16 @@ void test_oled_display_mode_switching() {
     display.nextMode();
     TEST_ASSERT_EQUAL(OledDisplay::INFO, display.getMode());
     
+    display.nextMode();
+    TEST_ASSERT_EQUAL(OledDisplay::PERF, display.getMode());
+    
     // Test wrap-around
     display.nextMode();
     TEST_ASSERT_EQUAL(OledDisplay::MIDI_LOG, display.getMode());
     
     // Test previous mode
     display.prevMode();
-    TEST_ASSERT_EQUAL(OledDisplay::INFO, display.getMode());
+    TEST_ASSERT_EQUAL(OledDisplay::PERF, display.getMode());
 }
 
 void test_oled_display_set_mode() {
@@ -0,0 +1,93 @@
+#include <unity.h>
+#include <string.h>
+#include "oled_text.h"
+
+static uint8_t buffer[128 * 64 / 8];
+
+void setUp(void) {
+    memset(buffer, 0, sizeof(buffer));
+}
+
+void tearDown(void) {
+    // Clean up after test
+}
+
+void test_format_uint() {
+    char out[12];
+    TEST_ASSERT_EQUAL_STRING("0", (OledText::formatUInt(out, 0), out));
+    TEST_ASSERT_EQUAL_STRING("127", (OledText::formatUInt(out, 127), out));
+    TEST_ASSERT_EQUAL_STRING("4294967295", (OledText::formatUInt(out, 4294967295u), out));
+}
+
+void test_format_int_negative() {
+    char out[12];
+    char* end = OledText::formatInt(out, -1);
+    TEST_ASSERT_EQUAL_STRING("-1", out);
+    TEST_ASSERT_EQUAL_PTR(out + 2, end);
+}
+
+void test_format_chaining() {
+    char out[32];
+    char* p = OledText::appendString(out, "CC", out + sizeof(out) - 1);
+    p = OledText::formatUInt(p, 20);
+    *p++ = '=';
+    p = OledText::formatHex2(p, 0x7F);
+    TEST_ASSERT_EQUAL_STRING("CC20=7F", out);
+}
+
+void test_append_string_bounded() {
+    char out[4];
+    OledText::appendString(out, "overflow", out + sizeof(out) - 1);
+    TEST_ASSERT_EQUAL_STRING("ove", out);
+}
+
+void test_draw_char_page_aligned() {
+    OledTextRenderer text(buffer, 128, 64);
+    int16_t next = text.drawChar(6, 16, 'A');
+
+    TEST_ASSERT_EQUAL_INT16(12, next);
+    // 'A' on page 2, columns 6-10 copied straight from the font
+    for (int col = 0; col < 5; col++) {
+        TEST_ASSERT_EQUAL_HEX8(OLED_FONT_5X7[('A' - 0x20) * 5 + col], buffer[2 * 128 + 6 + col]);
+    }
+    TEST_ASSERT_EQUAL_HEX8(0x00, buffer[2 * 128 + 11]);  // Spacing column
+}
+
+void test_draw_char_unaligned_splits_pages() {
+    OledTextRenderer text(buffer, 128, 64);
+    text.drawChar(0, 4, '|');  // 0x7F in the middle column
+
+    TEST_ASSERT_EQUAL_HEX8(0xF0, buffer[0 * 128 + 2]);
+    TEST_ASSERT_EQUAL_HEX8(0x07, buffer[1 * 128 + 2]);
+}
+
+void test_draw_string_clips_at_right_edge() {
+    OledTextRenderer text(buffer, 128, 64);
+    text.drawString(120, 0, "ABC");  // 'A' fits, 'B' is cut at x=128, 'C' starts off screen
+
+    TEST_ASSERT_NOT_EQUAL(0, buffer[120]);
+    TEST_ASSERT_NOT_EQUAL(0, buffer[126]);
+    for (int page = 1; page < 8; page++) {
+        TEST_ASSERT_EQUAL_HEX8(0x00, buffer[page * 128]);  // No wrap onto next row
+    }
+}
+
+void test_draw_without_buffer_is_safe() {
+    OledTextRenderer text;
+    TEST_ASSERT_EQUAL_INT16(6, text.drawChar(0, 0, 'X'));
+}
+
+int main() {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_format_uint);
+    RUN_TEST(test_format_int_negative);
+    RUN_TEST(test_format_chaining);
+    RUN_TEST(test_append_string_bounded);
+    RUN_TEST(test_draw_char_page_aligned);
+    RUN_TEST(test_draw_char_unaligned_splits_pages);
+    RUN_TEST(test_draw_string_clips_at_right_edge);
+    RUN_TEST(test_draw_without_buffer_is_safe);
+    
+    return UNITY_END();
+}
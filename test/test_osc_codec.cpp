@@ -0,0 +1,157 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "osc_codec.h"
+
+// Messages seen by the reader, flattened
+struct Collected {
+    char addresses[4][32];
+    int32_t firstInt[4];
+    uint8_t count;
+};
+
+static void collect(const OscMessage& message, void* context) {
+    Collected* collected = static_cast<Collected*>(context);
+    if (collected->count >= 4) return;
+    strncpy(collected->addresses[collected->count], message.address, 31);
+    collected->addresses[collected->count][31] = '\0';
+    int32_t value = -1;
+    message.getInt(0, value);
+    collected->firstInt[collected->count] = value;
+    collected->count++;
+}
+
+static uint8_t packet[128];
+
+void test_osc_message_encoding() {
+    OscWriter writer(packet, sizeof(packet));
+    TEST_ASSERT_TRUE(writer.beginMessage("/ping", ""));
+    TEST_ASSERT_TRUE(writer.endMessage());
+
+    // "/ping\0\0\0" ",\0\0\0"
+    const uint8_t expected[] = {'/', 'p', 'i', 'n', 'g', 0, 0, 0, ',', 0, 0, 0};
+    TEST_ASSERT_EQUAL(sizeof(expected), writer.getLength());
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, packet, sizeof(expected));
+
+    writer.reset();
+    writer.beginMessage("/portal/cmd", "ii");
+    writer.addInt(4);
+    writer.addInt(-2);
+    TEST_ASSERT_TRUE(writer.endMessage());
+    TEST_ASSERT_EQUAL(12 + 4 + 8, writer.getLength());
+    TEST_ASSERT_EQUAL_UINT32(0xFFFFFFFE, OscReader::readWord(packet + 20));
+}
+
+void test_osc_bundle_round_trip() {
+    OscWriter writer(packet, sizeof(packet));
+    writer.beginBundle();
+    writer.beginMessage("/portal/hue", "i");
+    writer.addInt(200);
+    writer.endMessage();
+    writer.beginMessage("/portal/bpm", "f");
+    writer.addFloat(96.7f);
+    writer.endMessage();
+    TEST_ASSERT_EQUAL(2, writer.getMessageCount());
+
+    Collected collected = {};
+    TEST_ASSERT_TRUE(OscReader::parse(packet, writer.getLength(), collect, &collected));
+    TEST_ASSERT_EQUAL(2, collected.count);
+    TEST_ASSERT_EQUAL_STRING("/portal/hue", collected.addresses[0]);
+    TEST_ASSERT_EQUAL_INT32(200, collected.firstInt[0]);
+    TEST_ASSERT_EQUAL_STRING("/portal/bpm", collected.addresses[1]);
+    TEST_ASSERT_EQUAL_INT32(96, collected.firstInt[1]);  // Float read as int
+}
+
+void test_osc_blob_arguments() {
+    const uint8_t frames[10] = {0xAA, 0x10, 0x00, 0x10, 0x55, 0xAA, 0x06, 0x00, 0x06, 0x55};
+    OscWriter writer(packet, sizeof(packet));
+    writer.beginMessage("/portal/frame", "bi");
+    writer.addBlob(frames, sizeof(frames));
+    writer.addInt(7);
+    TEST_ASSERT_TRUE(writer.endMessage());
+
+    struct Blob {
+        const uint8_t* data;
+        uint32_t length;
+        int32_t after;
+    } blob = {nullptr, 0, 0};
+    OscReader::parse(packet, writer.getLength(), [](const OscMessage& message, void* context) {
+        Blob* out = static_cast<Blob*>(context);
+        message.getBlob(0, out->data, out->length);
+        message.getInt(1, out->after);
+    }, &blob);
+    TEST_ASSERT_EQUAL_UINT32(sizeof(frames), blob.length);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(frames, blob.data, sizeof(frames));
+    TEST_ASSERT_EQUAL_INT32(7, blob.after);  // Past the padded blob
+}
+
+void test_osc_full_packet_rolls_back() {
+    uint8_t small[40];
+    OscWriter writer(small, sizeof(small));
+    writer.beginBundle();
+    writer.beginMessage("/a", "i");
+    writer.addInt(1);
+    TEST_ASSERT_TRUE(writer.endMessage());
+    const size_t length = writer.getLength();
+
+    writer.beginMessage("/this/does/not/fit", "iii");
+    writer.addInt(1);
+    writer.addInt(2);
+    writer.addInt(3);
+    TEST_ASSERT_FALSE(writer.endMessage());
+    TEST_ASSERT_EQUAL(length, writer.getLength());
+    TEST_ASSERT_EQUAL(1, writer.getMessageCount());
+
+    Collected collected = {};
+    TEST_ASSERT_TRUE(OscReader::parse(small, writer.getLength(), collect, &collected));
+    TEST_ASSERT_EQUAL(1, collected.count);
+}
+
+void test_osc_rejects_malformed_packets() {
+    Collected collected = {};
+    const uint8_t noSlash[] = {'p', 'i', 'n', 'g', 0, 0, 0, 0, ',', 0, 0, 0};
+    TEST_ASSERT_FALSE(OscReader::parse(noSlash, sizeof(noSlash), collect, &collected));
+
+    const uint8_t unterminated[] = {'/', 'p', 'i', 'n', 'g', 'x', 'y', 'z'};
+    TEST_ASSERT_FALSE(OscReader::parse(unterminated, sizeof(unterminated), collect, &collected));
+
+    // Bundle element size runs past the packet
+    uint8_t bundle[24] = {'#', 'b', 'u', 'n', 'd', 'l', 'e', 0};
+    bundle[19] = 200;
+    TEST_ASSERT_FALSE(OscReader::parse(bundle, sizeof(bundle), collect, &collected));
+    TEST_ASSERT_EQUAL(0, collected.count);
+
+    // Missing argument data
+    OscWriter writer(packet, sizeof(packet));
+    writer.beginMessage("/portal/hue", "i");
+    writer.addInt(5);
+    writer.endMessage();
+    OscReader::parse(packet, writer.getLength() - 4, collect, &collected);
+    TEST_ASSERT_EQUAL(1, collected.count);
+    TEST_ASSERT_EQUAL_INT32(-1, collected.firstInt[0]);
+}
+
+void setUp(void) {
+    memset(packet, 0xEE, sizeof(packet));
+}
+
+void tearDown(void) {
+    // Clean up code if needed
+}
+
+void setup() {
+    delay(2000); // Wait for serial
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_osc_message_encoding);
+    RUN_TEST(test_osc_bundle_round_trip);
+    RUN_TEST(test_osc_blob_arguments);
+    RUN_TEST(test_osc_full_packet_rolls_back);
+    RUN_TEST(test_osc_rejects_malformed_packets);
+
+    UNITY_END();
+}
+
+void loop() {
+    // Empty
+}
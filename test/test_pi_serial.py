@@ -20,11 +20,28 @@ class PortalSerialCommand(IntEnum):
     TRIGGER_RIPPLE = 0x07
     PING = 0x10
     RESET = 0x11
+    PROFILE_DUMP = 0x12
+    PROFILE_RESET = 0x13
+    STALL_REPORT = 0x14
+    FLIGHT_DUMP = 0x15
+    CONFIG_SELECT = 0x16
+    CONFIG_SET = 0x17
+    CONFIG_GET = 0x18
+    CONFIG_SAVE = 0x19
+    CONFIG_DEFAULTS = 0x1A
+    TRACE_CAPTURE = 0x1B
+    TRACE_DUMP = 0x1C
+    TRACE_REPLAY = 0x1D
+    LOG_LEVEL = 0x1E
+    LOG_CATEGORIES = 0x1F
     # Response commands
     PONG = 0x20
     ACK = 0x21
     NAK = 0x22
     STATUS = 0x23
+    CONFIG_VALUE = 0x24
+    # Continued past the response range
+    LOG_DUMP = 0x30
 
 PORTAL_MSG_START_BYTE = 0xAA
 PORTAL_MSG_END_BYTE = 0x55
@@ -0,0 +1,174 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "rule_engine.h"
+
+static CRGB leds[LED_COUNT];
+static PortalController portal;
+static MidiOut midi;
+static ConfigStore config;
+static RuleEngine engine;
+
+static Rule rule(uint8_t source, uint8_t index, uint8_t trigger, uint8_t action, uint16_t value = 0) {
+    return {source, index, trigger, RULE_OPERAND_CONST, RULE_IF_ALWAYS, 0, action, 0, value};
+}
+
+static RuleEvent press(uint8_t source, uint8_t index) {
+    return {source, index, 127, true};
+}
+
+void test_rules_default_table() {
+    TEST_ASSERT_EQUAL(RuleEngine::DEFAULT_RULE_COUNT, engine.getRuleCount());
+
+    // Button: flash and hue
+    TEST_ASSERT_EQUAL(2, engine.handleEvent(press(RULE_SRC_BUTTON, 4)));
+    TEST_ASSERT_EQUAL(0, engine.handleEvent({RULE_SRC_BUTTON, 4, 0, false}));
+
+    // Switch 0 on: next program; off does nothing
+    const uint8_t program = portal.getCurrentProgram();
+    TEST_ASSERT_EQUAL(1, engine.handleEvent(press(RULE_SRC_SWITCH, 0)));
+    TEST_ASSERT_EQUAL((program + 1) % PORTAL_PROGRAM_COUNT, portal.getCurrentProgram());
+    TEST_ASSERT_EQUAL(0, engine.handleEvent({RULE_SRC_SWITCH, 0, 0, false}));
+    TEST_ASSERT_EQUAL(0, engine.handleEvent(press(RULE_SRC_SWITCH, 1)));
+}
+
+void test_rules_input_group_before_any_and_stop() {
+    Rule table[] = {
+        rule(RULE_SRC_BUTTON, RULE_ANY_INDEX, RULE_ON_PRESS, RULE_DO_PROGRAM, 1),
+        rule(RULE_SRC_BUTTON, 2, RULE_ON_PRESS, RULE_DO_PROGRAM, 2),
+        rule(RULE_SRC_BUTTON, 3, RULE_ON_PRESS, RULE_DO_PROGRAM, 3),
+    };
+    table[2].flags |= RULE_STOP;
+    TEST_ASSERT_TRUE(engine.load(table, 3));
+
+    // Button 2's rule, then the "any" rule overrides it
+    TEST_ASSERT_EQUAL(2, engine.handleEvent(press(RULE_SRC_BUTTON, 2)));
+    TEST_ASSERT_EQUAL(1, portal.getCurrentProgram());
+
+    // Button 3 stops before the "any" rule
+    TEST_ASSERT_EQUAL(1, engine.handleEvent(press(RULE_SRC_BUTTON, 3)));
+    TEST_ASSERT_EQUAL(3, portal.getCurrentProgram());
+    TEST_ASSERT_EQUAL(2, engine.getMaxExamined());
+}
+
+void test_rules_conditions_and_operands() {
+    Rule table[] = {
+        rule(RULE_SRC_POT, 1, RULE_ON_CHANGE, RULE_DO_CONFIG),
+        rule(RULE_SRC_POT, 2, RULE_ON_CHANGE, RULE_DO_PROGRAM, 5),
+    };
+    // Pot 1 above 64 sets the LED brightness cap from the pot
+    table[0].flags = RULE_OPERAND_EVENT;
+    table[0].value = 256;
+    table[0].target = CONFIG_LED_BRIGHTNESS_MAX;
+    table[0].condition = RULE_IF_VALUE_ABOVE;
+    table[0].conditionArg = 64;
+    // Pot 2 only in program 4
+    table[1].condition = RULE_IF_PROGRAM;
+    table[1].conditionArg = 4;
+    TEST_ASSERT_TRUE(engine.load(table, 2));
+
+    TEST_ASSERT_EQUAL(0, engine.handleEvent({RULE_SRC_POT, 1, 63, true}));
+    TEST_ASSERT_EQUAL(1, engine.handleEvent({RULE_SRC_POT, 1, 100, true}));
+    TEST_ASSERT_EQUAL_UINT32(ConfigStore::fromWire(CONFIG_LED_BRIGHTNESS_MAX, 201),
+                             config.getValue(CONFIG_LED_BRIGHTNESS_MAX));
+
+    portal.setProgram(3);
+    TEST_ASSERT_EQUAL(0, engine.handleEvent({RULE_SRC_POT, 2, 10, true}));
+    portal.setProgram(4);
+    TEST_ASSERT_EQUAL(1, engine.handleEvent({RULE_SRC_POT, 2, 10, true}));
+    TEST_ASSERT_EQUAL(5, portal.getCurrentProgram());
+}
+
+void test_rules_actions_capped_per_event() {
+    Rule table[RULES_MAX_ACTIONS_PER_EVENT + 2];
+    for (uint8_t i = 0; i < RULES_MAX_ACTIONS_PER_EVENT + 2; i++) {
+        table[i] = rule(RULE_SRC_JOYSTICK, 1, RULE_ON_PRESS, RULE_DO_CC, i);
+        table[i].target = 70 + i;
+    }
+    TEST_ASSERT_TRUE(engine.load(table, RULES_MAX_ACTIONS_PER_EVENT + 2));
+    TEST_ASSERT_EQUAL(RULES_MAX_ACTIONS_PER_EVENT, engine.handleEvent(press(RULE_SRC_JOYSTICK, 1)));
+    TEST_ASSERT_EQUAL_UINT32(2, engine.getCapped());
+}
+
+void test_rules_invalid_table_keeps_old_one() {
+    // Unknown action
+    Rule bad = rule(RULE_SRC_BUTTON, 0, RULE_ON_PRESS, 0x7E);
+    TEST_ASSERT_FALSE(engine.load(&bad, 1));
+
+    // One input over RULES_MAX_PER_INPUT
+    static Rule crowded[RULES_MAX_PER_INPUT + 1];
+    for (uint8_t i = 0; i <= RULES_MAX_PER_INPUT; i++) {
+        crowded[i] = rule(RULE_SRC_SWITCH, 5, RULE_ON_CHANGE, RULE_DO_FLASH);
+    }
+    TEST_ASSERT_FALSE(engine.load(crowded, RULES_MAX_PER_INPUT + 1));
+    TEST_ASSERT_TRUE(engine.load(crowded, RULES_MAX_PER_INPUT));
+
+    // Too many rules (refused before the table is read)
+    TEST_ASSERT_FALSE(engine.load(crowded, RULES_MAX + 1));
+    TEST_ASSERT_EQUAL(RULES_MAX_PER_INPUT, engine.getRuleCount());
+}
+
+void test_rules_sysex_upload() {
+    Rule sent = rule(RULE_SRC_SWITCH, 3, RULE_ON_RELEASE, RULE_DO_BPM, 300);
+    sent.flags = RULE_OPERAND_INDEX | RULE_STOP;
+    uint8_t message[5 + RuleEngine::RULE_WIRE_SIZE] = {0xF0, 0x7D, 0x4D, RuleEngine::SYSEX_RULES_ADD};
+    RuleEngine::encodeRule(sent, message + 4);
+    message[sizeof(message) - 1] = 0xF7;
+
+    Rule received;
+    TEST_ASSERT_TRUE(RuleEngine::decodeRule(message + 4, received));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(&sent, &received, sizeof(Rule));
+
+    const uint8_t begin[] = {0xF0, 0x7D, 0x4D, RuleEngine::SYSEX_RULES_BEGIN, 0xF7};
+    const uint8_t commit[] = {0xF0, 0x7D, 0x4D, RuleEngine::SYSEX_RULES_COMMIT, 0xF7};
+    const uint8_t save[] = {0xF0, 0x7D, 0x4D, ConfigStore::SYSEX_SAVE, 0xF7};
+    uint8_t reply[RuleEngine::SYSEX_REPLY_SIZE];
+
+    // Adding before BEGIN is refused; ConfigStore messages are not ours
+    TEST_ASSERT_EQUAL(5, engine.handleSysEx(message, sizeof(message), reply));
+    TEST_ASSERT_EQUAL_HEX8(ConfigStore::SYSEX_ERROR, reply[3]);
+    TEST_ASSERT_EQUAL(0, engine.handleSysEx(save, sizeof(save), reply));
+
+    TEST_ASSERT_EQUAL(7, engine.handleSysEx(begin, sizeof(begin), reply));
+    TEST_ASSERT_EQUAL(7, engine.handleSysEx(message, sizeof(message), reply));
+    TEST_ASSERT_EQUAL(1, reply[5]);
+    TEST_ASSERT_EQUAL(RuleEngine::DEFAULT_RULE_COUNT, engine.getRuleCount());
+    TEST_ASSERT_EQUAL(7, engine.handleSysEx(commit, sizeof(commit), reply));
+    TEST_ASSERT_EQUAL_HEX8(ConfigStore::SYSEX_OK, reply[3]);
+    TEST_ASSERT_EQUAL(1, engine.getRuleCount());
+
+    // Switch 3 off: BPM from index x 300 (clamped to 255 = 180 BPM)
+    TEST_ASSERT_EQUAL(1, engine.handleEvent({RULE_SRC_SWITCH, 3, 0, false}));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 180.0f, portal.getBpm());
+}
+
+void setUp(void) {
+    portal.setProgram(0);
+    portal.setBpm(120);
+    engine = RuleEngine();
+    engine.begin(&portal, &midi, &config);
+}
+
+void tearDown(void) {
+    // Clean up code if needed
+}
+
+void setup() {
+    delay(2000); // Wait for serial
+
+    portal.begin(leds);
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_rules_default_table);
+    RUN_TEST(test_rules_input_group_before_any_and_stop);
+    RUN_TEST(test_rules_conditions_and_operands);
+    RUN_TEST(test_rules_actions_capped_per_event);
+    RUN_TEST(test_rules_invalid_table_keeps_old_one);
+    RUN_TEST(test_rules_sysex_upload);
+
+    UNITY_END();
+}
+
+void loop() {
+    // Empty
+}
@@ -0,0 +1,162 @@
+#include <unity.h>
+#include <new>
+#include "serial_mux.h"
+
+// USB stand-in with a settable amount of free transmit buffer
+class CaptureLink : public Print {
+public:
+    uint8_t data[4096];
+    size_t length = 0;
+    int room = 4096;
+
+    size_t write(uint8_t b) override {
+        if (length < sizeof(data)) data[length++] = b;
+        return 1;
+    }
+    using Print::write;
+    int availableForWrite() override { return room; }
+};
+
+struct Frame {
+    uint8_t channel;
+    uint8_t length;
+    const uint8_t* payload;
+};
+
+// Decode the frame at offset; false on a bad start byte or CRC
+static bool readFrame(const CaptureLink& capture, size_t& offset, Frame& frame) {
+    if (offset + SerialMux::FRAME_OVERHEAD > capture.length) return false;
+    const uint8_t* p = capture.data + offset;
+    if (p[0] != SerialMux::START_BYTE) return false;
+    frame.channel = p[1];
+    frame.length = p[2];
+    frame.payload = p + 3;
+    if (SerialMux::crc8(p + 1, frame.length + 2) != p[3 + frame.length]) return false;
+    offset += frame.length + SerialMux::FRAME_OVERHEAD;
+    return true;
+}
+
+static CaptureLink testLink;
+static SerialMux* mux;
+
+void test_mux_frames_channel_output() {
+    mux->channel(MUX_LOG).print("hello");
+    TEST_ASSERT_FALSE(mux->pump());
+
+    size_t offset = 0;
+    Frame frame;
+    TEST_ASSERT_TRUE(readFrame(testLink, offset, frame));
+    TEST_ASSERT_EQUAL_UINT8(MUX_LOG, frame.channel);
+    TEST_ASSERT_EQUAL_UINT8(5, frame.length);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY("hello", frame.payload, 5);
+    TEST_ASSERT_EQUAL(testLink.length, offset);
+}
+
+void test_mux_sends_highest_priority_first() {
+    uint8_t bulk[100];
+    memset(bulk, 0x5A, sizeof(bulk));
+    mux->channel(MUX_BULK).write(bulk, sizeof(bulk));
+    mux->channel(MUX_LOG).print("log");
+    mux->channel(MUX_TELEMETRY).print("beat");
+    mux->pump();
+
+    const uint8_t expected[] = {MUX_TELEMETRY, MUX_LOG, MUX_BULK, MUX_BULK};
+    size_t offset = 0;
+    Frame frame;
+    for (uint8_t i = 0; i < sizeof(expected); i++) {
+        TEST_ASSERT_TRUE(readFrame(testLink, offset, frame));
+        TEST_ASSERT_EQUAL_UINT8(expected[i], frame.channel);
+    }
+    TEST_ASSERT_EQUAL_UINT8(100 - SERIAL_MUX_MAX_PAYLOAD, frame.length);
+}
+
+void test_mux_control_flush_jumps_the_queue() {
+    mux->channel(MUX_LOG).print("debug text");
+    uint8_t ack[PORTAL_MSG_MIN_SIZE] = {0xAA, 0x21, 0x00, 0x21, 0x55};
+    mux->channel(MUX_CONTROL).write(ack, sizeof(ack));
+    mux->channel(MUX_CONTROL).flush();
+
+    // Only the control frame has gone out; the log text waits for the pump
+    size_t offset = 0;
+    Frame frame;
+    TEST_ASSERT_TRUE(readFrame(testLink, offset, frame));
+    TEST_ASSERT_EQUAL_UINT8(MUX_CONTROL, frame.channel);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(ack, frame.payload, sizeof(ack));
+    TEST_ASSERT_EQUAL(testLink.length, offset);
+    TEST_ASSERT_EQUAL_UINT32(10, mux->channel(MUX_LOG).getQueued());
+}
+
+void test_mux_drops_low_priority_under_pressure() {
+    // Link is stalled: nothing drains, telemetry fills and then drops
+    testLink.room = 0;
+    char line[100];
+    memset(line, 'x', sizeof(line));
+    size_t accepted = 0;
+    for (uint8_t i = 0; i < 20; i++) {
+        accepted += mux->channel(MUX_TELEMETRY).write((const uint8_t*)line, sizeof(line));
+    }
+    TEST_ASSERT_EQUAL(SERIAL_MUX_TELEMETRY_QUEUE / 100 * 100, accepted);
+    TEST_ASSERT_EQUAL_UINT32(2000 - accepted, mux->channel(MUX_TELEMETRY).getDropped());
+    TEST_ASSERT_TRUE(mux->pump());
+    TEST_ASSERT_EQUAL(0, testLink.length);
+
+    // The next frame on the channel carries the dropped flag, later ones don't
+    testLink.room = 4096;
+    while (mux->pump()) {}
+    size_t offset = 0;
+    Frame frame;
+    TEST_ASSERT_TRUE(readFrame(testLink, offset, frame));
+    TEST_ASSERT_EQUAL_UINT8(MUX_TELEMETRY | SerialMux::FLAG_DROPPED, frame.channel);
+    TEST_ASSERT_TRUE(readFrame(testLink, offset, frame));
+    TEST_ASSERT_EQUAL_UINT8(MUX_TELEMETRY, frame.channel);
+}
+
+void test_mux_bulk_blocks_instead_of_dropping() {
+    testLink.room = 0;
+    static uint8_t dump[SERIAL_MUX_BULK_QUEUE + 256];
+    for (size_t i = 0; i < sizeof(dump); i++) dump[i] = i;
+    TEST_ASSERT_EQUAL(sizeof(dump), mux->channel(MUX_BULK).write(dump, sizeof(dump)));
+    TEST_ASSERT_EQUAL_UINT32(0, mux->channel(MUX_BULK).getDropped());
+
+    // Reassemble the channel stream from what was sent plus the rest
+    testLink.room = 4096;
+    while (mux->pump()) {}
+    size_t offset = 0;
+    size_t received = 0;
+    Frame frame;
+    while (readFrame(testLink, offset, frame)) {
+        TEST_ASSERT_EQUAL_UINT8(MUX_BULK, frame.channel);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(dump + received, frame.payload, frame.length);
+        received += frame.length;
+    }
+    TEST_ASSERT_EQUAL(sizeof(dump), received);
+}
+
+void setUp(void) {
+    alignas(SerialMux) static uint8_t storage[sizeof(SerialMux)];
+    testLink.length = 0;
+    testLink.room = 4096;
+    mux = new (storage) SerialMux(testLink);
+}
+
+void tearDown(void) {
+    // Clean up code if needed
+}
+
+void setup() {
+    delay(2000); // Wait for serial
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_mux_frames_channel_output);
+    RUN_TEST(test_mux_sends_highest_priority_first);
+    RUN_TEST(test_mux_control_flush_jumps_the_queue);
+    RUN_TEST(test_mux_drops_low_priority_under_pressure);
+    RUN_TEST(test_mux_bulk_blocks_instead_of_dropping);
+
+    UNITY_END();
+}
+
+void loop() {
+    // Empty
+}
@@ -0,0 +1,79 @@
+#include <unity.h>
+#include "stage_profiler.h"
+
+void test_profiler_initial_state() {
+    StageProfiler profiler;
+    for (uint8_t i = 0; i < PERF_STAGE_COUNT; i++) {
+        TEST_ASSERT_EQUAL_UINT32(0, profiler.getProfile(i).histogram.count);
+        TEST_ASSERT_EQUAL_UINT32(0, profiler.getProfile(i).totalCycles);
+    }
+}
+
+void test_profiler_record_min_max_total() {
+    StageProfiler profiler;
+    profiler.record(PERF_STAGE_SCAN, 300);
+    profiler.record(PERF_STAGE_SCAN, 100);
+    profiler.record(PERF_STAGE_SCAN, 2000);
+
+    const StageProfiler::StageProfile& scan = profiler.getProfile(PERF_STAGE_SCAN);
+    TEST_ASSERT_EQUAL_UINT32(3, scan.histogram.count);
+    TEST_ASSERT_EQUAL_UINT32(100, scan.minCycles);
+    TEST_ASSERT_EQUAL_UINT32(2000, scan.histogram.maxValue);
+    TEST_ASSERT_EQUAL_UINT32(2400, scan.totalCycles);
+
+    // 100 -> bin 7 [64,128), 300 -> bin 9 [256,512), 2000 -> bin 11 [1024,2048)
+    TEST_ASSERT_EQUAL_UINT32(1, scan.histogram.bins[7]);
+    TEST_ASSERT_EQUAL_UINT32(1, scan.histogram.bins[9]);
+    TEST_ASSERT_EQUAL_UINT32(1, scan.histogram.bins[11]);
+
+    // Other stages untouched
+    TEST_ASSERT_EQUAL_UINT32(0, profiler.getProfile(PERF_STAGE_OLED).histogram.count);
+}
+
+void test_profiler_reset() {
+    StageProfiler profiler;
+    profiler.record(PERF_STAGE_PORTAL, 5000);
+    profiler.reset();
+
+    const StageProfiler::StageProfile& portal = profiler.getProfile(PERF_STAGE_PORTAL);
+    TEST_ASSERT_EQUAL_UINT32(0, portal.histogram.count);
+    TEST_ASSERT_EQUAL_UINT32(0, portal.histogram.maxValue);
+    TEST_ASSERT_EQUAL_UINT32(0xFFFFFFFF, portal.minCycles);
+}
+
+void test_profile_scope_records_on_exit() {
+    StageProfiler profiler;
+    profiler.begin();
+    {
+        ProfileScope scope(profiler, PERF_STAGE_MAPPER);
+        delayMicroseconds(50);
+    }
+    const StageProfiler::StageProfile& mapper = profiler.getProfile(PERF_STAGE_MAPPER);
+    TEST_ASSERT_EQUAL_UINT32(1, mapper.histogram.count);
+    TEST_ASSERT_GREATER_THAN(0, mapper.totalCycles);
+}
+
+void setUp(void) {
+    // Set up code if needed
+}
+
+void tearDown(void) {
+    // Clean up code if needed
+}
+
+void setup() {
+    delay(2000); // Wait for serial
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_profiler_initial_state);
+    RUN_TEST(test_profiler_record_min_max_total);
+    RUN_TEST(test_profiler_reset);
+    RUN_TEST(test_profile_scope_records_on_exit);
+
+    UNITY_END();
+}
+
+void loop() {
+    // Empty
+}
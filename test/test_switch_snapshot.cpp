@@ -0,0 +1,168 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <new>
+#include "robust_midi_mapper.h"
+#include "input_trace.h"
+
+static InputProcessor processor;
+static MidiOut midi;
+static RobustMidiMapper mapper(processor, midi);
+static RawInputFrame frame;
+
+// One 1 ms scan tick per ms, as the scan task runs them
+static void runMs(uint32_t ms) {
+    for (uint32_t i = 0; i < ms; i++) {
+        delay(1);
+        processor.update(frame);
+        mapper.processInputs();
+    }
+}
+
+static void flip(uint8_t sw) {
+    frame.switches ^= 1 << sw;
+}
+
+// Past debouncing and the settle window
+static void settle() {
+    runMs(SWITCH_DEBOUNCE_MS + SWITCH_SNAPSHOT_SETTLE_MS + 5);
+}
+
+void test_snapshot_sent_once_mode_is_on() {
+    settle();
+    TEST_ASSERT_EQUAL_UINT32(0, mapper.getSnapshotsSent());
+
+    mapper.setSwitchSnapshotMode(RobustMidiMapper::SWITCH_SNAPSHOT_SYSEX);
+    runMs(SWITCH_SNAPSHOT_SETTLE_MS - 1);
+    TEST_ASSERT_EQUAL_UINT32(0, mapper.getSnapshotsSent());
+    runMs(2);
+    TEST_ASSERT_EQUAL_UINT32(1, mapper.getSnapshotsSent());
+    TEST_ASSERT_EQUAL_UINT32(0, mapper.getSnapshotChanges());
+}
+
+void test_snapshot_collapses_burst() {
+    mapper.setSwitchSnapshotMode(RobustMidiMapper::SWITCH_SNAPSHOT_NRPN);
+    settle();
+
+    // Four switches over 6 ms: one snapshot carrying all four
+    for (uint8_t sw = 1; sw <= 4; sw++) {
+        flip(sw);
+        runMs(2);
+    }
+    settle();
+    TEST_ASSERT_EQUAL_UINT32(2, mapper.getSnapshotsSent());
+    TEST_ASSERT_EQUAL_UINT32(4, mapper.getSnapshotChanges());
+}
+
+void test_snapshot_slow_sweep_bounded() {
+    mapper.setSwitchSnapshotMode(RobustMidiMapper::SWITCH_SNAPSHOT_SYSEX);
+    settle();
+
+    // A switch every 5 ms never lets the bank settle; the hold limit sends anyway
+    const uint32_t start = mapper.getSnapshotsSent();
+    for (uint8_t sw = 0; sw < SWITCH_COUNT; sw++) {
+        flip(sw);
+        runMs(5);
+    }
+    TEST_ASSERT_GREATER_THAN(start, mapper.getSnapshotsSent());
+    settle();
+    TEST_ASSERT_EQUAL_UINT32(start + 2, mapper.getSnapshotsSent());
+    TEST_ASSERT_EQUAL_UINT32(SWITCH_COUNT, mapper.getSnapshotChanges());
+}
+
+void test_snapshot_skips_flip_and_back() {
+    mapper.setSwitchSnapshotMode(RobustMidiMapper::SWITCH_SNAPSHOT_SYSEX);
+    settle();
+    const uint32_t sent = mapper.getSnapshotsSent();
+
+    flip(5);
+    runMs(SWITCH_DEBOUNCE_MS + 2);
+    flip(5);
+    settle();
+    TEST_ASSERT_EQUAL_UINT32(sent, mapper.getSnapshotsSent());
+}
+
+void test_snapshot_direct_events() {
+    // The path a cluster primary plays merged events through
+    mapper.setSwitchSnapshotMode(RobustMidiMapper::SWITCH_SNAPSHOT_SYSEX);
+    mapper.flushSwitchBanks(millis() + SWITCH_SNAPSHOT_SETTLE_MS);
+    const uint32_t sent = mapper.getSnapshotsSent();
+
+    mapper.sendSwitch(3, true, MIDI_CHANNEL);
+    mapper.sendSwitch(9, true, MIDI_CHANNEL);
+    mapper.flushSwitchBanks(millis() + SWITCH_SNAPSHOT_SETTLE_MS - 1);
+    TEST_ASSERT_EQUAL_UINT32(sent, mapper.getSnapshotsSent());
+    mapper.flushSwitchBanks(millis() + SWITCH_SNAPSHOT_SETTLE_MS);
+    TEST_ASSERT_EQUAL_UINT32(sent + 1, mapper.getSnapshotsSent());
+    TEST_ASSERT_EQUAL_UINT32(2, mapper.getSnapshotChanges());
+
+    // A channel past the ones this build plays is ignored
+    mapper.sendSwitch(1, true, MIDI_CHANNEL + CLUSTER_MAX_NODES);
+    mapper.flushSwitchBanks(millis() + SWITCH_SNAPSHOT_MAX_HOLD_MS);
+    TEST_ASSERT_EQUAL_UINT32(sent + 1, mapper.getSnapshotsSent());
+}
+
+void test_snapshot_pending_burst_sent_when_turned_off() {
+    mapper.setSwitchSnapshotMode(RobustMidiMapper::SWITCH_SNAPSHOT_NRPN);
+    settle();
+    const uint32_t sent = mapper.getSnapshotsSent();
+    const uint32_t changes = mapper.getSnapshotChanges();
+
+    // Debounced but not settled: the burst goes out as the mode ends
+    flip(4);
+    flip(10);
+    runMs(SWITCH_DEBOUNCE_MS + 2);
+    TEST_ASSERT_EQUAL_UINT32(sent, mapper.getSnapshotsSent());
+    mapper.setSwitchSnapshotMode(RobustMidiMapper::SWITCH_SNAPSHOT_OFF);
+    TEST_ASSERT_EQUAL_UINT32(sent + 1, mapper.getSnapshotsSent());
+    TEST_ASSERT_EQUAL_UINT32(changes + 2, mapper.getSnapshotChanges());
+
+    // Later changes are per-switch CCs again
+    flip(4);
+    settle();
+    TEST_ASSERT_EQUAL_UINT32(sent + 1, mapper.getSnapshotsSent());
+}
+
+void test_snapshot_off_sends_none() {
+    flip(2);
+    flip(7);
+    settle();
+    TEST_ASSERT_EQUAL_UINT32(0, mapper.getSnapshotsSent());
+
+    // Unknown modes are ignored
+    mapper.setSwitchSnapshotMode(3);
+    TEST_ASSERT_EQUAL(RobustMidiMapper::SWITCH_SNAPSHOT_OFF, mapper.getSwitchSnapshotMode());
+}
+
+void setUp(void) {
+    // All switches off, per-switch CCs
+    memset(&frame, 0, sizeof(frame));
+    processor.restart(frame);
+    new (&mapper) RobustMidiMapper(processor, midi);
+    mapper.setSwitchSnapshotMode(RobustMidiMapper::SWITCH_SNAPSHOT_OFF);
+}
+
+void tearDown(void) {
+    // Clean up code if needed
+}
+
+void setup() {
+    delay(2000); // Wait for serial
+
+    processor.begin();
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_snapshot_sent_once_mode_is_on);
+    RUN_TEST(test_snapshot_collapses_burst);
+    RUN_TEST(test_snapshot_slow_sweep_bounded);
+    RUN_TEST(test_snapshot_skips_flip_and_back);
+    RUN_TEST(test_snapshot_direct_events);
+    RUN_TEST(test_snapshot_pending_burst_sent_when_turned_off);
+    RUN_TEST(test_snapshot_off_sends_none);
+
+    UNITY_END();
+}
+
+void loop() {
+    // Empty
+}
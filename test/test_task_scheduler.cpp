@@ -0,0 +1,175 @@
+#include <unity.h>
+#include "task_scheduler.h"
+
+// Call log shared by the test tasks
+static char callLog[16];
+static uint8_t callCount = 0;
+static uint8_t slicesLeft = 0;
+
+static void logCall(char id) {
+    if (callCount < sizeof(callLog) - 1) {
+        callLog[callCount++] = id;
+        callLog[callCount] = '\0';
+    }
+}
+
+static bool taskA() { logCall('A'); return false; }
+static bool taskB() { logCall('B'); return false; }
+
+static bool slicedTask() {
+    logCall('S');
+    if (slicesLeft > 0) {
+        slicesLeft--;
+        return true;
+    }
+    return false;
+}
+
+static bool slowCritical() {
+    logCall('C');
+    delayMicroseconds(200);
+    return false;
+}
+
+static bool slowBackground() {
+    logCall('L');
+    delayMicroseconds(1500);
+    return true;  // Never finishes, keeps asking for slices
+}
+
+void test_scheduler_add_task_limits() {
+    TaskScheduler scheduler;
+    for (uint8_t i = 0; i < TaskScheduler::MAX_TASKS; i++) {
+        TEST_ASSERT_EQUAL(i, scheduler.addTask("t", taskA, 1000, TASK_PRIORITY_LOW));
+    }
+    TEST_ASSERT_EQUAL(TaskScheduler::INVALID_TASK, scheduler.addTask("t", taskA, 1000, TASK_PRIORITY_LOW));
+    TEST_ASSERT_EQUAL(TaskScheduler::MAX_TASKS, scheduler.getTaskCount());
+
+    TaskScheduler other;
+    TEST_ASSERT_EQUAL(TaskScheduler::INVALID_TASK, other.addTask("t", nullptr, 1000, TASK_PRIORITY_LOW));
+    TEST_ASSERT_EQUAL(TaskScheduler::INVALID_TASK, other.addTask("t", taskA, 0, TASK_PRIORITY_LOW));
+}
+
+void test_scheduler_priority_order() {
+    TaskScheduler scheduler;
+    scheduler.addTask("low", taskA, 100000, TASK_PRIORITY_LOW);
+    scheduler.addTask("crit", taskB, 100000, TASK_PRIORITY_CRITICAL);
+    scheduler.begin();
+
+    // Both released at once: critical first, then low, then nothing
+    TEST_ASSERT_TRUE(scheduler.run());
+    TEST_ASSERT_TRUE(scheduler.run());
+    TEST_ASSERT_FALSE(scheduler.run());
+    TEST_ASSERT_EQUAL_STRING("BA", callLog);
+}
+
+void test_scheduler_sliced_job() {
+    TaskScheduler scheduler;
+    uint8_t id = scheduler.addTask("sliced", slicedTask, 100000, TASK_PRIORITY_NORMAL);
+    scheduler.begin();
+    slicesLeft = 2;
+
+    // One job, three slices, one per run()
+    TEST_ASSERT_TRUE(scheduler.run());
+    TEST_ASSERT_TRUE(scheduler.run());
+    TEST_ASSERT_TRUE(scheduler.run());
+    TEST_ASSERT_FALSE(scheduler.run());
+
+    TEST_ASSERT_EQUAL_STRING("SSS", callLog);
+    TEST_ASSERT_EQUAL(1, scheduler.getStats(id).jobs);
+    TEST_ASSERT_EQUAL(3, scheduler.getStats(id).slices);
+    TEST_ASSERT_EQUAL(0, scheduler.getStats(id).overruns);
+}
+
+void test_scheduler_skips_missed_releases() {
+    TaskScheduler scheduler;
+    uint8_t id = scheduler.addTask("fast", taskA, 1000, TASK_PRIORITY_CRITICAL);
+    scheduler.begin();
+    scheduler.run();
+
+    // Stall for several periods: backlog is dropped, not replayed
+    delay(5);
+    TEST_ASSERT_TRUE(scheduler.run());
+    TEST_ASSERT_FALSE(scheduler.run());
+    TEST_ASSERT_EQUAL_STRING("AA", callLog);
+    TEST_ASSERT_GREATER_OR_EQUAL(3, scheduler.getStats(id).missedReleases);
+}
+
+void test_scheduler_admission_defers_long_slice() {
+    TaskScheduler scheduler;
+    // Critical: every 2 ms, must start within 500 us of release
+    uint8_t crit = scheduler.addTask("crit", slowCritical, 2000, TASK_PRIORITY_CRITICAL, 500);
+    uint8_t low = scheduler.addTask("low", slowBackground, 100000, TASK_PRIORITY_LOW);
+    scheduler.begin();
+
+    TEST_ASSERT_TRUE(scheduler.run());   // Critical (~200 us)
+    TEST_ASSERT_TRUE(scheduler.run());   // Low, no estimate yet (~1500 us)
+
+    // Another 1500 us slice would run past the critical deadline: held back
+    TEST_ASSERT_FALSE(scheduler.run());
+    TEST_ASSERT_GREATER_THAN(0, scheduler.getStats(low).deferrals);
+
+    // Once the critical task is released it runs on time
+    while (!scheduler.run()) {}
+    TEST_ASSERT_EQUAL_STRING("CLC", callLog);
+    TEST_ASSERT_EQUAL(0, scheduler.getStats(crit).overruns);
+}
+
+void test_scheduler_disabled_task_does_not_defer() {
+    TaskScheduler scheduler;
+    uint8_t crit = scheduler.addTask("crit", slowCritical, 2000, TASK_PRIORITY_CRITICAL, 500);
+    uint8_t low = scheduler.addTask("low", slowBackground, 100000, TASK_PRIORITY_LOW);
+    scheduler.begin();
+    scheduler.setEnabled(crit, false);
+
+    // The disabled task's stale release must not hold back long slices
+    TEST_ASSERT_TRUE(scheduler.run());
+    TEST_ASSERT_TRUE(scheduler.run());
+    TEST_ASSERT_TRUE(scheduler.run());
+    TEST_ASSERT_EQUAL_STRING("LLL", callLog);
+    TEST_ASSERT_EQUAL(0, scheduler.getStats(low).deferrals);
+}
+
+void test_scheduler_disable_and_enable() {
+    TaskScheduler scheduler;
+    uint8_t id = scheduler.addTask("t", taskA, 100000, TASK_PRIORITY_NORMAL);
+    scheduler.begin();
+
+    scheduler.setEnabled(id, false);
+    TEST_ASSERT_FALSE(scheduler.run());
+
+    // Re-enabling releases the task right away
+    scheduler.setEnabled(id, true);
+    TEST_ASSERT_TRUE(scheduler.run());
+    TEST_ASSERT_EQUAL_STRING("A", callLog);
+}
+
+void setUp(void) {
+    callLog[0] = '\0';
+    callCount = 0;
+    slicesLeft = 0;
+}
+
+void tearDown(void) {
+    // Clean up code if needed
+}
+
+void setup() {
+    delay(2000); // Wait for serial
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_scheduler_add_task_limits);
+    RUN_TEST(test_scheduler_priority_order);
+    RUN_TEST(test_scheduler_sliced_job);
+    RUN_TEST(test_scheduler_skips_missed_releases);
+    RUN_TEST(test_scheduler_admission_defers_long_slice);
+    RUN_TEST(test_scheduler_disabled_task_does_not_defer);
+    RUN_TEST(test_scheduler_disable_and_enable);
+
+    UNITY_END();
+}
+
+void loop() {
+    // Empty
+}